@@ -167,9 +167,11 @@ protected:
 	static bool smolyak_normal_moments(const GeneralMatrix& m, int imom, int level);
 	static bool product_normal_moments(const GeneralMatrix& m, int imom, int level);
 	static bool qmc_normal_moments(const GeneralMatrix& m, int imom, int level);
+	static bool smolyak_table(const GeneralMatrix& m, int imom, int level);
 	static bool smolyak_product_cube(const VectorFunction& func, const Vector& res,
 									 double tol, int level);
 	static bool qmc_cube(const VectorFunction& func, double res, double tol, int level);
+	static bool sobol_cube(const VectorFunction& func, double res, double tol, int level);
 };
 
 bool TestRunnable::test() const
@@ -249,6 +251,46 @@ bool TestRunnable::product_normal_moments(const GeneralMatrix& m, int imom, int
 	return prod_out.getMax() < 1.e-7;
 }
 
+// integrates twice through the tabulated points (the second time the
+// table is reused) and compares with the point by point sum over the
+// quadrature iterators
+bool TestRunnable::smolyak_table(const GeneralMatrix& m, int imom, int level)
+{
+	GeneralMatrix mtr(m, "transpose");
+	GeneralMatrix msq(m, mtr);
+
+	int dim = m.numRows();
+	TensorPower tp(dim, imom);
+	GaussConverterFunction func(tp, msq);
+
+	GaussHermite gs;
+	SmolyakQuadrature quad(dim, level, gs);
+	Vector out1(UFSTensor::calcMaxOffset(dim, imom));
+	Vector out2(UFSTensor::calcMaxOffset(dim, imom));
+	{
+		WallTimer tim("\tTabulated integration time:      ");
+		quad.integrate(func, level, num_threads, out1);
+		quad.integrate(func, level, num_threads, out2);
+	}
+
+	Vector pw_out(UFSTensor::calcMaxOffset(dim, imom));
+	pw_out.zeros();
+	{
+		WallTimer tim("\tPointwise integration time:      ");
+		Vector tmp(pw_out.length());
+		for (smolpit run = quad.start(level); run != quad.end(level); ++run) {
+			func.eval(run.point(), run.signal(), tmp);
+			pw_out.add(run.weight(), tmp);
+		}
+	}
+
+	out2.add(-1.0, out1);
+	pw_out.add(-1.0, out1);
+	printf("\tRepeated integration difference: %16.12g\n", out2.getMax());
+	printf("\tPointwise integration difference:%16.12g\n", pw_out.getMax());
+	return out2.getMax() == 0.0 && pw_out.getMax() < 1.e-12*out1.getMax();
+}
+
 bool TestRunnable::qmc_normal_moments(const GeneralMatrix& m, int imom, int level)
 {
 	// first make m*m' and then Cholesky factor
@@ -374,6 +416,54 @@ bool TestRunnable::qmc_cube(const VectorFunction& func, double res, double tol,
 	return error1 < tol && error2 < tol && error3 < tol;
 }
 
+bool TestRunnable::sobol_cube(const VectorFunction& func, double res, double tol, int level)
+{
+	Vector r(1);
+	double error1;
+	{
+		WallTimer tim("\tSobol (no scrambling) time:      ");
+		SobolCubeQuadrature sq(func.indim(), level);
+		sq.integrate(func, level, num_threads, r);
+		error1 = std::max(res - r[0], r[0] - res);
+		printf("\tSobol (no scrambling) error:     %16.12g\n", error1);
+	}
+	double error2;
+	{
+		WallTimer tim("\tSobol (Owen scrambling) time:    ");
+		SobolCubeQuadrature sq(func.indim(), level, true, 12345);
+		sq.integrate(func, level, num_threads, r);
+		error2 = std::max(res - r[0], r[0] - res);
+		printf("\tSobol (Owen scrambling) error:   %16.12g\n", error2);
+	}
+
+	// check that a sequence started at n is the same as the one
+	// increased to n
+	SobolSequence seq(1, level, func.indim(), true, 12345);
+	for (int i = 1; i < level/2; i++)
+		seq.increase();
+	SobolSequence jump(level/2, level, func.indim(), true, 12345);
+	Vector diff((const Vector&)jump.point());
+	diff.add(-1.0, seq.point());
+	printf("\tSobol skip-ahead error:          %16.12g\n", diff.getMax());
+
+	// check that the sequence refuses dimensions and numbers of points
+	// beyond its table of direction numbers
+	int nraised = 0;
+	try {
+		SobolSequence s(1, level, SobolDirections::max_dim+1, false, 0);
+	} catch (const TLException& e) {
+		nraised++;
+	}
+	try {
+		SobolSequence s(1, 1 << SobolDirections::num_bits, func.indim(), false, 0);
+	} catch (const TLException& e) {
+		nraised++;
+	}
+	printf("\tSobol out of range raised:       %d of 2\n", nraised);
+
+	return error1 < tol && error2 < tol && diff.getMax() == 0.0 && nraised == 2;
+}
+
 /****************************************************/
 /*     definition of TestRunnable subclasses        */
 /****************************************************/
@@ -405,6 +495,21 @@ public:
 		}
 };
 
+class SmolyakTable : public TestRunnable {
+public:
+	SmolyakTable()
+		: TestRunnable("Smolyak tabulated points (dim=3, level=8, order=6)", 6, 3) {}
+
+	bool run() const
+		{
+			GeneralMatrix m(3,3);
+			m.zeros();
+			m.get(0,0)=1; m.get(0,2)=0.5; m.get(1,1)=1;
+			m.get(1,0)=0.5;m.get(2,2)=2;m.get(2,1)=4;
+			return smolyak_table(m, 6, 8);
+		}
+};
+
 class ProductNormalMom1 : public TestRunnable {
 public:
 	ProductNormalMom1()
@@ -490,6 +595,18 @@ public:
 		}
 };
 
+class F1Sobol : public TestRunnable {
+public:
+	F1Sobol()
+		: TestRunnable("Function1 Sobol (dim=6, level=100000)", 1, 1) {}
+
+	bool run() const
+		{
+			Function1 f1(6);
+			return sobol_cube(f1, 1.0, 1.e-4, 100000);
+		}
+};
+
 int main()
 {
 	TestRunnable* all_tests[50];
@@ -497,10 +614,12 @@ int main()
 	int num_tests = 0;
 	all_tests[num_tests++] = new SmolyakNormalMom1();
 	all_tests[num_tests++] = new SmolyakNormalMom2();
+	all_tests[num_tests++] = new SmolyakTable();
 	all_tests[num_tests++] = new ProductNormalMom1();
 	all_tests[num_tests++] = new ProductNormalMom2();
 	all_tests[num_tests++] = new QMCNormalMom1();
 	all_tests[num_tests++] = new QMCNormalMom2();
+	all_tests[num_tests++] = new F1Sobol();
 /*
 	all_tests[num_tests++] = new F1GaussLegendre();
 	all_tests[num_tests++] = new F1QuasiMCarlo();
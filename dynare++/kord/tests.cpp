@@ -1,8 +1,15 @@
 /* $Id: tests.cpp 148 2005-04-19 15:12:26Z kamenik $ */
 /* Copyright 2004, Ondra Kamenik */
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
 #include "korder.h"
+#include "first_order.h"
+#include "faa_di_bruno.h"
+#include "stats_accum.h"
+#include "philox.h"
 #include "SylvException.h"
 
 struct Rand {
@@ -226,8 +233,52 @@ protected:
 									 int nstat, int npred, int nboth, int forw,
 									 const TwoDMatrix& gy, const TwoDMatrix& gu,
 									 const TwoDMatrix& v);
+	static double korder_serial_parallel(int maxdim,
+										 int nstat, int npred, int nboth, int forw,
+										 const TwoDMatrix& gy, const TwoDMatrix& gu,
+										 const TwoDMatrix& v);
+	static double korder_first_touch(int maxdim,
+									 int nstat, int npred, int nboth, int forw,
+									 const TwoDMatrix& gy, const TwoDMatrix& gu,
+									 const TwoDMatrix& v);
+	static double korder_scaling(int maxdim,
+								 int nstat, int npred, int nboth, int forw,
+								 const TwoDMatrix& gy, const TwoDMatrix& gu,
+								 const TwoDMatrix& v);
 };
 
+// Returns the maximum difference of the derivatives of dimension d in
+// cont from the ones in ref, relative since the derivatives are large,
+// or 1.0e10 if some of them is missing in cont.
+template <class _Ttype>
+static double max_rel_diff(const TensorContainer<_Ttype>& ref,
+						   const TensorContainer<_Ttype>& cont, int d)
+{
+	double maxdiff = 0.0;
+	SymmetrySet ss(d, 4);
+	for (symiterator si(ss); !si.isEnd(); ++si) {
+		if (ref.check(*si)) {
+			if (! cont.check(*si))
+				return 1.0e10;
+			const _Ttype* r = ref.get(*si);
+			_Ttype diff(*r);
+			diff.add(-1.0, *(cont.get(*si)));
+			double err = diff.getData().getMax()/(1.0+r->getData().getMax());
+			if (maxdiff < err)
+				maxdiff = err;
+		}
+	}
+	return maxdiff;
+}
+
+// elapsed time, since the CPU time sums over the threads
+static double wall_time()
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec*1.0e-6;
+}
+
 
 bool TestRunnable::test() const
 {
@@ -308,6 +359,138 @@ double TestRunnable::korder_unfold_fold(int maxdim, int unfold_dim,
 	return maxerror;
 }
 
+double TestRunnable::korder_serial_parallel(int maxdim,
+											int nstat, int npred, int nboth, int nforw,
+											const TwoDMatrix& gy, const TwoDMatrix& gu,
+											const TwoDMatrix& v)
+{
+	TensorContainer<FSSparseTensor> c(1);
+	int ny = nstat+npred+nboth+nforw;
+	int nu = v.nrows();
+	int nz = nboth+nforw+ny+nboth+npred+nu;
+	SparseGenerator::fillContainer(c, maxdim, nz, ny, 5.0);
+	Journal jr("out.txt");
+	KOrder kser(nstat, npred, nboth, nforw, c, gy, gu, v, jr);
+	KOrder kpar(nstat, npred, nboth, nforw, c, gy, gu, v, jr);
+	int save_threads = THREAD_GROUP::max_parallel_threads;
+	double maxdiff = 0.0;
+	for (int d = 2; d <= maxdim; d++) {
+		THREAD_GROUP::max_parallel_threads = 1;
+		double sertime = wall_time();
+		kser.performStep<KOrder::unfold>(d);
+		sertime = wall_time()-sertime;
+		THREAD_GROUP::max_parallel_threads = 4;
+		double partime = wall_time();
+		kpar.performStep<KOrder::unfold>(d);
+		partime = wall_time()-partime;
+		printf("\twall time for serial/parallel step dim=%d: %8.4g %8.4g\n",
+			   d, sertime, partime);
+		maxdiff = std::max(maxdiff, max_rel_diff(kser.getUnfoldDers(), kpar.getUnfoldDers(), d));
+	}
+	THREAD_GROUP::max_parallel_threads = save_threads;
+	printf("\tmax relative difference between serial and parallel: %10.6g\n", maxdiff);
+	return maxdiff;
+}
+
+// Solves the folded korder with one thread, and with four threads and
+// the first touch of the output tensors by the threads, and returns the
+// maximum relative difference of the results.
+double TestRunnable::korder_first_touch(int maxdim,
+										int nstat, int npred, int nboth, int nforw,
+										const TwoDMatrix& gy, const TwoDMatrix& gu,
+										const TwoDMatrix& v)
+{
+	TensorContainer<FSSparseTensor> c(1);
+	int ny = nstat+npred+nboth+nforw;
+	int nu = v.nrows();
+	int nz = nboth+nforw+ny+nboth+npred+nu;
+	SparseGenerator::fillContainer(c, maxdim, nz, ny, 5.0);
+	Journal jr("out.txt");
+	KOrder kser(nstat, npred, nboth, nforw, c, gy, gu, v, jr);
+	KOrder ktouch(nstat, npred, nboth, nforw, c, gy, gu, v, jr);
+	kser.switchToFolded();
+	ktouch.switchToFolded();
+	int save_threads = THREAD_GROUP::max_parallel_threads;
+	bool save_first_touch = FaaDiBruno::first_touch;
+	int save_first_touch_min = FaaDiBruno::first_touch_min;
+	FaaDiBruno::first_touch_min = 1024; // the test problems are small
+	double maxdiff = 0.0;
+	for (int d = 2; d <= maxdim; d++) {
+		THREAD_GROUP::max_parallel_threads = 1;
+		FaaDiBruno::first_touch = false;
+		kser.performStep<KOrder::fold>(d);
+		THREAD_GROUP::max_parallel_threads = 4;
+		FaaDiBruno::first_touch = true;
+		ktouch.performStep<KOrder::fold>(d);
+		maxdiff = std::max(maxdiff, max_rel_diff(kser.getFoldDers(), ktouch.getFoldDers(), d));
+	}
+	THREAD_GROUP::max_parallel_threads = save_threads;
+	FaaDiBruno::first_touch = save_first_touch;
+	FaaDiBruno::first_touch_min = save_first_touch_min;
+	printf("\tmax relative difference with first touch: %10.6g\n", maxdiff);
+	return maxdiff;
+}
+
+// Solves the folded korder for 1, 2, 4 and 8 threads, with and without
+// the first touch of the output tensors by the threads, reports the
+// time of each step and the speedup against one thread, and returns
+// the maximum relative difference from the results of one thread. This
+// is not a part of the test suite, it is run by "tests scaling".
+double TestRunnable::korder_scaling(int maxdim,
+									int nstat, int npred, int nboth, int nforw,
+									const TwoDMatrix& gy, const TwoDMatrix& gu,
+									const TwoDMatrix& v)
+{
+	TensorContainer<FSSparseTensor> c(1);
+	int ny = nstat+npred+nboth+nforw;
+	int nu = v.nrows();
+	int nz = nboth+nforw+ny+nboth+npred+nu;
+	SparseGenerator::fillContainer(c, maxdim, nz, ny, 5.0);
+	Journal jr("out.txt");
+	int save_threads = THREAD_GROUP::max_parallel_threads;
+	bool save_first_touch = FaaDiBruno::first_touch;
+	int save_first_touch_min = FaaDiBruno::first_touch_min;
+	FaaDiBruno::first_touch_min = 1024; // the test problems are small
+
+	const int nconf = 7;
+	const int conf_threads[nconf] = {1, 2, 2, 4, 4, 8, 8};
+	const bool conf_touch[nconf] = {false, false, true, false, true, false, true};
+	vector<double> serial_time(maxdim+1, 0.0);
+	KOrder* kser = NULL;
+	double maxdiff = 0.0;
+	for (int ic = 0; ic < nconf; ic++) {
+		THREAD_GROUP::max_parallel_threads = conf_threads[ic];
+		FaaDiBruno::first_touch = conf_touch[ic];
+		KOrder* kord = new KOrder(nstat, npred, nboth, nforw, c, gy, gu, v, jr);
+		kord->switchToFolded();
+		printf("	threads=%d first_touch=%d:", conf_threads[ic], (int)conf_touch[ic]);
+		for (int d = 2; d <= maxdim; d++) {
+			double steptime = wall_time();
+			kord->performStep<KOrder::fold>(d);
+			steptime = wall_time()-steptime;
+			if (ic == 0) {
+				serial_time[d] = steptime;
+				printf(" dim=%d %8.4g", d, steptime);
+			} else
+				printf(" dim=%d %8.4g (x%4.2f)", d, steptime, serial_time[d]/steptime);
+		}
+		printf("\n");
+		if (ic == 0) {
+			kser = kord;
+			continue;
+		}
+		for (int d = 2; d <= maxdim; d++)
+			maxdiff = std::max(maxdiff, max_rel_diff(kser->getFoldDers(), kord->getFoldDers(), d));
+		delete kord;
+	}
+	delete kser;
+	THREAD_GROUP::max_parallel_threads = save_threads;
+	FaaDiBruno::first_touch = save_first_touch;
+	FaaDiBruno::first_touch_min = save_first_touch_min;
+	printf("\tmax relative difference from one thread: %10.6g\n", maxdiff);
+	return maxdiff;
+}
+
 class UnfoldKOrderSmall : public TestRunnable {
 public:
 	UnfoldKOrderSmall()
@@ -367,14 +550,338 @@ public:
 		}
 };
 
-int main()
+class KOrderParallelSmall : public TestRunnable {
+public:
+	KOrderParallelSmall()
+		: TestRunnable("serial vs parallel korder (stat=2,pred=3,both=1,forw=2,u=3,dim=4)",
+					   4, 18) {}
+
+	bool run() const
+		{
+			TwoDMatrix gy(8, 4, gy_data);
+			TwoDMatrix gu(8, 3, gu_data);
+			TwoDMatrix v(3, 3, vdata);
+			double err = korder_serial_parallel(4, 2, 3, 1, 2,
+												gy, gu, v);
+
+			return err < 1.e-10;
+		}
+};
+
+class KOrderFirstTouchSmall : public TestRunnable {
+public:
+	KOrderFirstTouchSmall()
+		: TestRunnable("first touch folded korder (stat=2,pred=3,both=1,forw=2,u=3,dim=4)",
+					   4, 18) {}
+
+	bool run() const
+		{
+			TwoDMatrix gy(8, 4, gy_data);
+			TwoDMatrix gu(8, 3, gu_data);
+			TwoDMatrix v(3, 3, vdata);
+			double err = korder_first_touch(4, 2, 3, 1, 2,
+											gy, gu, v);
+
+			return err < 1.e-10;
+		}
+};
+
+class KOrderScalingSmall : public TestRunnable {
+public:
+	KOrderScalingSmall()
+		: TestRunnable("threads scaling of folded korder (stat=2,pred=3,both=1,forw=2,u=3,dim=5)",
+					   5, 18) {}
+
+	bool run() const
+		{
+			TwoDMatrix gy(8, 4, gy_data);
+			TwoDMatrix gu(8, 3, gu_data);
+			TwoDMatrix v(3, 3, vdata);
+			double err = korder_scaling(5, 2, 3, 1, 2,
+										gy, gu, v);
+
+			return err < 1.e-10;
+		}
+};
+
+class KOrderScalingSW : public TestRunnable {
+public:
+	KOrderScalingSW()
+		: TestRunnable("threads scaling of folded S&W korder (stat=5,pred=12,both=8,forw=5,u=10,dim=3)",
+					   3, 73) {}
+
+	bool run() const
+		{
+			TwoDMatrix gy(30, 20, gy_data2);
+			TwoDMatrix gu(30, 10, gu_data2);
+			TwoDMatrix v(10, 10, vdata2);
+			v.mult(0.001);
+			gu.mult(.01);
+			double err = korder_scaling(3, 5, 12, 8, 5,
+										gy, gu, v);
+
+			return err < 1.e-10;
+		}
+};
+
+// a worker raising the given kind of exception, caught as in
+// KOrderStageWorker
+class ThrowingWorker : public THREAD {
+	int kind;
+	KOrderStageError& err;
+public:
+	ThrowingWorker(int k, KOrderStageError& e)
+		: kind(k), err(e) {}
+	void operator()()
+		{
+			try {
+				if (kind == 1)
+					throw KordException(__FILE__, __LINE__, "kord");
+				else if (kind == 2)
+					throw TLException(__FILE__, __LINE__, "tl");
+				else if (kind == 3)
+					throw SYLV_MES_EXCEPTION("sylv");
+				else if (kind == 4)
+					throw 4;
+			} catch (const KordException& e) {
+				err.set(e);
+			} catch (const TLException& e) {
+				err.set(e);
+			} catch (const SylvException& e) {
+				err.set(e);
+			} catch (...) {
+				err.setUnknown();
+			}
+		}
+};
+
+// exceptions raised in the threads are raised again with their type
+// in the calling thread
+class KOrderStageErrors : public TestRunnable {
+public:
+	KOrderStageErrors()
+		: TestRunnable("exceptions from k-order stage workers", 1, 1) {}
+
+	bool run() const
+		{
+			const int nw = 4;
+			int save_threads = THREAD_GROUP::max_parallel_threads;
+			THREAD_GROUP::max_parallel_threads = nw;
+			bool ok = true;
+			for (int kind = 1; kind <= 4; kind++) {
+				KOrderStageError errs[nw];
+				{
+					THREAD_GROUP gr;
+					for (int iw = 0; iw < nw; iw++)
+						gr.insert(new ThrowingWorker((iw == 2)? kind : 0, errs[iw]));
+					gr.run();
+				}
+				int caught = 0;
+				try {
+					for (int iw = 0; iw < nw; iw++)
+						errs[iw].raise();
+				} catch (const KordException& e) {
+					caught = (strcmp(e.get_message(), "kord") == 0)? 1 : 4;
+				} catch (const TLException& e) {
+					caught = 2;
+				} catch (const SylvException& e) {
+					caught = 3;
+				}
+				printf("\texception kind %d raised as kind %d\n", kind, caught);
+				ok = ok && caught == kind && ! errs[0].isSet() && errs[2].isSet();
+			}
+			THREAD_GROUP::max_parallel_threads = save_threads;
+			return ok;
+		}
+};
+
+// one accumulator vs. accumulators of pieces merged together
+class StatsAccumMerge : public TestRunnable {
+public:
+	StatsAccumMerge()
+		: TestRunnable("merged vs single stats accumulator (dim=4,lags=3,n=20000)",
+					   1, 1) {}
+
+	bool run() const
+		{
+			const int d = 4;
+			const int nl = 3;
+			const int n = 20000;
+			const int npieces = 7;
+			TwoDMatrix y(d, n);
+			Rand::init(1, 2, 3, 4, 5);
+			for (int t = 0; t < n; t++)
+				for (int i = 0; i < d; i++)
+					y.get(i, t) = ((t > 0)? 0.8*y.get(i, t-1) : 0.0) + Rand::get(1.0) + i;
+
+			StatsAccumulator single(d, nl);
+			StatsAccumulator merged(d, nl);
+			for (int ip = 0; ip < npieces; ip++) {
+				StatsAccumulator piece(d, nl);
+				for (int t = ip*n/npieces; t < (ip+1)*n/npieces; t++) {
+					single.update(ConstVector(y, t));
+					piece.update(ConstVector(y, t));
+				}
+				single.endPath();
+				merged.merge(piece);
+			}
+
+			Vector dmean(single.getMean());
+			dmean.add(-1.0, merged.getMean());
+			double err = dmean.getMax();
+			for (int k = 0; k <= nl; k++) {
+				TwoDMatrix s(d, d);
+				TwoDMatrix m(d, d);
+				single.getAutoCovariance(k, s);
+				merged.getAutoCovariance(k, m);
+				m.add(-1.0, s);
+				if (err < m.getData().getMax())
+					err = m.getData().getMax();
+			}
+			printf("\tmax difference of moments: %10.6g\n", err);
+
+			// the quantile sketch is approximate, compare ranks
+			double qerr = 0.0;
+			const double probs[] = {0.05, 0.5, 0.95};
+			for (int j = 0; j < 3; j++) {
+				double q = merged.getQuantile(0, probs[j]);
+				int below = 0;
+				for (int t = 0; t < n; t++)
+					if (y.get(0, t) <= q)
+						below++;
+				double e = fabs(((double)below)/n - probs[j]);
+				if (qerr < e)
+					qerr = e;
+			}
+			printf("\tmax rank error of quantiles: %10.6g\n", qerr);
+
+			return err < 1.e-10 && qerr < 0.01;
+		}
+};
+
+// known answers of Philox4x32-10 and independence of draws on order
+class PhiloxStreams : public TestRunnable {
+public:
+	PhiloxStreams()
+		: TestRunnable("philox known answers and substream reproducibility",
+					   1, 1) {}
+
+	bool run() const
+		{
+			const unsigned int ctr[3][4] = {
+				{0, 0, 0, 0},
+				{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+				{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+			const unsigned int key[3][2] = {
+				{0, 0},
+				{0xffffffff, 0xffffffff},
+				{0xa4093822, 0x299f31d0}};
+			const unsigned int res[3][4] = {
+				{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+				{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+				{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+			bool ok = true;
+			for (int i = 0; i < 3; i++) {
+				unsigned int out[4];
+				PhiloxGenerator::philox(ctr[i], key[i], out);
+				for (int j = 0; j < 4; j++)
+					ok = ok && out[j] == res[i][j];
+			}
+
+			// periods drawn in reverse order give the same numbers
+			const int nper = 50;
+			const int nsh = 7;
+			PhiloxGenerator forw(934098, 3);
+			PhiloxGenerator back(934098, 3);
+			TwoDMatrix df(nsh, nper);
+			TwoDMatrix db(nsh, nper);
+			for (int t = 0; t < nper; t++) {
+				forw.seek(t);
+				forw.normals(&df.get(0, t), nsh);
+				back.seek(nper-1-t);
+				back.normals(&db.get(0, nper-1-t), nsh);
+			}
+			df.add(-1.0, db);
+			ok = ok && df.getData().getMax() == 0.0;
+
+			// jumping over a block equals drawing it
+			PhiloxGenerator g1(1, 2);
+			PhiloxGenerator g2(1, 2);
+			g1.seek(10);
+			g1.lrand(); g1.lrand(); g1.lrand(); g1.lrand();
+			g2.seek(10);
+			g2.jump(1);
+			ok = ok && g1.lrand() == g2.lrand();
+			return ok;
+		}
+};
+
+// first order derivatives by QZ, cyclic reduction and logarithmic reduction
+class FirstOrderReduction : public TestRunnable {
+public:
+	FirstOrderReduction()
+		: TestRunnable("first order by QZ vs reductions (stat=3,pred=4,both=2,forw=3,u=2)",
+					   1, 25) {}
+
+	bool run() const
+		{
+			const int nstat = 3, npred = 4, nboth = 2, nforw = 3, nu = 2;
+			const int ny = nstat+npred+nboth+nforw;
+			const int nys = npred+nboth;
+			const int nyss = nboth+nforw;
+			const int nv = nyss+ny+nys+nu;
+			// derivatives at t+1 and t-1 small, at t close to identity,
+			// so that the model is stable
+			Rand::init(1, nstat, npred, nboth, nforw);
+			FSSparseTensor f(1, nv, ny);
+			for (int i = 0; i < ny; i++)
+				for (int j = 0; j < nv; j++) {
+					double x = Rand::get(0.2);
+					if (j >= nyss && j < nyss+ny && j-nyss == i)
+						x += 1.0;
+					if (x != 0.0)
+						f.insert(IntSequence(1, j), i, x);
+				}
+			Journal jr("out.txt");
+			FirstOrder fo_qz(nstat, npred, nboth, nforw, nu, f, jr, 1.000001);
+			FirstOrder fo_cr(nstat, npred, nboth, nforw, nu, f, jr, 1.000001,
+							 FirstOrder::cycle_reduction, 1.e-13);
+			FirstOrder fo_lr(nstat, npred, nboth, nforw, nu, f, jr, 1.000001,
+							 FirstOrder::logarithmic_reduction, 1.e-13);
+			double err = 0.0;
+			const FirstOrder* fos[2] = {&fo_cr, &fo_lr};
+			for (int k = 0; k < 2; k++) {
+				TwoDMatrix dy(fos[k]->getGy());
+				dy.add(-1.0, fo_qz.getGy());
+				TwoDMatrix du(fos[k]->getGu());
+				du.add(-1.0, fo_qz.getGu());
+				err = std::max(err, std::max(dy.getData().getMax(), du.getData().getMax()));
+			}
+			printf("	max difference from QZ: %10.6g\n", err);
+			return fo_qz.isStable() && fo_cr.isStable() && fo_lr.isStable() && err < 1.e-10;
+		}
+};
+
+int main(int argc, char** argv)
 {
 	TestRunnable* all_tests[50];
 	// fill in vector of all tests
 	int num_tests = 0;
-	all_tests[num_tests++] = new UnfoldKOrderSmall();
-	all_tests[num_tests++] = new UnfoldKOrderSW();
-	all_tests[num_tests++] = new UnfoldFoldKOrderSW();
+	if (argc > 1 && strcmp(argv[1], "scaling") == 0) {
+		// timings only, not run by make check
+		all_tests[num_tests++] = new KOrderScalingSmall();
+		all_tests[num_tests++] = new KOrderScalingSW();
+	} else {
+		all_tests[num_tests++] = new UnfoldKOrderSmall();
+		all_tests[num_tests++] = new KOrderParallelSmall();
+		all_tests[num_tests++] = new KOrderFirstTouchSmall();
+		all_tests[num_tests++] = new UnfoldKOrderSW();
+		all_tests[num_tests++] = new UnfoldFoldKOrderSW();
+		all_tests[num_tests++] = new KOrderStageErrors();
+		all_tests[num_tests++] = new StatsAccumMerge();
+		all_tests[num_tests++] = new PhiloxStreams();
+		all_tests[num_tests++] = new FirstOrderReduction();
+	}
 
 	// find maximum dimension and maximum nvar
 	int dmax=0;
@@ -11,6 +11,7 @@
 #include "formula_tab.hh"
 
 #include <cmath>
+#include <algorithm>
 
 using namespace ogp;
 
@@ -273,6 +274,41 @@ void FormulaCustomEvaluator::eval(const AtomValues& av, FormulaEvalLoader& loade
 	}
 }
 
+void FormulaCustomEvaluator::eval(const vector<const AtomValues*>& avs,
+								  const vector<FormulaEvalLoader*>& loaders)
+{
+	if (avs.size() != loaders.size())
+		throw ogu::Exception(__FILE__,__LINE__,
+							 "Different numbers of points and loaders in FormulaCustomEvaluator::eval");
+
+	int npoints = (int)avs.size();
+	vector<double> vals(tape.get_num_slots()*block_size);
+	vector<bool> loaded(block_size);
+	for (int first = 0; first < npoints; first += block_size) {
+		int n = std::min(block_size, npoints-first);
+		// set the nulary terms of the points; the points where the
+		// tape cannot be used are evaluated recursively
+		for (int p = 0; p < n; p++) {
+			etree.reset_all();
+			avs[first+p]->setValues(etree);
+			loaded[p] = etree.load_tape_point(tape, &vals[0], n, p);
+			if (! loaded[p]) {
+				for (int s = 0; s < tape.get_num_slots(); s++)
+					vals[s*n+p] = 0.0;
+				for (unsigned int i = 0; i < terms.size(); i++)
+					loaders[first+p]->load((int)i, etree.eval(terms[i]));
+			}
+		}
+
+		tape.eval(&vals[0], n);
+
+		for (int p = 0; p < n; p++)
+			if (loaded[p])
+				for (unsigned int i = 0; i < terms.size(); i++)
+					loaders[first+p]->load((int)i, vals[tape.term_slot(i)*n+p]);
+	}
+}
+
 FoldMultiIndex::FoldMultiIndex(int nv)
 	: nvar(nv), ord(0), data(new int[ord])
 {
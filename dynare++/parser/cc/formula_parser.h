@@ -278,22 +278,37 @@ namespace ogp {
 		EvalTree etree;
 		/** The custom tree indices to be evaluated. */
 		vector<int> terms;
+		/** The tape evaluating the terms. */
+		EvalTape tape;
 	public:
+		/** The maximum number of points evaluated at once by the
+		 * tape in eval() for several points. */
+		static const int block_size = 32;
 		/** Construct from FormulaParser and given list of terms. */
 		FormulaCustomEvaluator(const FormulaParser& fp, const vector<int>& ts)
-			: etree(fp.otree), terms(ts)
+			: etree(fp.otree), terms(ts), tape(fp.otree, ts)
 			{}
 		/** Construct from OperationTree and given list of terms. */
 		FormulaCustomEvaluator(const OperationTree& ot, const vector<int>& ts)
-			: etree(ot), terms(ts)
+			: etree(ot), terms(ts), tape(ot, ts)
 			{}
 		/** Evaluate the terms using the given AtomValues and load the
 		 * results using the given loader. The loader is called for
 		 * each term in the order of the terms. */
 		void eval(const AtomValues& av, FormulaEvalLoader& loader);
+		/** Evaluate the terms at a number of points, the i-th point
+		 * being given by avs[i] and loaded by loaders[i]. The points
+		 * are evaluated by blocks of at most block_size points, each
+		 * operation of the tape being done for all the points of the
+		 * block at once. The results are the same as of eval() called
+		 * for each point, provided the loaders do not feed the loaded
+		 * values back to the tree (as AtomAsgnEvaluator does); such
+		 * loaders must be used with eval() for one point. */
+		void eval(const vector<const AtomValues*>& avs, const vector<FormulaEvalLoader*>& loaders);
 	protected:
 		FormulaCustomEvaluator(const FormulaParser& fp)
-			: etree(fp.otree, fp.last_formula()), terms(fp.formulas)
+			: etree(fp.otree, fp.last_formula()), terms(fp.formulas),
+			  tape(fp.otree, fp.formulas)
 			{}
 	};
 
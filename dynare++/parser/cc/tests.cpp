@@ -0,0 +1,334 @@
+// Copyright (C) 2015, Dynare Team
+
+#include "formula_parser.h"
+#include "static_atoms.h"
+#include "atom_assignings.h"
+#include "parser_exception.h"
+#include "utils/cc/exception.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+using namespace ogp;
+
+/** Atoms registering the variables x0, x1, ... in advance. */
+class TestAtoms : public StaticAtoms {
+public:
+	TestAtoms(int nv)
+		{
+			char name[20];
+			for (int i = 0; i < nv; i++) {
+				sprintf(name, "x%d", i);
+				register_name(name);
+			}
+		}
+protected:
+	int check_variable(const char* name) const
+		{
+			if (0 == varnames.query(name))
+				throw ParserException(std::string("Unknown name <")+name+">", 0);
+			Tvarmap::const_iterator it = vars.find(name);
+			if (it == vars.end())
+				return -1;
+			else
+				return (*it).second;
+		}
+};
+
+/** Values of the variables of TestAtoms at one point. If skip is not
+ * negative, the variable of that index is left unset. */
+class TestAtomValues : public AtomValues {
+	const TestAtoms& atoms;
+	vector<double> vals;
+	int skip;
+public:
+	TestAtomValues(const TestAtoms& a, const vector<double>& v, int sk = -1)
+		: atoms(a), vals(v), skip(sk) {}
+	void setValues(EvalTree& et) const
+		{
+			atoms.Constants::setValues(et);
+			for (int i = 0; i < atoms.nvar(); i++) {
+				int t = atoms.index(atoms.name(i));
+				if (t >= 0 && i != skip)
+					et.set_nulary(t, vals[i]);
+			}
+		}
+};
+
+/** Loader storing the results of one point. */
+class TestLoader : public FormulaEvalLoader, public vector<double> {
+public:
+	TestLoader(int n)
+		: vector<double>(n, 0.0) {}
+	void load(int i, double res)
+		{operator[](i) = res;}
+};
+
+class TestRunnable {
+	char name[100];
+public:
+	TestRunnable(const char* n)
+		{strncpy(name, n, 100);}
+	virtual ~TestRunnable() {}
+	bool test() const;
+	virtual bool run() const =0;
+	const char* getName() const
+		{return name;}
+protected:
+	static bool same(double a, double b)
+		{return a == b || (std::isnan(a) && std::isnan(b));}
+	static bool tape_recursive(const char* formulas, int nv, int npoints,
+							   int unset = -1, int der_order = 0);
+};
+
+bool TestRunnable::test() const
+{
+	printf("Running test <%s>\n",name);
+	clock_t start = clock();
+	bool passed = run();
+	clock_t end = clock();
+	printf("CPU time %8.4g (CPU seconds)..................",
+		   ((double)(end-start))/CLOCKS_PER_SEC);
+	if (passed) {
+		printf("passed\n\n");
+		return passed;
+	} else {
+		printf("FAILED\n\n");
+		return passed;
+	}
+}
+
+// Parses the formulas in the nv variables and evaluates them at
+// npoints random points by the tape, one point at a time and all the
+// points at once, and recursively by EvalTree::eval. The results must
+// be exactly the same, including NaNs. If unset is not negative, every
+// 7th point sets x0 to zero and leaves the variable unset without a
+// value; the formulas must then need it only through a product with
+// x0, so that the recursive evaluation does not need it, and the tape
+// falls back to the recursive evaluation for the point. If der_order
+// is positive, the derivatives of the i-th formula with respect to
+// x_i, x_{i+1}, ... up to the given order are evaluated as well.
+bool TestRunnable::tape_recursive(const char* formulas, int nv, int npoints,
+								  int unset, int der_order)
+{
+	TestAtoms atoms(nv);
+	FormulaParser fp(atoms);
+	fp.parse(strlen(formulas), formulas);
+	vector<int> terms;
+	for (int i = 0; i < fp.nformulas(); i++) {
+		int t = fp.formula(i);
+		terms.push_back(t);
+		for (int k = 0; k < der_order; k++) {
+			int v = atoms.index(atoms.name((i+k) % nv));
+			if (v >= 0) {
+				t = fp.add_derivative(t, v);
+				terms.push_back(t);
+			}
+		}
+	}
+	int nf = (int)terms.size();
+
+	srand48(nv*1000+npoints);
+	vector<TestAtomValues*> avs;
+	for (int p = 0; p < npoints; p++) {
+		vector<double> v(nv);
+		for (int i = 0; i < nv; i++)
+			v[i] = 3*drand48()+0.1;
+		// a negative value giving NaNs in logs, square roots and powers
+		if (p % 11 == 5)
+			v[(p+1) % nv] = -v[(p+1) % nv];
+		// a zero absorbing the NaN of the other operand of a TIMES
+		if (p % 5 == 3)
+			v[p % nv] = 0.0;
+		int skip = -1;
+		if (unset >= 0 && p % 7 == 6) {
+			v[0] = 0.0;
+			skip = unset;
+		}
+		avs.push_back(new TestAtomValues(atoms, v, skip));
+	}
+
+	// recursive evaluation
+	vector<vector<double> > ref(npoints);
+	EvalTree etree(fp.getTree());
+	for (int p = 0; p < npoints; p++) {
+		etree.reset_all();
+		avs[p]->setValues(etree);
+		for (int i = 0; i < nf; i++)
+			ref[p].push_back(etree.eval(terms[i]));
+	}
+
+	FormulaCustomEvaluator fe(fp, terms);
+	bool ok = true;
+	int nnan = 0;
+
+	// tape for one point at a time
+	for (int p = 0; p < npoints; p++) {
+		TestLoader loader(nf);
+		vector<const AtomValues*> pavs(1, avs[p]);
+		vector<FormulaEvalLoader*> ploaders(1, &loader);
+		fe.eval(pavs, ploaders);
+		for (int i = 0; i < nf; i++) {
+			if (! same(loader[i], ref[p][i])) {
+				printf("point %d, formula %d: single %g, recursive %g\n",
+					   p, i, loader[i], ref[p][i]);
+				ok = false;
+			}
+			if (std::isnan(ref[p][i]))
+				nnan++;
+		}
+	}
+
+	// tape for all the points at once
+	vector<TestLoader*> loaders;
+	for (int p = 0; p < npoints; p++)
+		loaders.push_back(new TestLoader(nf));
+	vector<const AtomValues*> bavs(avs.begin(), avs.end());
+	vector<FormulaEvalLoader*> bloaders(loaders.begin(), loaders.end());
+	fe.eval(bavs, bloaders);
+	for (int p = 0; p < npoints; p++)
+		for (int i = 0; i < nf; i++)
+			if (! same((*loaders[p])[i], ref[p][i])) {
+				printf("point %d, formula %d: batched %g, recursive %g\n",
+					   p, i, (*loaders[p])[i], ref[p][i]);
+				ok = false;
+			}
+
+	printf("%d formulas, %d points, %d NaNs\n", nf, npoints, nnan);
+
+	for (int p = 0; p < npoints; p++) {
+		delete avs[p];
+		delete loaders[p];
+	}
+	return ok;
+}
+
+/****************************************************/
+/*     test classes                                 */
+/****************************************************/
+
+class TapeSmall : public TestRunnable {
+public:
+	TapeSmall() : TestRunnable("tape vs. recursive (small)") {}
+	bool run() const
+		{
+			const char* f =
+				"x0*x1 + x2 = 1;"
+				"log(x0)*x1;"
+				"x1*log(x0);"
+				"exp(x1-x2)/x0 - 2.5*x2^2;"
+				"sqrt(x2)*x0 + sin(x1)*cos(x2) - tan(x0/3);"
+				"erf(x0) - erfc(x1) + x2^x1;"
+				"-x0/(x1-x1) + x0^0;"
+				"0/x2 + x1*0;";
+			return tape_recursive(f, 3, 1) && tape_recursive(f, 3, 77);
+		}
+};
+
+class TapeFallback : public TestRunnable {
+public:
+	TapeFallback() : TestRunnable("tape vs. recursive (fallback)") {}
+	bool run() const
+		{
+			const char* f =
+				"x0*(x1+x2);"
+				"x0*(x1*exp(x2)) - x1;"
+				"x0*x1;";
+			return tape_recursive(f, 3, 40, 2);
+		}
+};
+
+class TapeDerivatives : public TestRunnable {
+public:
+	TapeDerivatives() : TestRunnable("tape vs. recursive (derivatives)") {}
+	bool run() const
+		{
+			const char* f =
+				"x0*exp(x1)*log(x2)^2;"
+				"x0^x1/(1+x2*x3);"
+				"sqrt(x0*x1+x2*x3)*erf(x3);"
+				"x3*log(x0) + x1*x2^3 = sin(x0*x3);";
+			return tape_recursive(f, 4, 32, -1, 3) && tape_recursive(f, 4, 100, -1, 3);
+		}
+};
+
+class TapeLarge : public TestRunnable {
+public:
+	TapeLarge() : TestRunnable("tape vs. recursive (large)") {}
+	bool run() const
+		{
+			// many formulas sharing subterms
+			const int nv = 10;
+			std::string f;
+			char buf[300];
+			for (int i = 0; i < 200; i++) {
+				int j = (7*i) % nv;
+				sprintf(buf, "x%d*exp(x%d/4) - log(1+x%d^2)/(x%d+2.5) + (x%d*x%d)^0.5*sin(x%d) - x%d^%d;",
+						j, (j+3)%nv, (j+1)%nv, (j+7)%nv, i%nv, (i+1)%nv, (i+2)%nv, i%3, i%4);
+				f += buf;
+			}
+			return tape_recursive(f.c_str(), nv, 1000);
+		}
+};
+
+class AssigningsInOrder : public TestRunnable {
+public:
+	AssigningsInOrder() : TestRunnable("atom assignings in order") {}
+	bool run() const
+		{
+			// AtomAsgnEvaluator feeds the results back to the tree,
+			// so later assignments must see the earlier ones
+			TestAtoms atoms(3);
+			AtomAssignings aa(atoms);
+			const char* a = "x0 = 1+1; x1 = x0*3 + x2; x2 = x1/x0;";
+			aa.parse(strlen(a), a);
+			AtomAsgnEvaluator ae(aa);
+			ae.set_user_value("x2", 1.0);
+			ae.eval();
+			double x1 = ae.get_value("x1");
+			double x2 = ae.get_value("x2");
+			printf("x1=%g x2=%g\n", x1, x2);
+			return x1 == 7.0 && x2 == 3.5;
+		}
+};
+
+int main()
+{
+	TestRunnable* all_tests[50];
+	// fill in vector of all tests
+	int num_tests = 0;
+	all_tests[num_tests++] = new TapeSmall();
+	all_tests[num_tests++] = new TapeFallback();
+	all_tests[num_tests++] = new TapeDerivatives();
+	all_tests[num_tests++] = new TapeLarge();
+	all_tests[num_tests++] = new AssigningsInOrder();
+
+	// launch the tests
+	int success = 0;
+	for (int i = 0; i < num_tests; i++) {
+		try {
+			if (all_tests[i]->test())
+				success++;
+		} catch (const ParserException& e) {
+			printf("Caught parser exception in <%s>:\n", all_tests[i]->getName());
+			e.print(stdout);
+		} catch (const ogu::Exception& e) {
+			printf("Caught exception in <%s>:\n", all_tests[i]->getName());
+			e.print();
+		}
+	}
+
+	printf("There were %d tests that failed out of %d tests run.\n",
+		   num_tests - success, num_tests);
+
+	// destroy
+	for (int i = 0; i < num_tests; i++) {
+		delete all_tests[i];
+	}
+
+	return (success == num_tests) ? 0 : 1;
+}
@@ -493,6 +493,153 @@ void OperationTree::update_nul_incidence_after_nularify(int t)
 }
 
 
+EvalTape::EvalTape(const OperationTree& otree, const vector<int>& terms)
+	: num_slots(OperationTree::num_constants),
+	  last_term(OperationTree::num_constants-1)
+{
+	int nterms = otree.get_num_op();
+	for (unsigned int i = 0; i < terms.size(); i++) {
+		if (terms[i] < 0 || terms[i] >= nterms)
+			throw ogu::Exception(__FILE__,__LINE__,
+								 "The tree index out of bounds in EvalTape constructor");
+		if (terms[i] > last_term)
+			last_term = terms[i];
+	}
+
+	// mark all terms needed by the given terms
+	vector<bool> needed(last_term+1, false);
+	vector<int> stack(terms);
+	while (! stack.empty()) {
+		int t = stack.back();
+		stack.pop_back();
+		if (needed[t])
+			continue;
+		needed[t] = true;
+		const Operation& op = otree.operation(t);
+		if (op.nary() >= 1 && ! needed[op.getOp1()])
+			stack.push_back(op.getOp1());
+		if (op.nary() == 2 && ! needed[op.getOp2()])
+			stack.push_back(op.getOp2());
+	}
+
+	// assign slots in the order of tree indices, which is a
+	// topological order; the special constants keep their indices
+	vector<int> slots(last_term+1, -1);
+	for (int t = 0; t < OperationTree::num_constants; t++)
+		slots[t] = t;
+	for (int t = OperationTree::num_constants; t <= last_term; t++) {
+		if (! needed[t])
+			continue;
+		slots[t] = num_slots++;
+		const Operation& op = otree.operation(t);
+		if (op.nary() == 0) {
+			nulary_terms.push_back(t);
+			nulary_slots.push_back(slots[t]);
+		} else {
+			TapeOp top;
+			top.code = op.getCode();
+			top.t = t;
+			top.op1 = op.getOp1();
+			top.op2 = op.getOp2();
+			top.s = slots[t];
+			top.s1 = slots[top.op1];
+			top.s2 = (top.op2 == -1) ? -1 : slots[top.op2];
+			// pickup less complex formula first, as EvalTree::eval does
+			top.op1_first = (op.getCode() == TIMES &&
+							 otree.nulary_of_term(top.op1).size() < otree.nulary_of_term(top.op2).size());
+			ops.push_back(top);
+		}
+	}
+
+	for (unsigned int i = 0; i < terms.size(); i++)
+		term_slots.push_back(slots[terms[i]]);
+}
+
+/** The results must be the same as of EvalTree::eval. There, the
+ * second operand of TIMES, DIVIDE and POWER is not evaluated if the
+ * first determines the result, here both are evaluated, but the result
+ * is selected in the same way, so the NaNs and infinities of the
+ * unused operand do not propagate. */
+void EvalTape::apply(const TapeOp& op, double* res, const double* r1,
+					 const double* r2, int n)
+{
+	switch (op.code) {
+	case UMINUS:
+		for (int i = 0; i < n; i++)
+			res[i] = -r1[i];
+		break;
+	case LOG:
+		for (int i = 0; i < n; i++)
+			res[i] = log(r1[i]);
+		break;
+	case EXP:
+		for (int i = 0; i < n; i++)
+			res[i] = exp(r1[i]);
+		break;
+	case SIN:
+		for (int i = 0; i < n; i++)
+			res[i] = sin(r1[i]);
+		break;
+	case COS:
+		for (int i = 0; i < n; i++)
+			res[i] = cos(r1[i]);
+		break;
+	case TAN:
+		for (int i = 0; i < n; i++)
+			res[i] = tan(r1[i]);
+		break;
+	case SQRT:
+		for (int i = 0; i < n; i++)
+			res[i] = sqrt(r1[i]);
+		break;
+	case ERF:
+		for (int i = 0; i < n; i++)
+			res[i] = 1-erffc(r1[i]);
+		break;
+	case ERFC:
+		for (int i = 0; i < n; i++)
+			res[i] = erffc(r1[i]);
+		break;
+	case PLUS:
+		for (int i = 0; i < n; i++)
+			res[i] = r1[i] + r2[i];
+		break;
+	case MINUS:
+		for (int i = 0; i < n; i++)
+			res[i] = r1[i] - r2[i];
+		break;
+	case TIMES:
+		if (op.op1_first) {
+			for (int i = 0; i < n; i++)
+				res[i] = (r1[i] == 0.0) ? 0.0 : r1[i]*r2[i];
+		} else {
+			for (int i = 0; i < n; i++)
+				res[i] = (r2[i] == 0.0) ? 0.0 : r1[i]*r2[i];
+		}
+		break;
+	case DIVIDE:
+		for (int i = 0; i < n; i++)
+			res[i] = (r1[i] == 0.0) ? 0.0 : r1[i]/r2[i];
+		break;
+	case POWER:
+		for (int i = 0; i < n; i++)
+			res[i] = (r2[i] == 0.0) ? 1.0 : pow(r1[i], r2[i]);
+		break;
+	default:
+		throw ogu::Exception(__FILE__,__LINE__,
+							 "Unknown operation code in EvalTape::apply");
+	}
+}
+
+void EvalTape::eval(double* vals, int npoints) const
+{
+	for (unsigned int i = 0; i < ops.size(); i++) {
+		const TapeOp& op = ops[i];
+		apply(op, vals + op.s*npoints, vals + op.s1*npoints,
+			  (op.s2 == -1) ? NULL : vals + op.s2*npoints, npoints);
+	}
+}
+
 EvalTree::EvalTree(const OperationTree& ot, int last)
 	: otree(ot),
 	  values(new double[(last==-1)? ot.terms.size() : last+1]),
@@ -639,6 +786,22 @@ double EvalTree::eval(int t)
 	return values[t];
 }
 
+bool EvalTree::load_tape_point(const EvalTape& tape, double* vals, int npoints, int p) const
+{
+	if (tape.get_last_term() > last_operation)
+		return false;
+	for (int t = 0; t < OperationTree::num_constants; t++)
+		vals[t*npoints+p] = values[t];
+	const vector<int>& nulary_terms = tape.get_nulary_terms();
+	const vector<int>& nulary_slots = tape.get_nulary_slots();
+	for (unsigned int i = 0; i < nulary_terms.size(); i++) {
+		if (! flags[nulary_terms[i]])
+			return false;
+		vals[nulary_slots[i]*npoints+p] = values[nulary_terms[i]];
+	}
+	return true;
+}
+
 void EvalTree::print() const
 {
 	printf("last_op=%d\n", last_operation);
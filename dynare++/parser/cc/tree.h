@@ -328,6 +328,83 @@ namespace ogp {
 		void update_nul_incidence_after_nularify(int t);
 	};
 
+	/** EvalTape class is a linearized form of the terms needed for an
+	 * evaluation of a given set of terms of an OperationTree. All the
+	 * unary and binary terms on which the given terms depend are
+	 * stored in a flat sequence of operations ordered so that the
+	 * operands of each operation come before it (the tree indices are
+	 * already ordered this way). Each operation refers to its result
+	 * and operands both by tree indices and by slots, which are
+	 * compact indices of the terms in the tape. The order in which
+	 * EvalTree::eval would evaluate the operands of a TIMES is
+	 * precomputed, so that the results (including zeros absorbing
+	 * NaNs) are the same.
+	 *
+	 * The tape is run over a block of points at once. The values are
+	 * stored by slots, the values of a slot for all the points being
+	 * contiguous, so that each operation is a simple loop over the
+	 * points. */
+	class EvalTape {
+	protected:
+		/** One operation of the tape. */
+		struct TapeOp {
+			/** Code of the operation. */
+			code_t code;
+			/** Tree index of the result and of the operands, -1 if none. */
+			int t, op1, op2;
+			/** Slot of the result and of the operands, -1 if none. */
+			int s, s1, s2;
+			/** For TIMES, true if the first operand is checked for zero. */
+			bool op1_first;
+		};
+		/** The operations in the order of evaluation. */
+		vector<TapeOp> ops;
+		/** Tree indices of the nulary terms (besides the special
+		 * constants) needed by the tape. */
+		vector<int> nulary_terms;
+		/** Slots of the nulary terms. */
+		vector<int> nulary_slots;
+		/** Slots of the terms given in the constructor. */
+		vector<int> term_slots;
+		/** Number of slots. The special constants have the first slots. */
+		int num_slots;
+		/** The maximum tree index used by the tape. */
+		int last_term;
+	public:
+		/** Compiles the tape evaluating the given terms of the given
+		 * operation tree. */
+		EvalTape(const OperationTree& otree, const vector<int>& terms);
+		/** Evaluate the tape over a block of points. The vals has
+		 * num_slots()*npoints items, the values of slot s being
+		 * vals[s*npoints], ..., vals[s*npoints+npoints-1]. The slots of
+		 * the special constants and of the nulary terms must be set
+		 * before. */
+		void eval(double* vals, int npoints) const;
+		/** Return the number of slots. */
+		int get_num_slots() const
+			{return num_slots;}
+		/** Return the slot of the i-th term given in the constructor. */
+		int term_slot(int i) const
+			{return term_slots[i];}
+		/** Return the maximum tree index used by the tape. */
+		int get_last_term() const
+			{return last_term;}
+		/** Return the tree indices of the nulary terms needed by the tape. */
+		const vector<int>& get_nulary_terms() const
+			{return nulary_terms;}
+		/** Return the slots of the nulary terms needed by the tape. */
+		const vector<int>& get_nulary_slots() const
+			{return nulary_slots;}
+		/** Return the number of operations. */
+		int get_num_ops() const
+			{return (int)ops.size();}
+	protected:
+		/** Evaluate one operation for n points, the result and
+		 * operands being given by pointers to their n values. */
+		static void apply(const TapeOp& op, double* res, const double* r1,
+						  const double* r2, int n);
+	};
+
 	/** EvalTree class allows for an evaluation of the given tree for
 	 * a given values of nulary terms. For each term in the
 	 * OperationTree the class maintains a resulting value and a flag
@@ -372,6 +449,11 @@ namespace ogp {
 		void set_nulary(int t, double val);
 		/** Evaluate the given term with nulary terms set so far. */
 		double eval(int t);
+		/** Copy the values of the special constants and of the nulary
+		 * terms needed by the tape to the slots of the given point p
+		 * of a block of npoints points (see EvalTape::eval). Return
+		 * false if a nulary term needed by the tape has not been set. */
+		bool load_tape_point(const EvalTape& tape, double* vals, int npoints, int p) const;
 		/** Debug print. */
 		void print() const;
 		/* Return the operation tree. */
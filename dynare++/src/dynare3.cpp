@@ -11,6 +11,8 @@
 #include "../tl/cc/tl_exception.h"
 #include "../kord/kord_exception.h"
 
+#include <algorithm>
+
 #ifndef DYNVERSION
 #define DYNVERSION "unknown"
 #endif
@@ -41,7 +43,7 @@ vector<int> DynareNameList::selectIndices(const vector<const char*>& ns) const
 
 Dynare::Dynare(const char* modname, int ord, double sstol, Journal& jr)
 	: journal(jr), model(NULL), ysteady(NULL), md(1), dnl(NULL), denl(NULL), dsnl(NULL),
-	  fe(NULL), fde(NULL), ss_tol(sstol)
+	  fe(NULL), fde(NULL), ss_tol(sstol), ss_sparse(false), ss_jac_reuse(0)
 {
 	// make memory file
 	ogu::MemoryFile mf(modname);
@@ -72,7 +74,7 @@ Dynare::Dynare(const char** endo, int num_endo,
 			   const char* equations, int len, int ord,
 			   double sstol, Journal& jr)
 	: journal(jr), model(NULL), ysteady(NULL), md(1), dnl(NULL), denl(NULL), dsnl(NULL),
-	  fe(NULL), fde(NULL), ss_tol(sstol)
+	  fe(NULL), fde(NULL), ss_tol(sstol), ss_sparse(false), ss_jac_reuse(0)
 {
 	try {
 		model = new ogdyn::DynareSPModel(endo, num_endo, exo, num_exo, par, num_par,
@@ -93,7 +95,7 @@ Dynare::Dynare(const Dynare& dynare)
 	: journal(dynare.journal), model(NULL),
 	  ysteady(NULL), md(dynare.md),
 	  dnl(NULL), denl(NULL), dsnl(NULL), fe(NULL), fde(NULL),
-	  ss_tol(dynare.ss_tol)
+	  ss_tol(dynare.ss_tol), ss_sparse(dynare.ss_sparse), ss_jac_reuse(dynare.ss_jac_reuse)
 {
 	model = dynare.model->clone();
 	ysteady = new Vector(*(dynare.ysteady));
@@ -165,10 +167,18 @@ void Dynare::solveDeterministicSteady(Vector& steady)
 	pa << "Non-linear solver for deterministic steady state" << endrec;
 	steady = (const Vector&) model->getInit();
 	DynareVectorFunction dvf(*this);
-	DynareJacobian dj(*this);
-	ogu::NLSolver nls(dvf, dj, 500, ss_tol, journal);
 	int iter;
-	if (! nls.solve(steady, iter))
+	bool converged;
+	if (ss_sparse) {
+		DynareSparseJacobian dj(*this);
+		ogu::SparseNLSolver nls(dvf, dj, 500, ss_tol, ss_jac_reuse, journal);
+		converged = nls.solve(steady, iter);
+	} else {
+		DynareJacobian dj(*this);
+		ogu::NLSolver nls(dvf, dj, 500, ss_tol, journal);
+		converged = nls.solve(steady, iter);
+	}
+	if (! converged)
 		throw DynareException(__FILE__, __LINE__,
 							  "Could not obtain convergence in non-linear solver");
 }
@@ -192,6 +202,28 @@ void Dynare::evaluateSystem(Vector& out, const Vector& yym, const Vector& yy,
 	fe->eval(dav, del);
 }
 
+// evaluate system at given y^*_{t-1}, y_t and x_t for each column of
+// yyp being y^{**}_{t+1}, the residuals are stored in the columns of
+// out; the points are evaluated at once by the evaluation tape
+void Dynare::evaluateSystemBlock(GeneralMatrix& out, const Vector& yym, const Vector& yy,
+								 const GeneralMatrix& yyp, const Vector& xx)
+{
+	int npoints = yyp.numCols();
+	vector<const ogp::AtomValues*> davs(npoints);
+	vector<ogp::FormulaEvalLoader*> dels(npoints);
+	for (int i = 0; i < npoints; i++) {
+		davs[i] = new ogdyn::DynareAtomValues(model->getAtoms(), model->getParams(),
+											  ConstVector(yym), yy, ConstVector(yyp, i), xx);
+		Vector outi(out, i);
+		dels[i] = new DynareEvalLoader(model->getAtoms(), outi);
+	}
+	fe->eval(davs, dels);
+	for (int i = 0; i < npoints; i++) {
+		delete davs[i];
+		delete dels[i];
+	}
+}
+
 void Dynare::calcDerivatives(const Vector& yy, const Vector& xx)
 {
 	ConstVector yym(yy, nstat(), nys());
@@ -354,6 +386,63 @@ void DynareJacobian::load(int i, int iord, const int* vars, double res)
 		get(i, j-d.nyss()-d.ny()+d.nstat()) += res;
 }
 
+DynareSparseJacobian::DynareSparseJacobian(Dynare& dyn)
+	: SparseJacobian(dyn.ny()), d(dyn), num_loaded(0)
+{
+}
+
+void DynareSparseJacobian::eval(const Vector& yy)
+{
+	ogdyn::DynareSteadyAtomValues
+		dav(d.getModel().getAtoms(), d.getModel().getParams(), yy);
+	if (nnz() == 0) {
+		// the first evaluation only gathers the pattern
+		d.fde->eval(dav, *this, 1);
+		vector<std::pair<int,int> > entries;
+		for (unsigned int k = 0; k < loaded.size(); k++)
+			if (loaded[k].second != -1)
+				entries.push_back(loaded[k]);
+		set_pattern(entries);
+		for (unsigned int k = 0; k < loaded.size(); k++)
+			load_pos.push_back((loaded[k].second == -1) ? -1 : position(loaded[k].first, loaded[k].second));
+		loaded.clear();
+	}
+	std::fill(vals.begin(), vals.end(), 0.0);
+	num_loaded = 0;
+	d.fde->eval(dav, *this, 1);
+	if (num_loaded != (int)load_pos.size())
+		throw DynareException(__FILE__, __LINE__,
+							  "Wrong number of derivatives in DynareSparseJacobian::eval");
+}
+
+void DynareSparseJacobian::load(int i, int iord, const int* vars, double res)
+{
+	if (iord != 1)
+		throw DynareException(__FILE__, __LINE__,
+							  "Derivative order different from order=1 in DynareSparseJacobian::load");
+
+	int t = vars[0];
+	int j = d.getModel().getAtoms().get_pos_of_all(t);
+	int col = -1;
+	if (j < d.nyss())
+		col = j+d.nstat()+d.npred();
+	else if (j < d.nyss()+d.ny())
+		col = j-d.nyss();
+	else if (j < d.nyss()+d.ny()+d.nys())
+		col = j-d.nyss()-d.ny()+d.nstat();
+
+	if (nnz() == 0) {
+		loaded.push_back(std::pair<int,int>(i, col));
+	} else {
+		if (num_loaded >= (int)load_pos.size())
+			throw DynareException(__FILE__, __LINE__,
+								  "Wrong number of derivatives in DynareSparseJacobian::load");
+		int pos = load_pos[num_loaded++];
+		if (pos != -1)
+			vals[pos] += res;
+	}
+}
+
 void DynareVectorFunction::eval(const ConstVector& in, Vector& out)
 {
 	check_for_eval(in, out);
@@ -61,6 +61,7 @@ class Dynare : public DynamicModel {
 	friend class DynareExogNameList;
 	friend class DynareStateNameList;
 	friend class DynareJacobian;
+	friend class DynareSparseJacobian;
 	Journal& journal;
 	ogdyn::DynareModel* model;
 	Vector* ysteady;
@@ -71,6 +72,11 @@ class Dynare : public DynamicModel {
 	ogp::FormulaEvaluator* fe;
 	ogp::FormulaDerEvaluator* fde;
 	const double ss_tol;
+	/** Flag for the sparse solver of the deterministic steady state. */
+	bool ss_sparse;
+	/** Maximum number of Broyden updates of the Jacobian in the
+	 * sparse solver of the deterministic steady state. */
+	int ss_jac_reuse;
 public:
 	/** Parses the given model file and uses the given order to
 	 * override order from the model file (if it is != -1). */
@@ -131,6 +137,11 @@ public:
 		{return *ysteady;}
 	const ogdyn::DynareModel& getModel() const
 		{return *model;}
+	/** Sets the solver of the deterministic steady state. If sparse
+	 * is true, the Jacobian is sparse and reused for at most
+	 * jac_reuse Broyden updates. */
+	void setSteadySolver(bool sparse, int jac_reuse)
+		{ss_sparse = sparse; ss_jac_reuse = jac_reuse;}
 
 	// here is true public interface
 	void solveDeterministicSteady(Vector& steady);
@@ -139,6 +150,8 @@ public:
 	void evaluateSystem(Vector& out, const Vector& yy, const Vector& xx);
 	void evaluateSystem(Vector& out, const Vector& yym, const Vector& yy,
 						const Vector& yyp, const Vector& xx);
+	void evaluateSystemBlock(GeneralMatrix& out, const Vector& yym, const Vector& yy,
+							 const GeneralMatrix& yyp, const Vector& xx);
 	void calcDerivatives(const Vector& yy, const Vector& xx);
 	void calcDerivativesAtSteady();
 
@@ -175,6 +188,29 @@ public:
 	void eval(const Vector& in);
 };
 
+/** This is the sparse counterpart of DynareJacobian. The pattern is
+ * given by the first order derivatives stored in the
+ * FormulaDerivatives, it is set at the first evaluation. Since the
+ * derivatives are always loaded in the same order, we remember the
+ * position in the sparse Jacobian of each loaded derivative. */
+class DynareSparseJacobian : public ogu::SparseJacobian, public ogp::FormulaDerEvalLoader {
+protected:
+	Dynare& d;
+	/** The (row, column) of each loaded derivative during the first
+	 * evaluation, the column is -1 for derivatives wrt exogenous
+	 * variables. */
+	vector<std::pair<int,int> > loaded;
+	/** The position in vals of each loaded derivative, or -1. */
+	vector<int> load_pos;
+	/** The number of derivatives loaded so far in the evaluation. */
+	int num_loaded;
+public:
+	DynareSparseJacobian(Dynare& dyn);
+	virtual ~DynareSparseJacobian() {}
+	void load(int i, int iord, const int* vars, double res);
+	void eval(const Vector& in);
+};
+
 class DynareVectorFunction : public ogu::VectorFunction {
 protected:
 	Dynare& d;
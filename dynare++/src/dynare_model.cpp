@@ -527,6 +527,8 @@ void DynareParser::parse_glob(int length, const char* stream)
 	strncpy(buffer, stream, length);
 	buffer[length] = '\0';
 	buffer[length+1] = '\0';
+	dynglob_lloc.off = 0;
+	dynglob_lloc.ll = 0;
 	void* p = dynglob__scan_buffer(buffer, (unsigned int)length+2);
 	dynare_parser = this;
 	dynglob_parse();
@@ -18,6 +18,7 @@ const char* help_str =
 "    --sim <num>          number of simulations [80]\n"
 "    --rtper <num>        number of RT periods simulated after burnt [0]\n"
 "    --rtsim <num>        number of RT simulations [0]\n"
+"    --rtlags <num>       number of lags of RT autocovariances [0]\n"
 "    --condper <num>      number of periods in cond. simulations [0]\n"
 "    --condsim <num>      number of conditional simulations [0]\n"
 "    --steps <num>        steps towards stoch. SS [0=deter.]\n"
@@ -28,6 +29,8 @@ const char* help_str =
 "    --order <num>        order of approximation [no default]\n"
 "    --threads <num>      number of max parallel threads [2]\n"
 "    --ss-tol <num>       steady state calcs tolerance [1.e-13]\n"
+"    --ss-sparse          sparse Jacobian in steady state calcs [dense]\n"
+"    --ss-jac-reuse <num> max iterations reusing sparse Jacobian [0]\n"
 "    --check pesPES       check model residuals [no checks]\n"
 "                         lower/upper case switches off/on\n"
 "                           pP  checking along simulation path\n"
@@ -39,6 +42,9 @@ const char* help_str =
 "    --no-irfs            shuts down IRF simulations [do IRFs]\n"
 "    --irfs               performs IRF simulations [do IRFs]\n"
 "    --qz-criterium <num> threshold for stable eigenvalues [1.000001]\n"
+"    --fo-solver <str>    first order solver: qz, cr (cyclic reduction),\n"
+"                         lr (logarithmic reduction) [qz]\n"
+"    --fo-tol <num>       tolerance of cyclic/logarithmic reduction [1.e-10]\n"
 "\n\n";
 
 // returns the pointer to the first character after the last slash or
@@ -47,13 +53,15 @@ const char* dyn_basename(const char* str);
 
 DynareParams::DynareParams(int argc, char** argv)
 	: modname(NULL), num_per(100), num_burn(0), num_sim(80), 
-	  num_rtper(0), num_rtsim(0),
+	  num_rtper(0), num_rtsim(0), num_rtlags(0),
 	  num_condper(0), num_condsim(0),
 	  num_threads(2), num_steps(0),
 	  prefix("dyn"), seed(934098), order(-1), ss_tol(1.e-13),
+	  ss_sparse(false), ss_jac_reuse(0),
 	  check_along_path(false), check_along_shocks(false),
 	  check_on_ellipse(false), check_evals(1000), check_num(10), check_scale(2.0),
 	  do_irfs_all(true), do_centralize(true), qz_criterium(1.0+1e-6),
+	  fo_solver(0), fo_tol(1.e-10),
 	  help(false), version(false)
 {
 	if (argc == 1 || !strcmp(argv[1],"--help")) {
@@ -78,6 +86,7 @@ DynareParams::DynareParams(int argc, char** argv)
 		{"rtper", required_argument, NULL, opt_rtper},
 		{"rtsimulations", required_argument, NULL, opt_rtsim},
 		{"rtsim", required_argument, NULL, opt_rtsim},
+		{"rtlags", required_argument, NULL, opt_rtlags},
 		{"condperiods", required_argument, NULL, opt_condper},
 		{"condper", required_argument, NULL, opt_condper},
 		{"condsimulations", required_argument, NULL, opt_condsim},
@@ -88,11 +97,15 @@ DynareParams::DynareParams(int argc, char** argv)
 		{"seed", required_argument, NULL, opt_seed},
 		{"order", required_argument, NULL, opt_order},
 		{"ss-tol", required_argument, NULL, opt_ss_tol},
+		{"ss-sparse", no_argument, NULL, opt_ss_sparse},
+		{"ss-jac-reuse", required_argument, NULL, opt_ss_jac_reuse},
 		{"check", required_argument, NULL, opt_check},
 		{"check-scale", required_argument, NULL, opt_check_scale},
 		{"check-evals", required_argument, NULL, opt_check_evals},
 		{"check-num", required_argument, NULL, opt_check_num},
 		{"qz-criterium",required_argument, NULL, opt_qz_criterium},
+		{"fo-solver", required_argument, NULL, opt_fo_solver},
+		{"fo-tol", required_argument, NULL, opt_fo_tol},
 		{"no-irfs", no_argument, NULL, opt_noirfs},
 		{"irfs", no_argument, NULL, opt_irfs},
 		{"centralize", no_argument, NULL, opt_centralize},
@@ -126,6 +139,10 @@ DynareParams::DynareParams(int argc, char** argv)
 			if (1 != sscanf(optarg, "%d", &num_rtsim))
 				fprintf(stderr, "Couldn't parse integer %s, ignored\n", optarg);
 			break;
+		case opt_rtlags:
+			if (1 != sscanf(optarg, "%d", &num_rtlags))
+				fprintf(stderr, "Couldn't parse integer %s, ignored\n", optarg);
+			break;
 		case opt_condper:
 			if (1 != sscanf(optarg, "%d", &num_condper))
 				fprintf(stderr, "Couldn't parse integer %s, ignored\n", optarg);
@@ -157,6 +174,13 @@ DynareParams::DynareParams(int argc, char** argv)
 			if (1 != sscanf(optarg, "%lf", &ss_tol))
 				fprintf(stderr, "Couldn't parse float %s, ignored\n", optarg);
 			break;
+		case opt_ss_sparse:
+			ss_sparse = true;
+			break;
+		case opt_ss_jac_reuse:
+			if (1 != sscanf(optarg, "%d", &ss_jac_reuse))
+				fprintf(stderr, "Couldn't parse integer %s, ignored\n", optarg);
+			break;
 		case opt_check:
 			processCheckFlags(optarg);
 			break;
@@ -193,6 +217,20 @@ DynareParams::DynareParams(int argc, char** argv)
 			if (1 != sscanf(optarg, "%lf", &qz_criterium))
 				fprintf(stderr, "Couldn't parse float %s, ignored\n", optarg);
 			break;
+		case opt_fo_solver:
+			if (!strcmp(optarg, "qz"))
+				fo_solver = 0;
+			else if (!strcmp(optarg, "cr"))
+				fo_solver = 1;
+			else if (!strcmp(optarg, "lr"))
+				fo_solver = 2;
+			else
+				fprintf(stderr, "Unknown first order solver %s, ignored\n", optarg);
+			break;
+		case opt_fo_tol:
+			if (1 != sscanf(optarg, "%lf", &fo_tol))
+				fprintf(stderr, "Couldn't parse float %s, ignored\n", optarg);
+			break;
 		case opt_help:
 			help = true;
 			break;
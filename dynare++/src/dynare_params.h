@@ -21,6 +21,7 @@ struct DynareParams {
 	int num_sim;
 	int num_rtper;
 	int num_rtsim;
+	int num_rtlags;
 	int num_condper;
 	int num_condsim;
 	int num_threads;
@@ -30,6 +31,11 @@ struct DynareParams {
 	int order;
 	/** Tolerance used for steady state calcs. */
 	double ss_tol;
+	/** Flag for the sparse Jacobian in steady state calcs. */
+	bool ss_sparse;
+	/** Maximum number of iterations reusing the sparse Jacobian in
+	 * steady state calcs. */
+	int ss_jac_reuse;
 	bool check_along_path;
 	bool check_along_shocks;
 	bool check_on_ellipse;
@@ -42,6 +48,11 @@ struct DynareParams {
 	std::vector<const char*> irf_list;
 	bool do_centralize;
 	double qz_criterium;
+	/** Solver of the first order approximation: 0 for QZ, 1 for
+	 * cyclic reduction, 2 for logarithmic reduction. */
+	int fo_solver;
+	/** Tolerance of the cyclic and logarithmic reductions. */
+	double fo_tol;
 	bool help;
 	bool version;
 	DynareParams(int argc, char** argv);
@@ -57,12 +68,13 @@ struct DynareParams {
 	int getCheckPathPoints() const
 		{return 10*check_num;}
 private:
-	enum {opt_per, opt_burn, opt_sim, opt_rtper, opt_rtsim, opt_condper, opt_condsim,
+	enum {opt_per, opt_burn, opt_sim, opt_rtper, opt_rtsim, opt_rtlags, opt_condper, opt_condsim,
 		  opt_prefix, opt_threads,
-		  opt_steps, opt_seed, opt_order, opt_ss_tol, opt_check,
+		  opt_steps, opt_seed, opt_order, opt_ss_tol, opt_ss_sparse, opt_ss_jac_reuse, opt_check,
 		  opt_check_along_path, opt_check_along_shocks, opt_check_on_ellipse,
 		  opt_check_evals, opt_check_scale, opt_check_num, opt_noirfs, opt_irfs,
-                  opt_help, opt_version, opt_centralize, opt_no_centralize, opt_qz_criterium};
+                  opt_help, opt_version, opt_centralize, opt_no_centralize, opt_qz_criterium,
+                  opt_fo_solver, opt_fo_tol};
 	void processCheckFlags(const char* flags);
 	/** This gathers strings from argv[optind] and on not starting
 	 * with '-' to the irf_list. It stops one item before the end,
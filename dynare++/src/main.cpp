@@ -38,6 +38,7 @@ int main(int argc, char** argv)
 
 		// make dynare object
 		Dynare dynare(params.modname, params.order, params.ss_tol, journal);
+		dynare.setSteadySolver(params.ss_sparse, params.ss_jac_reuse);
 		// make list of shocks for which we will do IRFs
         vector<int> irf_list_ind;
 		if (params.do_irfs_all)
@@ -89,7 +90,13 @@ int main(int argc, char** argv)
 				 dynare.nstat()+2*dynare.npred()+3*dynare.nboth()+
 				 2*dynare.nforw()+dynare.nexog());
 
-		Approximation app(dynare, journal, params.num_steps, params.do_centralize, params.qz_criterium);
+		FirstOrder::solver_t fo_solver = FirstOrder::qz;
+		if (params.fo_solver == 1)
+			fo_solver = FirstOrder::cycle_reduction;
+		else if (params.fo_solver == 2)
+			fo_solver = FirstOrder::logarithmic_reduction;
+		Approximation app(dynare, journal, params.num_steps, params.do_centralize, params.qz_criterium,
+						  fo_solver, params.fo_tol);
 		try {
 			app.walkStochSteady();
 		} catch (const KordException& e) {
@@ -153,7 +160,8 @@ int main(int argc, char** argv)
 
 		// simulate with real-time statistics
 		if (params.num_rtper > 0 && params.num_rtsim > 0) {
-			RTSimResultsStats rtres(dynare.numeq(), params.num_rtper, params.num_burn);
+			RTSimResultsStats rtres(dynare.numeq(), params.num_rtper, params.num_burn,
+										 params.num_rtlags);
 			rtres.simulate(params.num_rtsim, dr, dynare.getSteady(), dynare.getVcov(), journal);
 			rtres.writeMat(matfd, params.prefix);
 		}
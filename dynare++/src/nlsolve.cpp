@@ -6,9 +6,18 @@
 #include "dynare_exception.h"
 
 #include <cmath>
+#include <algorithm>
 
 using namespace ogu;
 
+/** The relative tolerance of the GMRES solves of the Newton steps in
+ * SparseNLSolver. */
+static const double gmres_tol = 1.e-12;
+/** The maximum number of GMRES iterations of a Newton step. */
+static const int gmres_maxit = 1000;
+/** The GMRES restart. */
+static const int gmres_restart = 50;
+
 /** This should not be greater than DBL_EPSILON^(1/2). */
 double GoldenSectionSearch::tol = 1.e-4;
 
@@ -226,3 +235,325 @@ bool NLSolver::solve(Vector& xx, int& iter)
 
 	return converged;
 }
+
+void SparseJacobian::set_pattern(const vector<std::pair<int,int> >& entries)
+{
+	vector<std::pair<int,int> > ent(entries);
+	for (int i = 0; i < n; i++)
+		ent.push_back(std::pair<int,int>(i, i));
+	std::sort(ent.begin(), ent.end());
+	ent.erase(std::unique(ent.begin(), ent.end()), ent.end());
+
+	rowptr.assign(n+1, 0);
+	colind.resize(ent.size());
+	diag.resize(n);
+	for (unsigned int k = 0; k < ent.size(); k++) {
+		if (ent[k].first < 0 || ent[k].first >= n || ent[k].second < 0 || ent[k].second >= n)
+			throw DynareException(__FILE__, __LINE__,
+								  "Index out of bounds in SparseJacobian::set_pattern");
+		rowptr[ent[k].first+1]++;
+		colind[k] = ent[k].second;
+		if (ent[k].first == ent[k].second)
+			diag[ent[k].first] = k;
+	}
+	for (int i = 0; i < n; i++)
+		rowptr[i+1] += rowptr[i];
+	vals.assign(ent.size(), 0.0);
+	ilu.assign(ent.size(), 0.0);
+}
+
+int SparseJacobian::position(int i, int j) const
+{
+	vector<int>::const_iterator beg = colind.begin()+rowptr[i];
+	vector<int>::const_iterator end = colind.begin()+rowptr[i+1];
+	vector<int>::const_iterator it = std::lower_bound(beg, end, j);
+	if (it == end || *it != j)
+		return -1;
+	return it - colind.begin();
+}
+
+void SparseJacobian::multaVec(Vector& y, const ConstVector& x) const
+{
+	for (int i = 0; i < n; i++) {
+		double sum = 0.0;
+		for (int k = rowptr[i]; k < rowptr[i+1]; k++)
+			sum += vals[k]*x[colind[k]];
+		y[i] += sum;
+	}
+}
+
+void SparseJacobian::multaVecTrans(Vector& y, const ConstVector& x) const
+{
+	for (int i = 0; i < n; i++)
+		for (int k = rowptr[i]; k < rowptr[i+1]; k++)
+			y[colind[k]] += vals[k]*x[i];
+}
+
+/** This is the IKJ variant of the incomplete LU factorization
+ * restricted to the pattern. A zero pivot is replaced by a small
+ * number relative to the norm of the row, so that the preconditioner
+ * is always defined. */
+void SparseJacobian::factorize()
+{
+	ilu = vals;
+	vector<int> pos(n, -1);
+	for (int i = 0; i < n; i++) {
+		double rownorm = 0.0;
+		for (int k = rowptr[i]; k < rowptr[i+1]; k++) {
+			pos[colind[k]] = k;
+			rownorm = std::max(rownorm, std::abs(vals[k]));
+		}
+		for (int k = rowptr[i]; k < diag[i]; k++) {
+			int j = colind[k];
+			ilu[k] /= ilu[diag[j]];
+			for (int kk = diag[j]+1; kk < rowptr[j+1]; kk++)
+				if (pos[colind[kk]] != -1)
+					ilu[pos[colind[kk]]] -= ilu[k]*ilu[kk];
+		}
+		if (std::abs(ilu[diag[i]]) <= 1.e-12*rownorm || ilu[diag[i]] == 0.0)
+			ilu[diag[i]] = (rownorm == 0.0) ? 1.0 : 1.e-8*rownorm;
+		for (int k = rowptr[i]; k < rowptr[i+1]; k++)
+			pos[colind[k]] = -1;
+	}
+}
+
+void SparseJacobian::precond(Vector& x) const
+{
+	for (int i = 0; i < n; i++)
+		for (int k = rowptr[i]; k < diag[i]; k++)
+			x[i] -= ilu[k]*x[colind[k]];
+	for (int i = n-1; i >= 0; i--) {
+		for (int k = diag[i]+1; k < rowptr[i+1]; k++)
+			x[i] -= ilu[k]*x[colind[k]];
+		x[i] /= ilu[diag[i]];
+	}
+}
+
+/** This is the restarted GMRES with the right preconditioning, so
+ * that the residual monitored in the Arnoldi process is the true
+ * residual of the system. */
+bool SparseJacobian::solve(Vector& x, const ConstVector& b, double tol, int maxit) const
+{
+	double bnorm = b.getNorm();
+	if (bnorm == 0.0) {
+		x.zeros();
+		return true;
+	}
+
+	int m = std::min(n, gmres_restart);
+	vector<double> vv((m+1)*n);
+	vector<double> h((m+1)*m);
+	vector<double> cs(m), sn(m), g(m+1), yy(m);
+	Vector r(n);
+	int it = 0;
+	while (true) {
+		// r = b-J*x
+		r = b;
+		r.mult(-1);
+		multaVec(r, x);
+		r.mult(-1);
+		double beta = r.getNorm();
+		if (beta <= tol*bnorm)
+			return true;
+		if (it >= maxit)
+			return false;
+
+		Vector v0(&vv[0], n);
+		v0 = (const Vector&)r;
+		v0.mult(1/beta);
+		g.assign(m+1, 0.0);
+		g[0] = beta;
+		int j = 0;
+		while (j < m && it < maxit) {
+			Vector vj(&vv[j*n], n);
+			Vector w(&vv[(j+1)*n], n);
+			Vector z((const Vector&)vj);
+			precond(z);
+			w.zeros();
+			multaVec(w, z);
+			// modified Gram-Schmidt
+			for (int i = 0; i <= j; i++) {
+				Vector vi(&vv[i*n], n);
+				h[i+j*(m+1)] = w.dot(vi);
+				w.add(-h[i+j*(m+1)], vi);
+			}
+			double hnext = w.getNorm();
+			if (hnext != 0.0)
+				w.mult(1/hnext);
+			// apply previous rotations to the new column, and compute a new one
+			for (int i = 0; i < j; i++) {
+				double tmp = cs[i]*h[i+j*(m+1)] + sn[i]*h[i+1+j*(m+1)];
+				h[i+1+j*(m+1)] = -sn[i]*h[i+j*(m+1)] + cs[i]*h[i+1+j*(m+1)];
+				h[i+j*(m+1)] = tmp;
+			}
+			double hjj = h[j+j*(m+1)];
+			double rho = std::sqrt(hjj*hjj + hnext*hnext);
+			cs[j] = (rho == 0.0) ? 1.0 : hjj/rho;
+			sn[j] = (rho == 0.0) ? 0.0 : hnext/rho;
+			h[j+j*(m+1)] = rho;
+			g[j+1] = -sn[j]*g[j];
+			g[j] = cs[j]*g[j];
+			j++;
+			it++;
+			if (std::abs(g[j]) <= tol*bnorm || hnext == 0.0)
+				break;
+		}
+
+		// solve the triangular system and update x
+		for (int i = j-1; i >= 0; i--) {
+			double sum = g[i];
+			for (int k = i+1; k < j; k++)
+				sum -= h[i+k*(m+1)]*yy[k];
+			yy[i] = (h[i+i*(m+1)] == 0.0) ? 0.0 : sum/h[i+i*(m+1)];
+		}
+		Vector u(n);
+		u.zeros();
+		for (int i = 0; i < j; i++)
+			u.add(yy[i], Vector(&vv[i*n], n));
+		precond(u);
+		x.add(1.0, u);
+	}
+}
+
+void SparseNLSolver::clear_updates()
+{
+	for (unsigned int i = 0; i < bw.size(); i++) {
+		delete bw[i];
+		delete by[i];
+	}
+	bw.clear();
+	by.clear();
+}
+
+bool SparseNLSolver::mult_inv(Vector& xx, const ConstVector& b) const
+{
+	xx.zeros();
+	if (! jacob.solve(xx, b, gmres_tol, gmres_maxit))
+		return false;
+	for (unsigned int i = 0; i < bw.size(); i++)
+		xx.add(ConstVector(*(by[i])).dot(b), *(bw[i]));
+	return true;
+}
+
+double SparseNLSolver::eval(double lambda)
+{
+	Vector xx((const Vector&)x);
+	xx.add(1-lambda, xcauchy);
+	xx.add(lambda, xnewton);
+	Vector ff(func.outDim());
+	func.eval(xx, ff);
+	return ff.dot(ff);
+}
+
+bool SparseNLSolver::solve(Vector& xx, int& iter)
+{
+	JournalRecord rec(journal);
+	rec << "Iter   lambda      residual" << endrec;
+	JournalRecord rec1(journal);
+	rec1 << "---------------------------" << endrec;
+	char tmpbuf[14];
+
+	x = (const Vector&)xx;
+	iter = 0;
+	clear_updates();
+	// setup fx
+	Vector fx(func.outDim());
+	func.eval(x, fx);
+	if (!fx.isFinite())
+		throw DynareException(__FILE__,__LINE__,
+							  "Initial guess does not yield finite residual in SparseNLSolver::solve");
+	bool converged = fx.getMax() < tol;
+	JournalRecord rec2(journal);
+	sprintf(tmpbuf, "%10.6g", fx.getMax());
+	rec2 << iter << "         N/A   " << tmpbuf << endrec;
+	bool refresh = true;
+	int num_evals = 0;
+	while (! converged && iter < max_iter) {
+		// setup Jacobian, unless it is reused with Broyden updates
+		bool fresh = refresh || (int)bw.size() >= jac_reuse;
+		if (fresh) {
+			jacob.eval(x);
+			jacob.factorize();
+			clear_updates();
+			num_evals++;
+		}
+		// calculate newton step, if GMRES does not converge with a
+		// reused Jacobian, refactorize it at x and try once more (with
+		// the Jacobian just evaluated, this would give the same
+		// result), if it fails, give up with the current x
+		bool gmres_ok = mult_inv(xnewton, fx);
+		if (! gmres_ok && ! fresh) {
+			jacob.eval(x);
+			jacob.factorize();
+			clear_updates();
+			num_evals++;
+			gmres_ok = mult_inv(xnewton, fx);
+		}
+		if (! gmres_ok) {
+			JournalRecord recf(journal);
+			recf << "GMRES did not converge for the Newton step" << endrec;
+			break;
+		}
+		xnewton.mult(-1);
+		// calculate cauchy step with the last evaluated Jacobian
+		Vector g(func.inDim());
+		g.zeros();
+		jacob.multaVecTrans(g, fx);
+		Vector Jg(func.inDim());
+		Jg.zeros();
+		jacob.multaVec(Jg, g);
+		double m = -g.dot(g)/Jg.dot(Jg);
+		xcauchy = (const Vector&) g;
+		xcauchy.mult(m);
+
+		// line search
+		double lambda = GoldenSectionSearch::search(*this, 0, 1);
+		Vector s((const Vector&)xcauchy);
+		s.mult(1-lambda);
+		s.add(lambda, xnewton);
+		x.add(1.0, s);
+		// evaluate func
+		Vector fxnew(func.outDim());
+		func.eval(x, fxnew);
+		converged = fxnew.getMax() < tol;
+
+		// if the residual has been halved, the Jacobian can be reused
+		// with a Broyden update
+		refresh = ! (fxnew.getNorm() <= 0.5*fx.getNorm());
+		if (! converged && ! refresh && jac_reuse > 0) {
+			Vector y((const Vector&)fxnew);
+			y.add(-1.0, fx);
+			double yy = y.dot(y);
+			if (yy > 0) {
+				Vector* w = new Vector(func.inDim());
+				if (mult_inv(*w, y)) {
+					w->mult(-1);
+					w->add(1.0, s);
+					w->mult(1/yy);
+					bw.push_back(w);
+					by.push_back(new Vector((const Vector&)y));
+				} else {
+					// GMRES failed, evaluate the Jacobian instead
+					delete w;
+					refresh = true;
+				}
+			}
+		}
+		fx = (const Vector&)fxnew;
+
+		// iter
+		iter++;
+
+		JournalRecord rec3(journal);
+		sprintf(tmpbuf, "%10.6g", fx.getMax());
+		rec3 << iter << "    " << lambda << "   " << tmpbuf << endrec;
+	}
+	clear_updates();
+	xx = (const Vector&)x;
+
+	JournalRecord rec4(journal);
+	rec4 << "Number of Jacobian evaluations: " << num_evals
+		 << ", nonzeros in Jacobian: " << jacob.nnz() << endrec;
+
+	return converged;
+}
@@ -8,8 +8,12 @@
 #include "twod_matrix.h"
 #include "journal.h"
 
+#include <vector>
+
 namespace ogu {
 
+	using std::vector;
+
 	class OneDFunction {
 	public:
 		virtual ~OneDFunction() {}
@@ -58,6 +62,58 @@ namespace ogu {
 		virtual void eval(const Vector& in) = 0;
 	};
 
+	/** This is a square Jacobian stored in the compressed row
+	 * format. The pattern is set by the implementation with
+	 * set_pattern(), the diagonal is always included in the
+	 * pattern. The class provides an incomplete LU factorization with
+	 * no fill-in (ILU(0)), which is used as a preconditioner of a
+	 * restarted GMRES to solve linear systems with the Jacobian. */
+	class SparseJacobian {
+	protected:
+		/** Dimension. */
+		int n;
+		/** Beginnings of the rows in colind and vals, it has n+1 items. */
+		vector<int> rowptr;
+		/** Column indices, increasing within each row. */
+		vector<int> colind;
+		/** Values. */
+		vector<double> vals;
+		/** Incomplete LU factors with the same pattern as vals, the
+		 * unit diagonal of L is not stored. */
+		vector<double> ilu;
+		/** Positions of the diagonal items. */
+		vector<int> diag;
+	public:
+		SparseJacobian(int nn)
+			: n(nn), rowptr(nn+1, 0) {}
+		virtual ~SparseJacobian() {}
+		virtual void eval(const Vector& in) = 0;
+		int nrows() const
+			{return n;}
+		int nnz() const
+			{return (int)colind.size();}
+		/** Computes y = y + J*x. */
+		void multaVec(Vector& y, const ConstVector& x) const;
+		/** Computes y = y + J^T*x. */
+		void multaVecTrans(Vector& y, const ConstVector& x) const;
+		/** Computes the ILU(0) factors of the current values. */
+		void factorize();
+		/** Solves J*x = b by GMRES preconditioned with the ILU(0)
+		 * factors, which must have been computed. The x is used as
+		 * the starting point. Returns true if the relative residual
+		 * is less than tol in at most maxit iterations. */
+		bool solve(Vector& x, const ConstVector& b, double tol, int maxit) const;
+	protected:
+		/** Sets the pattern from the given (row, column) pairs, which
+		 * may contain duplicates. The values are set to zeros. */
+		void set_pattern(const vector<std::pair<int,int> >& entries);
+		/** Returns the position of the (i,j) item in vals, or -1 if
+		 * it is not in the pattern. */
+		int position(int i, int j) const;
+		/** Solves L*U*x = b with the ILU(0) factors in place. */
+		void precond(Vector& x) const;
+	};
+
 	class NLSolver : public OneDFunction {
 	protected:
 		Journal& journal;
@@ -85,6 +141,59 @@ namespace ogu {
 		double eval(double lambda);
 	};
 
+	/** This is the same as NLSolver, but with a sparse Jacobian. The
+	 * Newton step is calculated by GMRES preconditioned with the
+	 * incomplete LU factorization of the Jacobian. In addition, the
+	 * Jacobian can be reused for a number of iterations, during which
+	 * the inverse of the Jacobian is corrected by Broyden's
+	 * (second) rank one updates, which are stored as pairs of vectors
+	 * so that the Jacobian stays sparse. The Jacobian is reevaluated
+	 * after jac_reuse updates or if an iteration did not halve the
+	 * residual. With jac_reuse equal to zero, the Jacobian is
+	 * evaluated at each iteration, as in NLSolver. */
+	class SparseNLSolver : public OneDFunction {
+	protected:
+		Journal& journal;
+		VectorFunction& func;
+		SparseJacobian& jacob;
+		const int max_iter;
+		const double tol;
+		const int jac_reuse;
+	private:
+		Vector xnewton;
+		Vector xcauchy;
+		Vector x;
+		/** The corrections of the Broyden updates, this is s-H*y
+		 * divided by y^T*y, where s is the step, y is the change of
+		 * the residual, and H is the inverse Jacobian before the
+		 * update. */
+		vector<Vector*> bw;
+		/** The changes of the residual of the Broyden updates. */
+		vector<Vector*> by;
+	public:
+		SparseNLSolver(VectorFunction& f, SparseJacobian& j, int maxit, double tl,
+					   int jreuse, Journal& jr)
+			: journal(jr), func(f), jacob(j), max_iter(maxit), tol(tl), jac_reuse(jreuse),
+			  xnewton(f.inDim()), xcauchy(f.inDim()), x(f.inDim())
+			{xnewton.zeros(); xcauchy.zeros(); x.zeros();}
+		virtual ~SparseNLSolver()
+			{clear_updates();}
+		/** Returns true if the problem has converged. xx as input is the
+		 * starting value, as output it is a solution. It returns false
+		 * also if GMRES did not converge for a Newton step even with
+		 * a refactorized Jacobian, xx is then the last iterate. */
+		bool solve(Vector& xx, int& iter);
+		/** The same as NLSolver::eval. */
+		double eval(double lambda);
+	private:
+		/** Computes x = H*b, where H is the inverse of the Jacobian
+		 * corrected by the Broyden updates. Returns false if GMRES
+		 * did not converge, x is then not usable. */
+		bool mult_inv(Vector& x, const ConstVector& b) const;
+		/** Forgets the Broyden updates. */
+		void clear_updates();
+	};
+
 };
 
 #endif
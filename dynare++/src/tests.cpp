@@ -0,0 +1,218 @@
+// Copyright (C) 2015, Dynare Team
+
+#include "dynare3.h"
+#include "dynare_exception.h"
+#include "nlsolve.h"
+
+#include "utils/cc/exception.h"
+#include "parser/cc/parser_exception.h"
+#include "../tl/cc/tl_exception.h"
+#include "../kord/kord_exception.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+/** The directory with the models, given as the first argument. */
+static std::string models_dir("../tests");
+
+class TestRunnable {
+	char name[100];
+public:
+	TestRunnable(const char* n)
+		{strncpy(name, n, 100);}
+	virtual ~TestRunnable() {}
+	bool test() const;
+	virtual bool run() const =0;
+	const char* getName() const
+		{return name;}
+protected:
+	static bool sparse_dense(const char* modname, int jac_reuse);
+};
+
+bool TestRunnable::test() const
+{
+	printf("Running test <%s>\n",name);
+	clock_t start = clock();
+	bool passed = run();
+	clock_t end = clock();
+	printf("CPU time %8.4g (CPU seconds)..................",
+		   ((double)(end-start))/CLOCKS_PER_SEC);
+	if (passed) {
+		printf("passed\n\n");
+		return passed;
+	} else {
+		printf("FAILED\n\n");
+		return passed;
+	}
+}
+
+// Solves the deterministic steady state of the given model with the
+// dense solver and with the sparse one reusing the Jacobian for at
+// most jac_reuse Broyden updates, and compares the two solutions.
+bool TestRunnable::sparse_dense(const char* modname, int jac_reuse)
+{
+	std::string fname = models_dir + "/" + modname;
+	Journal journal("tests.jnl");
+	Dynare dense(fname.c_str(), 1, 1.e-13, journal);
+	dense.solveDeterministicSteady();
+	Dynare sparse(fname.c_str(), 1, 1.e-13, journal);
+	sparse.setSteadySolver(true, jac_reuse);
+	sparse.solveDeterministicSteady();
+
+	Vector diff(sparse.getSteady());
+	diff.add(-1.0, dense.getSteady());
+	double err = diff.getMax()/(1.0+dense.getSteady().getMax());
+	printf("%s: %d variables, jac_reuse=%d, relative difference %g\n",
+		   modname, dense.ny(), jac_reuse, err);
+	return err < 1.e-9;
+}
+
+/** This is a linear function J*x-b with a 3x3 sparse J whose items
+ * (1,2) and (2,1) are not in the pattern, so that its ILU(0) factors
+ * drop the fill there and are not the LU factors. With c=1, J is
+ * singular and b is not in its range, so GMRES cannot converge,
+ * although the ILU(0) factors are regular. */
+class LinearFunction : public ogu::VectorFunction, public ogu::SparseJacobian {
+	double c;
+public:
+	LinearFunction(double cc)
+		: ogu::SparseJacobian(3), c(cc)
+		{
+			vector<std::pair<int,int> > entries;
+			entries.push_back(std::pair<int,int>(0,0));
+			entries.push_back(std::pair<int,int>(0,1));
+			entries.push_back(std::pair<int,int>(0,2));
+			entries.push_back(std::pair<int,int>(1,0));
+			entries.push_back(std::pair<int,int>(2,0));
+			set_pattern(entries);
+		}
+	int inDim() const
+		{return 3;}
+	int outDim() const
+		{return 3;}
+	void eval(const ConstVector& in, Vector& out)
+		{
+			check_for_eval(in, out);
+			out[0] = 2*in[0] + in[1] + in[2] - 1;
+			out[1] = in[0] + in[1];
+			out[2] = in[0] + c*in[2];
+		}
+	void eval(const Vector& in)
+		{
+			vals[position(0,0)] = 2;
+			vals[position(0,1)] = 1;
+			vals[position(0,2)] = 1;
+			vals[position(1,0)] = 1;
+			vals[position(1,1)] = 1;
+			vals[position(2,0)] = 1;
+			vals[position(2,2)] = c;
+		}
+};
+
+/****************************************************/
+/*     test classes                                 */
+/****************************************************/
+
+class SparseDenseSmall : public TestRunnable {
+public:
+	SparseDenseSmall() : TestRunnable("sparse vs. dense steady state (example1)") {}
+	bool run() const
+		{return sparse_dense("example1.mod", 0) && sparse_dense("example1.mod", 5);}
+};
+
+class SparseDensePortfolio : public TestRunnable {
+public:
+	SparseDensePortfolio() : TestRunnable("sparse vs. dense steady state (portfolio)") {}
+	bool run() const
+		{return sparse_dense("portfolio.mod", 0) && sparse_dense("portfolio.mod", 5);}
+};
+
+class SparseLinear : public TestRunnable {
+public:
+	SparseLinear() : TestRunnable("sparse solver on a regular linear system") {}
+	bool run() const
+		{
+			Journal journal("tests.jnl");
+			LinearFunction f(2.0);
+			ogu::SparseNLSolver nls(f, f, 100, 1.e-12, 0, journal);
+			Vector x(3);
+			x.zeros();
+			int iter;
+			bool converged = nls.solve(x, iter);
+			Vector res(3);
+			f.eval(ConstVector(x), res);
+			printf("converged=%d after %d iterations, residual %g\n",
+				   converged, iter, res.getMax());
+			return converged && res.getMax() < 1.e-12;
+		}
+};
+
+class SparseGmresFailure : public TestRunnable {
+public:
+	SparseGmresFailure() : TestRunnable("sparse solver with failing GMRES") {}
+	bool run() const
+		{
+			Journal journal("tests.jnl");
+			LinearFunction f(1.0);
+			ogu::SparseNLSolver nls(f, f, 100, 1.e-12, 5, journal);
+			Vector x(3);
+			x.zeros();
+			int iter;
+			bool converged = nls.solve(x, iter);
+			// the solver must give up at the starting point instead
+			// of stepping along a GMRES iterate
+			printf("converged=%d after %d iterations, x=(%g,%g,%g)\n",
+				   converged, iter, x[0], x[1], x[2]);
+			return ! converged && iter == 0 && x.isFinite() && x.getMax() == 0.0;
+		}
+};
+
+int main(int argc, char** argv)
+{
+	if (argc > 1)
+		models_dir = argv[1];
+
+	TestRunnable* all_tests[50];
+	// fill in vector of all tests
+	int num_tests = 0;
+	all_tests[num_tests++] = new SparseLinear();
+	all_tests[num_tests++] = new SparseGmresFailure();
+	all_tests[num_tests++] = new SparseDenseSmall();
+	all_tests[num_tests++] = new SparseDensePortfolio();
+
+	// launch the tests
+	int success = 0;
+	for (int i = 0; i < num_tests; i++) {
+		try {
+			if (all_tests[i]->test())
+				success++;
+		} catch (const DynareException& e) {
+			printf("Caught Dynare exception in <%s>: %s\n", all_tests[i]->getName(), e.message());
+		} catch (const ogu::Exception& e) {
+			printf("Caught exception in <%s>:\n", all_tests[i]->getName());
+			e.print();
+		} catch (const ogp::ParserException& e) {
+			printf("Caught parser exception in <%s>:\n", all_tests[i]->getName());
+			e.print(stdout);
+		} catch (const TLException& e) {
+			printf("Caught TL exception in <%s>:\n", all_tests[i]->getName());
+			e.print();
+		} catch (const KordException& e) {
+			printf("Caught Kord exception in <%s>:\n", all_tests[i]->getName());
+			e.print();
+		}
+	}
+
+	printf("There were %d tests that failed out of %d tests run.\n",
+		   num_tests - success, num_tests);
+
+	// destroy
+	for (int i = 0; i < num_tests; i++) {
+		delete all_tests[i];
+	}
+
+	return (success == num_tests) ? 0 : 1;
+}
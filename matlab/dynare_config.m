@@ -135,6 +135,9 @@ mex_status(4,3) = {'Sparse kronecker products'};
 mex_status(5,1) = {'local_state_space_iteration_2'};
 mex_status(5,2) = {'reduced_form_models/local_state_space_iteration_2'};
 mex_status(5,3) = {'Local state space iteration (second order)'};
+mex_status(6,1) = {'local_state_space_iteration_k'};
+mex_status(6,2) = {'reduced_form_models/local_state_space_iteration_k'};
+mex_status(6,3) = {'Local state space iteration (order k)'};
 number_of_mex_files = size(mex_status,1);
 
 % Remove some directories from matlab's path. This is necessary if the user has
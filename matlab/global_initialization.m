@@ -77,6 +77,11 @@ options_.huge_number = 1e7;
 options_.threads.kronecker.A_times_B_kronecker_C = 1;
 options_.threads.kronecker.sparse_hessian_times_B_kronecker_C = 1;
 options_.threads.local_state_space_iteration_2 = 1;
+options_.threads.local_state_space_iteration_k = 1;
+options_.threads.particle_filter_step = 1;
+options_.threads.k_order_perturbation = 2;
+% Zero the large tensors of k_order_perturbation in the threads (first touch policy, for NUMA machines).
+options_.threads.k_order_perturbation_first_touch = 0;
 
 % steady state
 options_.jacobian_flag = 1;
@@ -73,7 +73,23 @@ switch(order)
     dr.g_2 = g_2;
     dr.g_3 = g_3;
   otherwise
-    error('order > 3 isn''t implemented')
+    % The derivatives of the model of order 4 and above are computed by the
+    % DLL generated by the preprocessor with the use_dll option
+    if ~options.use_dll
+        error('order > 3 requires the use_dll option')
+    end
+    g = cell(1, order+1);
+    [err, g{:}] = k_order_perturbation(dr,M,options);
+    if err
+      info(1)=9;
+      return;
+    end
+    g_0 = g{1};
+    g_1 = g{2};
+    g_2 = g{3};
+    for i = 0:order
+        dr.(['g_' int2str(i)]) = g{i+1};
+    end
 end
 
 % Now fill in dr.ghx, dr.ghu...
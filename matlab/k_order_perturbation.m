@@ -48,6 +48,18 @@
 %                         tensor. Symmetric derivatives are repeated. The
 %                         Taylor coefficients (1/2 and 1/6) aren't
 %                         included.
+%
+% The solver can be kept alive between calls, for instance when only the
+% parameters change during an estimation:
+%   [err, h] = k_order_perturbation('open',dr,DynareModel,DynareOptions)
+% loads the dynamic model and builds the index permutations, the tensor
+% tables and the derivative buffers once, and returns a handle h. Then
+%   [err, g_0, g_1, ...] = k_order_perturbation(h,dr,DynareModel)
+% solves the model for the current values of DynareModel.params,
+% DynareModel.Sigma_e and dr.ys, with the same outputs as above, and
+%   err = k_order_perturbation('close',h)
+% releases the handle.
+%
 % k_order_peturbation is a compiled MEX function. It's source code is in
 % dynare/mex/sources/k_order_perturbation.cc and it uses code provided by
 % dynare++
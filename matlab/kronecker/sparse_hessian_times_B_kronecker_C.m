@@ -33,6 +33,8 @@ function [D, err] = sparse_hessian_times_B_kronecker_C(varargin)
 %! [1] This routine is called by Dynare if and only the mex version is not compiled (also used for testing purposes).
 %! @sp 1
 %! [2] This routine can be called with three or four arguments. In the first case A*kron(B,B) is computed.
+%! @sp 1
+%! [3] If the fourth argument is 'folded', A*kron(B,B) is computed and only the columns (j1,j2) with j1<=j2 are returned (in lexicographic order).
 %! @sp 2
 %! @strong{This function is called by:}
 %! @sp 1
@@ -45,7 +47,7 @@ function [D, err] = sparse_hessian_times_B_kronecker_C(varargin)
 %! @end deftypefn
 %@eod:
 
-% Copyright (C) 1996-2012 Dynare Team
+% Copyright (C) 1996-2015 Dynare Team
 %
 % This file is part of Dynare.
 %
@@ -69,6 +71,18 @@ B = varargin{2};
 C = varargin{3};
 fake = varargin{nargin};
 
+if nargin==4 && ischar(varargin{4})
+    if ~strcmp(varargin{4},'folded')
+        error('The fourth argument must be the number of threads or ''folded''!')
+    end
+    [D, fake] = A_times_B_kronecker_C(A,B,C);
+    nB = size(B,2);
+    [j2,j1] = find(triu(ones(nB))');
+    D = D(:,(j1-1)*nB+j2);
+    err = 0;
+    return
+end
+
 switch nargin
   case 4
     [D, fake] = A_times_B_kronecker_C(A,B,C,fake);
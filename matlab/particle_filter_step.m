@@ -0,0 +1,250 @@
+% h = particle_filter_step('open',constant,g,gs,ys,istates,mf,H,particles,options)
+% [lik, ess, resampled] = particle_filter_step(h,epsilon,yobs,u)
+% [particles, weights] = particle_filter_step('get',h)
+% particle_filter_step('close',h)
+%
+% performs the steps of a bootstrap particle filter over a swarm of
+% particles kept by the MEX file between the calls: propagation of the
+% particles, evaluation of the density of the measurement errors, update
+% and normalization of the weights, and resampling.
+%
+% INPUTS ('open')
+% constant:      vector   m*1, deterministic steady state plus constant of
+%                         the decision rule (unused with pruning), where m
+%                         is the number of states and observed variables
+% g:             cell     1*k, folded tensors of the decision rule of
+%                         order 1 to k (see local_state_space_iteration_k)
+% gs:            cell     folded tensors of the terms in sigma^2 of the
+%                         decision rule with pruning (see
+%                         local_state_space_iteration_k). If gs is not a
+%                         cell (for instance []), pruning is not used
+% ys:            vector   m*1, deterministic steady state
+% istates:       vector   indices of the n states in the m variables
+% mf:            vector   indices of the p observed variables in the m
+%                         variables
+% H:             matrix   p*p, covariance matrix of the measurement errors
+%                         (positive definite)
+% particles:     matrix   n*s, initial particles in deviation from the
+%                         steady state (n*s*k array of their k components
+%                         with pruning)
+% options:       struct   [optional] fields resampling ('systematic'
+%                         (default), 'stratified' or 'residual'),
+%                         threshold (the particles are resampled if the
+%                         effective sample size is lower than threshold*s,
+%                         default 0.5) and threads (number of threads,
+%                         default 1, see options_.threads.particle_filter_step)
+%
+% INPUTS (step)
+% h:             double   handle returned by 'open'
+% epsilon:       matrix   q*s, innovations of the particles
+% yobs:          vector   p*1, observations
+% u:             vector   uniform draws for the resampling: s draws for the
+%                         stratified resampling, one draw otherwise
+%
+% OUTPUTS (step)
+% lik:           double   log-likelihood of yobs (-Inf if the density of
+%                         the observations is zero for all the particles,
+%                         the weights are then left unchanged, but the
+%                         particles are still replaced by the propagated
+%                         states)
+% ess:           double   effective sample size before the resampling
+% resampled:     logical  true if the particles were resampled
+%
+% The reductions over the particles are computed over chunks of fixed
+% size, so the results do not depend on the number of threads. The random
+% draws are given by the caller, so the results only depend on the state
+% of the random number generator of MATLAB.
+%
+% particle_filter_step is a compiled MEX function. Its source code is in
+% dynare/mex/sources/local_state_space_iterations/particle_filter_step.cc
+
+% Copyright (C) 2015 Dynare Team
+%
+% This file is part of Dynare.
+%
+% Dynare is free software: you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation, either version 3 of the License, or
+% (at your option) any later version.
+%
+% Dynare is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details.
+%
+% You should have received a copy of the GNU General Public License
+% along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+
+%@test:1
+%$ % Compare a step with resampling with a particle filter step written in MATLAB, for the three resampling methods.
+%$ m = 4;
+%$ n = 2;
+%$ q = 2;
+%$ p = 2;
+%$ s = 5000;
+%$ istates = [1; 3];
+%$ mf = [2; 4];
+%$ ys = [1; 2; 3; 4];
+%$ constant = ys+.01*randn(m,1);
+%$ g = {.5*rand(m,n+q)};
+%$ H = .1*eye(p)+.01*ones(p);
+%$ particles = .1*randn(n,s);
+%$ epsilon = .1*randn(q,s);
+%$ yobs = ys(mf)+.1*randn(p,1);
+%$
+%$ % Reference propagation, log-sum-exp likelihood and effective sample size.
+%$ y = bsxfun(@plus,constant,g{1}*[particles; epsilon]);
+%$ e = bsxfun(@minus,yobs,y(mf,:));
+%$ lnw = log(1/s)-.5*p*log(2*pi)-.5*log(det(H))-.5*sum(e.*(H\e),1);
+%$ mx = max(lnw);
+%$ w = exp(lnw-mx);
+%$ lik0 = mx+log(sum(w));
+%$ w = w/sum(w);
+%$ ess0 = 1/sum(w.^2);
+%$
+%$ methods = {'systematic', 'stratified', 'residual'};
+%$ t = true(5,3);
+%$ for i=1:3
+%$     if strcmp(methods{i},'stratified')
+%$         u = rand(1,s);
+%$     else
+%$         u = rand;
+%$     end
+%$
+%$     % Call the tested routine (with threshold=1 the particles are resampled).
+%$     h = particle_filter_step('open',constant,g,[],ys,istates,mf,H,particles,struct('resampling',methods{i},'threshold',1));
+%$     [lik, ess, resampled] = particle_filter_step(h,epsilon,yobs,u);
+%$     [newparticles, weights] = particle_filter_step('get',h);
+%$     particle_filter_step('close',h);
+%$
+%$     % Reference resampling: particle j is drawn for the positions x such that c(j-1)<=x<c(j), where c is the
+%$     % cumulative sum of the weights (of the residual weights, after the copies, for the residual resampling).
+%$     if strcmp(methods{i},'residual')
+%$         k = floor(s*w);
+%$         idx = zeros(1,0);
+%$         for j=1:s
+%$             idx = [idx j*ones(1,k(j))];
+%$         end
+%$         c = cumsum(s*w-k);
+%$     else
+%$         idx = zeros(1,0);
+%$         c = cumsum(w);
+%$     end
+%$     r = s-length(idx);
+%$     x = ((0:r-1)+u)*c(end)/r;
+%$     idx = [idx min(sum(bsxfun(@le,c',x),1)+1,s)];
+%$
+%$     % Check the results.
+%$     t(1,i) = dassert(lik,lik0,1e-12);
+%$     t(2,i) = dassert(ess,ess0,1e-9);
+%$     t(3,i) = resampled;
+%$     t(4,i) = dassert(newparticles,bsxfun(@minus,y(istates,idx),ys(istates)),1e-12);
+%$     t(5,i) = dassert(weights,ones(1,s)/s,1e-15);
+%$ end
+%$ T = all(t(:));
+%@eof:1
+
+%@test:2
+%$ % Two steps without resampling, then a step where the density of the observations is zero for all the particles.
+%$ m = 4;
+%$ n = 2;
+%$ q = 2;
+%$ p = 2;
+%$ s = 100;
+%$ istates = [1; 3];
+%$ mf = [2; 4];
+%$ ys = [1; 2; 3; 4];
+%$ constant = ys+.01*randn(m,1);
+%$ g = {.5*rand(m,n+q)};
+%$ H = .1*eye(p)+.01*ones(p);
+%$ particles = .1*randn(n,s);
+%$ epsilon = .1*randn(q,s,3);
+%$ yobs = bsxfun(@plus,ys(mf),.1*randn(p,2));
+%$
+%$ % Call the tested routine (with threshold=0 the particles are never resampled).
+%$ h = particle_filter_step('open',constant,g,[],ys,istates,mf,H,particles,struct('threshold',0));
+%$ lik = zeros(1,2);
+%$ ess = zeros(1,2);
+%$ resampled = true(1,2);
+%$ for i=1:2
+%$     [lik(i), ess(i), resampled(i)] = particle_filter_step(h,epsilon(:,:,i),yobs(:,i),rand);
+%$ end
+%$ [newparticles, weights] = particle_filter_step('get',h);
+%$ lik3 = particle_filter_step(h,epsilon(:,:,3),[Inf; 0],rand);
+%$ [newparticles3, weights3] = particle_filter_step('get',h);
+%$ particle_filter_step('close',h);
+%$
+%$ % Reference steps, the weights being carried over.
+%$ lik0 = zeros(1,2);
+%$ ess0 = zeros(1,2);
+%$ yhat = particles;
+%$ w = ones(1,s)/s;
+%$ for i=1:2
+%$     y = bsxfun(@plus,constant,g{1}*[yhat; epsilon(:,:,i)]);
+%$     yhat = bsxfun(@minus,y(istates,:),ys(istates));
+%$     e = bsxfun(@minus,yobs(:,i),y(mf,:));
+%$     lnw = log(w)-.5*p*log(2*pi)-.5*log(det(H))-.5*sum(e.*(H\e),1);
+%$     mx = max(lnw);
+%$     w = exp(lnw-mx);
+%$     lik0(i) = mx+log(sum(w));
+%$     w = w/sum(w);
+%$     ess0(i) = 1/sum(w.^2);
+%$ end
+%$ y = bsxfun(@plus,constant,g{1}*[yhat; epsilon(:,:,3)]);
+%$
+%$ % Check the results: in the last step, the particles are propagated but the weights are unchanged.
+%$ t(1) = dassert(lik,lik0,1e-12);
+%$ t(2) = dassert(ess,ess0,1e-9);
+%$ t(3) = ~any(resampled);
+%$ t(4) = dassert(newparticles,yhat,1e-12);
+%$ t(5) = dassert(weights,w,1e-12);
+%$ t(6) = isequal(lik3,-Inf);
+%$ t(7) = isequal(weights3,weights);
+%$ t(8) = dassert(newparticles3,bsxfun(@minus,y(istates,:),ys(istates)),1e-12);
+%$ T = all(t);
+%@eof:2
+
+%@test:3
+%$ % The results do not depend on the number of threads (several chunks of particles, with pruning).
+%$ m = 4;
+%$ n = 2;
+%$ q = 2;
+%$ p = 2;
+%$ s = 10000;
+%$ istates = [1; 3];
+%$ mf = [2; 4];
+%$ ys = [1; 2; 3; 4];
+%$ g = {.5*rand(m,n+q), .1*rand(m,nchoosek(n+q+1,2))};
+%$ gs = {.01*rand(m,1)};
+%$ H = .1*eye(p)+.01*ones(p);
+%$ particles = .1*randn(n,s,2);
+%$ epsilon = .1*randn(q,s,2);
+%$ yobs = bsxfun(@plus,ys(mf),.1*randn(p,2));
+%$ u = rand(s,2);
+%$
+%$ methods = {'systematic', 'stratified', 'residual'};
+%$ t = true(1,3);
+%$ for i=1:3
+%$     res = cell(1,2);
+%$     threads = [1 3];
+%$     for k=1:2
+%$         % Call the tested routine.
+%$         h = particle_filter_step('open',ys,g,gs,ys,istates,mf,H,particles,struct('resampling',methods{i},'threshold',1,'threads',threads(k)));
+%$         for j=1:2
+%$             if strcmp(methods{i},'stratified')
+%$                 uj = u(:,j);
+%$             else
+%$                 uj = u(1,j);
+%$             end
+%$             [lik, ess, resampled] = particle_filter_step(h,epsilon(:,:,j),yobs(:,j),uj);
+%$             [newparticles, weights] = particle_filter_step('get',h);
+%$             res{k} = [res{k} {lik, ess, resampled, newparticles, weights}];
+%$         end
+%$         particle_filter_step('close',h);
+%$     end
+%$
+%$     % Check the results.
+%$     t(i) = isequal(res{1},res{2});
+%$ end
+%$ T = all(t);
+%@eof:3
@@ -0,0 +1,235 @@
+function [y,y_] = local_state_space_iteration_k(yhat,epsilon,constant,g,a,b)%gs,numthreads)
+
+%@info:
+%! @deftypefn {Function File} {@var{y}, @var{y_} =} local_state_space_iteration_k (@var{yhat},@var{epsilon}, @var{constant}, @var{g}, @var{gs}, @var{numthreads})
+%! @anchor{particle/local_state_space_iteration_k}
+%! @sp 1
+%! Given the states (y) and structural innovations (epsilon), this routine computes the level of selected endogenous variables when the
+%! model is approximated by a taylor expansion of order k around the deterministic steady state. The decision rule is given by folded
+%! tensors: each column corresponds to a non decreasing sequence of indices of the variables [yhat;epsilon] (in lexicographic order), and
+%! the Taylor coefficients are included (as in dr.g_1, dr.g_2, ... returned by k_order_perturbation). Depending on the number of
+%! input/output arguments the pruning algorithm is used or not. With pruning, the states are split into k components of order 1 to k,
+%! and the terms in the perturbation parameter are given separately.
+%!
+%! @sp 2
+%! @strong{Inputs}
+%! @sp 1
+%! @table @ @var
+%! @item yhat
+%! n*s matrix of doubles, initial condition, where n is the number of state variables and s the number of particles. With pruning,
+%! n*s*k array of doubles, the k components of the states (in deviation from the steady state).
+%! @item epsilon
+%! q*s matrix of doubles, structural innovations.
+%! @item constant
+%! m*1 vector of doubles, deterministic steady state plus constant of the decision rule for a subset of endogenous variables (deterministic
+%! steady state only with pruning).
+%! @item g
+%! 1*k cell array, g@{d@} is the m*nchoosek(n+q+d-1,d) folded tensor of order d of the decision rule, restricted to the lines of a
+%! subset of endogenous variables. With pruning, the derivatives are taken with respect to the states and innovations only.
+%! @item gs
+%! cell array of length lower than k, gs@{d+1@} is the m*nchoosek(n+q+d-1,d) folded tensor of the terms in sigma^2 z^d (pruning only,
+%! for instance gs@{1@} = dr.ghs2/2 at second order).
+%! @item numthreads
+%! integer scalar, number of threads used by the mex file.
+%! @end table
+%! @sp 2
+%! @strong{Outputs}
+%! @sp 1
+%! @table @ @var
+%! @item y
+%! m*s matrix of doubles, selected endogenous variables.
+%! @item y_
+%! m*s*k array of doubles, update of the k components of the selected endogenous variables (pruning only).
+%! @end table
+%! @sp 2
+%! @strong{Remarks}
+%! @sp 1
+%! [1] If the function has 6 input arguments then it must have 2 output arguments (pruning version).
+%! @sp 1
+%! [2] If the function has 5 input arguments then it must have 1 output argument.
+%! @sp 2
+%! @strong{This function is called by:}
+%! @sp 2
+%! @strong{This function calls:}
+%!
+%!
+%! @end deftypefn
+%@eod:
+
+% Copyright (C) 2015 Dynare Team
+%
+% This file is part of Dynare.
+%
+% Dynare is free software: you can redistribute it and/or modify
+% it under the terms of the GNU General Public License as published by
+% the Free Software Foundation, either version 3 of the License, or
+% (at your option) any later version.
+%
+% Dynare is distributed in the hope that it will be useful,
+% but WITHOUT ANY WARRANTY; without even the implied warranty of
+% MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+% GNU General Public License for more details.
+%
+% You should have received a copy of the GNU General Public License
+% along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+
+if nargin==5
+    pruning = 0;
+    if nargout>1
+        error('local_state_space_iteration_k:: Numbers of input and output argument are inconsistent!')
+    end
+elseif nargin==6
+    pruning = 1; gs = a;
+    if nargout~=2
+        error('local_state_space_iteration_k:: Numbers of input and output argument are inconsistent!')
+    end
+else
+    error('local_state_space_iteration_k:: Wrong number of input arguments!')
+end
+
+order = length(g);
+n = size(yhat,1);
+q = size(epsilon,1);
+s = size(epsilon,2);
+m = size(constant,1);
+
+[parent,last,mult] = folded_monomials(n+q,order);
+
+switch pruning
+  case 0
+    z = [yhat; epsilon];
+    y = repmat(constant,1,s);
+    mono = z;
+    for d=1:order
+        if d>1
+            mono = mono(parent{d},:).*z(last{d},:);
+        end
+        if ~isempty(g{d})
+            y = y + bsxfun(@times,g{d},mult{d}')*mono;
+        end
+    end
+  case 1
+    % mono(:,:,p) is the coefficient of t^p of the monomials evaluated at sum_j t^j z(:,:,j)
+    z = zeros(n+q,s,order);
+    z(1:n,:,:) = reshape(yhat,n,s,order);
+    z(n+1:end,:,1) = epsilon;
+    y_ = zeros(m,s,order);
+    mono = z;
+    for d=1:order
+        if d>1
+            tmp = zeros(length(parent{d}),s,order);
+            for p=d:order
+                for i=d-1:p-1
+                    tmp(:,:,p) = tmp(:,:,p) + mono(parent{d},:,i).*z(last{d},:,p-i);
+                end
+            end
+            mono = tmp;
+        end
+        if ~isempty(g{d})
+            G = bsxfun(@times,g{d},mult{d}');
+            for p=d:order
+                y_(:,:,p) = y_(:,:,p) + G*mono(:,:,p);
+            end
+        end
+        if d<length(gs) && ~isempty(gs{d+1})
+            G = bsxfun(@times,gs{d+1},mult{d}');
+            for p=d+2:order
+                y_(:,:,p) = y_(:,:,p) + G*mono(:,:,p-2);
+            end
+        end
+    end
+    if order>1 && ~isempty(gs) && ~isempty(gs{1})
+        y_(:,:,2) = bsxfun(@plus,y_(:,:,2),gs{1});
+    end
+    y = bsxfun(@plus,constant,sum(y_,3));
+end
+
+function [parent,last,mult] = folded_monomials(nz,order)
+% Each monomial of order d is the product of a monomial of order d-1 (parent) by a variable (last),
+% mult is the number of permutations of its indices.
+parent = cell(order,1);
+last = cell(order,1);
+mult = cell(order,1);
+last{1} = transpose(1:nz);
+mult{1} = ones(nz,1);
+run = ones(nz,1);
+for d=2:order
+    nm = nchoosek(nz+d-1,d);
+    parent{d} = zeros(nm,1);
+    last{d} = zeros(nm,1);
+    mult{d} = zeros(nm,1);
+    newrun = ones(nm,1);
+    c = 0;
+    for pc=1:length(last{d-1})
+        for i=last{d-1}(pc):nz
+            c = c+1;
+            parent{d}(c) = pc;
+            last{d}(c) = i;
+            if i==last{d-1}(pc)
+                newrun(c) = run(pc)+1;
+            end
+            mult{d}(c) = mult{d-1}(pc)*d/newrun(c);
+        end
+    end
+    run = newrun;
+end
+
+%@test:1
+%$ n = 2;
+%$ q = 3;
+%$ s = 5;
+%$
+%$ yhat = zeros(n,s);
+%$ epsilon = zeros(q,s);
+%$ constant = ones(n,1);
+%$ g = {rand(n,n+q), rand(n,nchoosek(n+q+1,2)), rand(n,nchoosek(n+q+2,3))};
+%$ gs = {rand(n,1), rand(n,n+q)};
+%$
+%$ % Call the tested routine.
+%$ y1 = local_state_space_iteration_k(yhat,epsilon,constant,g,1);
+%$ [y2,y2_] = local_state_space_iteration_k(zeros(n,s,3),epsilon,constant,g,gs,1);
+%$
+%$ % Check the results.
+%$ t(1) = dassert(y1,ones(n,s));
+%$ t(2) = dassert(y2,bsxfun(@plus,ones(n,1),gs{1}));
+%$ t(3) = dassert(y2_(:,:,[1 3]),zeros(n,s,2));
+%$ T = all(t);
+%@eof:1
+
+%@test:2
+%$ % Second order: compare with local_state_space_iteration_2.
+%$ n = 2;
+%$ q = 3;
+%$ s = 10;
+%$
+%$ yhat = .1*randn(n,s);
+%$ epsilon = .1*randn(q,s);
+%$ ghx = rand(n,n);
+%$ ghu = rand(n,q);
+%$ constant = ones(n,1);
+%$ H = rand(n,(n+q)^2);
+%$ for i=1:n
+%$     Hi = reshape(H(i,:),n+q,n+q);
+%$     H(i,:) = vec(Hi+Hi')';
+%$ end
+%$ idx = reshape(1:(n+q)^2,n+q,n+q);
+%$ ghxx = H(:,vec(idx(1:n,1:n)));
+%$ ghuu = H(:,vec(idx(n+1:end,n+1:end)));
+%$ ghxu = H(:,vec(idx(n+1:end,1:n)));
+%$ g2 = zeros(n,nchoosek(n+q+1,2));
+%$ c = 0;
+%$ for i=1:n+q
+%$     for j=i:n+q
+%$         c = c+1;
+%$         g2(:,c) = .5*H(:,idx(i,j));
+%$     end
+%$ end
+%$
+%$ % Call the tested routine.
+%$ y1 = local_state_space_iteration_2(yhat,epsilon,ghx,ghu,constant,ghxx,ghuu,ghxu,1);
+%$ y2 = local_state_space_iteration_k(yhat,epsilon,constant,{[ghx ghu], g2},1);
+%$
+%$ % Check the results.
+%$ t(1) = dassert(y1,y2,1e-12);
+%$ T = all(t);
+%@eof:2
@@ -43,6 +43,12 @@ switch mexname
     options_.threads.kronecker.sparse_hessian_times_B_kronecker_C = n;
   case 'local_state_space_iteration_2'
     options_.threads.local_state_space_iteration_2 = n;
+  case 'local_state_space_iteration_k'
+    options_.threads.local_state_space_iteration_k = n;
+  case 'particle_filter_step'
+    options_.threads.particle_filter_step = n;
+  case 'k_order_perturbation'
+    options_.threads.k_order_perturbation = n;
   otherwise
     message = [ mexname ' is not a known parallel mex file.' ];
     message_id  = 'Dynare:Threads:UnknownParallelMex';
@@ -1,4 +1,4 @@
-function dyn_mex(win_compiler,basename,force)
+function dyn_mex(win_compiler,basename,force,nchunks)
 
 % Compile Dynare model dlls when model option use_dll is used
 % if C file is fresher than mex file 
@@ -9,6 +9,10 @@ function dyn_mex(win_compiler,basename,force)
 %                        'cygwin'
 %  o basename      str  filenames base
 %  o force         bool recompile if 1 
+%  o nchunks       int  number of chunk files across which the code of the
+%                       static and dynamic models is split (see the
+%                       split_c_files option of the preprocessor), 0 or
+%                       absent if the code is not split
 %  
 % OUTPUTS 
 %  none
@@ -32,6 +36,18 @@ function dyn_mex(win_compiler,basename,force)
 % You should have received a copy of the GNU General Public License
 % along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
 
+if nargin < 4
+    nchunks = 0;
+end
+
+% The chunk files are compiled as separate translation units
+dynamic_sources = [basename '_dynamic.c ' basename '_dynamic_mex.c'];
+static_sources = [basename '_static.c ' basename '_static_mex.c'];
+for i = 1:nchunks
+    dynamic_sources = [dynamic_sources ' ' basename '_dynamic_chunk' int2str(i) '.c'];
+    static_sources = [static_sources ' ' basename '_static_chunk' int2str(i) '.c'];
+end
+
 Dc = dir([basename '_dynamic.c']);
 Dmex = dir([basename '_dynamic.' mexext]);
 
@@ -50,16 +66,16 @@ if ~exist('OCTAVE_VERSION')
       if strcmp(win_compiler,'msvc')
           % MATLAB/Windows + Microsoft Visual C++
           % Add /TP flag as fix for #1227
-          eval(['mex -O LINKFLAGS="$LINKFLAGS /export:Dynamic" COMPFLAGS="/TP" ' basename '_dynamic.c ' basename '_dynamic_mex.c'])
-          eval(['mex -O LINKFLAGS="$LINKFLAGS /export:Static" COMPFLAGS="/TP" ' basename '_static.c ' basename '_static_mex.c'])
+          eval(['mex -O LINKFLAGS="$LINKFLAGS /export:Dynamic" COMPFLAGS="/TP" ' dynamic_sources])
+          eval(['mex -O LINKFLAGS="$LINKFLAGS /export:Static" COMPFLAGS="/TP" ' static_sources])
       elseif strcmp(win_compiler,'cygwin')
           % MATLAB/Windows + Cygwin g++
           eval(['mex -O PRELINK_CMDS1="echo EXPORTS > mex.def & echo ' ...
                 'mexFunction >> mex.def & echo Dynamic >> mex.def" ' ...
-                basename '_dynamic.c ' basename '_dynamic_mex.c'])
+                dynamic_sources])
           eval(['mex -O PRELINK_CMDS1="echo EXPORTS > mex.def & echo ' ...
                 'mexFunction >> mex.def & echo Dynamic >> mex.def" ' ...
-                basename '_static.c ' basename '_static_mex.c'])
+                static_sources])
       else
         error(['When using the USE_DLL option, you must give either ' ...
                '''cygwin'' or ''msvc'' option to the ''dynare'' command'])
@@ -68,12 +84,12 @@ if ~exist('OCTAVE_VERSION')
         % MATLAB/Linux
         if matlab_ver_less_than('8.3')
             eval(['mex -O LDFLAGS=''-pthread -shared -Wl,--no-undefined'' ' ...
-                  basename '_dynamic.c ' basename '_dynamic_mex.c'])
+                  dynamic_sources])
             eval(['mex -O LDFLAGS=''-pthread -shared -Wl,--no-undefined'' ' ...
-                  basename '_static.c ' basename '_static_mex.c'])
+                  static_sources])
         else
-            eval(['mex -O LINKEXPORT='''' ' basename '_dynamic.c ' basename '_dynamic_mex.c'])
-            eval(['mex -O LINKEXPORT='''' ' basename '_static.c ' basename '_static_mex.c'])
+            eval(['mex -O LINKEXPORT='''' ' dynamic_sources])
+            eval(['mex -O LINKEXPORT='''' ' static_sources])
         end
     elseif ismac
         % MATLAB/MacOS
@@ -82,30 +98,28 @@ if ~exist('OCTAVE_VERSION')
                 eval(['mex -O LDFLAGS=''-Wl,-twolevel_namespace -undefined ' ...
                       'error -arch $ARCHS -Wl,-syslibroot,$SDKROOT ' ...
                       '-mmacosx-version-min=$MACOSX_DEPLOYMENT_TARGET -bundle'' ' ...
-                      basename '_dynamic.c ' basename '_dynamic_mex.c'])
+                      dynamic_sources])
                 eval(['mex -O LDFLAGS=''-Wl,-twolevel_namespace -undefined ' ...
                       'error -arch $ARCHS -Wl,-syslibroot,$SDKROOT ' ...
                       '-mmacosx-version-min=$MACOSX_DEPLOYMENT_TARGET -bundle'' ' ...
-                      basename '_static.c ' basename '_static_mex.c'])
+                      static_sources])
             else
                 eval(['mex -O LDFLAGS=''-Wl,-twolevel_namespace -undefined ' ...
                       'error -arch $ARCHS -Wl,-syslibroot,$MW_SDKROOT ' ...
                       '-mmacosx-version-min=$MACOSX_DEPLOYMENT_TARGET -bundle'' ' ...
-                      basename '_dynamic.c ' basename '_dynamic_mex.c'])
+                      dynamic_sources])
                 eval(['mex -O LDFLAGS=''-Wl,-twolevel_namespace -undefined ' ...
                       'error -arch $ARCHS -Wl,-syslibroot,$MW_SDKROOT ' ...
                       '-mmacosx-version-min=$MACOSX_DEPLOYMENT_TARGET -bundle'' ' ...
-                      basename '_static.c ' basename '_static_mex.c'])
+                      static_sources])
             end
         else
-            eval(['mex -O LINKEXPORT='''' ' basename '_dynamic.c ' ...
-                  basename '_dynamic_mex.c'])
-            eval(['mex -O LINKEXPORT='''' ' basename '_static.c ' basename ...
-                  '_static_mex.c'])
+            eval(['mex -O LINKEXPORT='''' ' dynamic_sources])
+            eval(['mex -O LINKEXPORT='''' ' static_sources])
         end
     end
 else
     % Octave
-    eval(['mex ' basename '_dynamic.c ' basename '_dynamic_mex.c'])
-    eval(['mex ' basename '_static.c ' basename '_static_mex.c'])
+    eval(['mex ' dynamic_sources])
+    eval(['mex ' static_sources])
 end
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010-2013 Dynare Team
+ * Copyright (C) 2010-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -20,16 +20,242 @@
 #include <cassert>
 
 #include <algorithm>
+#include <limits>
 
 #include "DecisionRules.hh"
 
+/*
+  Solves M*X+N*X*G=R, M and N being m×m and G k×k, using the real Schur form
+  G=Q*T*Q': the columns of Y=X*Q are computed from the first one (by pairs for
+  the 2×2 blocks of T), each of them being the solution of an m×m linear
+  system (2m×2m for a pair), and X=Y*Q'.
+*/
+class SylvesterSolver
+{
+private:
+  const size_t m, k;
+  Matrix T, Q, Y, A1, A2, W;
+  Vector acc;
+  LUSolver LU1, LU2;
+  lapack_int lwork;
+  double *work;
+  lapack_int *bwork;
+public:
+  //! Real and imaginary parts of the eigenvalues of G
+  std::vector<double> wr, wi;
+  SylvesterSolver(size_t m_arg, size_t k_arg);
+  ~SylvesterSolver();
+  //! Computes the Schur form of G, returns false if the QR algorithm failed
+  bool setG(const Matrix &G);
+  //! Solves the equation, X containing R on entry; returns false if a system is singular
+  bool solve(const Matrix &M, const Matrix &N, Matrix &X);
+};
+
+SylvesterSolver::SylvesterSolver(size_t m_arg, size_t k_arg) :
+  m(m_arg), k(k_arg), T(k), Q(k), Y(m, k), A1(m), A2(2*m), W(2*m, 1), acc(m),
+  LU1(m), LU2(2*m), wr(k), wi(k)
+{
+  bwork = new lapack_int[k];
+
+  // Workspace query
+  lapack_int k2 = k, ld = k > 0 ? k : 1, sdim, info = -1;
+  double work_size;
+  lwork = -1;
+  if (k > 0)
+    dgees("V", "N", NULL, &k2, T.getData(), &ld, &sdim, &wr[0], &wi[0], Q.getData(), &ld,
+          &work_size, &lwork, bwork, &info);
+  lwork = info == 0 ? (lapack_int) work_size : 3*k;
+  if (lwork < 1)
+    lwork = 1;
+  work = new double[(int) lwork];
+}
+
+SylvesterSolver::~SylvesterSolver()
+{
+  delete[] work;
+  delete[] bwork;
+}
+
+bool
+SylvesterSolver::setG(const Matrix &G)
+{
+  T = G;
+  lapack_int k2 = k, ld = T.getLd(), sdim, info;
+  dgees("V", "N", NULL, &k2, T.getData(), &ld, &sdim, &wr[0], &wi[0], Q.getData(), &ld,
+        work, &lwork, bwork, &info);
+  return info == 0;
+}
+
+bool
+SylvesterSolver::solve(const Matrix &M, const Matrix &N, Matrix &X)
+{
+  blas::gemm("N", "N", 1.0, X, Q, 0.0, Y);
+
+  size_t j = 0;
+  while (j < k)
+    {
+      const bool pair = (j + 1 < k && T(j+1, j) != 0.0);
+      const size_t nj = pair ? 2 : 1;
+
+      // Move the contribution of the columns already computed to the right hand side
+      if (j > 0)
+        for (size_t l = j; l < j + nj; l++)
+          {
+            VectorView t(T.getData() + l*k, j, 1), y = mat::get_col(Y, l);
+            blas::gemv("N", 1.0, MatrixView(Y, 0, 0, m, j), t, 0.0, acc);
+            blas::gemv("N", -1.0, N, acc, 1.0, y);
+          }
+
+      try
+        {
+          if (!pair)
+            {
+              // (M+T(j,j)*N)*y = r
+              for (size_t c = 0; c < m; c++)
+                for (size_t i = 0; i < m; i++)
+                  A1(i, c) = M(i, c) + T(j, j)*N(i, c);
+              MatrixView y(Y, 0, j, m, 1);
+              LU1.invMult("N", A1, y);
+            }
+          else
+            {
+              /* [M+T(j,j)*N, T(j+1,j)*N; T(j,j+1)*N, M+T(j+1,j+1)*N]*[y1; y2] = [r1; r2] */
+              for (size_t c = 0; c < m; c++)
+                for (size_t i = 0; i < m; i++)
+                  {
+                    A2(i, c) = M(i, c) + T(j, j)*N(i, c);
+                    A2(i, m+c) = T(j+1, j)*N(i, c);
+                    A2(m+i, c) = T(j, j+1)*N(i, c);
+                    A2(m+i, m+c) = M(i, c) + T(j+1, j+1)*N(i, c);
+                  }
+              for (size_t i = 0; i < m; i++)
+                {
+                  W(i, 0) = Y(i, j);
+                  W(m+i, 0) = Y(i, j+1);
+                }
+              LU2.invMult("N", A2, W);
+              for (size_t i = 0; i < m; i++)
+                {
+                  Y(i, j) = W(i, 0);
+                  Y(i, j+1) = W(m+i, 0);
+                }
+            }
+        }
+      catch (LUSolver::LUException &e)
+        {
+          return false;
+        }
+      j += nj;
+    }
+
+  blas::gemm("N", "T", 1.0, Y, Q, 0.0, X);
+  return true;
+}
+
+// The variables (or equations) of the model which are not in v1 nor in v2
+static std::vector<size_t>
+complement(size_t n, const std::vector<size_t> &v1, const std::vector<size_t> &v2)
+{
+  std::vector<bool> in(n, false);
+  for (size_t i = 0; i < v1.size(); i++)
+    in[v1[i]] = true;
+  for (size_t i = 0; i < v2.size(); i++)
+    in[v2[i]] = true;
+  std::vector<size_t> res;
+  for (size_t i = 0; i < n; i++)
+    if (!in[i])
+      res.push_back(i);
+  return res;
+}
+
+// The elements of zeta which are in vars (sorted), as indices in vars
+static std::vector<size_t>
+restrict_to(const std::vector<size_t> &zeta, const std::vector<size_t> &vars)
+{
+  std::vector<size_t> res;
+  for (size_t i = 0; i < zeta.size(); i++)
+    {
+      std::vector<size_t>::const_iterator it = std::lower_bound(vars.begin(), vars.end(), zeta[i]);
+      if (it != vars.end() && *it == zeta[i])
+        res.push_back(it - vars.begin());
+    }
+  return res;
+}
+
+/*
+  The purely backward block (B), the purely forward block (F) and the core
+  (C) of the model, with the core as a smaller model, and the workspaces of
+  DecisionRules::computeWithBlocks(). They are kept as long as the blocks do
+  not change.
+*/
+class DecisionRules::BlockReduction
+{
+public:
+  const std::vector<size_t> vars_B, eqs_B, vars_F, eqs_F, vars_C, eqs_C;
+  const size_t n_B, n_F, n_C;
+  const std::vector<size_t> zeta_fwrd_C, zeta_back_C, zeta_mixed_C, zeta_static_C;
+  DecisionRules core;
+  const size_t n_back_mixed_C, n_fwrd_mixed_C;
+  //! Columns of the jacobian of the core in the jacobian of the model
+  std::vector<size_t> cols_C;
+  std::vector<bool> in_F;
+  Matrix jacobian_C, g_y_C;
+  Matrix A0_B, G_B;
+  LUSolver LU_B;
+  //! Core w.r. to the lags of the backward block
+  Matrix M_C, N_C, X_CB;
+  SylvesterSolver sylvester_B;
+  Matrix M_F, N_F, E_F, D_F, Z_F, G_s, X_F, Y_F;
+  GeneralizedSchurDecomposition GSD_F;
+  SylvesterSolver sylvester_F;
+  BlockReduction(const DecisionRules &model, const std::vector<size_t> &vars_B_arg,
+                 const std::vector<size_t> &eqs_B_arg, const std::vector<size_t> &vars_F_arg,
+                 const std::vector<size_t> &eqs_F_arg);
+};
+
+DecisionRules::BlockReduction::BlockReduction(const DecisionRules &model,
+                                              const std::vector<size_t> &vars_B_arg,
+                                              const std::vector<size_t> &eqs_B_arg,
+                                              const std::vector<size_t> &vars_F_arg,
+                                              const std::vector<size_t> &eqs_F_arg) :
+  vars_B(vars_B_arg), eqs_B(eqs_B_arg), vars_F(vars_F_arg), eqs_F(eqs_F_arg),
+  vars_C(complement(model.n, vars_B, vars_F)), eqs_C(complement(model.n, eqs_B, eqs_F)),
+  n_B(vars_B.size()), n_F(vars_F.size()), n_C(vars_C.size()),
+  zeta_fwrd_C(restrict_to(model.zeta_fwrd, vars_C)), zeta_back_C(restrict_to(model.zeta_back, vars_C)),
+  zeta_mixed_C(restrict_to(model.zeta_mixed, vars_C)), zeta_static_C(restrict_to(model.zeta_static, vars_C)),
+  core(n_C, 0, zeta_fwrd_C, zeta_back_C, zeta_mixed_C, zeta_static_C, model.qz_criterium, false,
+       model.solver, model.solver_tol),
+  n_back_mixed_C(core.n_back_mixed), n_fwrd_mixed_C(core.n_fwrd_mixed),
+  in_F(model.n, false),
+  jacobian_C(n_C, n_back_mixed_C + n_C + n_fwrd_mixed_C), g_y_C(n_C, n_back_mixed_C),
+  A0_B(n_B), G_B(n_B), LU_B(n_B),
+  M_C(n_C), N_C(n_C), X_CB(n_C, n_B), sylvester_B(n_C, n_B),
+  M_F(n_F), N_F(n_F), E_F(n_F), D_F(n_F), Z_F(n_F), G_s(model.n_back_mixed),
+  X_F(n_F, model.n_back_mixed), Y_F(n_F, model.n_back_mixed),
+  GSD_F(n_F, model.qz_criterium), sylvester_F(n_F, n_F > 0 ? model.n_back_mixed : 0)
+{
+  for (size_t i = 0; i < n_back_mixed_C; i++)
+    cols_C.push_back(model.lag_index[vars_C[core.zeta_back_mixed[i]]]);
+  for (size_t i = 0; i < n_C; i++)
+    cols_C.push_back(model.n_back_mixed + vars_C[i]);
+  for (size_t i = 0; i < n_fwrd_mixed_C; i++)
+    cols_C.push_back(model.n_back_mixed + model.n + model.lead_index[vars_C[core.zeta_fwrd_mixed[i]]]);
+
+  for (size_t i = 0; i < n_F; i++)
+    in_F[vars_F[i]] = true;
+}
+
 DecisionRules::DecisionRules(size_t n_arg, size_t p_arg,
                              const std::vector<size_t> &zeta_fwrd_arg,
                              const std::vector<size_t> &zeta_back_arg,
                              const std::vector<size_t> &zeta_mixed_arg,
                              const std::vector<size_t> &zeta_static_arg,
-                             double qz_criterium) :
-  n(n_arg), p(p_arg), zeta_fwrd(zeta_fwrd_arg), zeta_back(zeta_back_arg),
+                             double qz_criterium_arg,
+                             bool block_reduction_arg,
+                             Solver solver_arg,
+                             double solver_tol_arg) :
+  n(n_arg), p(p_arg), qz_criterium(qz_criterium_arg),
+  zeta_fwrd(zeta_fwrd_arg), zeta_back(zeta_back_arg),
   zeta_mixed(zeta_mixed_arg), zeta_static(zeta_static_arg),
   n_fwrd(zeta_fwrd.size()), n_back(zeta_back.size()),
   n_mixed(zeta_mixed.size()), n_static(zeta_static.size()),
@@ -55,7 +281,27 @@ DecisionRules::DecisionRules(size_t n_arg, size_t p_arg,
   g_y_static_tmp(n_fwrd_mixed, n_back_mixed),
   g_u_tmp1(n, n_back_mixed),
   g_u_tmp2(n),
-  LU4(n)
+  LU4(n),
+  block_reduction(block_reduction_arg),
+  lag_index(n, -1),
+  lead_index(n, -1),
+  dynamic_index(n, -1),
+  eq_vars(n),
+  eq_vars_current(n),
+  reduction(NULL),
+  solver(solver_arg),
+  solver_tol(solver_tol_arg),
+  A_m(solver == qz ? 0 : n_dynamic),
+  A_0(solver == qz ? 0 : n_dynamic),
+  A_p(solver == qz ? 0 : n_dynamic),
+  X_dynamic(solver == qz ? 0 : n_dynamic),
+  cyclicReductionSolver(solver == cycleReduction ? n_dynamic : 0, solver_tol),
+  logarithmicReductionSolver(solver == logarithmicReduction ? n_dynamic : 0, solver_tol),
+  K(solver == qz ? 0 : n_dynamic),
+  Y_fwrd(solver == qz ? 0 : n_dynamic, solver == qz ? 0 : n_fwrd_mixed),
+  P_fwrd(solver == qz ? 0 : n_fwrd_mixed),
+  LU5(solver == qz ? 0 : n_dynamic),
+  eig_stored(false)
 {
   assert(n == n_back + n_fwrd + n_mixed + n_static);
 
@@ -84,6 +330,18 @@ DecisionRules::DecisionRules(size_t n_arg, size_t p_arg,
       pi_fwrd.push_back(i);
     else
       beta_fwrd.push_back(i);
+
+  for (size_t i = 0; i < n_back_mixed; i++)
+    lag_index[zeta_back_mixed[i]] = i;
+  for (size_t i = 0; i < n_fwrd_mixed; i++)
+    lead_index[zeta_fwrd_mixed[i]] = i;
+  for (size_t i = 0; i < n_dynamic; i++)
+    dynamic_index[zeta_dynamic[i]] = i;
+}
+
+DecisionRules::~DecisionRules()
+{
+  delete reduction;
 }
 
 void
@@ -94,6 +352,15 @@ DecisionRules::compute(const Matrix &jacobian, Matrix &g_y, Matrix &g_u) throw (
   assert(g_y.getRows() == n && g_y.getCols() == n_back_mixed);
   assert(g_u.getRows() == n && g_u.getCols() == p);
 
+  if (!(block_reduction && computeWithBlocks(jacobian, g_y)))
+    computeWithoutBlocks(jacobian, g_y);
+
+  computeShocks(jacobian, g_y, g_u);
+}
+
+void
+DecisionRules::computeWithoutBlocks(const Matrix &jacobian, Matrix &g_y) throw (BlanchardKahnException, GeneralizedSchurDecomposition::GSDException, LUSolver::LUException)
+{
   // Construct S, perform QR decomposition and get A = Q*jacobian
   A = MatrixConstView(jacobian, 0, 0, n, n_back_mixed + n + n_fwrd_mixed);
   if (n_static > 0)
@@ -104,6 +371,36 @@ DecisionRules::compute(const Matrix &jacobian, Matrix &g_y, Matrix &g_u) throw (
       QR.computeAndLeftMultByQ(S, "T", A);
     }
 
+  eig_stored = solver != qz && computeWithReduction(g_y);
+  if (!eig_stored)
+    computeWithQZ(g_y);
+
+  // Compute DR for static variables w.r. to endogenous
+  if (n_static > 0)
+    {
+      g_y_static = MatrixView(A, 0, 0, n_static, n_back_mixed);
+      for (size_t i = 0; i < n_dynamic; i++)
+        {
+          mat::row_copy(g_y, zeta_dynamic[i], g_y_dynamic, i);
+          mat::col_copy(A, n_back_mixed + zeta_dynamic[i], 0, n_static, A0d, i, 0);
+        }
+      blas::gemm("N", "N", 1.0, A0d, g_y_dynamic, 1.0, g_y_static);
+      blas::gemm("N", "N", 1.0, Z21, g_y_back, 0.0, g_y_static_tmp);
+      blas::gemm("N", "N", 1.0, MatrixView(A, 0, n_back_mixed + n, n_static, n_fwrd_mixed),
+                 g_y_static_tmp, 1.0, g_y_static);
+      for (size_t i = 0; i < n_static; i++)
+        mat::col_copy(A, n_back_mixed + zeta_static[i], 0, n_static, A0s, i, 0);
+      LU3.invMult("N", A0s, g_y_static);
+      mat::negate(g_y_static);
+
+      for (size_t i = 0; i < n_static; i++)
+        mat::row_copy(g_y_static, i, g_y, zeta_static[i]);
+    }
+}
+
+void
+DecisionRules::computeWithQZ(Matrix &g_y) throw (BlanchardKahnException, GeneralizedSchurDecomposition::GSDException)
+{
   // Construct matrix D
   D.setAll(0.0);
   for (size_t i = 0; i < n_mixed; i++)
@@ -167,30 +464,16 @@ DecisionRules::compute(const Matrix &jacobian, Matrix &g_y, Matrix &g_u) throw (
   // TODO: avoid to copy mixed variables again, rather test it...
   for (size_t i = 0; i < n_back_mixed; i++)
     mat::row_copy(g_y_back, i, g_y, zeta_back_mixed[i]);
+}
 
-  // Compute DR for static variables w.r. to endogenous
-  if (n_static > 0)
-    {
-      g_y_static = MatrixView(A, 0, 0, n_static, n_back_mixed);
-      for (size_t i = 0; i < n_dynamic; i++)
-        {
-          mat::row_copy(g_y, zeta_dynamic[i], g_y_dynamic, i);
-          mat::col_copy(A, n_back_mixed + zeta_dynamic[i], 0, n_static, A0d, i, 0);
-        }
-      blas::gemm("N", "N", 1.0, A0d, g_y_dynamic, 1.0, g_y_static);
-      blas::gemm("N", "N", 1.0, g_y_fwrd, g_y_back, 0.0, g_y_static_tmp);
-      blas::gemm("N", "N", 1.0, MatrixView(A, 0, n_back_mixed + n, n_static, n_fwrd_mixed),
-                 g_y_static_tmp, 1.0, g_y_static);
-      for (size_t i = 0; i < n_static; i++)
-        mat::col_copy(A, n_back_mixed + zeta_static[i], 0, n_static, A0s, i, 0);
-      LU3.invMult("N", A0s, g_y_static);
-      mat::negate(g_y_static);
-
-      for (size_t i = 0; i < n_static; i++)
-        mat::row_copy(g_y_static, i, g_y, zeta_static[i]);
-    }
-
+void
+DecisionRules::computeShocks(const Matrix &jacobian, const Matrix &g_y, Matrix &g_u)
+{
   // Compute DR for all endogenous w.r. to shocks
+  for (size_t i = 0; i < n_fwrd_mixed; i++)
+    mat::row_copy(g_y, zeta_fwrd_mixed[i], Z21, i);
+  const Matrix &g_y_fwrd = Z21;
+
   blas::gemm("N", "N", 1.0, MatrixConstView(jacobian, 0, n_back_mixed + n, n, n_fwrd_mixed), g_y_fwrd, 0.0, g_u_tmp1);
   g_u_tmp2 = MatrixConstView(jacobian, 0, n_back_mixed, n, n);
   for (size_t i = 0; i < n_back_mixed; i++)
@@ -204,6 +487,445 @@ DecisionRules::compute(const Matrix &jacobian, Matrix &g_y, Matrix &g_u) throw (
   mat::negate(g_u);
 }
 
+// Eigenvalues of the square matrix M (which is overwritten), returns false if the QR algorithm failed
+static bool
+eigenvalues(Matrix &M, double *wr, double *wi)
+{
+  lapack_int n = M.getRows(), ld = n > 0 ? n : 1, sdim, info, lwork = -1;
+  if (n == 0)
+    return true;
+  double work_size, vs;
+  dgees("N", "N", NULL, &n, M.getData(), &ld, &sdim, wr, wi, &vs, &ld,
+        &work_size, &lwork, NULL, &info);
+  lwork = info == 0 ? (lapack_int) work_size : 3*n;
+  std::vector<double> work(lwork);
+  dgees("N", "N", NULL, &n, M.getData(), &ld, &sdim, wr, wi, &vs, &ld,
+        &work[0], &lwork, NULL, &info);
+  return info == 0;
+}
+
+bool
+DecisionRules::computeWithReduction(Matrix &g_y)
+{
+  // Matrix quadratic equation in the dynamic variables, on the equations where the static variables do not appear
+  A_m.setAll(0.0);
+  A_p.setAll(0.0);
+  for (size_t i = 0; i < n_back_mixed; i++)
+    mat::col_copy(A, i, n_static, n_dynamic, A_m, dynamic_index[zeta_back_mixed[i]], 0);
+  for (size_t i = 0; i < n_dynamic; i++)
+    mat::col_copy(A, n_back_mixed + zeta_dynamic[i], n_static, n_dynamic, A_0, i, 0);
+  for (size_t i = 0; i < n_fwrd_mixed; i++)
+    mat::col_copy(A, n_back_mixed + n + i, n_static, n_dynamic, A_p, dynamic_index[zeta_fwrd_mixed[i]], 0);
+
+  try
+    {
+      if (solver == cycleReduction)
+        cyclicReductionSolver.solve(A_m, A_0, A_p, X_dynamic);
+      else
+        logarithmicReductionSolver.solve(A_m, A_0, A_p, X_dynamic);
+    }
+  catch (CyclicReduction::CRException &e)
+    {
+      return false;
+    }
+  catch (LogarithmicReduction::LRException &e)
+    {
+      return false;
+    }
+
+  for (size_t j = 0; j < n_back_mixed; j++)
+    {
+      const size_t c = dynamic_index[zeta_back_mixed[j]];
+      for (size_t i = 0; i < n_back_mixed; i++)
+        g_y_back(i, j) = X_dynamic(dynamic_index[zeta_back_mixed[i]], c);
+      for (size_t i = 0; i < n_fwrd_mixed; i++)
+        Z21(i, j) = X_dynamic(dynamic_index[zeta_fwrd_mixed[i]], c);
+    }
+
+  /* Blanchard-Kahn conditions: the eigenvalues of g_y_back must be stable, and
+     the other generalized eigenvalues, which are the opposites of the
+     inverses of the eigenvalues of the forward part of (A_0+A_p*X)^(-1)*A_p,
+     explosive */
+  eig_real_stored.resize(n_back_mixed + n_fwrd_mixed);
+  eig_cmplx_stored.resize(n_back_mixed + n_fwrd_mixed);
+  g_y_back_tmp = g_y_back;
+  if (!eigenvalues(g_y_back_tmp, &eig_real_stored[0], &eig_cmplx_stored[0]))
+    return false;
+  for (size_t i = 0; i < n_back_mixed; i++)
+    if (eig_real_stored[i]*eig_real_stored[i] + eig_cmplx_stored[i]*eig_cmplx_stored[i] >= qz_criterium)
+      return false;
+
+  K = A_0;
+  blas::gemm("N", "N", 1.0, A_p, X_dynamic, 1.0, K);
+  for (size_t i = 0; i < n_fwrd_mixed; i++)
+    mat::col_copy(A_p, dynamic_index[zeta_fwrd_mixed[i]], Y_fwrd, i);
+  try
+    {
+      LU5.invMult("N", K, Y_fwrd);
+    }
+  catch (LUSolver::LUException &e)
+    {
+      return false;
+    }
+  for (size_t i = 0; i < n_fwrd_mixed; i++)
+    mat::row_copy(Y_fwrd, dynamic_index[zeta_fwrd_mixed[i]], P_fwrd, i);
+  if (!eigenvalues(P_fwrd, &eig_real_stored[n_back_mixed], &eig_cmplx_stored[n_back_mixed]))
+    return false;
+  for (size_t i = n_back_mixed; i < n_back_mixed + n_fwrd_mixed; i++)
+    {
+      const double re = eig_real_stored[i], im = eig_cmplx_stored[i], mod2 = re*re + im*im;
+      if (qz_criterium*mod2 > 1.0)
+        return false;
+      if (mod2 == 0.0)
+        {
+          eig_real_stored[i] = std::numeric_limits<double>::infinity();
+          eig_cmplx_stored[i] = 0.0;
+        }
+      else
+        {
+          eig_real_stored[i] = -re/mod2;
+          eig_cmplx_stored[i] = im/mod2;
+        }
+    }
+
+  for (size_t j = 0; j < n_back_mixed; j++)
+    {
+      const size_t c = dynamic_index[zeta_back_mixed[j]];
+      for (size_t i = 0; i < n_dynamic; i++)
+        g_y(zeta_dynamic[i], j) = X_dynamic(i, c);
+    }
+
+  return true;
+}
+
+// Finds an augmenting path from the variable v in the matching of variables to equations
+static bool
+augment(size_t v, const std::vector<std::vector<size_t> > &var_eqs, std::vector<int> &eq_match,
+        std::vector<int> &var_match, std::vector<bool> &visited)
+{
+  for (size_t k = 0; k < var_eqs[v].size(); k++)
+    {
+      size_t i = var_eqs[v][k];
+      if (visited[i])
+        continue;
+      visited[i] = true;
+      if (eq_match[i] < 0 || augment(eq_match[i], var_eqs, eq_match, var_match, visited))
+        {
+          eq_match[i] = v;
+          var_match[v] = i;
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+DecisionRules::findBlocks(const Matrix &jacobian, std::vector<size_t> &vars_B, std::vector<size_t> &eqs_B,
+                          std::vector<size_t> &vars_F, std::vector<size_t> &eqs_F)
+{
+  // Incidence of the variables in the equations
+  std::vector<std::vector<size_t> > var_eqs_current(n);
+  for (size_t i = 0; i < n; i++)
+    {
+      eq_vars[i].clear();
+      eq_vars_current[i].clear();
+      for (size_t v = 0; v < n; v++)
+        {
+          const bool current = jacobian(i, n_back_mixed + v) != 0.0;
+          if (current)
+            {
+              eq_vars_current[i].push_back(v);
+              var_eqs_current[v].push_back(i);
+            }
+          if (current
+              || (lag_index[v] >= 0 && jacobian(i, lag_index[v]) != 0.0)
+              || (lead_index[v] >= 0 && jacobian(i, n_back_mixed + n + lead_index[v]) != 0.0))
+            eq_vars[i].push_back(v);
+        }
+    }
+
+  /* Backward block: the purely backward variables which appear at t in the
+     equations involving only such variables. Removing a variable removes the
+     equations where it appears, hence the loop. */
+  std::vector<bool> in_B(n, false), eq_in_B(n, false);
+  for (size_t i = 0; i < n_back; i++)
+    in_B[zeta_back[i]] = true;
+  bool changed = true;
+  while (changed)
+    {
+      std::vector<bool> determined(n, false);
+      for (size_t i = 0; i < n; i++)
+        {
+          eq_in_B[i] = !eq_vars[i].empty();
+          for (size_t k = 0; k < eq_vars[i].size() && eq_in_B[i]; k++)
+            eq_in_B[i] = in_B[eq_vars[i][k]];
+          if (eq_in_B[i])
+            for (size_t k = 0; k < eq_vars_current[i].size(); k++)
+              determined[eq_vars_current[i][k]] = true;
+        }
+      changed = false;
+      for (size_t v = 0; v < n; v++)
+        if (in_B[v] && !determined[v])
+          {
+            in_B[v] = false;
+            changed = true;
+          }
+    }
+  vars_B.clear();
+  eqs_B.clear();
+  for (size_t i = 0; i < n; i++)
+    {
+      if (in_B[i])
+        vars_B.push_back(i);
+      if (eq_in_B[i])
+        eqs_B.push_back(i);
+    }
+  if (vars_B.size() != eqs_B.size())
+    {
+      vars_B.clear();
+      eqs_B.clear();
+    }
+
+  /* Forward block: the purely forward variables, matched to equations where
+     they appear at t. A variable is removed if it cannot be matched, or if it
+     appears in an equation which is not matched to the block (the rest of the
+     model then depends on it). */
+  std::vector<bool> in_F(n, false);
+  for (size_t i = 0; i < n_fwrd; i++)
+    in_F[zeta_fwrd[i]] = true;
+  std::vector<int> eq_match(n), var_match(n);
+  changed = true;
+  while (changed)
+    {
+      std::fill(eq_match.begin(), eq_match.end(), -1);
+      std::fill(var_match.begin(), var_match.end(), -1);
+      for (size_t v = 0; v < n; v++)
+        if (in_F[v])
+          {
+            std::vector<bool> visited(n, false);
+            augment(v, var_eqs_current, eq_match, var_match, visited);
+          }
+      changed = false;
+      for (size_t v = 0; v < n; v++)
+        if (in_F[v] && var_match[v] < 0)
+          {
+            in_F[v] = false;
+            changed = true;
+          }
+      for (size_t i = 0; i < n; i++)
+        if (eq_match[i] < 0)
+          for (size_t k = 0; k < eq_vars[i].size(); k++)
+            if (in_F[eq_vars[i][k]])
+              {
+                in_F[eq_vars[i][k]] = false;
+                changed = true;
+              }
+    }
+  vars_F.clear();
+  eqs_F.clear();
+  for (size_t i = 0; i < n; i++)
+    {
+      if (in_F[i])
+        vars_F.push_back(i);
+      if (eq_match[i] >= 0)
+        eqs_F.push_back(i);
+    }
+
+  return !vars_B.empty() || !vars_F.empty();
+}
+
+bool
+DecisionRules::computeWithBlocks(const Matrix &jacobian, Matrix &g_y)
+{
+  std::vector<size_t> vars_B, eqs_B, vars_F, eqs_F;
+  if (!findBlocks(jacobian, vars_B, eqs_B, vars_F, eqs_F))
+    return false;
+
+  // The core must have both backward and forward variables
+  if (vars_B.size() == n_back_mixed || vars_F.size() == n_fwrd_mixed)
+    return false;
+
+  if (reduction == NULL || reduction->vars_B != vars_B || reduction->eqs_B != eqs_B
+      || reduction->vars_F != vars_F || reduction->eqs_F != eqs_F)
+    {
+      delete reduction;
+      reduction = new BlockReduction(*this, vars_B, eqs_B, vars_F, eqs_F);
+    }
+  BlockReduction &r = *reduction;
+
+  g_y.setAll(0.0);
+
+  // Backward block: A0_B*y_B + A-_B*y_B(-1) = 0, and its eigenvalues must be stable
+  if (r.n_B > 0)
+    {
+      for (size_t j = 0; j < r.n_B; j++)
+        for (size_t i = 0; i < r.n_B; i++)
+          {
+            r.A0_B(i, j) = jacobian(r.eqs_B[i], n_back_mixed + r.vars_B[j]);
+            r.G_B(i, j) = -jacobian(r.eqs_B[i], lag_index[r.vars_B[j]]);
+          }
+      try
+        {
+          r.LU_B.invMult("N", r.A0_B, r.G_B);
+        }
+      catch (LUSolver::LUException &e)
+        {
+          return false;
+        }
+      if (!r.sylvester_B.setG(r.G_B))
+        return false;
+      for (size_t i = 0; i < r.n_B; i++)
+        if (r.sylvester_B.wr[i]*r.sylvester_B.wr[i] + r.sylvester_B.wi[i]*r.sylvester_B.wi[i] >= qz_criterium)
+          return false;
+
+      for (size_t j = 0; j < r.n_B; j++)
+        for (size_t i = 0; i < r.n_B; i++)
+          g_y(r.vars_B[i], lag_index[r.vars_B[j]]) = r.G_B(i, j);
+    }
+
+  // Core, w.r. to its own states
+  for (size_t j = 0; j < r.cols_C.size(); j++)
+    for (size_t i = 0; i < r.n_C; i++)
+      r.jacobian_C(i, j) = jacobian(r.eqs_C[i], r.cols_C[j]);
+  try
+    {
+      r.core.computeWithoutBlocks(r.jacobian_C, r.g_y_C);
+    }
+  catch (BlanchardKahnException &e)
+    {
+      return false;
+    }
+  catch (GeneralizedSchurDecomposition::GSDException &e)
+    {
+      return false;
+    }
+  catch (LUSolver::LUException &e)
+    {
+      return false;
+    }
+  for (size_t k = 0; k < r.n_back_mixed_C; k++)
+    for (size_t i = 0; i < r.n_C; i++)
+      g_y(r.vars_C[i], r.cols_C[k]) = r.g_y_C(i, k);
+
+  /* Core, w.r. to the lags of the backward block: with y_C = G_CC*s_C(-1) +
+     X*y_B(-1), X solves (A0_CC + A+_C*G_CC)*X + A+_C*X*G_B = -(A-_CB + A0_CB*G_B),
+     where A+_C*G_CC only acts on the states of the core */
+  if (r.n_B > 0)
+    {
+      for (size_t j = 0; j < r.n_C; j++)
+        for (size_t i = 0; i < r.n_C; i++)
+          r.M_C(i, j) = r.jacobian_C(i, r.n_back_mixed_C + j);
+      r.N_C.setAll(0.0);
+      for (size_t k = 0; k < r.n_fwrd_mixed_C; k++)
+        {
+          const size_t f = r.core.zeta_fwrd_mixed[k];
+          for (size_t i = 0; i < r.n_C; i++)
+            r.N_C(i, f) = r.jacobian_C(i, r.n_back_mixed_C + r.n_C + k);
+          for (size_t l = 0; l < r.n_back_mixed_C; l++)
+            {
+              const double g = r.g_y_C(f, l);
+              const size_t s = r.core.zeta_back_mixed[l];
+              if (g != 0.0)
+                for (size_t i = 0; i < r.n_C; i++)
+                  r.M_C(i, s) += r.N_C(i, f)*g;
+            }
+        }
+      for (size_t j = 0; j < r.n_B; j++)
+        for (size_t i = 0; i < r.n_C; i++)
+          r.X_CB(i, j) = -jacobian(r.eqs_C[i], lag_index[r.vars_B[j]]);
+      for (size_t b = 0; b < r.n_B; b++)
+        for (size_t i = 0; i < r.n_C; i++)
+          {
+            const double a = jacobian(r.eqs_C[i], n_back_mixed + r.vars_B[b]);
+            if (a != 0.0)
+              for (size_t j = 0; j < r.n_B; j++)
+                r.X_CB(i, j) -= a*r.G_B(b, j);
+          }
+      if (!r.sylvester_B.solve(r.M_C, r.N_C, r.X_CB))
+        return false;
+
+      for (size_t j = 0; j < r.n_B; j++)
+        for (size_t i = 0; i < r.n_C; i++)
+          g_y(r.vars_C[i], lag_index[r.vars_B[j]]) = r.X_CB(i, j);
+    }
+
+  /* Forward block: with y_F = X*s(-1) and G_s the rows of g_y for the states,
+     X solves A0_FF*X + A+_FF*X*G_s = -(A-_F + A0_Fo*g_o + A+_Fo*g_o*G_s), o
+     being the other variables; all the eigenvalues of its pencil must be
+     explosive */
+  if (r.n_F > 0)
+    {
+      for (size_t j = 0; j < r.n_F; j++)
+        for (size_t i = 0; i < r.n_F; i++)
+          {
+            r.M_F(i, j) = jacobian(r.eqs_F[i], n_back_mixed + r.vars_F[j]);
+            r.N_F(i, j) = jacobian(r.eqs_F[i], n_back_mixed + n + lead_index[r.vars_F[j]]);
+          }
+      r.E_F = r.M_F;
+      mat::negate(r.E_F);
+      r.D_F = r.N_F;
+      size_t sdim;
+      try
+        {
+          r.GSD_F.compute(r.E_F, r.D_F, r.Z_F, sdim);
+        }
+      catch (GeneralizedSchurDecomposition::GSDException &e)
+        {
+          return false;
+        }
+      if (sdim > 0)
+        return false;
+
+      for (size_t k = 0; k < n_back_mixed; k++)
+        mat::row_copy(g_y, zeta_back_mixed[k], r.G_s, k);
+      for (size_t l = 0; l < n_back_mixed; l++)
+        for (size_t i = 0; i < r.n_F; i++)
+          r.X_F(i, l) = -jacobian(r.eqs_F[i], l);
+      r.Y_F.setAll(0.0);
+      for (size_t v = 0; v < n; v++)
+        if (!r.in_F[v])
+          for (size_t i = 0; i < r.n_F; i++)
+            {
+              double a = jacobian(r.eqs_F[i], n_back_mixed + v);
+              if (a != 0.0)
+                for (size_t l = 0; l < n_back_mixed; l++)
+                  r.X_F(i, l) -= a*g_y(v, l);
+              a = lead_index[v] >= 0 ? jacobian(r.eqs_F[i], n_back_mixed + n + lead_index[v]) : 0.0;
+              if (a != 0.0)
+                for (size_t l = 0; l < n_back_mixed; l++)
+                  r.Y_F(i, l) += a*g_y(v, l);
+            }
+      blas::gemm("N", "N", -1.0, r.Y_F, r.G_s, 1.0, r.X_F);
+      if (!r.sylvester_F.setG(r.G_s) || !r.sylvester_F.solve(r.M_F, r.N_F, r.X_F))
+        return false;
+
+      for (size_t l = 0; l < n_back_mixed; l++)
+        for (size_t i = 0; i < r.n_F; i++)
+          g_y(r.vars_F[i], l) = r.X_F(i, l);
+    }
+
+  // Generalized eigenvalues: those of the core, then of the backward and forward blocks
+  const size_t n_pencil_C = r.core.n_fwrd + r.core.n_back + 2*r.core.n_mixed;
+  eig_real_stored.resize(n_pencil_C + r.n_B + r.n_F);
+  eig_cmplx_stored.resize(n_pencil_C + r.n_B + r.n_F);
+  VectorView eig_real_C(&eig_real_stored[0], n_pencil_C, 1), eig_cmplx_C(&eig_cmplx_stored[0], n_pencil_C, 1);
+  r.core.getGeneralizedEigenvalues(eig_real_C, eig_cmplx_C);
+  for (size_t i = 0; i < r.n_B; i++)
+    {
+      eig_real_stored[n_pencil_C + i] = r.sylvester_B.wr[i];
+      eig_cmplx_stored[n_pencil_C + i] = r.sylvester_B.wi[i];
+    }
+  if (r.n_F > 0)
+    {
+      VectorView eig_real_F(&eig_real_stored[n_pencil_C + r.n_B], r.n_F, 1),
+        eig_cmplx_F(&eig_cmplx_stored[n_pencil_C + r.n_B], r.n_F, 1);
+      r.GSD_F.getGeneralizedEigenvalues(eig_real_F, eig_cmplx_F);
+    }
+  eig_stored = true;
+
+  return true;
+}
+
 std::ostream &
 operator<<(std::ostream &out, const DecisionRules::BlanchardKahnException &e)
 {
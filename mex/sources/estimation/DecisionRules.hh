@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010 Dynare Team
+ * Copyright (C) 2010-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -25,11 +25,24 @@
 #include "QRDecomposition.hh"
 #include "GeneralizedSchurDecomposition.hh"
 #include "LUSolver.hh"
+#include "CyclicReduction.hh"
+#include "LogarithmicReduction.hh"
 
 class DecisionRules
 {
+public:
+  //! Algorithm used for the decision rules of the dynamic variables
+  enum Solver
+  {
+    qz = 0, // generalized Schur (QZ) decomposition
+    cycleReduction = 1, // cyclic reduction on the matrix quadratic equation, with QZ as fallback
+    logarithmicReduction = 2 // logarithmic reduction on the matrix quadratic equation, with QZ as fallback
+  };
+
 private:
+  class BlockReduction;
   const size_t n, p;
+  const double qz_criterium;
   const std::vector<size_t> zeta_fwrd, zeta_back, zeta_mixed, zeta_static;
   const size_t n_fwrd, n_back, n_mixed, n_static, n_back_mixed, n_fwrd_mixed, n_dynamic;
   std::vector<size_t> zeta_fwrd_mixed, zeta_back_mixed, zeta_dynamic,
@@ -42,6 +55,28 @@ private:
   Matrix g_y_static, A0s, A0d, g_y_dynamic, g_y_static_tmp;
   Matrix g_u_tmp1, g_u_tmp2;
   LUSolver LU4;
+  //! Whether the purely backward and purely forward blocks are solved apart from the core of the model
+  const bool block_reduction;
+  //! For each variable, its index in zeta_back_mixed (resp. zeta_fwrd_mixed, zeta_dynamic), or -1
+  std::vector<int> lag_index, lead_index, dynamic_index;
+  //! For each equation, the variables which appear in it (at any lag), and those which appear at t
+  std::vector<std::vector<size_t> > eq_vars, eq_vars_current;
+  //! The blocks found at the last call, NULL if none
+  BlockReduction *reduction;
+  const Solver solver;
+  const double solver_tol;
+  //! The matrix quadratic equation A_m + A_0*X + A_p*X^2 = 0 in the dynamic variables, and its solution
+  Matrix A_m, A_0, A_p, X_dynamic;
+  CyclicReduction cyclicReductionSolver;
+  LogarithmicReduction logarithmicReductionSolver;
+  //! Workspace for the Blanchard-Kahn conditions on the solution of the matrix quadratic equation
+  Matrix K, Y_fwrd, P_fwrd;
+  LUSolver LU5;
+  //! Whether the generalized eigenvalues of the last call are stored here rather than in GSD
+  bool eig_stored;
+  std::vector<double> eig_real_stored, eig_cmplx_stored;
+  DecisionRules(const DecisionRules &);
+  DecisionRules &operator=(const DecisionRules &);
 public:
   class BlanchardKahnException
   {
@@ -53,18 +88,60 @@ public:
   };
   /*!
     The zetas are supposed to follow C convention (first vector index is zero).
+    \param block_reduction_arg If true, the purely backward and purely forward blocks of the model are solved apart from the QZ (see compute())
+    \param solver_arg The algorithm for the dynamic variables (of the core if there are blocks)
+    \param solver_tol_arg The tolerance of cyclic or logarithmic reduction
   */
   DecisionRules(size_t n_arg, size_t p_arg, const std::vector<size_t> &zeta_fwrd_arg,
                 const std::vector<size_t> &zeta_back_arg, const std::vector<size_t> &zeta_mixed_arg,
-                const std::vector<size_t> &zeta_static_arg, double qz_criterium);
-  virtual ~DecisionRules(){};
+                const std::vector<size_t> &zeta_static_arg, double qz_criterium_arg,
+                bool block_reduction_arg = true, Solver solver_arg = qz, double solver_tol_arg = 1e-7);
+  virtual ~DecisionRules();
 
   /*!
     \param jacobian First columns are backetermined vars at t-1 (in the order of zeta_back_mixed), then all vars at t (in the orig order), then forward vars at t+1 (in the order of zeta_fwrd_mixed), then exogenous vars.
+
+    The model is first split, using the non zero elements of the jacobian, into
+    a block of purely backward variables which does not depend on the other
+    variables (typically the exogenous processes), a block of purely forward
+    variables on which the other variables do not depend (typically asset
+    prices), and the core. Only the core goes through the QZ decomposition, the
+    first block being solved by an LU decomposition, the second by the
+    generalized eigenvalues of its own (small) pencil, and the cross terms by
+    Sylvester equations. If no block is found, or if one of the smaller
+    problems fails, the whole model goes through the QZ, so that the decision
+    rules and the exceptions are the same as without the blocks.
+
+    With cyclic or logarithmic reduction, the Blanchard-Kahn conditions are
+    checked on the solution: the eigenvalues of the rules of the states
+    must be stable, and the other generalized eigenvalues, given by the
+    forward part of (A_0+A_p*X)^(-1)*A_p, explosive. If the reduction does
+    not converge or if the conditions fail, the QZ decomposition is used, so
+    that the exceptions are the same as with the QZ.
   */
   void compute(const Matrix &jacobian, Matrix &g_y, Matrix &g_u) throw (BlanchardKahnException, GeneralizedSchurDecomposition::GSDException);
+  /*!
+    If the last call to compute() used the blocks, the eigenvalues are those of
+    the core (stable ones first), then those of the backward and forward blocks.
+    With cyclic or logarithmic reduction, they are computed from the solution
+    (see compute()).
+  */
   template<class Vec1, class Vec2>
   void getGeneralizedEigenvalues(Vec1 &eig_real, Vec2 &eig_cmplx);
+private:
+  //! Computes g_y on the whole model, with the chosen solver or with a QZ decomposition
+  void computeWithoutBlocks(const Matrix &jacobian, Matrix &g_y) throw (BlanchardKahnException, GeneralizedSchurDecomposition::GSDException, LUSolver::LUException);
+  //! Computes g_y for the dynamic variables with a QZ decomposition
+  void computeWithQZ(Matrix &g_y) throw (BlanchardKahnException, GeneralizedSchurDecomposition::GSDException);
+  //! Computes g_y for the dynamic variables by cyclic or logarithmic reduction, returns false if it failed
+  bool computeWithReduction(Matrix &g_y);
+  //! Computes g_y block by block, returns false if this was not possible
+  bool computeWithBlocks(const Matrix &jacobian, Matrix &g_y);
+  //! Finds the purely backward and purely forward blocks, returns false if there are none
+  bool findBlocks(const Matrix &jacobian, std::vector<size_t> &vars_B, std::vector<size_t> &eqs_B,
+                  std::vector<size_t> &vars_F, std::vector<size_t> &eqs_F);
+  //! Computes g_u given g_y
+  void computeShocks(const Matrix &jacobian, const Matrix &g_y, Matrix &g_u);
 };
 
 std::ostream &operator<<(std::ostream &out, const DecisionRules::BlanchardKahnException &e);
@@ -73,5 +150,16 @@ template<class Vec1, class Vec2>
 void
 DecisionRules::getGeneralizedEigenvalues(Vec1 &eig_real, Vec2 &eig_cmplx)
 {
-  GSD.getGeneralizedEigenvalues(eig_real, eig_cmplx);
+  if (!eig_stored)
+    {
+      GSD.getGeneralizedEigenvalues(eig_real, eig_cmplx);
+      return;
+    }
+
+  assert(eig_real.getSize() == eig_real_stored.size() && eig_cmplx.getSize() == eig_cmplx_stored.size());
+  for (size_t i = 0; i < eig_real_stored.size(); i++)
+    {
+      eig_real(i) = eig_real_stored[i];
+      eig_cmplx(i) = eig_cmplx_stored[i];
+    }
 }
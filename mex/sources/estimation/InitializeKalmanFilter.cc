@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010-2013 Dynare Team
+ * Copyright (C) 2010-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -37,13 +37,24 @@ InitializeKalmanFilter::InitializeKalmanFilter(const std::string &basename, size
                                                const std::vector<size_t> &varobs_arg,
                                                double qz_criterium_arg,
                                                double lyapunov_tol_arg,
+                                               LyapunovSolver lyapunov_solver_arg,
+                                               DecisionRules::Solver dr_solver_arg,
+                                               double dr_tol_arg,
                                                bool noconstant_arg) :
   lyapunov_tol(lyapunov_tol_arg),
+  lyapunov_solver(lyapunov_solver_arg),
   zeta_varobs_back_mixed(zeta_varobs_back_mixed_arg),
   detrendData(varobs_arg, noconstant_arg),
   modelSolution(basename, n_endo_arg, n_exo_arg, zeta_fwrd_arg, zeta_back_arg,
-                zeta_mixed_arg, zeta_static_arg, qz_criterium_arg),
-  discLyapFast(zeta_varobs_back_mixed.size()),
+                zeta_mixed_arg, zeta_static_arg, qz_criterium_arg, dr_solver_arg, dr_tol_arg),
+  discLyapFast(lyapunov_solver_arg == doubling ? zeta_varobs_back_mixed.size()
+               : lyapunov_solver_arg == doublingStates ? zeta_back_arg.size() + zeta_mixed_arg.size() : 0),
+  discLyapSchur(lyapunov_solver_arg == schurStates ? zeta_back_arg.size() + zeta_mixed_arg.size() : 0),
+  Tss(zeta_back_arg.size() + zeta_mixed_arg.size()),
+  RQRtss(zeta_back_arg.size() + zeta_mixed_arg.size()),
+  Pss(zeta_back_arg.size() + zeta_mixed_arg.size()),
+  Ts(zeta_varobs_back_mixed.size(), zeta_back_arg.size() + zeta_mixed_arg.size()),
+  TsPss(zeta_varobs_back_mixed.size(), zeta_back_arg.size() + zeta_mixed_arg.size()),
   g_x(n_endo_arg, zeta_back_arg.size() + zeta_mixed_arg.size()),
   g_u(n_endo_arg, n_exo_arg),
   Rt(n_exo_arg, zeta_varobs_back_mixed.size()),
@@ -67,10 +78,39 @@ InitializeKalmanFilter::setT(Matrix &T)
 }
 
 void
-InitializeKalmanFilter::setPstar(Matrix &Pstar, Matrix &Pinf, const Matrix &T, const Matrix &RQRt) throw (DiscLyapFast::DLPException)
+InitializeKalmanFilter::setPstar(Matrix &Pstar, Matrix &Pinf, const Matrix &T, const Matrix &RQRt) throw (DiscLyapFast::DLPException, DiscLyapSchur::DLSException)
 {
+  if (lyapunov_solver == doubling)
+    discLyapFast.solve_lyap(T, RQRt, Pstar, lyapunov_tol, 0);
+  else
+    {
+      /* Only the columns of the states are non zero in T, so that
+         T*Pstar*T' = Ts*Pss*Ts', where Ts=T(:,s) and Pss=Pstar(s,s) is the
+         solution of the Lyapunov equation restricted to the states:
+         Pss = Tss*Pss*Tss' + RQRtss */
+      const size_t n_s = pi_bm_vbm.size();
+      for (size_t j = 0; j < n_s; j++)
+        {
+          for (size_t i = 0; i < n_s; i++)
+            {
+              Tss(i, j) = T(pi_bm_vbm[i], pi_bm_vbm[j]);
+              RQRtss(i, j) = RQRt(pi_bm_vbm[i], pi_bm_vbm[j]);
+            }
+          mat::col_copy(T, pi_bm_vbm[j], Ts, j);
+        }
 
-  discLyapFast.solve_lyap(T, RQRt, Pstar, lyapunov_tol, 0);
+      // Pstar = Ts*Pss*Ts' + RQRt
+      Pstar = RQRt;
+      if (n_s > 0)
+        {
+          if (lyapunov_solver == doublingStates)
+            discLyapFast.solve_lyap(Tss, RQRtss, Pss, lyapunov_tol, 0);
+          else
+            discLyapSchur.solve_lyap(Tss, RQRtss, Pss);
+          blas::gemm("N", "N", 1.0, Ts, Pss, 0.0, TsPss);
+          blas::gemm("N", "T", 1.0, TsPss, Ts, 1.0, Pstar);
+        }
+    }
 
   Pinf.setAll(0.0);
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010-2013 Dynare Team
+ * Copyright (C) 2010-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -29,6 +29,7 @@
 #include "DetrendData.hh"
 #include "ModelSolution.hh"
 #include "DiscLyapFast.hh"
+#include "DiscLyapSchur.hh"
 #include <string>
 
 /**
@@ -40,15 +41,26 @@ class InitializeKalmanFilter
 {
 
 public:
+  //! Algorithm used for the Lyapunov equation giving Pstar
+  enum LyapunovSolver
+  {
+    doubling = 0, // doubling algorithm on the whole transition matrix
+    doublingStates = 1, // doubling algorithm on the block of the states (backward and mixed variables)
+    schurStates = 2 // Schur (Bartels-Stewart) algorithm on the block of the states
+  };
+
   /*!
     \param[in] zeta_varobs_back_mixed_arg The union of indices of observed, backward and mixed variables
+    \param[in] lyapunov_solver_arg The algorithm used for Pstar
+    \param[in] dr_solver_arg The algorithm used for the first order decision rules, with tolerance dr_tol_arg
   */
   InitializeKalmanFilter(const std::string &basename, size_t n_endo, size_t n_exo, const std::vector<size_t> &zeta_fwrd_arg,
                          const std::vector<size_t> &zeta_back_arg, const std::vector<size_t> &zeta_mixed_arg, const std::vector<size_t> &zeta_static_arg,
                          const std::vector<size_t> &zeta_varobs_back_mixed_arg,
                          const std::vector<size_t> &varobs_arg,
                          double qz_criterium_arg, double lyapunov_tol_arg,
-                         bool noconstant_arg);
+                         LyapunovSolver lyapunov_solver_arg,
+                         DecisionRules::Solver dr_solver_arg, double dr_tol_arg, bool noconstant_arg);
   virtual ~InitializeKalmanFilter();
   // initialise parameter dependent KF matrices only but not Ps
   template <class Vec1, class Vec2, class Mat1, class Mat2>
@@ -77,6 +89,7 @@ public:
 
 private:
   const double lyapunov_tol;
+  const LyapunovSolver lyapunov_solver;
   const std::vector<size_t> zeta_varobs_back_mixed;
   //! Indices of back+mixed zetas inside varobs+back+mixed zetas
   std::vector<size_t> pi_bm_vbm;
@@ -84,6 +97,9 @@ private:
   DetrendData detrendData;
   ModelSolution modelSolution;
   DiscLyapFast discLyapFast; //Lyapunov solver
+  DiscLyapSchur discLyapSchur;
+  //! Block of the states of T and RQRt, Lyapunov solution for this block, columns of the states of T and their product with it
+  Matrix Tss, RQRtss, Pss, Ts, TsPss;
   Matrix g_x;
   Matrix g_u;
   Matrix Rt, RQ;
@@ -98,7 +114,7 @@ private:
     blas::gemm("N", "N", 1.0, R, Q, 0.0, RQ); // R*Q
     blas::gemm("N", "T", 1.0, RQ, R, 0.0, RQRt); // R*Q*R'
   }
-  void setPstar(Matrix &Pstar, Matrix &Pinf, const Matrix &T, const Matrix &RQRt) throw (DiscLyapFast::DLPException);
+  void setPstar(Matrix &Pstar, Matrix &Pinf, const Matrix &T, const Matrix &RQRt) throw (DiscLyapFast::DLPException, DiscLyapSchur::DLSException);
 
 };
 
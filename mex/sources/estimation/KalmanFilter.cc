@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2009-2013 Dynare Team
+ * Copyright (C) 2009-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -36,6 +36,8 @@ KalmanFilter::KalmanFilter(const std::string &basename, size_t n_endo, size_t n_
                            const std::vector<size_t> &zeta_mixed_arg, const std::vector<size_t> &zeta_static_arg,
                            double qz_criterium_arg, const std::vector<size_t> &varobs_arg,
                            double riccati_tol_arg, double lyapunov_tol_arg,
+                           InitializeKalmanFilter::LyapunovSolver lyapunov_solver_arg,
+                           DecisionRules::Solver dr_solver_arg, double dr_tol_arg,
                            bool noconstant_arg) :
   zeta_varobs_back_mixed(compute_zeta_varobs_back_mixed(zeta_back_arg, zeta_mixed_arg, varobs_arg)),
   Z(varobs_arg.size(), zeta_varobs_back_mixed.size()), Zt(Z.getCols(), Z.getRows()), T(zeta_varobs_back_mixed.size()), R(zeta_varobs_back_mixed.size(), n_exo),
@@ -45,7 +47,7 @@ KalmanFilter::KalmanFilter(const std::string &basename, size_t n_endo, size_t n_
   oldKFinv(zeta_varobs_back_mixed.size(), varobs_arg.size()), a_init(zeta_varobs_back_mixed.size()),
   a_new(zeta_varobs_back_mixed.size()), vt(varobs_arg.size()), vtFinv(varobs_arg.size()), riccati_tol(riccati_tol_arg),
   initKalmanFilter(basename, n_endo, n_exo, zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg,
-                   zeta_static_arg, zeta_varobs_back_mixed, varobs_arg, qz_criterium_arg, lyapunov_tol_arg, noconstant_arg),
+                   zeta_static_arg, zeta_varobs_back_mixed, varobs_arg, qz_criterium_arg, lyapunov_tol_arg, lyapunov_solver_arg, dr_solver_arg, dr_tol_arg, noconstant_arg),
   FUTP(varobs_arg.size()*(varobs_arg.size()+1)/2)
 {
   Z.setAll(0.0);
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2009-2013 Dynare Team
+ * Copyright (C) 2009-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -53,7 +53,8 @@ public:
                const std::vector<size_t> &zeta_back_arg, const std::vector<size_t> &zeta_mixed_arg, const std::vector<size_t> &zeta_static_arg,
                double qz_criterium_arg, const std::vector<size_t> &varobs_arg,
                double riccati_tol_arg, double lyapunov_tol_arg,
-               bool noconstant_arg);
+               InitializeKalmanFilter::LyapunovSolver lyapunov_solver_arg,
+               DecisionRules::Solver dr_solver_arg, double dr_tol_arg, bool noconstant_arg);
 
   template <class Vec1, class Vec2, class Mat1>
   double compute(const MatrixConstView &dataView, Vec1 &steadyState,
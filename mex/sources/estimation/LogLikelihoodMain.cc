@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2009-2013 Dynare Team
+ * Copyright (C) 2009-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -29,11 +29,12 @@ LogLikelihoodMain::LogLikelihoodMain(const std::string &basename, EstimatedParam
                                      const std::vector<size_t> &zeta_fwrd_arg, const std::vector<size_t> &zeta_back_arg,
                                      const std::vector<size_t> &zeta_mixed_arg, const std::vector<size_t> &zeta_static_arg, const double qz_criterium,
                                      const std::vector<size_t> &varobs, double riccati_tol, double lyapunov_tol,
-                                     bool noconstant_arg)
+                                     InitializeKalmanFilter::LyapunovSolver lyapunov_solver,
+                                     DecisionRules::Solver dr_solver, double dr_tol, bool noconstant_arg)
 
   : estSubsamples(estiParDesc.estSubsamples),
     logLikelihoodSubSample(basename, estiParDesc, n_endo, n_exo, zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg, zeta_static_arg, qz_criterium,
-                           varobs, riccati_tol, lyapunov_tol, noconstant_arg),
+                           varobs, riccati_tol, lyapunov_tol, lyapunov_solver, dr_solver, dr_tol, noconstant_arg),
     vll(estiParDesc.getNumberOfPeriods()), // time dimension size of data
     detrendedData(varobs.size(), estiParDesc.getNumberOfPeriods())
 {
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+
+#include "CyclicReduction.hh"
+
+// 1-norm (maximum absolute column sum), NaN if there is a NaN
+static double
+norm1(const Matrix &M)
+{
+  double res = 0.0;
+  for (size_t j = 0; j < M.getCols(); j++)
+    {
+      double s = 0.0;
+      for (size_t i = 0; i < M.getRows(); i++)
+        s += std::fabs(M(i, j));
+      if (s > res || s != s)
+        res = s;
+    }
+  return res;
+}
+
+CyclicReduction::CyclicReduction(size_t n_arg, double tol_arg, size_t max_iter_arg) :
+  n(n_arg), tol(tol_arg), max_iter(max_iter_arg),
+  A0(n), A1(n), A2(n), Ahat1(n), A0_init(n), W(n, 2*n), A1_tmp(n),
+  T00(n), T02(n), T20(n), T22(n), LU(n)
+{
+}
+
+void
+CyclicReduction::iterate() throw (CRException)
+{
+  A0_init = A0;
+  Ahat1 = A1;
+  MatrixView W0(W, 0, 0, n, n), W2(W, 0, n, n, n);
+
+  size_t it = 0;
+  while (true)
+    {
+      W0 = A0;
+      W2 = A2;
+      A1_tmp = A1;
+      try
+        {
+          LU.invMult("N", A1_tmp, W);
+        }
+      catch (LUSolver::LUException &e)
+        {
+          throw CRException(1, std::string("CyclicReduction: singular matrix"));
+        }
+
+      blas::gemm("N", "N", 1.0, A0, W0, 0.0, T00);
+      blas::gemm("N", "N", 1.0, A0, W2, 0.0, T02);
+      blas::gemm("N", "N", 1.0, A2, W0, 0.0, T20);
+      blas::gemm("N", "N", 1.0, A2, W2, 0.0, T22);
+      mat::sub(A1, T02);
+      mat::sub(A1, T20);
+      mat::sub(Ahat1, T20);
+      A0 = T00;
+      mat::negate(A0);
+      A2 = T22;
+      mat::negate(A2);
+      it++;
+
+      const double crit = norm1(A0);
+      if (crit != crit)
+        throw CRException(2, std::string("CyclicReduction: NaN in the iterations"));
+      if (crit < tol && norm1(A2) < tol)
+        break;
+      if (it == max_iter)
+        throw CRException(3, std::string("CyclicReduction: no convergence"));
+    }
+
+  // X=-Ahat1^(-1)*A0
+  try
+    {
+      LU.invMult("N", Ahat1, A0_init);
+    }
+  catch (LUSolver::LUException &e)
+    {
+      throw CRException(1, std::string("CyclicReduction: singular matrix"));
+    }
+  mat::negate(A0_init);
+}
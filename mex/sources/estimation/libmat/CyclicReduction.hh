@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CYCLIC_REDUCTION_HH
+#define _CYCLIC_REDUCTION_HH
+
+#include <string>
+
+#include "Matrix.hh"
+#include "BlasBindings.hh"
+#include "LUSolver.hh"
+
+/*!
+  Computes the minimal solvent X of the matrix quadratic equation
+  A0+A1*X+A2*X^2=0 (the solution with the eigenvalues of smallest modulus)
+  by cyclic reduction, as in cycle_reduction.m: at each step
+    A1 <- A1-A0*A1^(-1)*A2-A2*A1^(-1)*A0, A0 <- -A0*A1^(-1)*A0,
+    A2 <- -A2*A1^(-1)*A2, Ahat1 <- Ahat1-A2*A1^(-1)*A0,
+  until A0 and A2 vanish, and X=-Ahat1^(-1)*A0 (with the initial A0).
+  Each step is one LU decomposition and four matrix products.
+*/
+class CyclicReduction
+{
+public:
+  class CRException
+  {
+  public:
+    const int info;
+    std::string message;
+    CRException(int info_arg, std::string message_arg) :
+      info(info_arg), message(message_arg)
+    {
+    };
+  };
+
+private:
+  const size_t n;
+  const double tol;
+  const size_t max_iter;
+  Matrix A0, A1, A2, Ahat1, A0_init;
+  //! A1^(-1)*[A0 A2], and a copy of A1 for its LU decomposition
+  Matrix W, A1_tmp;
+  Matrix T00, T02, T20, T22;
+  LUSolver LU;
+  //! Iterates on A0, A1, A2 and Ahat1, and stores the solution in A0_init
+  void iterate() throw (CRException);
+public:
+  //! \param tol_arg Tolerance on the 1-norms of A0 and A2
+  CyclicReduction(size_t n_arg, double tol_arg, size_t max_iter_arg = 300);
+  virtual ~CyclicReduction() {};
+  template<class Mat0, class Mat1, class Mat2, class MatX>
+  void solve(const Mat0 &A0_arg, const Mat1 &A1_arg, const Mat2 &A2_arg, MatX &X) throw (CRException);
+};
+
+template<class Mat0, class Mat1, class Mat2, class MatX>
+void
+CyclicReduction::solve(const Mat0 &A0_arg, const Mat1 &A1_arg, const Mat2 &A2_arg, MatX &X) throw (CRException)
+{
+  assert(A0_arg.getRows() == n && A0_arg.getCols() == n
+         && A1_arg.getRows() == n && A1_arg.getCols() == n
+         && A2_arg.getRows() == n && A2_arg.getCols() == n
+         && X.getRows() == n && X.getCols() == n);
+
+  A0 = A0_arg;
+  A1 = A1_arg;
+  A2 = A2_arg;
+  iterate();
+  X = A0_init;
+}
+
+#endif
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DiscLyapSchur.hh"
+
+DiscLyapSchur::DiscLyapSchur(size_t n_arg) :
+  n(n_arg), G0(n), has_schur(false), S(n), S2(n), U(n), Y(n), W(n), M(n),
+  w1(n), w2(n), r1(n), r2(n)
+{
+  wr = new double[n];
+  wi = new double[n];
+  bwork = new lapack_int[n];
+
+  // Workspace query
+  lapack_int n2 = n, ld = n > 0 ? n : 1, sdim, info;
+  double work_size;
+  lwork = -1;
+  dgees("V", "N", NULL, &n2, S.getData(), &ld, &sdim, wr, wi, U.getData(), &ld,
+        &work_size, &lwork, bwork, &info);
+  lwork = info == 0 ? (lapack_int) work_size : 3*n;
+  if (lwork < 1)
+    lwork = 1;
+  work = new double[(int) lwork];
+}
+
+DiscLyapSchur::~DiscLyapSchur()
+{
+  delete[] wr;
+  delete[] wi;
+  delete[] work;
+  delete[] bwork;
+}
+
+void
+DiscLyapSchur::computeSchur() throw (DLSException)
+{
+  has_schur = false;
+  S = G0;
+  lapack_int n2 = n, ld = n > 0 ? n : 1, sdim, info;
+  dgees("V", "N", NULL, &n2, S.getData(), &ld, &sdim, wr, wi, U.getData(), &ld,
+        work, &lwork, bwork, &info);
+  if (info != 0)
+    throw DLSException((int) info, std::string("DiscLyapSchur: the QR algorithm failed to compute the Schur form"));
+  for (size_t i = 0; i < n; i++)
+    if (wr[i]*wr[i] + wi[i]*wi[i] >= 1.0)
+      throw DLSException(0, std::string("DiscLyapSchur: the matrix has eigenvalues outside the unit circle"));
+
+  blas::gemm("N", "N", 1.0, S, S, 0.0, S2);
+  has_schur = true;
+}
+
+void
+DiscLyapSchur::setSystem(double alpha, double beta)
+{
+  // Only the upper part and the subdiagonal of the 2×2 blocks are used
+  for (size_t j = 0; j < n; j++)
+    for (size_t i = 0; i <= j + 1 && i < n; i++)
+      M(i, j) = alpha*S(i, j) + beta*S2(i, j) + (i == j ? 1.0 : 0.0);
+}
+
+void
+DiscLyapSchur::solveQuasiTriangular(Vector &r)
+{
+  size_t j = n;
+  while (j > 0)
+    if (j > 1 && S(j-1, j-2) != 0.0)
+      {
+        // 2×2 block on rows and columns j-2 and j-1
+        const size_t i = j-2;
+        const double a = M(i, i), b = M(i, i+1), c = M(i+1, i), d = M(i+1, i+1);
+        const double det = a*d - b*c;
+        const double x1 = (d*r(i) - b*r(i+1))/det;
+        const double x2 = (a*r(i+1) - c*r(i))/det;
+        r(i) = x1;
+        r(i+1) = x2;
+        for (size_t k = 0; k < i; k++)
+          r(k) -= M(k, i)*x1 + M(k, i+1)*x2;
+        j -= 2;
+      }
+    else
+      {
+        const size_t i = j-1;
+        r(i) /= M(i, i);
+        for (size_t k = 0; k < i; k++)
+          r(k) -= M(k, i)*r(i);
+        j--;
+      }
+}
+
+void
+DiscLyapSchur::solveTransformed()
+{
+  /* Column j of Y=S*Y*S'+C is Y(:,j) = S*(sum_k Y(:,k)*S(j,k)) + C(:,j),
+     where the sum runs over k>=j (and k=j-1 for a 2×2 block), so that the
+     columns can be computed from the last one, the contribution of the
+     columns already computed being moved to the right hand side */
+  size_t j = n;
+  while (j > 0)
+    {
+      const bool pair = (j > 1 && S(j-1, j-2) != 0.0);
+      const size_t i = pair ? j-2 : j-1;
+      VectorView y1 = mat::get_col(Y, i);
+      r1 = y1;
+      if (j < n)
+        {
+          // w1 = Y(:,j:n)*S(i,j:n)', r1 = C(:,i) + S*w1
+          MatrixView Yk(Y, 0, j, n, n-j);
+          VectorView s1(S.getData() + i + j*n, n-j, n);
+          blas::gemv("N", 1.0, Yk, s1, 0.0, w1);
+          blas::gemv("N", 1.0, S, w1, 1.0, r1);
+        }
+      if (!pair)
+        {
+          // (I - s*S)*y = r1
+          setSystem(-S(i, i), 0.0);
+          solveQuasiTriangular(r1);
+          y1 = r1;
+          j--;
+          continue;
+        }
+
+      VectorView y2 = mat::get_col(Y, i+1);
+      r2 = y2;
+      if (j < n)
+        {
+          MatrixView Yk(Y, 0, j, n, n-j);
+          VectorView s2(S.getData() + i + 1 + j*n, n-j, n);
+          blas::gemv("N", 1.0, Yk, s2, 0.0, w1);
+          blas::gemv("N", 1.0, S, w1, 1.0, r2);
+        }
+      /* With B=[a b; c d] the 2×2 block of S, the two columns satisfy
+           (I-a*S)*y1 - b*S*y2 = r1
+           -c*S*y1 + (I-d*S)*y2 = r2
+         Eliminating y2 gives (I-(a+d)*S+(a*d-b*c)*S^2)*y1 = (I-d*S)*r1 + b*S*r2 */
+      const double a = S(i, i), b = S(i, i+1), c = S(i+1, i), d = S(i+1, i+1);
+      blas::gemv("N", 1.0, S, r1, 0.0, w1);
+      blas::gemv("N", 1.0, S, r2, 0.0, w2);
+      for (size_t k = 0; k < n; k++)
+        w1(k) = r1(k) - d*w1(k) + b*w2(k);
+      setSystem(-(a+d), a*d-b*c);
+      solveQuasiTriangular(w1);
+      y1 = w1;
+      // (I-d*S)*y2 = r2 + c*S*y1
+      blas::gemv("N", c, S, w1, 1.0, r2);
+      setSystem(-d, 0.0);
+      solveQuasiTriangular(r2);
+      y2 = r2;
+      j -= 2;
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DISC_LYAP_SCHUR_HH
+#define _DISC_LYAP_SCHUR_HH
+
+#include <string>
+
+#include <dynlapack.h>
+
+#include "Vector.hh"
+#include "Matrix.hh"
+#include "BlasBindings.hh"
+
+/*!
+  Solves the discrete Lyapunov equation X=G*X*G'+V, using the real Schur
+  form G=U*S*U' (Bartels-Stewart algorithm, as in lyapunov_symm.m): the
+  equation Y=S*Y*S'+U'*V*U is solved column by column (by pairs of columns
+  for the 2×2 blocks of S), starting from the last one, and X=U*Y*U'.
+
+  The Schur form of G is kept between the calls, and is not recomputed if G
+  did not change (which is typically the case when only the variances of
+  the shocks are modified). All the workspaces are allocated at construction.
+*/
+class DiscLyapSchur
+{
+public:
+  class DLSException
+  {
+  public:
+    const int info;
+    std::string message;
+    DLSException(int info_arg, std::string message_arg) :
+      info(info_arg), message(message_arg)
+    {
+    };
+  };
+
+private:
+  const size_t n;
+  //! The last matrix G whose Schur form was computed
+  Matrix G0;
+  bool has_schur;
+  //! Schur form S, its square, and Schur vectors U
+  Matrix S, S2, U;
+  //! Transformed equation, and workspace
+  Matrix Y, W;
+  //! Quasi triangular matrix of the system for a column or a pair of columns
+  Matrix M;
+  Vector w1, w2, r1, r2;
+  lapack_int lwork;
+  double *wr, *wi, *work;
+  lapack_int *bwork;
+  void computeSchur() throw (DLSException);
+  //! Solves Y=S*Y*S'+Y in place
+  void solveTransformed();
+  //! Solves M*x=r in place, M having the block structure of S
+  void solveQuasiTriangular(Vector &r);
+  //! M = I + alpha*S + beta*S^2
+  void setSystem(double alpha, double beta);
+public:
+  DiscLyapSchur(size_t n_arg);
+  virtual ~DiscLyapSchur();
+  template <class MatG, class MatV, class MatX>
+  void solve_lyap(const MatG &G, const MatV &V, MatX &X) throw (DLSException);
+};
+
+template <class MatG, class MatV, class MatX>
+void
+DiscLyapSchur::solve_lyap(const MatG &G, const MatV &V, MatX &X) throw (DLSException)
+{
+  assert(G.getRows() == n && G.getCols() == n && V.getRows() == n && V.getCols() == n
+         && X.getRows() == n && X.getCols() == n);
+
+  if (!has_schur || mat::isDiff(G, G0, 0.0))
+    {
+      G0 = G;
+      computeSchur();
+    }
+
+  // Y=U'*V*U
+  blas::gemm("T", "N", 1.0, U, V, 0.0, W);
+  blas::gemm("N", "N", 1.0, W, U, 0.0, Y);
+
+  solveTransformed();
+
+  // X=U*Y*U', symmetrized
+  blas::gemm("N", "N", 1.0, U, Y, 0.0, W);
+  blas::gemm("N", "T", 1.0, W, U, 0.0, Y);
+  for (size_t j = 0; j < n; j++)
+    for (size_t i = 0; i <= j; i++)
+      X(i, j) = X(j, i) = 0.5*(Y(i, j) + Y(j, i));
+}
+
+#endif
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010 Dynare Team
+ * Copyright (C) 2010-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -17,6 +17,9 @@
  * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifndef _LU_SOLVER_HH
+#define _LU_SOLVER_HH
+
 #include <cstdlib>
 #include <cassert>
 
@@ -61,3 +64,5 @@ LUSolver::invMult(const char *trans, Mat1 &A, Mat2 &B) throw (LUException)
   dgetrs(trans, &n, &nrhs, A.getData(), &lda, ipiv, B.getData(), &ldb, &info);
   assert(info == 0);
 }
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+
+#include "LogarithmicReduction.hh"
+
+// Largest absolute value of the elements, NaN if there is a NaN
+static double
+max_abs(const Matrix &M)
+{
+  double res = 0.0;
+  for (size_t j = 0; j < M.getCols(); j++)
+    for (size_t i = 0; i < M.getRows(); i++)
+      if (std::fabs(M(i, j)) > res || M(i, j) != M(i, j))
+        res = std::fabs(M(i, j));
+  return res;
+}
+
+LogarithmicReduction::LogarithmicReduction(size_t n_arg, double tol_arg, size_t max_iter_arg) :
+  n(n_arg), tol(tol_arg), max_iter(max_iter_arg),
+  A1(n), X0(n), HL(n, 2*n), HL2(n, 2*n), U(n), M(n), tmp(n), LU(n)
+{
+}
+
+void
+LogarithmicReduction::iterate() throw (LRException)
+{
+  MatrixView H(HL, 0, 0, n, n), L(HL, 0, n, n, n),
+    H2(HL2, 0, 0, n, n), L2(HL2, 0, n, n, n);
+
+  // [H L] = -A1^(-1)*[A2 A0]
+  try
+    {
+      LU.invMult("N", A1, HL);
+    }
+  catch (LUSolver::LUException &e)
+    {
+      throw LRException(1, std::string("LogarithmicReduction: singular matrix"));
+    }
+  mat::negate(HL);
+  X0 = L;
+  U = H;
+
+  for (size_t it = 0; it < max_iter; it++)
+    {
+      // M = I-H*L-L*H
+      mat::set_identity(M);
+      blas::gemm("N", "N", -1.0, H, L, 1.0, M);
+      blas::gemm("N", "N", -1.0, L, H, 1.0, M);
+      blas::gemm("N", "N", 1.0, H, H, 0.0, H2);
+      blas::gemm("N", "N", 1.0, L, L, 0.0, L2);
+      try
+        {
+          LU.invMult("N", M, HL2);
+        }
+      catch (LUSolver::LUException &e)
+        {
+          throw LRException(1, std::string("LogarithmicReduction: singular matrix"));
+        }
+      HL = HL2;
+
+      // X <- X+U*L, U <- U*H
+      blas::gemm("N", "N", 1.0, U, L, 0.0, tmp);
+      mat::add(X0, tmp);
+      const double change = max_abs(tmp);
+      if (change != change)
+        throw LRException(2, std::string("LogarithmicReduction: NaN in the iterations"));
+      if (change <= tol)
+        return;
+      blas::gemm("N", "N", 1.0, U, H, 0.0, tmp);
+      U = tmp;
+    }
+
+  throw LRException(3, std::string("LogarithmicReduction: no convergence"));
+}
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _LOGARITHMIC_REDUCTION_HH
+#define _LOGARITHMIC_REDUCTION_HH
+
+#include <string>
+
+#include "Matrix.hh"
+#include "BlasBindings.hh"
+#include "LUSolver.hh"
+
+/*!
+  Computes the minimal solvent X of the matrix quadratic equation
+  A0+A1*X+A2*X^2=0 by logarithmic reduction, as in logarithmic_reduction.m:
+  starting from H=-A1^(-1)*A2, L=-A1^(-1)*A0, X=L and U=H, each step computes
+    [H L] <- (I-H*L-L*H)^(-1)*[H^2 L^2], X <- X+U*L, U <- U*H
+  until the change in X is below the tolerance. The convergence is
+  quadratic, each step being one LU decomposition and six matrix products.
+*/
+class LogarithmicReduction
+{
+public:
+  class LRException
+  {
+  public:
+    const int info;
+    std::string message;
+    LRException(int info_arg, std::string message_arg) :
+      info(info_arg), message(message_arg)
+    {
+    };
+  };
+
+private:
+  const size_t n;
+  const double tol;
+  const size_t max_iter;
+  Matrix A1, X0;
+  //! [H L], and [H^2 L^2] before the solve
+  Matrix HL, HL2;
+  Matrix U, M, tmp;
+  LUSolver LU;
+  //! Iterates from A1, H=A2 and L=A0 (stored in HL), and stores the solution in X0
+  void iterate() throw (LRException);
+public:
+  //! \param tol_arg Tolerance on the largest change of an element of X
+  LogarithmicReduction(size_t n_arg, double tol_arg, size_t max_iter_arg = 100);
+  virtual ~LogarithmicReduction() {};
+  template<class Mat0, class Mat1, class Mat2, class MatX>
+  void solve(const Mat0 &A0_arg, const Mat1 &A1_arg, const Mat2 &A2_arg, MatX &X) throw (LRException);
+};
+
+template<class Mat0, class Mat1, class Mat2, class MatX>
+void
+LogarithmicReduction::solve(const Mat0 &A0_arg, const Mat1 &A1_arg, const Mat2 &A2_arg, MatX &X) throw (LRException)
+{
+  assert(A0_arg.getRows() == n && A0_arg.getCols() == n
+         && A1_arg.getRows() == n && A1_arg.getCols() == n
+         && A2_arg.getRows() == n && A2_arg.getCols() == n
+         && X.getRows() == n && X.getCols() == n);
+
+  A1 = A1_arg;
+  MatrixView(HL, 0, 0, n, n) = A2_arg;
+  MatrixView(HL, 0, n, n, n) = A0_arg;
+  iterate();
+  X = X0;
+}
+
+#endif
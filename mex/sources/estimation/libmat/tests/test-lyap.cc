@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+
+#include "DiscLyapFast.hh"
+#include "DiscLyapSchur.hh"
+
+int
+main(int argc, char **argv)
+{
+  size_t n = 4;
+  // A stable matrix with a pair of complex eigenvalues
+  double G_data[] = { 0.9, 0.3, 0.0, 0.1,
+                      -0.4, 0.7, 0.2, 0.0,
+                      0.0, 0.0, 0.5, -0.2,
+                      0.1, 0.0, 0.3, -0.6 };
+  double V_data[] = { 2.0, 0.5, 0.0, 0.1,
+                      0.5, 1.0, 0.2, 0.0,
+                      0.0, 0.2, 1.5, 0.3,
+                      0.1, 0.0, 0.3, 0.8 };
+  MatrixView G(G_data, n, n, n), V(V_data, n, n, n);
+
+  // Need to transpose because internally matrices are in column-major order
+  mat::transpose(G);
+
+  std::cout << "G =" << std::endl << G << std::endl;
+  std::cout << "V =" << std::endl << V << std::endl;
+
+  DiscLyapFast DLF(n);
+  DiscLyapSchur DLS(n);
+  Matrix X_doubling(n), X_schur(n), R(n), GX(n);
+
+  DLF.solve_lyap(G, V, X_doubling, 1e-16, 0);
+  DLS.solve_lyap(G, V, X_schur);
+
+  std::cout << "X (doubling) =" << std::endl << X_doubling << std::endl;
+  std::cout << "X (Schur) =" << std::endl << X_schur << std::endl;
+
+  // Residual R = G*X*G' + V - X
+  R = V;
+  blas::gemm("N", "N", 1.0, G, X_schur, 0.0, GX);
+  blas::gemm("N", "T", 1.0, GX, G, 1.0, R);
+  mat::sub(R, X_schur);
+  double res = mat::nrminf(R);
+
+  // The Schur form is reused for a new right hand side
+  mat::transpose(V);
+  mat::add(V, 1.0);
+  DLF.solve_lyap(G, V, X_doubling, 1e-16, 0);
+  DLS.solve_lyap(G, V, X_schur);
+  mat::sub(X_doubling, X_schur);
+  double diff = mat::nrminf(X_doubling);
+
+  std::cout << "Residual: " << res << std::endl;
+  std::cout << "Difference with the doubling algorithm (new right hand side): " << diff << std::endl;
+
+  return (res < 1e-12 && diff < 1e-10) ? 0 : 1;
+}
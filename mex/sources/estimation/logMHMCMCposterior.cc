@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010-2013 Dynare Team
+ * Copyright (C) 2010-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -438,6 +438,12 @@ sampleMHMC(LogPosteriorDensity &lpd, RandomWalkMetropolisHastings &rwmh,
               mexPrintf(" Lyapunov solver Exception in RandomWalkMH : %s ,  info: %d\n", dlpe.message.c_str(), dlpe.info);
               goto cleanup;
             }
+          catch (const DiscLyapSchur::DLSException &dlse)
+            {
+              iret = -50;
+              mexPrintf(" Lyapunov solver Exception in RandomWalkMH : %s ,  info: %d\n", dlse.message.c_str(), dlse.info);
+              goto cleanup;
+            }
           catch (const std::runtime_error &re)
             {
               iret = -3;
@@ -681,6 +687,23 @@ logMCMCposterior(VectorConstView &estParams, const MatrixConstView &data,
   double qz_criterium = *mxGetPr(mxGetField(options_, 0, "qz_criterium"));
   double lyapunov_tol = *mxGetPr(mxGetField(options_, 0, "lyapunov_complex_threshold"));
   double riccati_tol = *mxGetPr(mxGetField(options_, 0, "riccati_tol"));
+  // As in dsge_likelihood.m, the Schur algorithm is used for Pstar unless the doubling algorithm is requested
+  InitializeKalmanFilter::LyapunovSolver lyapunov_solver = InitializeKalmanFilter::schurStates;
+  if (*mxGetPr(mxGetField(options_, 0, "lyapunov_db")) == 1)
+    lyapunov_solver = InitializeKalmanFilter::doublingStates;
+  // As in dyn_first_order_solver.m, the reduction algorithms replace the QZ when requested
+  DecisionRules::Solver dr_solver = DecisionRules::qz;
+  double dr_tol = 0.0;
+  if (*mxGetPr(mxGetField(options_, 0, "dr_cycle_reduction")) == 1)
+    {
+      dr_solver = DecisionRules::cycleReduction;
+      dr_tol = *mxGetPr(mxGetField(options_, 0, "dr_cycle_reduction_tol"));
+    }
+  else if (*mxGetPr(mxGetField(options_, 0, "dr_logarithmic_reduction")) == 1)
+    {
+      dr_solver = DecisionRules::logarithmicReduction;
+      dr_tol = *mxGetPr(mxGetField(options_, 0, "dr_logarithmic_reduction_tol"));
+    }
   size_t presample = (size_t) *mxGetPr(mxGetField(options_, 0, "presample"));
   size_t console_mode = (size_t) *mxGetPr(mxGetField(options_, 0, "console_mode"));
   size_t load_mh_file = (size_t) *mxGetPr(mxGetField(options_, 0, "load_mh_file"));
@@ -717,7 +740,7 @@ logMCMCposterior(VectorConstView &estParams, const MatrixConstView &data,
 
   // Allocate LogPosteriorDensity object
   LogPosteriorDensity lpd(basename, epd, n_endo, n_exo, zeta_fwrd, zeta_back, zeta_mixed, zeta_static,
-                          qz_criterium, varobs, riccati_tol, lyapunov_tol, noconstant);
+                          qz_criterium, varobs, riccati_tol, lyapunov_tol, lyapunov_solver, dr_solver, dr_tol, noconstant);
 
   // Construct MHMCMC Sampler
   RandomWalkMetropolisHastings rwmh(estParams.getSize());
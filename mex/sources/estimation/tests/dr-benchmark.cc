@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark of the algorithms of DecisionRules for the first order decision
+ * rules (QZ, cyclic reduction and logarithmic reduction, with and without the
+ * reduction to the block of the variables that are neither purely backward
+ * nor purely forward), on models made of m copies of a small model with
+ * exogenous processes, a capital stock, a static variable and two purely
+ * forward variables, each copy being linked to the previous one. The rules
+ * are compared to the ones given by the QZ on the whole model.
+ *
+ * Compile (from this directory) with:
+ *   g++ -O2 -I.. -I../libmat -I../../ dr-benchmark.cc ../DecisionRules.cc ../libmat/Matrix.cc
+ *     ../libmat/Vector.cc ../libmat/QRDecomposition.cc ../libmat/GeneralizedSchurDecomposition.cc
+ *     ../libmat/LUSolver.cc ../libmat/CyclicReduction.cc ../libmat/LogarithmicReduction.cc
+ *     -llapack -lblas -o dr-benchmark
+ * and run with the number of copies as optional arguments.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include "DecisionRules.hh"
+
+static double
+now()
+{
+  return (double) clock()/CLOCKS_PER_SEC;
+}
+
+/* The variables of copy i are z=i, w=m+i (exogenous processes), k=2m+i
+   (capital), c=3m+i (forward), h=4m+i (static), q=5m+i and p=6m+i (purely
+   forward, not feeding back into the core) */
+static void
+fill_jacobian(size_t m, Matrix &J)
+{
+  const size_t n = 7*m, nb = 3*m, nf = 3*m;
+  const size_t cur = nb, lead = nb+n, exo = nb+n+nf;
+  J.setAll(0.0);
+  for (size_t i = 0; i < m; i++)
+    {
+      const size_t z = i, w = m+i, k = 2*m+i, c = 3*m+i, h = 4*m+i, q = 5*m+i, p = 6*m+i;
+      // Leads are ordered as the forward variables: c, q, p
+      const size_t lc = lead+i, lq = lead+m+i, lp = lead+2*m+i;
+
+      J(z, cur+z) = 1; J(z, z) = -0.9; J(z, w) = 0.3; J(z, exo+i) = -1;
+      J(w, cur+w) = 1; J(w, w) = -0.5; J(w, cur+z) = -0.2; J(w, exo+m+i) = -1;
+      J(k, cur+k) = 1; J(k, k) = -1.05; J(k, cur+c) = 1; J(k, cur+z) = -1;
+      J(c, cur+c) = 1; J(c, lc) = -1; J(c, cur+k) = -0.1; J(c, cur+w) = -0.2;
+      J(h, cur+h) = 1; J(h, cur+c) = -1; J(h, cur+k) = -1;
+      J(q, cur+q) = 1; J(q, lq) = -0.96; J(q, cur+h) = -1;
+      J(p, cur+p) = 1; J(p, lp) = -0.9; J(p, lq) = -1; J(p, cur+z) = -0.3;
+      if (i > 0)
+        {
+          J(z, i-1) = -0.05;
+          J(k, k-1) = -0.01;
+          J(c, lc-1) = 0.02;
+          J(q, lq-1) = -0.01;
+        }
+    }
+}
+
+static bool
+run(size_t m, int reps)
+{
+  const size_t n = 7*m, n_exo = 2*m;
+  std::vector<size_t> zeta_fwrd, zeta_back, zeta_mixed, zeta_static;
+  for (size_t i = 0; i < 3*m; i++)
+    zeta_back.push_back(i);
+  for (size_t i = 3*m; i < 4*m; i++)
+    zeta_fwrd.push_back(i);
+  for (size_t i = 4*m; i < 5*m; i++)
+    zeta_static.push_back(i);
+  for (size_t i = 5*m; i < 7*m; i++)
+    zeta_fwrd.push_back(i);
+
+  Matrix J(n, 3*m+n+3*m+n_exo);
+  fill_jacobian(m, J);
+
+  const double qz_criterium = 1.000001;
+  Matrix g_y_qz(n, 3*m), g_u_qz(n, n_exo), g_y(n, 3*m), g_u(n, n_exo);
+  printf("n=%lu\n", (unsigned long) n);
+
+  const char *names[] = { "QZ", "cyclic reduction", "logarithmic reduction" };
+  const DecisionRules::Solver solvers[] = { DecisionRules::qz, DecisionRules::cycleReduction,
+                                            DecisionRules::logarithmicReduction };
+  bool ok = true;
+  for (int s = 0; s < 3; s++)
+    for (int blocks = 0; blocks < 2; blocks++)
+      {
+        DecisionRules dr(n, n_exo, zeta_fwrd, zeta_back, zeta_mixed, zeta_static, qz_criterium,
+                         blocks == 1, solvers[s], 1e-12);
+        double t0 = now();
+        for (int r = 0; r < reps; r++)
+          dr.compute(J, g_y, g_u);
+        double t = (now()-t0)/reps;
+        if (s == 0 && blocks == 0)
+          {
+            g_y_qz = g_y;
+            g_u_qz = g_u;
+          }
+        mat::sub(g_y, g_y_qz);
+        mat::sub(g_u, g_u_qz);
+        double err = std::max(mat::nrminf(g_y), mat::nrminf(g_u));
+        printf("  %-22s %-14s %.4fs, error %.2e\n", names[s], blocks ? "(blocks)" : "(whole model)", t, err);
+        ok = ok && err < 1e-8;
+      }
+  return ok;
+}
+
+int
+main(int argc, char **argv)
+{
+  bool ok = true;
+  if (argc > 1)
+    for (int i = 1; i < argc; i++)
+      ok = run((size_t) atoi(argv[i]), 5) && ok;
+  else
+    {
+      ok = run(5, 100) && ok;
+      ok = run(20, 20) && ok;
+      ok = run(50, 5) && ok;
+    }
+  printf(ok ? "OK\n" : "FAILED\n");
+  return ok ? 0 : 1;
+}
@@ -3,7 +3,7 @@
  */
 
 /*
- * Copyright (C) 2010-2013 Dynare Team
+ * Copyright (C) 2010-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -190,4 +190,88 @@ main(int argc, char **argv)
   mat::sub(real_g_u, g_u);
 
   assert(mat::nrminf(real_g_u) < 1e-12);
+
+  // Cyclic and logarithmic reduction must give the same rules as the QZ
+  for (int solver = DecisionRules::cycleReduction; solver <= DecisionRules::logarithmicReduction; solver++)
+    {
+      DecisionRules dr_reduction(endo_nbr, exo_nbr, zeta_fwrd, zeta_back, zeta_mixed, zeta_static,
+                                 qz_criterium, true, (DecisionRules::Solver) solver, 1e-12);
+      Matrix g_y_reduction(6, 3), g_u_reduction(6, 2);
+      dr_reduction.compute(jacobian, g_y_reduction, g_u_reduction);
+      dr_reduction.getGeneralizedEigenvalues(eig_real, eig_cmplx);
+      std::cout << (solver == DecisionRules::cycleReduction ? "Cyclic" : "Logarithmic")
+                << " reduction, eigenvalues (real part): " << eig_real << std::endl;
+      mat::sub(g_y_reduction, g_y);
+      mat::sub(g_u_reduction, g_u);
+      assert(mat::nrminf(g_y_reduction) < 1e-10 && mat::nrminf(g_u_reduction) < 1e-10);
+    }
+
+  /* A model with a purely backward block (z and w, with complex eigenvalues),
+     a core (k, c and h) and a purely forward block (q and p): the decision
+     rules must be the same with the blocks and with the QZ on the whole model.
+
+       z = 0.9*z(-1) - 0.3*w(-1) + e1
+       w = 0.5*w(-1) + 0.2*z + e2
+       k = 1.05*k(-1) - c + z
+       c = c(+1) + 0.1*k + 0.2*w
+       h = c + k
+       q = 0.96*q(+1) + h
+       p = 0.9*p(+1) + q(+1) + 0.3*z
+  */
+  std::vector<size_t> zeta_fwrd2, zeta_back2, zeta_mixed2, zeta_static2;
+  zeta_back2.push_back(0);
+  zeta_back2.push_back(1);
+  zeta_back2.push_back(2);
+  zeta_fwrd2.push_back(3);
+  zeta_fwrd2.push_back(5);
+  zeta_fwrd2.push_back(6);
+  zeta_static2.push_back(4);
+
+  DecisionRules dr_blocks(7, 2, zeta_fwrd2, zeta_back2, zeta_mixed2, zeta_static2, qz_criterium),
+    dr_qz(7, 2, zeta_fwrd2, zeta_back2, zeta_mixed2, zeta_static2, qz_criterium, false);
+
+  // Columns: z, w, k at t-1, all variables at t, c, q, p at t+1, e1, e2
+  Matrix jacobian2(7, 15);
+  jacobian2.setAll(0.0);
+  jacobian2(0, 3) = 1;
+  jacobian2(0, 0) = -0.9;
+  jacobian2(0, 1) = 0.3;
+  jacobian2(0, 13) = -1;
+  jacobian2(1, 4) = 1;
+  jacobian2(1, 1) = -0.5;
+  jacobian2(1, 3) = -0.2;
+  jacobian2(1, 14) = -1;
+  jacobian2(2, 5) = 1;
+  jacobian2(2, 2) = -1.05;
+  jacobian2(2, 6) = 1;
+  jacobian2(2, 3) = -1;
+  jacobian2(3, 6) = 1;
+  jacobian2(3, 10) = -1;
+  jacobian2(3, 5) = -0.1;
+  jacobian2(3, 4) = -0.2;
+  jacobian2(4, 7) = 1;
+  jacobian2(4, 6) = -1;
+  jacobian2(4, 5) = -1;
+  jacobian2(5, 8) = 1;
+  jacobian2(5, 11) = -0.96;
+  jacobian2(5, 7) = -1;
+  jacobian2(6, 9) = 1;
+  jacobian2(6, 12) = -0.9;
+  jacobian2(6, 11) = -1;
+  jacobian2(6, 3) = -0.3;
+
+  Matrix g_y_blocks(7, 3), g_u_blocks(7, 2), g_y_qz(7, 3), g_u_qz(7, 2);
+  dr_blocks.compute(jacobian2, g_y_blocks, g_u_blocks);
+  dr_qz.compute(jacobian2, g_y_qz, g_u_qz);
+
+  Vector eig_real2(6), eig_cmplx2(6);
+  dr_blocks.getGeneralizedEigenvalues(eig_real2, eig_cmplx2);
+  std::cout << "Eigenvalues with the blocks (real part): " << eig_real2
+            << "Eigenvalues with the blocks (complex part): " << eig_cmplx2 << std::endl
+            << "g_y = " << std::endl << g_y_blocks << std::endl
+            << "g_u = " << std::endl << g_u_blocks;
+
+  mat::sub(g_y_blocks, g_y_qz);
+  mat::sub(g_u_blocks, g_u_qz);
+  assert(mat::nrminf(g_y_blocks) < 1e-12 && mat::nrminf(g_u_blocks) < 1e-12);
 }
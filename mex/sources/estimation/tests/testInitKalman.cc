@@ -133,7 +133,8 @@ main(int argc, char **argv)
   InitializeKalmanFilter initializeKalmanFilter(modName, n_endo, n_exo,
                                                 zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg, zeta_static_arg,
                                                 zeta_varobs_back_mixed, qz_criterium,
-                                                lyapunov_tol, info);
+                                                lyapunov_tol, InitializeKalmanFilter::doubling,
+                                                DecisionRules::qz, 0.0, info);
 
   std::cout << "Initialize KF with Q: " << std::endl << Q << std::endl;
 
@@ -122,7 +122,8 @@ main(int argc, char **argv)
 
   KalmanFilter kalman(modName, n_endo, n_exo,
                       zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg, zeta_static_arg, qz_criterium,
-                      varobs_arg, riccati_tol, lyapunov_tol, info);
+                      varobs_arg, riccati_tol, lyapunov_tol, InitializeKalmanFilter::doubling,
+                      DecisionRules::qz, 0.0, info);
 
   size_t start = 0, period = 0;
   double ll = kalman.compute(dataView, steadyStateVW,  Q, H, deepParams,
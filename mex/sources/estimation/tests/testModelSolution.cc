@@ -90,7 +90,8 @@ main(int argc, char **argv)
   Matrix ghu(n_endo, n_exo);
 
   ModelSolution modelSolution(modName, n_endo, n_exo,
-                              zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg, zeta_static_arg, qz_criterium);
+                              zeta_fwrd_arg, zeta_back_arg, zeta_mixed_arg, zeta_static_arg, qz_criterium,
+                              DecisionRules::qz, 0.0);
 
   modelSolution.compute(steadyState, deepParams, ghx,  ghu);
 
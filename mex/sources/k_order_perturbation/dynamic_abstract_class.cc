@@ -21,6 +21,13 @@
 
 #include "dynamic_abstract_class.hh"
 
+void
+DynamicModelAC::evalHigherDerivatives(int order, const Vector &y, const Vector &x, const Vector &params, const Vector &ySteady,
+                                      TwoDMatrix &gk) throw (DynareException)
+{
+  throw DynareException(__FILE__, __LINE__, "Derivatives of order > 3 are only available with the use_dll option");
+}
+
 void
 DynamicModelAC::copyDoubleIntoTwoDMatData(double *dm, TwoDMatrix *tdm, int rows, int cols)
 {
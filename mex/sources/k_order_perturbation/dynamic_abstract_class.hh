@@ -25,9 +25,16 @@
 class DynamicModelAC
 {
 public:
+  virtual ~DynamicModelAC()
+  {
+  }
   static double *unpackSparseMatrix(mxArray *sparseMatrix);
   static void copyDoubleIntoTwoDMatData(double *dm, TwoDMatrix *tdm, int rows, int cols);
   virtual void eval(const Vector &y, const Vector &x, const Vector &params, const Vector &ySteady,
                     Vector &residual, TwoDMatrix *g1, TwoDMatrix *g2, TwoDMatrix *g3) throw (DynareException) = 0;
+  // Computes the derivatives of order 4 and above, with one row per derivative w.r. to sorted
+  // variables: equation, the order columns of the dynamic Jacobian (all 1-based), and value
+  virtual void evalHigherDerivatives(int order, const Vector &y, const Vector &x, const Vector &params, const Vector &ySteady,
+                                     TwoDMatrix &gk) throw (DynareException);
 };
 #endif
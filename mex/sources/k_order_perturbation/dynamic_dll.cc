@@ -93,3 +93,28 @@ DynamicModelDLL::eval(const Vector &y, const Vector &x, const Vector &modParams,
   Dynamic(y.base(), x.base(), 1, modParams.base(), ySteady.base(), 0, residual.base(), g1->base(),
           g2 == NULL ? NULL : g2->base(), g3 == NULL ? NULL : g3->base());
 }
+
+void
+DynamicModelDLL::evalHigherDerivatives(int order, const Vector &y, const Vector &x, const Vector &modParams, const Vector &ySteady,
+                                       TwoDMatrix &gk) throw (DynareException)
+{
+  ostringstream fnName;
+  fnName << "Dynamic_g" << order;
+
+#if defined(__CYGWIN32__) || defined(_WIN32)
+  DynamicHigherDerivativesDLLFn DynamicHigherDerivatives
+    = (DynamicHigherDerivativesDLLFn) GetProcAddress(dynamicHinstance, fnName.str().c_str());
+#else
+  DynamicHigherDerivativesDLLFn DynamicHigherDerivatives
+    = (DynamicHigherDerivativesDLLFn) dlsym(dynamicHinstance, fnName.str().c_str());
+#endif
+  if (DynamicHigherDerivatives == NULL)
+    {
+      ostringstream msg;
+      msg << "Can't locate the '" << fnName.str() << "' symbol in the *_dynamic DLL (the derivatives of order "
+          << order << " were not computed by the preprocessor)";
+      throw DynareException(__FILE__, __LINE__, msg.str());
+    }
+
+  DynamicHigherDerivatives(y.base(), x.base(), 1, modParams.base(), ySteady.base(), 0, gk.base());
+}
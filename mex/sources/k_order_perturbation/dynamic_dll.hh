@@ -39,6 +39,11 @@ typedef void (*DynamicDLLFn)
 (const double *y, const double *x, int nb_row_x, const double *params, const double *steady_state,
  int it_, double *residual, double *g1, double *g2, double *g3);
 
+// Dynamic_g4, Dynamic_g5... functions of <model>_Dynamic DLL
+typedef void (*DynamicHigherDerivativesDLLFn)
+(const double *y, const double *x, int nb_row_x, const double *params, const double *steady_state,
+ int it_, double *gk);
+
 /**
  * creates pointer to Dynamic function inside <model>_dynamic.dll
  * and handles calls to it.
@@ -60,5 +65,7 @@ public:
 
   void eval(const Vector &y, const Vector &x, const Vector &params, const Vector &ySteady,
             Vector &residual, TwoDMatrix *g1, TwoDMatrix *g2, TwoDMatrix *g3) throw (DynareException);
+  void evalHigherDerivatives(int order, const Vector &y, const Vector &x, const Vector &params, const Vector &ySteady,
+                             TwoDMatrix &gk) throw (DynareException);
 };
 #endif
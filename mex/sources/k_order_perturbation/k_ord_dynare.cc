@@ -47,7 +47,7 @@ KordpDynare::KordpDynare(const vector<string> &endo, int num_endo,
   nOrder(norder), journal(jr), ySteady(ysteady), params(inParams), vCov(vcov),
   md(1), dnl(*this, endo), denl(*this, exo), dsnl(*this, dnl, denl), ss_tol(sstol), varOrder(var_order),
   ll_Incidence(llincidence), qz_criterium(criterium), g1p(NULL),
-  g2p(NULL), g3p(NULL), dynamicModelFile(dynamicModelFile_arg)
+  g2p(NULL), g3p(NULL), gOwned(false), dynamicModelFile(dynamicModelFile_arg)
 {
   ReorderDynareJacobianIndices();
 
@@ -69,7 +69,7 @@ KordpDynare::KordpDynare(const vector<string> &endo, int num_endo,
   nOrder(norder), journal(jr), ySteady(ysteady), params(inParams), vCov(vcov),
   md(1), dnl(*this, endo), denl(*this, exo), dsnl(*this, dnl, denl), ss_tol(sstol), varOrder(var_order),
   ll_Incidence(llincidence), qz_criterium(criterium),
-  g1p(g1_arg), g2p(g2_arg), g3p(g3_arg), dynamicModelFile(dynamicModelFile_arg)
+  g1p(g1_arg), g2p(g2_arg), g3p(g3_arg), gOwned(false), dynamicModelFile(dynamicModelFile_arg)
 {
   ReorderDynareJacobianIndices();
 
@@ -81,6 +81,14 @@ KordpDynare::KordpDynare(const vector<string> &endo, int num_endo,
 KordpDynare::~KordpDynare()
 {
   // No need to manually delete tensors in "md", they are deleted by the TensorContainer destructor
+  if (gOwned)
+    {
+      delete g1p;
+      delete g2p;
+      delete g3p;
+    }
+  for (unsigned int i = 0; i < gkp.size(); i++)
+    delete gkp[i];
 }
 
 void
@@ -112,48 +120,79 @@ KordpDynare::evaluateSystem(Vector &out, const Vector &yym, const Vector &yy,
 void
 KordpDynare::calcDerivativesAtSteady()
 {
-  if (g1p == NULL)
+  // The derivatives passed as arguments are used once, afterwards they are evaluated
+  if (g1p != NULL && !gOwned)
     {
-      g1p = new TwoDMatrix(nY, nJcols);
+      if ((nOrder > 1 && g2p == NULL) || (nOrder > 2 && g3p == NULL))
+        throw DynareException(__FILE__, __LINE__, "The derivatives passed as arguments don't match the order of approximation");
+      populateDerivativesContainer(*g1p, 1);
+      delete g1p;
+      g1p = NULL;
+      if (g2p != NULL)
+        {
+          populateDerivativesContainer(*g2p, 2);
+          delete g2p;
+          g2p = NULL;
+        }
+      if (g3p != NULL)
+        {
+          populateDerivativesContainer(*g3p, 3);
+          delete g3p;
+          g3p = NULL;
+        }
+    }
+  else
+    {
+      // The buffers are allocated at the first evaluation and kept for the subsequent ones
+      if (g1p == NULL)
+        {
+          g1p = new TwoDMatrix(nY, nJcols);
+          if (nOrder > 1)
+            // allocate space for sparse Hessian
+            g2p = new TwoDMatrix((int) NNZD[1], 3);
+          if (nOrder > 2)
+            g3p = new TwoDMatrix((int) NNZD[2], 3);
+          gOwned = true;
+        }
       g1p->zeros();
-      
-      if (nOrder > 1)
-	{
-	  // allocate space for sparse Hessian
-	  g2p = new TwoDMatrix((int) NNZD[1], 3);
-	  g2p->zeros();
-	}
-      
-      if (nOrder > 2)
-	{
-	  g3p = new TwoDMatrix((int) NNZD[2], 3);
-	  g3p->zeros();
-	}
+      if (g2p != NULL)
+        g2p->zeros();
+      if (g3p != NULL)
+        g3p->zeros();
 
       Vector xx(nexog());
       xx.zeros();
-      
+
       Vector out(nY);
       out.zeros();
       Vector llxSteady(nJcols-nExog);
       LLxSteady(ySteady, llxSteady);
-      
-      dynamicModelFile->eval(llxSteady, xx, params, ySteady, out, g1p, g2p, g3p);
-                
-    }
 
-  populateDerivativesContainer(*g1p, 1, JacobianIndices);
-  delete g1p;
+      dynamicModelFile->eval(llxSteady, xx, params, ySteady, out, g1p, g2p, g3p);
 
-  if (nOrder > 1)
-    {
-      populateDerivativesContainer(*g2p, 2, JacobianIndices);
-      delete g2p;
+      populateDerivativesContainer(*g1p, 1);
+      if (nOrder > 1)
+        populateDerivativesContainer(*g2p, 2);
+      if (nOrder > 2)
+        populateDerivativesContainer(*g3p, 3);
     }
-  if (nOrder > 2)
+
+  // Derivatives of order 4 and above are only computed by the Dynamic_g4, Dynamic_g5... functions
+  if (nOrder > 3)
     {
-      populateDerivativesContainer(*g3p, 3, JacobianIndices);
-      delete g3p;
+      Vector xx(nexog());
+      xx.zeros();
+      Vector llxSteady(nJcols-nExog);
+      LLxSteady(ySteady, llxSteady);
+
+      for (int ord = 4; ord <= nOrder; ord++)
+        {
+          if ((int) gkp.size() < ord-3)
+            gkp.push_back(new TwoDMatrix((int) NNZD[ord-1], ord+2));
+          TwoDMatrix &gk = *gkp[ord-4];
+          dynamicModelFile->evalHigherDerivatives(ord, llxSteady, xx, params, ySteady, gk);
+          populateDerivativesContainer(gk, ord);
+        }
     }
 }
 
@@ -161,7 +200,7 @@ KordpDynare::calcDerivativesAtSteady()
  * populateDerivatives to sparse Tensor and fit it in the Derivatives Container
  *******************************************************************************/
 void
-KordpDynare::populateDerivativesContainer(const TwoDMatrix &g, int ord, const vector<int> &vOrder)
+KordpDynare::populateDerivativesContainer(const TwoDMatrix &g, int ord)
 {
   // model derivatives FSSparseTensor instance
   FSSparseTensor *mdTi = (new FSSparseTensor(ord, nJcols, nY));
@@ -176,7 +215,7 @@ KordpDynare::populateDerivativesContainer(const TwoDMatrix &g, int ord, const ve
             {
               double x;
               if (s[0] < nJcols-nExog)
-                x = g.get(j, vOrder[s[0]]);
+                x = g.get(j, JacobianIndices[s[0]]);
               else
                 x = g.get(j, s[0]);
               if (x != 0.0)
@@ -188,9 +227,7 @@ KordpDynare::populateDerivativesContainer(const TwoDMatrix &g, int ord, const ve
   else if (ord == 2)
     {
       int nJcols1 = nJcols-nExog;
-      vector<int> revOrder(nJcols1);
-      for (int i = 0; i < nJcols1; i++)
-        revOrder[vOrder[i]] = i;
+      const vector<int> &revOrder = revJacobianIndices;
       for (int i = 0; i < g.nrows(); i++)
         {
           int j = (int) g.get(i, 0)-1; // hessian indices start with 1
@@ -218,9 +255,7 @@ KordpDynare::populateDerivativesContainer(const TwoDMatrix &g, int ord, const ve
     {
       int nJcols1 = nJcols-nExog;
       int nJcols2 = nJcols*nJcols;
-      vector<int> revOrder(nJcols1);
-      for (int i = 0; i < nJcols1; i++)
-        revOrder[vOrder[i]] = i;
+      const vector<int> &revOrder = revJacobianIndices;
       for (int i = 0; i < g.nrows(); i++)
         {
           int j = (int) g.get(i, 0)-1;
@@ -248,6 +283,26 @@ KordpDynare::populateDerivativesContainer(const TwoDMatrix &g, int ord, const ve
             mdTi->insert(s, j, x);
         }
     }
+  else
+    {
+      // Only the derivatives w.r. to sorted columns are given, one column index per variable
+      int nJcols1 = nJcols-nExog;
+      const vector<int> &revOrder = revJacobianIndices;
+      for (int i = 0; i < g.nrows(); i++)
+        {
+          int j = (int) g.get(i, 0)-1;
+          for (int l = 0; l < ord; l++)
+            {
+              int sl = (int) g.get(i, l+1)-1;
+              if (sl < nJcols1)
+                s[l] = revOrder[sl];
+              else
+                s[l] = sl;
+            }
+          s.sort();
+          mdTi->insert(s, j, g.get(i, ord+1));
+        }
+    }
 
   // md container
   md.remove(Symmetry(ord));
@@ -337,6 +392,11 @@ KordpDynare::ReorderDynareJacobianIndices() throw (TLException)
   //add the indices for the nExog exogenous jacobians
   for (j = nJcols-nExog; j < nJcols; j++)
     JacobianIndices[j] = j;
+
+  // the inverse permutation of the endogenous columns, used to reorder the sparse higher derivatives
+  revJacobianIndices.resize(nJcols-nExog);
+  for (j = 0; j < nJcols-nExog; j++)
+    revJacobianIndices[JacobianIndices[j]] = j;
 }
 
 /**************************************************************************************/
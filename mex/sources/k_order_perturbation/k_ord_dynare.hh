@@ -113,10 +113,13 @@ class KordpDynare : public DynamicModel
   const TwoDMatrix &ll_Incidence;
   double qz_criterium;
   vector<int> JacobianIndices;
+  vector<int> revJacobianIndices; // inverse of JacobianIndices restricted to the endogenous columns
 
   TwoDMatrix *g1p;
   TwoDMatrix *g2p;
   TwoDMatrix *g3p;
+  bool gOwned; // true if g1p, g2p and g3p were allocated here and are kept across evaluations
+  vector<TwoDMatrix *> gkp; // buffers for the derivatives of order 4 and above
 public:
   KordpDynare(const vector<string> &endo, int num_endo,
               const vector<string> &exo, int num_exo, int num_par,
@@ -244,7 +247,7 @@ public:
 
 private:
   void ReorderDynareJacobianIndices() throw (TLException);
-  void populateDerivativesContainer(const TwoDMatrix &g, int ord, const vector<int> &vOrder);
+  void populateDerivativesContainer(const TwoDMatrix &g, int ord);
 };
 
 #endif
@@ -25,10 +25,20 @@
   2) M_
   3) options
 
+  The solver can also be kept alive between calls through a handle, so that
+  the dynamic model is loaded and the index permutations, tensor library
+  tables and derivative buffers are built only once:
+  - [err, handle] = k_order_perturbation('open', dr, M_, options) creates it,
+  - [err, g_0, ...] = k_order_perturbation(handle, dr, M_) solves the model
+    for the current values of M_.params, M_.Sigma_e and dr.ys,
+  - err = k_order_perturbation('close', handle) releases it.
+
   Outputs:
   - if order == 1: only g_1
   - if order == 2: g_0, g_1, g_2
   - if order == 3: g_0, g_1, g_2, g_3
+  - if order > 3: g_0, g_1, ..., g_order (the derivatives of the model of order
+    4 and above are only computed by the DLL generated with use_dll)
 */
 
 #include "dynamic_m.hh"
@@ -38,6 +48,7 @@
 #include <cstring>
 #include <cctype>
 #include <cassert>
+#include <map>
 
 #if defined(MATLAB_MEX_FILE) || defined(OCTAVE_MEX_FILE)  // exclude mexFunction for other applications
 
@@ -72,251 +83,463 @@ void copy_derivatives(mxArray *destin,const Symmetry &sym,const FGSContainer *de
   mxSetField(destin,0,fieldname.c_str(),tmp);
 }
 
+/*
+  The k-order solver of a model together with the data referenced by
+  KordpDynare. The dynamic model and the KordpDynare object are created by
+  load(); afterwards only the values of params, vCov and ySteady change
+  between calls to solve().
+*/
+class KOrderContext
+{
+public:
+  const string fName;
+  const int use_dll;
+  const int kOrder;
+  const int num_threads;
+  const bool first_touch;
+  const int nSteps;
+  const double sstol;
+  const double qz_criterium;
+  const FirstOrder::solver_t fo_solver;
+  const double fo_tol;
+  const vector<string> endoNames;
+  const vector<string> exoNames;
+  const int nStat, nPred, nBoth, nForw, nExog, nEndo, nPar, jcols;
+  const Vector NNZD;
+  const vector<int> varOrder;
+  const TwoDMatrix llincidence;
+  Vector params;
+  TwoDMatrix vCov;
+  Vector ySteady;
+  TwoDMatrix *g1m, *g2m, *g3m;
+  Journal journal;
+  DynamicModelAC *dynamicModelFile;
+  KordpDynare *dynare;
+
+  KOrderContext(const string &fName_arg, int use_dll_arg, int kOrder_arg, int num_threads_arg, bool first_touch_arg, double qz_criterium_arg,
+                FirstOrder::solver_t fo_solver_arg, double fo_tol_arg, const vector<string> &endoNames_arg, const vector<string> &exoNames_arg,
+                int nStat_arg, int nPred_arg, int nBoth_arg, int nForw_arg, int nExog_arg,
+                int nEndo_arg, int nPar_arg, int jcols_arg, const Vector &NNZD_arg,
+                const vector<int> &varOrder_arg, const TwoDMatrix &llincidence_arg,
+                const Vector &params_arg, const TwoDMatrix &vCov_arg, const Vector &ySteady_arg,
+                TwoDMatrix *g1m_arg, TwoDMatrix *g2m_arg, TwoDMatrix *g3m_arg) :
+    fName(fName_arg), use_dll(use_dll_arg), kOrder(kOrder_arg), num_threads(num_threads_arg),
+    first_touch(first_touch_arg),
+    nSteps(0), // Dynare++ solving steps, for time being default to 0 = deterministic steady state
+    sstol(1.e-13), //NL solver tolerance from
+    qz_criterium(qz_criterium_arg), fo_solver(fo_solver_arg), fo_tol(fo_tol_arg), endoNames(endoNames_arg), exoNames(exoNames_arg),
+    nStat(nStat_arg), nPred(nPred_arg), nBoth(nBoth_arg), nForw(nForw_arg), nExog(nExog_arg),
+    nEndo(nEndo_arg), nPar(nPar_arg), jcols(jcols_arg), NNZD(NNZD_arg), varOrder(varOrder_arg),
+    llincidence(llincidence_arg), params(params_arg), vCov(vCov_arg), ySteady(ySteady_arg),
+    g1m(g1m_arg), g2m(g2m_arg), g3m(g3m_arg), journal((fName_arg + ".jnl").c_str()),
+    dynamicModelFile(NULL), dynare(NULL)
+  {
+  }
+  ~KOrderContext()
+  {
+    delete dynare;
+    delete dynamicModelFile;
+  }
+  void load();
+  void solve(int nlhs, mxArray *plhs[]);
+};
+
+void
+KOrderContext::load()
+{
+  if (dynare != NULL)
+    return;
+
+  if (use_dll == 1)
+    dynamicModelFile = new DynamicModelDLL(fName);
+  else
+    dynamicModelFile = new DynamicModelMFile(fName);
+
+  // make KordpDynare object, it takes care of the derivatives passed as arguments
+  dynare = new KordpDynare(endoNames, nEndo, exoNames, nExog, nPar,
+                           ySteady, vCov, params, nStat, nPred, nForw, nBoth,
+                           jcols, NNZD, nSteps, kOrder, journal, dynamicModelFile,
+                           sstol, varOrder, llincidence, qz_criterium,
+                           g1m, g2m, g3m);
+}
+
+void
+KOrderContext::solve(int nlhs, mxArray *plhs[])
+{
+  THREAD_GROUP::max_parallel_threads = num_threads;
+  FaaDiBruno::first_touch = first_touch;
+
+  // intiate tensor library, the equivalence and permutation bundles are only generated once
+  tls.init(kOrder, nStat+2*nPred+3*nBoth+2*nForw+nExog);
+
+  // construct main K-order approximation class
+  Approximation app(*dynare, journal,  nSteps, false, qz_criterium, fo_solver, fo_tol);
+  // run stochastic steady
+  app.walkStochSteady();
+
+  /* Write derivative outputs into memory map */
+  map<string, ConstTwoDMatrix> mm;
+  app.getFoldDecisionRule().writeMMap(mm, string());
+
+  if (kOrder == 1)
+    {
+      /* Set the output pointer to the output matrix ysteady. */
+      map<string, ConstTwoDMatrix>::const_iterator cit = mm.begin();
+      ++cit;
+      plhs[1] = mxCreateDoubleMatrix((*cit).second.numRows(), (*cit).second.numCols(), mxREAL);
+
+      // Copy Dynare++ matrix into MATLAB matrix
+      const ConstVector &vec = (*cit).second.getData();
+      assert(vec.skip() == 1);
+      memcpy(mxGetPr(plhs[1]), vec.base(), vec.length() * sizeof(double));
+    }
+  if (kOrder >= 2)
+    {
+      int ii = 1;
+      for (map<string, ConstTwoDMatrix>::const_iterator cit = mm.begin();
+           ((cit != mm.end()) && (ii < nlhs)); ++cit)
+        {
+          plhs[ii] = mxCreateDoubleMatrix((*cit).second.numRows(), (*cit).second.numCols(), mxREAL);
+
+          // Copy Dynare++ matrix into MATLAB matrix
+          const ConstVector &vec = (*cit).second.getData();
+          assert(vec.skip() == 1);
+          memcpy(mxGetPr(plhs[ii]), vec.base(), vec.length() * sizeof(double));
+
+          ++ii;
+        }
+      if (kOrder == 3 && nlhs > 4)
+        {
+          const FGSContainer *derivs = app.get_rule_ders();
+          const std::string fieldnames[] = {"gy", "gu", "gyy", "gyu", "guu", "gss",
+                                            "gyyy", "gyyu", "gyuu", "guuu", "gyss", "guss"};
+          // creates the char** expected by mxCreateStructMatrix()
+          const char* c_fieldnames[12];
+          for (int i=0; i < 12;++i)
+            c_fieldnames[i] = fieldnames[i].c_str();
+          plhs[ii] = mxCreateStructMatrix(1,1,12,c_fieldnames);
+          copy_derivatives(plhs[ii],Symmetry(1,0,0,0),derivs,"gy");
+          copy_derivatives(plhs[ii],Symmetry(0,1,0,0),derivs,"gu");
+          copy_derivatives(plhs[ii],Symmetry(2,0,0,0),derivs,"gyy");
+          copy_derivatives(plhs[ii],Symmetry(0,2,0,0),derivs,"guu");
+          copy_derivatives(plhs[ii],Symmetry(1,1,0,0),derivs,"gyu");
+          copy_derivatives(plhs[ii],Symmetry(0,0,0,2),derivs,"gss");
+          copy_derivatives(plhs[ii],Symmetry(3,0,0,0),derivs,"gyyy");
+          copy_derivatives(plhs[ii],Symmetry(0,3,0,0),derivs,"guuu");
+          copy_derivatives(plhs[ii],Symmetry(2,1,0,0),derivs,"gyyu");
+          copy_derivatives(plhs[ii],Symmetry(1,2,0,0),derivs,"gyuu");
+          copy_derivatives(plhs[ii],Symmetry(1,0,0,2),derivs,"gyss");
+          copy_derivatives(plhs[ii],Symmetry(0,1,0,2),derivs,"guss");
+        }
+    }
+}
+
+// The contexts opened with k_order_perturbation('open', ...), indexed by their handle
+static map<int, KOrderContext *> contexts;
+static int last_handle = 0;
+
+static void
+close_contexts()
+{
+  for (map<int, KOrderContext *>::iterator it = contexts.begin(); it != contexts.end(); ++it)
+    delete it->second;
+  contexts.clear();
+}
+
 extern "C" {
 
   void
   mexFunction(int nlhs, mxArray *plhs[],
               int nrhs, const mxArray *prhs[])
   {
-    if (nrhs < 3 || nlhs < 2)
-      DYN_MEX_FUNC_ERR_MSG_TXT("Must have at least 3 input parameters and takes at least 2 output parameters.");
-
-    const mxArray *dr = prhs[0];
-    const mxArray *M_ = prhs[1];
-    const mxArray *options_ = prhs[2];
-    int use_dll = (int) mxGetScalar(mxGetField(options_, 0, "use_dll"));
-
-    mxArray *mFname = mxGetField(M_, 0, "fname");
-    if (!mxIsChar(mFname))
-      DYN_MEX_FUNC_ERR_MSG_TXT("Input must be of type char.");
+    KOrderContext *context = NULL;
+    bool owned = true; // false if the context was obtained from a handle
+    bool open = false;
 
-    string fName = mxArrayToString(mFname);
-
-    int kOrder;
-    mxArray *mxFldp = mxGetField(options_, 0, "order");
-    if (mxIsNumeric(mxFldp))
-      kOrder = (int) mxGetScalar(mxFldp);
-    else
-      kOrder = 1;
-
-    //if (kOrder == 1 && nlhs != 2)
-    //  DYN_MEX_FUNC_ERR_MSG_TXT("k_order_perturbation at order 1 requires exactly 2 arguments in output");
-    //else if (kOrder > 1 && nlhs != kOrder+2)
-    //  DYN_MEX_FUNC_ERR_MSG_TXT("k_order_perturbation at order > 1 requires exactly order+2 arguments in output");
-
-    double qz_criterium = 1+1e-6;
-    mxFldp = mxGetField(options_, 0, "qz_criterium");
-    if (mxGetNumberOfElements(mxFldp) > 0 && mxIsNumeric(mxFldp))
-      qz_criterium = (double) mxGetScalar(mxFldp);
-
-    mxFldp = mxGetField(M_, 0, "params");
-    double *dparams = mxGetPr(mxFldp);
-    int npar = (int) mxGetM(mxFldp);
-    Vector modParams(dparams, npar);
-    if (!modParams.isFinite())
-      DYN_MEX_FUNC_ERR_MSG_TXT("The parameters vector contains NaN or Inf");
-
-    mxFldp = mxGetField(M_, 0, "Sigma_e");
-    dparams = mxGetPr(mxFldp);
-    npar = (int) mxGetN(mxFldp);
-    TwoDMatrix vCov(npar, npar, dparams);
-    if (!vCov.isFinite())
-      DYN_MEX_FUNC_ERR_MSG_TXT("The covariance matrix of shocks contains NaN or Inf");
-
-    mxFldp = mxGetField(dr, 0, "ys");  // and not in order of dr.order_var
-    dparams = mxGetPr(mxFldp);
-    const int nSteady = (int) mxGetM(mxFldp);
-    Vector ySteady(dparams, nSteady);
-    if (!ySteady.isFinite())
-      DYN_MEX_FUNC_ERR_MSG_TXT("The steady state vector contains NaN or Inf");
-
-    mxFldp = mxGetField(M_, 0, "nstatic");
-    const int nStat = (int) mxGetScalar(mxFldp);
-    mxFldp = mxGetField(M_, 0, "npred");
-    const int nPred = (int) mxGetScalar(mxFldp);
-    mxFldp = mxGetField(M_, 0, "nspred");
-    const int nsPred = (int) mxGetScalar(mxFldp);
-    mxFldp = mxGetField(M_, 0, "nboth");
-    const int nBoth = (int) mxGetScalar(mxFldp);
-    mxFldp = mxGetField(M_, 0, "nfwrd");
-    const int nForw = (int) mxGetScalar(mxFldp);
-    mxFldp = mxGetField(M_, 0, "nsfwrd");
-    const int nsForw = (int) mxGetScalar(mxFldp);
-
-    mxFldp = mxGetField(M_, 0, "exo_nbr");
-    const int nExog = (int) mxGetScalar(mxFldp);
-    mxFldp = mxGetField(M_, 0, "endo_nbr");
-    const int nEndo = (int) mxGetScalar(mxFldp);
-    mxFldp = mxGetField(M_, 0, "param_nbr");
-    const int nPar = (int) mxGetScalar(mxFldp);
-
-    mxFldp = mxGetField(dr, 0, "order_var");
-    dparams = mxGetPr(mxFldp);
-    npar = (int) mxGetM(mxFldp);
-    if (npar != nEndo)
-      DYN_MEX_FUNC_ERR_MSG_TXT("Incorrect number of input var_order vars.");
-
-    vector<int> var_order_vp(nEndo);
-    for (int v = 0; v < nEndo; v++)
-      var_order_vp[v] = (int) (*(dparams++));
-
-    // the lag, current and lead blocks of the jacobian respectively
-    mxFldp = mxGetField(M_, 0, "lead_lag_incidence");
-    dparams = mxGetPr(mxFldp);
-    npar = (int) mxGetN(mxFldp);
-    int nrows = (int) mxGetM(mxFldp);
-
-    TwoDMatrix llincidence(nrows, npar, dparams);
-    if (npar != nEndo)
+    if (nrhs > 0 && mxIsChar(prhs[0]))
       {
-        ostringstream strstrm;
-        strstrm << "dynare:k_order_perturbation " << "Incorrect length of lead lag incidences: ncol=" << npar << " != nEndo=" << nEndo;
-        DYN_MEX_FUNC_ERR_MSG_TXT(strstrm.str().c_str());
+        string command = mxArrayToString(prhs[0]);
+        if (command == "close")
+          {
+            if (nrhs != 2 || nlhs < 1 || !mxIsNumeric(prhs[1]))
+              DYN_MEX_FUNC_ERR_MSG_TXT("dynare:k_order_perturbation: 'close' takes a handle as input and returns 1 output parameter.");
+            map<int, KOrderContext *>::iterator it = contexts.find((int) mxGetScalar(prhs[1]));
+            if (it == contexts.end())
+              DYN_MEX_FUNC_ERR_MSG_TXT("dynare:k_order_perturbation: Unknown handle.");
+            delete it->second;
+            contexts.erase(it);
+            plhs[0] = mxCreateDoubleScalar(0);
+            return;
+          }
+        else if (command != "open")
+          DYN_MEX_FUNC_ERR_MSG_TXT("dynare:k_order_perturbation: Unknown command, must be 'open' or 'close'.");
+        open = true;
+        prhs++;
+        nrhs--;
       }
-    //get NNZH =NNZD(2) = the total number of non-zero Hessian elements
-    mxFldp = mxGetField(M_, 0, "NNZDerivatives");
-    dparams = mxGetPr(mxFldp);
-    Vector NNZD(dparams, (int) mxGetM(mxFldp));
-    if (NNZD[kOrder-1] == -1)
-      DYN_MEX_FUNC_ERR_MSG_TXT("The derivatives were not computed for the required order. Make sure that you used the right order option inside the stoch_simul command");
-
-    const int jcols = nExog+nEndo+nsPred+nsForw; // Num of Jacobian columns
-
-    mxFldp = mxGetField(M_, 0, "var_order_endo_names");
-    const int nendo = (int) mxGetM(mxFldp);
-    const int widthEndo = (int) mxGetN(mxFldp);
-    vector<string> endoNames;
-    DynareMxArrayToString(mxFldp, nendo, widthEndo, endoNames);
-
-    mxFldp = mxGetField(M_, 0, "exo_names");
-    const int nexo = (int) mxGetM(mxFldp);
-    const int widthExog = (int) mxGetN(mxFldp);
-    vector<string> exoNames;
-    DynareMxArrayToString(mxFldp, nexo, widthExog, exoNames);
-
-    if ((nEndo != nendo) || (nExog != nexo))
-      DYN_MEX_FUNC_ERR_MSG_TXT("Incorrect number of input parameters.");
-
-    TwoDMatrix *g1m=NULL;
-    TwoDMatrix *g2m=NULL;
-    TwoDMatrix *g3m=NULL;
-    // derivatives passed as arguments */
-    if (nrhs > 3) 
+
+    if (nrhs > 0 && mxIsNumeric(prhs[0]))
       {
-	const mxArray *g1 = prhs[3];
-	int m = (int) mxGetM(g1);
-	int n = (int) mxGetN(g1);
-	g1m = new TwoDMatrix(m, n, mxGetPr(g1));
-	if (nrhs > 4)
-	  {
-	    const mxArray *g2 = prhs[4];
-	    int m = (int) mxGetM(g2);
-	    int n = (int) mxGetN(g2);
-	    g2m = new TwoDMatrix(m, n, mxGetPr(g2));
-	    if (nrhs > 5)
-	      {
-		const mxArray *g3 = prhs[5];
-		int m = (int) mxGetM(g3);
-		int n = (int) mxGetN(g3);
-		g3m = new TwoDMatrix(m, n, mxGetPr(g3));
-	      }
-	  }
+        // call through a handle: only the values of the parameters, of the
+        // covariance matrix of shocks and of the steady state are read
+        if (nrhs != 3 || nlhs < 2)
+          DYN_MEX_FUNC_ERR_MSG_TXT("Must have exactly 3 input parameters with a handle and takes at least 2 output parameters.");
+        map<int, KOrderContext *>::iterator it = contexts.find((int) mxGetScalar(prhs[0]));
+        if (it == contexts.end())
+          DYN_MEX_FUNC_ERR_MSG_TXT("dynare:k_order_perturbation: Unknown handle.");
+        context = it->second;
+        owned = false;
+
+        const mxArray *dr = prhs[1];
+        const mxArray *M_ = prhs[2];
+
+        mxArray *mxFldp = mxGetField(M_, 0, "params");
+        if ((int) mxGetNumberOfElements(mxFldp) != context->params.length())
+          DYN_MEX_FUNC_ERR_MSG_TXT("Incorrect number of parameters for the handle.");
+        ConstVector modParams(mxGetPr(mxFldp), context->params.length());
+        if (!modParams.isFinite())
+          DYN_MEX_FUNC_ERR_MSG_TXT("The parameters vector contains NaN or Inf");
+
+        mxFldp = mxGetField(M_, 0, "Sigma_e");
+        if ((int) mxGetM(mxFldp) != context->vCov.numRows() || (int) mxGetN(mxFldp) != context->vCov.numCols())
+          DYN_MEX_FUNC_ERR_MSG_TXT("Incorrect size of the covariance matrix of shocks for the handle.");
+        ConstTwoDMatrix vCov(context->vCov.numRows(), context->vCov.numCols(), mxGetPr(mxFldp));
+        if (!vCov.isFinite())
+          DYN_MEX_FUNC_ERR_MSG_TXT("The covariance matrix of shocks contains NaN or Inf");
+
+        mxFldp = mxGetField(dr, 0, "ys");
+        if ((int) mxGetM(mxFldp) != context->ySteady.length())
+          DYN_MEX_FUNC_ERR_MSG_TXT("Incorrect length of the steady state vector for the handle.");
+        ConstVector ySteady(mxGetPr(mxFldp), context->ySteady.length());
+        if (!ySteady.isFinite())
+          DYN_MEX_FUNC_ERR_MSG_TXT("The steady state vector contains NaN or Inf");
+
+        context->params = modParams;
+        memcpy(context->vCov.base(), vCov.base(), vCov.numRows()*vCov.numCols()*sizeof(double));
+        context->ySteady = ySteady;
       }
-	    
-
-    const int nSteps = 0; // Dynare++ solving steps, for time being default to 0 = deterministic steady state
-    const double sstol = 1.e-13; //NL solver tolerance from
-
-    THREAD_GROUP::max_parallel_threads = 2; //params.num_threads;
-
-    try
+    else
       {
-        // make journal name and journal
-        std::string jName(fName); //params.basename);
-        jName += ".jnl";
-        Journal journal(jName.c_str());
-
-        DynamicModelAC *dynamicModelFile;
-        if (use_dll == 1)
-          dynamicModelFile = new DynamicModelDLL(fName);
+        if (nrhs < 3 || nlhs < 2)
+          DYN_MEX_FUNC_ERR_MSG_TXT("Must have at least 3 input parameters and takes at least 2 output parameters.");
+        if (open && nrhs > 3)
+          DYN_MEX_FUNC_ERR_MSG_TXT("dynare:k_order_perturbation: The derivatives can't be passed when opening a handle.");
+
+        const mxArray *dr = prhs[0];
+        const mxArray *M_ = prhs[1];
+        const mxArray *options_ = prhs[2];
+        int use_dll = (int) mxGetScalar(mxGetField(options_, 0, "use_dll"));
+
+        mxArray *mFname = mxGetField(M_, 0, "fname");
+        if (!mxIsChar(mFname))
+          DYN_MEX_FUNC_ERR_MSG_TXT("Input must be of type char.");
+
+        string fName = mxArrayToString(mFname);
+
+        int kOrder;
+        mxArray *mxFldp = mxGetField(options_, 0, "order");
+        if (mxIsNumeric(mxFldp))
+          kOrder = (int) mxGetScalar(mxFldp);
         else
-          dynamicModelFile = new DynamicModelMFile(fName);
-
-        // intiate tensor library
-        tls.init(kOrder, nStat+2*nPred+3*nBoth+2*nForw+nExog);
+          kOrder = 1;
 
-        // make KordpDynare object
-        KordpDynare dynare(endoNames, nEndo, exoNames, nExog, nPar,
-                           ySteady, vCov, modParams, nStat, nPred, nForw, nBoth,
-                           jcols, NNZD, nSteps, kOrder, journal, dynamicModelFile,
-                           sstol, var_order_vp, llincidence, qz_criterium,
-			   g1m, g2m, g3m);
+        //if (kOrder == 1 && nlhs != 2)
+        //  DYN_MEX_FUNC_ERR_MSG_TXT("k_order_perturbation at order 1 requires exactly 2 arguments in output");
+        //else if (kOrder > 1 && nlhs != kOrder+2)
+        //  DYN_MEX_FUNC_ERR_MSG_TXT("k_order_perturbation at order > 1 requires exactly order+2 arguments in output");
 
-        // construct main K-order approximation class
+        // number of threads of the tensor library, kept with the handle
+        int num_threads = 2;
+        mxFldp = mxGetField(options_, 0, "threads");
+        if (mxFldp != NULL && mxIsStruct(mxFldp))
+          {
+            mxFldp = mxGetField(mxFldp, 0, "k_order_perturbation");
+            if (mxFldp != NULL && mxIsNumeric(mxFldp))
+              num_threads = (int) mxGetScalar(mxFldp);
+          }
+        if (num_threads < 1)
+          DYN_MEX_FUNC_ERR_MSG_TXT("dynare:k_order_perturbation: The number of threads must be at least 1.");
 
-        Approximation app(dynare, journal,  nSteps, false, qz_criterium);
-        // run stochastic steady
-        app.walkStochSteady();
+        // whether the threads zero the large output tensors (first touch policy, for NUMA machines)
+        bool first_touch = false;
+        mxFldp = mxGetField(options_, 0, "threads");
+        if (mxFldp != NULL && mxIsStruct(mxFldp))
+          {
+            mxFldp = mxGetField(mxFldp, 0, "k_order_perturbation_first_touch");
+            if (mxFldp != NULL && mxIsNumeric(mxFldp))
+              first_touch = (mxGetScalar(mxFldp) != 0);
+          }
 
-        /* Write derivative outputs into memory map */
-        map<string, ConstTwoDMatrix> mm;
-        app.getFoldDecisionRule().writeMMap(mm, string());
+        double qz_criterium = 1+1e-6;
+        mxFldp = mxGetField(options_, 0, "qz_criterium");
+        if (mxGetNumberOfElements(mxFldp) > 0 && mxIsNumeric(mxFldp))
+          qz_criterium = (double) mxGetScalar(mxFldp);
 
-        // get latest ysteady
-        ySteady = dynare.getSteady();
+        // As in dyn_first_order_solver.m, cyclic reduction has precedence over logarithmic reduction
+        FirstOrder::solver_t fo_solver = FirstOrder::qz;
+        double fo_tol = 1.e-10;
+        mxFldp = mxGetField(options_, 0, "dr_cycle_reduction");
+        if (mxFldp != NULL && mxIsNumeric(mxFldp) && mxGetScalar(mxFldp) == 1)
+          {
+            fo_solver = FirstOrder::cycle_reduction;
+            mxFldp = mxGetField(options_, 0, "dr_cycle_reduction_tol");
+            if (mxFldp != NULL && mxIsNumeric(mxFldp))
+              fo_tol = (double) mxGetScalar(mxFldp);
+          }
+        else
+          {
+            mxFldp = mxGetField(options_, 0, "dr_logarithmic_reduction");
+            if (mxFldp != NULL && mxIsNumeric(mxFldp) && mxGetScalar(mxFldp) == 1)
+              {
+                fo_solver = FirstOrder::logarithmic_reduction;
+                mxFldp = mxGetField(options_, 0, "dr_logarithmic_reduction_tol");
+                if (mxFldp != NULL && mxIsNumeric(mxFldp))
+                  fo_tol = (double) mxGetScalar(mxFldp);
+              }
+          }
 
-        if (kOrder == 1)
+        mxFldp = mxGetField(M_, 0, "params");
+        double *dparams = mxGetPr(mxFldp);
+        int npar = (int) mxGetM(mxFldp);
+        Vector modParams(dparams, npar);
+        if (!modParams.isFinite())
+          DYN_MEX_FUNC_ERR_MSG_TXT("The parameters vector contains NaN or Inf");
+
+        mxFldp = mxGetField(M_, 0, "Sigma_e");
+        dparams = mxGetPr(mxFldp);
+        npar = (int) mxGetN(mxFldp);
+        TwoDMatrix vCov(npar, npar, dparams);
+        if (!vCov.isFinite())
+          DYN_MEX_FUNC_ERR_MSG_TXT("The covariance matrix of shocks contains NaN or Inf");
+
+        mxFldp = mxGetField(dr, 0, "ys");  // and not in order of dr.order_var
+        dparams = mxGetPr(mxFldp);
+        const int nSteady = (int) mxGetM(mxFldp);
+        Vector ySteady(dparams, nSteady);
+        if (!ySteady.isFinite())
+          DYN_MEX_FUNC_ERR_MSG_TXT("The steady state vector contains NaN or Inf");
+
+        mxFldp = mxGetField(M_, 0, "nstatic");
+        const int nStat = (int) mxGetScalar(mxFldp);
+        mxFldp = mxGetField(M_, 0, "npred");
+        const int nPred = (int) mxGetScalar(mxFldp);
+        mxFldp = mxGetField(M_, 0, "nspred");
+        const int nsPred = (int) mxGetScalar(mxFldp);
+        mxFldp = mxGetField(M_, 0, "nboth");
+        const int nBoth = (int) mxGetScalar(mxFldp);
+        mxFldp = mxGetField(M_, 0, "nfwrd");
+        const int nForw = (int) mxGetScalar(mxFldp);
+        mxFldp = mxGetField(M_, 0, "nsfwrd");
+        const int nsForw = (int) mxGetScalar(mxFldp);
+
+        mxFldp = mxGetField(M_, 0, "exo_nbr");
+        const int nExog = (int) mxGetScalar(mxFldp);
+        mxFldp = mxGetField(M_, 0, "endo_nbr");
+        const int nEndo = (int) mxGetScalar(mxFldp);
+        mxFldp = mxGetField(M_, 0, "param_nbr");
+        const int nPar = (int) mxGetScalar(mxFldp);
+
+        mxFldp = mxGetField(dr, 0, "order_var");
+        dparams = mxGetPr(mxFldp);
+        npar = (int) mxGetM(mxFldp);
+        if (npar != nEndo)
+          DYN_MEX_FUNC_ERR_MSG_TXT("Incorrect number of input var_order vars.");
+
+        vector<int> var_order_vp(nEndo);
+        for (int v = 0; v < nEndo; v++)
+          var_order_vp[v] = (int) (*(dparams++));
+
+        // the lag, current and lead blocks of the jacobian respectively
+        mxFldp = mxGetField(M_, 0, "lead_lag_incidence");
+        dparams = mxGetPr(mxFldp);
+        npar = (int) mxGetN(mxFldp);
+        int nrows = (int) mxGetM(mxFldp);
+
+        TwoDMatrix llincidence(nrows, npar, dparams);
+        if (npar != nEndo)
           {
-            /* Set the output pointer to the output matrix ysteady. */
-            map<string, ConstTwoDMatrix>::const_iterator cit = mm.begin();
-            ++cit;
-            plhs[1] = mxCreateDoubleMatrix((*cit).second.numRows(), (*cit).second.numCols(), mxREAL);
-
-            // Copy Dynare++ matrix into MATLAB matrix
-            const ConstVector &vec = (*cit).second.getData();
-            assert(vec.skip() == 1);
-            memcpy(mxGetPr(plhs[1]), vec.base(), vec.length() * sizeof(double));
+            ostringstream strstrm;
+            strstrm << "dynare:k_order_perturbation " << "Incorrect length of lead lag incidences: ncol=" << npar << " != nEndo=" << nEndo;
+            DYN_MEX_FUNC_ERR_MSG_TXT(strstrm.str().c_str());
           }
-        if (kOrder >= 2)
+        //get NNZH =NNZD(2) = the total number of non-zero Hessian elements
+        mxFldp = mxGetField(M_, 0, "NNZDerivatives");
+        dparams = mxGetPr(mxFldp);
+        Vector NNZD(dparams, (int) mxGetM(mxFldp));
+        if (NNZD.length() < kOrder || NNZD[kOrder-1] == -1)
+          DYN_MEX_FUNC_ERR_MSG_TXT("The derivatives were not computed for the required order. Make sure that you used the right order option inside the stoch_simul command");
+
+        const int jcols = nExog+nEndo+nsPred+nsForw; // Num of Jacobian columns
+
+        mxFldp = mxGetField(M_, 0, "var_order_endo_names");
+        const int nendo = (int) mxGetM(mxFldp);
+        const int widthEndo = (int) mxGetN(mxFldp);
+        vector<string> endoNames;
+        DynareMxArrayToString(mxFldp, nendo, widthEndo, endoNames);
+
+        mxFldp = mxGetField(M_, 0, "exo_names");
+        const int nexo = (int) mxGetM(mxFldp);
+        const int widthExog = (int) mxGetN(mxFldp);
+        vector<string> exoNames;
+        DynareMxArrayToString(mxFldp, nexo, widthExog, exoNames);
+
+        if ((nEndo != nendo) || (nExog != nexo))
+          DYN_MEX_FUNC_ERR_MSG_TXT("Incorrect number of input parameters.");
+
+        TwoDMatrix *g1m=NULL;
+        TwoDMatrix *g2m=NULL;
+        TwoDMatrix *g3m=NULL;
+        // derivatives passed as arguments */
+        if (nrhs > 3)
           {
-            int ii = 1;
-            for (map<string, ConstTwoDMatrix>::const_iterator cit = mm.begin();
-                 ((cit != mm.end()) && (ii < nlhs)); ++cit)
+            const mxArray *g1 = prhs[3];
+            int m = (int) mxGetM(g1);
+            int n = (int) mxGetN(g1);
+            g1m = new TwoDMatrix(m, n, mxGetPr(g1));
+            if (nrhs > 4)
               {
-		plhs[ii] = mxCreateDoubleMatrix((*cit).second.numRows(), (*cit).second.numCols(), mxREAL);
-		
-		// Copy Dynare++ matrix into MATLAB matrix
-		const ConstVector &vec = (*cit).second.getData();
-		assert(vec.skip() == 1);
-		memcpy(mxGetPr(plhs[ii]), vec.base(), vec.length() * sizeof(double));
-		
-		++ii;
-		
+                const mxArray *g2 = prhs[4];
+                int m = (int) mxGetM(g2);
+                int n = (int) mxGetN(g2);
+                g2m = new TwoDMatrix(m, n, mxGetPr(g2));
+                if (nrhs > 5)
+                  {
+                    const mxArray *g3 = prhs[5];
+                    int m = (int) mxGetM(g3);
+                    int n = (int) mxGetN(g3);
+                    g3m = new TwoDMatrix(m, n, mxGetPr(g3));
+                  }
               }
-	    if (kOrder == 3 && nlhs > 4)
-	      {
-		const FGSContainer *derivs = app.get_rule_ders();
-		const std::string fieldnames[] = {"gy", "gu", "gyy", "gyu", "guu", "gss", 
-				      "gyyy", "gyyu", "gyuu", "guuu", "gyss", "guss"};
-		// creates the char** expected by mxCreateStructMatrix()
-		const char* c_fieldnames[12];
-		for (int i=0; i < 12;++i)
-		  c_fieldnames[i] = fieldnames[i].c_str();
-		plhs[ii] = mxCreateStructMatrix(1,1,12,c_fieldnames);
-		copy_derivatives(plhs[ii],Symmetry(1,0,0,0),derivs,"gy");
-		copy_derivatives(plhs[ii],Symmetry(0,1,0,0),derivs,"gu");
-		copy_derivatives(plhs[ii],Symmetry(2,0,0,0),derivs,"gyy");
-		copy_derivatives(plhs[ii],Symmetry(0,2,0,0),derivs,"guu");
-		copy_derivatives(plhs[ii],Symmetry(1,1,0,0),derivs,"gyu");
-		copy_derivatives(plhs[ii],Symmetry(0,0,0,2),derivs,"gss");
-		copy_derivatives(plhs[ii],Symmetry(3,0,0,0),derivs,"gyyy");
-		copy_derivatives(plhs[ii],Symmetry(0,3,0,0),derivs,"guuu");
-		copy_derivatives(plhs[ii],Symmetry(2,1,0,0),derivs,"gyyu");
-		copy_derivatives(plhs[ii],Symmetry(1,2,0,0),derivs,"gyuu");
-		copy_derivatives(plhs[ii],Symmetry(1,0,0,2),derivs,"gyss");
-		copy_derivatives(plhs[ii],Symmetry(0,1,0,2),derivs,"guss");
-	      }
-	  }
+          }
+
+        context = new KOrderContext(fName, use_dll, kOrder, num_threads, first_touch, qz_criterium, fo_solver, fo_tol,
+                                    endoNames, exoNames,
+                                    nStat, nPred, nBoth, nForw, nExog, nEndo, nPar, jcols, NNZD,
+                                    var_order_vp, llincidence, modParams, vCov, ySteady,
+                                    g1m, g2m, g3m);
+      }
+
+    try
+      {
+        try
+          {
+            context->load();
+            if (open)
+              {
+                contexts[++last_handle] = context;
+                owned = false;
+                mexAtExit(close_contexts);
+                plhs[1] = mxCreateDoubleScalar(last_handle);
+              }
+            else
+              context->solve(nlhs, plhs);
+          }
+        catch (...)
+          {
+            if (owned)
+              delete context;
+            throw;
+          }
       }
     catch (const KordException &e)
       {
@@ -347,6 +570,8 @@ extern "C" {
         strstrm << "dynare:k_order_perturbation: Caught general exception: " << e.message();
         DYN_MEX_FUNC_ERR_MSG_TXT(strstrm.str().c_str());
       }
+    if (owned)
+      delete context;
     plhs[0] = mxCreateDoubleScalar(0);
   } // end of mexFunction()
 } // end of extern C
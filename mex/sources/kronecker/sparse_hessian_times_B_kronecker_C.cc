@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2007-2011 Dynare Team
+ * Copyright (C) 2007-2015 Dynare Team
  *
  * This file is part of Dynare.
  *
@@ -21,123 +21,16 @@
  * This mex file computes A*kron(B,C) or A*kron(B,B) without explicitly building kron(B,C) or kron(B,B), so that
  * one can consider large matrices A, B and/or C, and assuming that A is a the hessian of a dsge model
  * (dynare format). This mex file should not be used outside dr1.m.
+ *
+ * With a fourth argument equal to 'folded', A*kron(B,B) is returned folded: only the columns
+ * (j1,j2) with j1<=j2 are returned, in lexicographic order (see sparse_kronecker.hh).
  */
 
-#include <string.h>
+#include <cstring>
 
 #include <dynmex.h>
 
-#ifdef USE_OMP
-# include <omp.h>
-#endif
-
-#define DEBUG_OMP 0
-
-void
-sparse_hessian_times_B_kronecker_B(mwIndex *isparseA, mwIndex *jsparseA, double *vsparseA,
-                                   double *B, double *D, mwSize mA, mwSize nA, mwSize mB, mwSize nB, int number_of_threads)
-{
-  /*
-  **   Loop over the columns of kron(B,B) (or of the result matrix D).
-  **   This loop is splitted into two nested loops because we use the
-  **   symmetric pattern of the hessian matrix.
-  */
-#if USE_OMP
-# pragma omp parallel for num_threads(number_of_threads)
-#endif
-  for (mwIndex j1B = 0; j1B < nB; j1B++)
-    {
-#if DEBUG_OMP
-      mexPrintf("%d thread number is %d (%d).\n", j1B, omp_get_thread_num(), omp_get_num_threads());
-#endif
-      for (mwIndex j2B = j1B; j2B < nB; j2B++)
-        {
-          mwIndex jj = j1B*nB+j2B; // column of kron(B,B) index.
-          mwIndex iv = 0;
-          int nz_in_column_ii_of_A = 0;
-          mwIndex k1 = 0;
-          mwIndex k2 = 0;
-          /*
-          ** Loop over the rows of kron(B,B) (column jj).
-          */
-          for (mwIndex ii = 0; ii < nA; ii++)
-            {
-              k1 = jsparseA[ii];
-              k2 = jsparseA[ii+1];
-              if (k1 < k2) // otherwise column ii of A does not have non zero elements (and there is nothing to compute).
-                {
-                  ++nz_in_column_ii_of_A;
-                  mwIndex i1B = (ii/mB);
-                  mwIndex i2B = (ii%mB);
-                  double bb  = B[j1B*mB+i1B]*B[j2B*mB+i2B];
-                  /*
-                  ** Loop over the non zero entries of A(:,ii).
-                  */
-                  for (mwIndex k = k1; k < k2; k++)
-                    {
-                      mwIndex kk = isparseA[k];
-                      D[jj*mA+kk] = D[jj*mA+kk] + bb*vsparseA[iv];
-                      iv++;
-                    }
-                }
-            }
-          if (nz_in_column_ii_of_A > 0)
-            {
-              memcpy(&D[(j2B*nB+j1B)*mA], &D[jj*mA], mA*sizeof(double));
-            }
-        }
-    }
-}
-
-void
-sparse_hessian_times_B_kronecker_C(mwIndex *isparseA, mwIndex *jsparseA, double *vsparseA,
-                                   double *B, double *C, double *D,
-                                   mwSize mA, mwSize nA, mwSize mB, mwSize nB, mwSize mC, mwSize nC, int number_of_threads)
-{
-  /*
-  **   Loop over the columns of kron(B,B) (or of the result matrix D).
-  */
-#if USE_OMP
-# pragma omp parallel for num_threads(number_of_threads)
-#endif
-  for (mwIndex jj = 0; jj < nB*nC; jj++) // column of kron(B,C) index.
-    {
-      // Uncomment the following line to check if all processors are used.
-#if DEBUG_OMP
-      mexPrintf("%d thread number is %d (%d).\n", jj, omp_get_thread_num(), omp_get_num_threads());
-#endif
-      mwIndex jB = jj/nC;
-      mwIndex jC = jj%nC;
-      mwIndex k1 = 0;
-      mwIndex k2 = 0;
-      mwIndex iv = 0;
-      int nz_in_column_ii_of_A = 0;
-      /*
-      ** Loop over the rows of kron(B,C) (column jj).
-      */
-      for (mwIndex ii = 0; ii < nA; ii++)
-        {
-          k1 = jsparseA[ii];
-          k2 = jsparseA[ii+1];
-          if (k1 < k2) // otherwise column ii of A does not have non zero elements (and there is nothing to compute).
-            {
-              ++nz_in_column_ii_of_A;
-              mwIndex iC = (ii%mB);
-              mwIndex iB = (ii/mB);
-              double cb = C[jC*mC+iC]*B[jB*mB+iB];
-              /*
-              ** Loop over the non zero entries of A(:,ii).
-              */
-              for (mwIndex k = k1; k < k2; k++)
-                {
-                  mwIndex kk = isparseA[k];
-                  D[jj*mA+kk] = D[jj*mA+kk] + cb*vsparseA[iv];
-                  iv++;
-                }
-            }
-        }
-    }
-}
+#include "sparse_kronecker.hh"
 
 void
 mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
@@ -145,6 +38,17 @@ mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
   // Check input and output:
   if ((nrhs > 4) || (nrhs < 3) )
     DYN_MEX_FUNC_ERR_MSG_TXT("sparse_hessian_times_B_kronecker_C takes 3 or 4 input arguments and provides 2 output arguments.");
+  // A*kron(B,B) is to be computed if there is no C (the last argument being the number of threads or 'folded').
+  const bool folded = (nrhs == 4 && mxIsChar(prhs[3]));
+  const bool kronecker_B_B = (nrhs == 3 || folded);
+  if (folded)
+    {
+      char *str = mxArrayToString(prhs[3]);
+      bool ok = (str != NULL && strcmp(str, "folded") == 0);
+      mxFree(str);
+      if (!ok)
+        DYN_MEX_FUNC_ERR_MSG_TXT("sparse_hessian_times_B_kronecker_C: the fourth argument must be the number of threads or 'folded'.");
+    }
 
   if (!mxIsSparse(prhs[0]))
     DYN_MEX_FUNC_ERR_MSG_TXT("sparse_hessian_times_B_kronecker_C: First input must be a sparse (dynare) hessian matrix.");
@@ -155,7 +59,7 @@ mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
   nA = mxGetN(prhs[0]);
   mB = mxGetM(prhs[1]);
   nB = mxGetN(prhs[1]);
-  if (nrhs == 4) // A*kron(B,C) is to be computed.
+  if (!kronecker_B_B) // A*kron(B,C) is to be computed.
     {
       mC = mxGetM(prhs[2]);
       nC = mxGetN(prhs[2]);
@@ -172,7 +76,7 @@ mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
   int numthreads;
   B = mxGetPr(prhs[1]);
   numthreads = (int) mxGetScalar(prhs[2]);
-  if (nrhs == 4)
+  if (!kronecker_B_B)
     {
       C = mxGetPr(prhs[2]);
       numthreads = (int) mxGetScalar(prhs[3]);
@@ -183,23 +87,29 @@ mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
   double  *vsparseA = mxGetPr(prhs[0]);
   // Initialization of the ouput:
   double *D;
-  if (nrhs == 4)
+  if (!kronecker_B_B)
     {
       plhs[0] = mxCreateDoubleMatrix(mA, nB*nC, mxREAL);
     }
+  else if (folded)
+    {
+      plhs[0] = mxCreateDoubleMatrix(mA, nB*(nB+1)/2, mxREAL);
+    }
   else
     {
       plhs[0] = mxCreateDoubleMatrix(mA, nB*nB, mxREAL);
     }
   D = mxGetPr(plhs[0]);
-  // Computational part:
-  if (nrhs == 3)
+  // Computational part (A is stored by rows):
+  if (kronecker_B_B)
     {
-      sparse_hessian_times_B_kronecker_B(isparseA, jsparseA, vsparseA, B, D, mA, nA, mB, nB, numthreads);
+      SparseRows A(isparseA, jsparseA, vsparseA, mA, nA, mB, true);
+      sparse_hessian_times_B_kronecker_B(A, B, D, mB, nB, folded, numthreads);
     }
   else
     {
-      sparse_hessian_times_B_kronecker_C(isparseA, jsparseA, vsparseA, B, C, D, mA, nA, mB, nB, mC, nC, numthreads);
+      SparseRows A(isparseA, jsparseA, vsparseA, mA, nA, mC, false);
+      sparse_times_B_kronecker_C(A, B, C, D, mB, nB, mC, nC, numthreads);
     }
   plhs[1] = mxCreateDoubleScalar(0);
 }
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#ifdef USE_OMP
+# include <omp.h>
+#endif
+
+#include "sparse_kronecker.hh"
+
+using namespace std;
+
+// Number of rows of A processed together
+static const size_t row_block = 16;
+// Size (in doubles) of the buffer of the rows of the result
+static const size_t buffer_size = 32768;
+
+// Transposes the mB×nB matrix B, so that the rows of B are contiguous
+static void
+transpose(const double *B, size_t mB, size_t nB, vector<double> &BT)
+{
+  BT.resize(mB*nB);
+  for (size_t j = 0; j < nB; j++)
+    for (size_t i = 0; i < mB; i++)
+      BT[i*nB+j] = B[j*mB+i];
+}
+
+void
+sparse_times_B_kronecker_C(const SparseRows &A, const double *B, const double *C, double *D,
+                           size_t mB, size_t nB, size_t mC, size_t nC, int number_of_threads)
+{
+  const size_t mA = A.nrows;
+  vector<double> BT, CT;
+  transpose(B, mB, nB, BT);
+  transpose(C, mC, nC, CT);
+  // Columns of B per block, so that row_block rows of nC columns per column of B fit in the buffer
+  const size_t jb = max((size_t) 1, min(nB, buffer_size/(row_block*max(nC, (size_t) 1))));
+  const size_t nrow_blocks = (mA+row_block-1)/row_block;
+
+#ifdef USE_OMP
+# pragma omp parallel num_threads(number_of_threads)
+#endif
+  {
+    vector<double> buf(row_block*jb*nC);
+#ifdef USE_OMP
+# pragma omp for schedule(dynamic)
+#endif
+    for (size_t rb = 0; rb < nrow_blocks; rb++)
+      {
+        const size_t r0 = rb*row_block;
+        const size_t nr = min(row_block, mA-r0);
+        for (size_t jB0 = 0; jB0 < nB; jB0 += jb)
+          {
+            const size_t njB = min(jb, nB-jB0);
+            const size_t ncols = njB*nC;
+            memset(&buf[0], 0, nr*ncols*sizeof(double));
+            for (size_t r = 0; r < nr; r++)
+              {
+                double *d = &buf[r*ncols];
+                for (size_t k = A.rowptr[r0+r]; k < A.rowptr[r0+r+1]; k++)
+                  {
+                    const double *b = &BT[A.i1[k]*nB+jB0];
+                    const double *c = &CT[A.i2[k]*nC];
+                    const double a = A.val[k];
+                    for (size_t jB = 0; jB < njB; jB++)
+                      {
+                        const double ab = a*b[jB];
+                        double *dd = d+jB*nC;
+                        for (size_t jC = 0; jC < nC; jC++)
+                          dd[jC] += ab*c[jC];
+                      }
+                  }
+              }
+            // The columns of the result for the block are contiguous
+            for (size_t col = 0; col < ncols; col++)
+              {
+                double *dcol = &D[(jB0*nC+col)*mA+r0];
+                for (size_t r = 0; r < nr; r++)
+                  dcol[r] = buf[r*ncols+col];
+              }
+          }
+      }
+  }
+}
+
+void
+sparse_hessian_times_B_kronecker_B(const SparseRows &A, const double *B, double *D,
+                                   size_t mB, size_t nB, bool folded, int number_of_threads)
+{
+  const size_t mA = A.nrows;
+  vector<double> BT;
+  transpose(B, mB, nB, BT);
+  /* The folded columns (j1,j2) with j1 in a block of columns of B are
+     contiguous, start[j1] is the position of the column (j1,j1) */
+  vector<size_t> start(nB+1, 0);
+  for (size_t j1 = 1; j1 <= nB; j1++)
+    start[j1] = start[j1-1]+nB-(j1-1);
+  const size_t jb = max((size_t) 1, min(nB, buffer_size/(row_block*max(nB, (size_t) 1))));
+  const size_t nrow_blocks = (mA+row_block-1)/row_block;
+
+#ifdef USE_OMP
+# pragma omp parallel num_threads(number_of_threads)
+#endif
+  {
+    vector<double> buf(row_block*jb*nB);
+#ifdef USE_OMP
+# pragma omp for schedule(dynamic)
+#endif
+    for (size_t rb = 0; rb < nrow_blocks; rb++)
+      {
+        const size_t r0 = rb*row_block;
+        const size_t nr = min(row_block, mA-r0);
+        for (size_t j10 = 0; j10 < nB; j10 += jb)
+          {
+            const size_t nj1 = min(jb, nB-j10);
+            const size_t first = start[j10];
+            const size_t ncols = start[j10+nj1]-first;
+            memset(&buf[0], 0, nr*ncols*sizeof(double));
+            for (size_t r = 0; r < nr; r++)
+              {
+                double *d = &buf[r*ncols];
+                for (size_t k = A.rowptr[r0+r]; k < A.rowptr[r0+r+1]; k++)
+                  {
+                    const double *b1 = &BT[A.i1[k]*nB];
+                    const double *b2 = &BT[A.i2[k]*nB];
+                    const double a = A.val[k];
+                    if (A.i1[k] == A.i2[k])
+                      for (size_t j1 = j10; j1 < j10+nj1; j1++)
+                        {
+                          const double c = a*b1[j1];
+                          double *dd = d+start[j1]-first-j1;
+                          for (size_t j2 = j1; j2 < nB; j2++)
+                            dd[j2] += c*b1[j2];
+                        }
+                    else
+                      for (size_t j1 = j10; j1 < j10+nj1; j1++)
+                        {
+                          const double c1 = a*b1[j1];
+                          const double c2 = a*b2[j1];
+                          double *dd = d+start[j1]-first-j1;
+                          for (size_t j2 = j1; j2 < nB; j2++)
+                            dd[j2] += c1*b2[j2]+c2*b1[j2];
+                        }
+                  }
+              }
+            if (folded)
+              for (size_t col = 0; col < ncols; col++)
+                {
+                  double *dcol = &D[(first+col)*mA+r0];
+                  for (size_t r = 0; r < nr; r++)
+                    dcol[r] = buf[r*ncols+col];
+                }
+            else
+              for (size_t j1 = j10; j1 < j10+nj1; j1++)
+                for (size_t j2 = j1; j2 < nB; j2++)
+                  {
+                    const size_t col = start[j1]-first+j2-j1;
+                    double *dcol1 = &D[(j1*nB+j2)*mA+r0];
+                    double *dcol2 = &D[(j2*nB+j1)*mA+r0];
+                    for (size_t r = 0; r < nr; r++)
+                      dcol1[r] = dcol2[r] = buf[r*ncols+col];
+                  }
+          }
+      }
+  }
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SPARSE_KRONECKER_HH
+#define _SPARSE_KRONECKER_HH
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+/*
+ * Products of a sparse matrix A (mA×nA, typically the Hessian of a model)
+ * with kron(B,C) or kron(B,B), without building the Kronecker product.
+ *
+ * The matrix A is stored by rows (CSR): for each row, the list of its non
+ * zero elements with the pair of indices (i1,i2) of its column i1*mC+i2.
+ * The products are computed row by row: for a block of rows and a block of
+ * columns of B, the rows of the result are accumulated in a small buffer
+ * with contiguous inner loops over the columns of C (or B), and then written
+ * to the column-major result. The blocks of rows are distributed over the
+ * threads.
+ *
+ * For kron(B,B), A is assumed symmetric as a Hessian (A(:,i1*mB+i2) equal
+ * to A(:,i2*mB+i1)). Only the elements with i1<=i2 are kept (the symmetric
+ * elements being averaged), and only the columns j1<=j2 of the result are
+ * computed. The result can then be returned folded (one column per pair
+ * j1<=j2, in lexicographic order, as in the folded tensors of Dynare++) or
+ * unfolded.
+ */
+class SparseRows
+{
+public:
+  const size_t nrows;
+  // Start of each row in the arrays of elements
+  std::vector<size_t> rowptr;
+  std::vector<int> i1, i2;
+  std::vector<double> val;
+
+  /* Converts a CSC matrix (ir, jc, v) of size mA×nA, the columns being
+     indexed by pairs (i1,i2) with nA=m1*m2. If symmetric, m1=m2 and the
+     elements of columns (i1,i2) and (i2,i1) are merged. */
+  template<class Index>
+  SparseRows(const Index *ir, const Index *jc, const double *v, size_t mA, size_t nA,
+             size_t m2, bool symmetric);
+private:
+  struct Element
+  {
+    int i1, i2;
+    double val;
+    bool
+    operator<(const Element &e) const
+    {
+      return i1 < e.i1 || (i1 == e.i1 && i2 < e.i2);
+    }
+  };
+};
+
+/* D = A*kron(B,C), B is mB×nB and C is mC×nC (column major), D is
+   mA×(nB*nC). */
+void sparse_times_B_kronecker_C(const SparseRows &A, const double *B, const double *C, double *D,
+                                size_t mB, size_t nB, size_t mC, size_t nC, int number_of_threads);
+
+/* D = A*kron(B,B) for a symmetric A (see above), B is mB×nB. If folded, D is
+   mA×(nB*(nB+1)/2), otherwise D is mA×(nB*nB). */
+void sparse_hessian_times_B_kronecker_B(const SparseRows &A, const double *B, double *D,
+                                        size_t mB, size_t nB, bool folded, int number_of_threads);
+
+template<class Index>
+SparseRows::SparseRows(const Index *ir, const Index *jc, const double *v, size_t mA, size_t nA,
+                       size_t m2, bool symmetric)
+  : nrows(mA), rowptr(mA+1, 0)
+{
+  // Count the elements of each row, and place them
+  for (size_t j = 0; j < nA; j++)
+    for (Index k = jc[j]; k < jc[j+1]; k++)
+      rowptr[ir[k]+1]++;
+  for (size_t r = 0; r < mA; r++)
+    rowptr[r+1] += rowptr[r];
+  std::vector<Element> elements(rowptr[mA]);
+  std::vector<size_t> pos(rowptr.begin(), rowptr.end()-1);
+  for (size_t j = 0; j < nA; j++)
+    for (Index k = jc[j]; k < jc[j+1]; k++)
+      {
+        Element &e = elements[pos[ir[k]]++];
+        e.i1 = (int) (j/m2);
+        e.i2 = (int) (j%m2);
+        e.val = v[k];
+        if (symmetric && e.i1 != e.i2)
+          {
+            // Average of the elements (i1,i2) and (i2,i1), stored with i1<i2
+            e.val *= 0.5;
+            if (e.i1 > e.i2)
+              std::swap(e.i1, e.i2);
+          }
+      }
+
+  // Sort and merge the elements of each row
+  i1.reserve(elements.size());
+  i2.reserve(elements.size());
+  val.reserve(elements.size());
+  size_t start = 0;
+  for (size_t r = 0; r < mA; r++)
+    {
+      std::vector<Element>::iterator first = elements.begin()+start, last = elements.begin()+rowptr[r+1];
+      start = rowptr[r+1];
+      std::sort(first, last);
+      rowptr[r] = val.size();
+      for (std::vector<Element>::iterator it = first; it != last; ++it)
+        if (val.size() > rowptr[r] && i1.back() == it->i1 && i2.back() == it->i2)
+          val.back() += it->val;
+        else
+          {
+            i1.push_back(it->i1);
+            i2.push_back(it->i2);
+            val.push_back(it->val);
+          }
+    }
+  rowptr[mA] = val.size();
+}
+
+#endif
@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark of the products of a sparse hessian with kron(B,B) and kron(B,C)
+ * (sparse_kronecker.cc) against the column by column algorithm previously used
+ * in sparse_hessian_times_B_kronecker_C.cc, on random hessians with the
+ * sparsity of a dsge model (each equation involves a few variables, the
+ * hessian being symmetric). The results of both algorithms are compared.
+ *
+ * Compile (from this directory) with:
+ *   g++ -O2 -fopenmp -DUSE_OMP -I.. sparse_kronecker_benchmark.cc ../sparse_kronecker.cc -o sparse_kronecker_benchmark
+ * and run with an optional number of threads as argument.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#ifdef USE_OMP
+# include <omp.h>
+#endif
+
+#include "sparse_kronecker.hh"
+
+using namespace std;
+
+static double
+now()
+{
+#ifdef USE_OMP
+  return omp_get_wtime();
+#else
+  return (double) clock()/CLOCKS_PER_SEC;
+#endif
+}
+
+// The previous algorithm for A*kron(B,B), looping over the columns j1<=j2 of the result
+static void
+legacy_B_kronecker_B(const size_t *isparseA, const size_t *jsparseA, const double *vsparseA,
+                     const double *B, double *D, size_t mA, size_t nA, size_t mB, size_t nB,
+                     int number_of_threads)
+{
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(number_of_threads)
+#endif
+  for (size_t j1B = 0; j1B < nB; j1B++)
+    for (size_t j2B = j1B; j2B < nB; j2B++)
+      {
+        size_t jj = j1B*nB+j2B;
+        for (size_t ii = 0; ii < nA; ii++)
+          {
+            double bb = B[j1B*mB+ii/mB]*B[j2B*mB+ii%mB];
+            for (size_t k = jsparseA[ii]; k < jsparseA[ii+1]; k++)
+              D[jj*mA+isparseA[k]] += bb*vsparseA[k];
+          }
+        copy(&D[jj*mA], &D[(jj+1)*mA], &D[(j2B*nB+j1B)*mA]);
+      }
+}
+
+// The previous algorithm for A*kron(B,C), looping over the columns of the result
+static void
+legacy_B_kronecker_C(const size_t *isparseA, const size_t *jsparseA, const double *vsparseA,
+                     const double *B, const double *C, double *D, size_t mA, size_t nA,
+                     size_t mB, size_t nB, size_t mC, size_t nC, int number_of_threads)
+{
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(number_of_threads)
+#endif
+  for (size_t jj = 0; jj < nB*nC; jj++)
+    {
+      size_t jB = jj/nC, jC = jj%nC;
+      for (size_t ii = 0; ii < nA; ii++)
+        {
+          double cb = C[jC*mC+ii%mC]*B[jB*mB+ii/mC];
+          for (size_t k = jsparseA[ii]; k < jsparseA[ii+1]; k++)
+            D[jj*mA+isparseA[k]] += cb*vsparseA[k];
+        }
+    }
+}
+
+static double
+uniform()
+{
+  return (double) rand()/RAND_MAX;
+}
+
+/* Random mA×(mB*mB) symmetric hessian in CSC format: each equation involves
+   nvars variables, and all the second order derivatives in these variables
+   are non zero. */
+static void
+random_hessian(size_t mA, size_t mB, size_t nvars, vector<size_t> &ir, vector<size_t> &jc,
+               vector<double> &v)
+{
+  vector<vector<pair<size_t, double> > > columns(mB*mB);
+  for (size_t r = 0; r < mA; r++)
+    {
+      vector<size_t> vars;
+      while (vars.size() < nvars)
+        {
+          size_t i = rand() % mB;
+          if (find(vars.begin(), vars.end(), i) == vars.end())
+            vars.push_back(i);
+        }
+      for (size_t a = 0; a < nvars; a++)
+        for (size_t b = a; b < nvars; b++)
+          {
+            double x = uniform()-0.5;
+            columns[vars[a]*mB+vars[b]].push_back(make_pair(r, x));
+            if (a != b)
+              columns[vars[b]*mB+vars[a]].push_back(make_pair(r, x));
+          }
+    }
+  ir.clear();
+  v.clear();
+  jc.assign(1, 0);
+  for (size_t j = 0; j < mB*mB; j++)
+    {
+      sort(columns[j].begin(), columns[j].end());
+      for (size_t k = 0; k < columns[j].size(); k++)
+        {
+          ir.push_back(columns[j][k].first);
+          v.push_back(columns[j][k].second);
+        }
+      jc.push_back(ir.size());
+    }
+}
+
+static double
+max_abs_diff(const vector<double> &x, const vector<double> &y)
+{
+  double res = 0;
+  for (size_t i = 0; i < x.size(); i++)
+    res = max(res, fabs(x[i]-y[i]));
+  return res;
+}
+
+static bool
+run(size_t mA, size_t mB, size_t nB, size_t nvars, int nthreads)
+{
+  vector<size_t> ir, jc;
+  vector<double> v;
+  random_hessian(mA, mB, nvars, ir, jc, v);
+  vector<double> B(mB*nB), C(mB*nB/2);
+  const size_t nC = nB/2;
+  for (size_t i = 0; i < B.size(); i++)
+    B[i] = uniform()-0.5;
+  for (size_t i = 0; i < C.size(); i++)
+    C[i] = uniform()-0.5;
+  printf("mA=%lu mB=%lu nB=%lu, %lu non zero elements\n", (unsigned long) mA, (unsigned long) mB,
+         (unsigned long) nB, (unsigned long) v.size());
+
+  // A*kron(B,B)
+  vector<double> D0(mA*nB*nB, 0.0), D1(mA*nB*nB), D2(mA*nB*(nB+1)/2);
+  double t0 = now();
+  legacy_B_kronecker_B(&ir[0], &jc[0], &v[0], &B[0], &D0[0], mA, mB*mB, mB, nB, nthreads);
+  double t1 = now();
+  SparseRows A(&ir[0], &jc[0], &v[0], mA, mB*mB, mB, true);
+  double t2 = now();
+  sparse_hessian_times_B_kronecker_B(A, &B[0], &D1[0], mB, nB, false, nthreads);
+  double t3 = now();
+  sparse_hessian_times_B_kronecker_B(A, &B[0], &D2[0], mB, nB, true, nthreads);
+  double t4 = now();
+  vector<double> D0f;
+  for (size_t j1 = 0; j1 < nB; j1++)
+    for (size_t j2 = j1; j2 < nB; j2++)
+      D0f.insert(D0f.end(), &D0[(j1*nB+j2)*mA], &D0[(j1*nB+j2+1)*mA]);
+  double err_BB = max(max_abs_diff(D0, D1), max_abs_diff(D0f, D2));
+  printf("  A*kron(B,B): legacy %.4fs, rows %.4fs (folded %.4fs, conversion of A %.4fs), error %.2e\n",
+         t1-t0, t3-t2, t4-t3, t2-t1, err_BB);
+
+  // A*kron(B,C), C having mB rows
+  vector<double> E0(mA*nB*nC, 0.0), E1(mA*nB*nC);
+  t0 = now();
+  legacy_B_kronecker_C(&ir[0], &jc[0], &v[0], &B[0], &C[0], &E0[0], mA, mB*mB, mB, nB, mB, nC, nthreads);
+  t1 = now();
+  SparseRows A2(&ir[0], &jc[0], &v[0], mA, mB*mB, mB, false);
+  t2 = now();
+  sparse_times_B_kronecker_C(A2, &B[0], &C[0], &E1[0], mB, nB, mB, nC, nthreads);
+  t3 = now();
+  double err_BC = max_abs_diff(E0, E1);
+  printf("  A*kron(B,C): legacy %.4fs, rows %.4fs (conversion of A %.4fs), error %.2e\n",
+         t1-t0, t3-t2, t2-t1, err_BC);
+
+  return err_BB < 1e-10 && err_BC < 1e-10;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int nthreads = argc > 1 ? atoi(argv[1]) : 1;
+  srand(1);
+  bool ok = run(60, 150, 30, 6, nthreads);
+  ok = run(200, 500, 60, 8, nthreads) && ok;
+  ok = run(400, 800, 120, 10, nthreads) && ok;
+  printf(ok ? "OK\n" : "FAILED\n");
+  return ok ? 0 : 1;
+}
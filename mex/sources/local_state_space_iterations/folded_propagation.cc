@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <dynblas.h>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+#include "folded_propagation.hh"
+
+using namespace std;
+
+FoldedPropagation::FoldedPropagation(int m_arg, int n_arg, int q_arg, const vector<const double *> &g,
+                                     const vector<const double *> &gs)
+  : m(m_arg), n(n_arg), q(q_arg), nz(n_arg+q_arg), gm(g.size()), gsm(gs.size())
+{
+  const int order = max((int) g.size(), (int) gs.size());
+
+  /* The monomials of order d are the children of the monomials of order d-1
+     (the last index of the child being greater or equal to the last index of
+     the parent), taken in order: this is the lexicographic ordering of the
+     folded tensors. The multiplicity d!/(r_1!...r_l!) of a child is the
+     multiplicity of its parent times d/r, where r is the number of
+     occurences of its last index. */
+  vector<vector<double> > mult(order+1);
+  vector<int> last_prev(nz), run_prev(nz, 1);
+  mult[0].assign(1, 1.0);
+  if (order >= 1)
+    mult[1].assign(nz, 1.0);
+  for (int i = 0; i < nz; i++)
+    last_prev[i] = i;
+  for (int d = 2; d <= order; d++)
+    {
+      const int nm = nmono(nz, d);
+      parent.push_back(vector<int>(nm));
+      last.push_back(vector<int>(nm));
+      vector<int> &par = parent.back();
+      vector<int> &lst = last.back();
+      vector<int> run(nm);
+      mult[d].resize(nm);
+      int c = 0;
+      for (int pc = 0; pc < (int) last_prev.size(); pc++)
+        for (int i = last_prev[pc]; i < nz; i++, c++)
+          {
+            par[c] = pc;
+            lst[c] = i;
+            run[c] = (i == last_prev[pc]) ? run_prev[pc]+1 : 1;
+            mult[d][c] = mult[d-1][pc]*d/run[c];
+          }
+      last_prev = lst;
+      run_prev = run;
+    }
+
+  for (int d = 1; d <= (int) g.size(); d++)
+    if (g[d-1])
+      scaleByMultiplicity(g[d-1], d, mult[d], gm[d-1]);
+  for (int d = 0; d < (int) gs.size(); d++)
+    if (gs[d])
+      scaleByMultiplicity(gs[d], d, mult[d], gsm[d]);
+}
+
+int
+FoldedPropagation::nmono(int nz, int d)
+{
+  // Binomial coefficient C(nz+d-1,d)
+  double res = 1.0;
+  for (int i = 1; i <= d; i++)
+    res = res*(nz+i-1)/i;
+  return (int) (res+0.5);
+}
+
+void
+FoldedPropagation::scaleByMultiplicity(const double *g, int d, const vector<double> &mult,
+                                       vector<double> &res) const
+{
+  const int nm = nmono(nz, d);
+  res.resize(m*nm);
+  for (int c = 0; c < nm; c++)
+    for (int i = 0; i < m; i++)
+      res[c*m+i] = mult[c]*g[c*m+i];
+}
+
+int
+FoldedPropagation::blockSize(int ncomp) const
+{
+  int per_particle = 0;
+  for (int d = 1; d <= order(); d++)
+    per_particle += ncomp*nmono(nz, d);
+  per_particle += ncomp*m;
+  return min(512, max(8, 32768/max(per_particle, 1)));
+}
+
+/* Computes the monomials and the contractions of the block of nb particles
+   starting at particle first. In the non-pruned version (ncomp=1), the column
+   j of mono[d-1] contains the monomials of order d of particle j. In the
+   pruned version, the column j*ncomp+p contains the coefficients of t^(p+1)
+   of the monomials. The results are stored in res in the same layout, they
+   do not include the constant nor the steady state. */
+void
+FoldedPropagation::propagateBlock(const double *yhat, const double *epsilon, int s, int first, int nb,
+                                  int ncomp, vector<vector<double> > &mono, vector<double> &res) const
+{
+  const int ncol = nb*ncomp;
+  const int ord = order();
+  mono.resize(ord);
+
+  // Order 1: z=[yhat; epsilon], the innovations only enter the first component
+  vector<double> &z = mono[0];
+  z.assign(nz*ncol, 0.0);
+  for (int j = 0; j < nb; j++)
+    for (int p = 0; p < ncomp; p++)
+      {
+        double *zc = &z[(j*ncomp+p)*nz];
+        memcpy(zc, &yhat[(first+j + (size_t) s*p)*n], n*sizeof(double));
+        if (p == 0)
+          memcpy(zc+n, &epsilon[(size_t) (first+j)*q], q*sizeof(double));
+      }
+
+  // Order d: one product (resp. one truncated polynomial product) per monomial
+  for (int d = 2; d <= ord; d++)
+    {
+      const int nm = nmono(nz, d);
+      const int nmp = nmono(nz, d-1);
+      const vector<int> &par = parent[d-2];
+      const vector<int> &lst = last[d-2];
+      const vector<double> &prev = mono[d-2];
+      vector<double> &cur = mono[d-1];
+      cur.resize(nm*ncol);
+      if (ncomp == 1)
+        for (int j = 0; j < nb; j++)
+          {
+            const double *pc = &prev[j*nmp];
+            const double *zc = &z[j*nz];
+            double *cc = &cur[j*nm];
+            for (int c = 0; c < nm; c++)
+              cc[c] = pc[par[c]]*zc[lst[c]];
+          }
+      else
+        for (int j = 0; j < nb; j++)
+          for (int p = 0; p < ncomp; p++)
+            {
+              double *cc = &cur[(j*ncomp+p)*nm];
+              // The monomials of order d have no term of degree less than d in t
+              if (p < d-1)
+                {
+                  memset(cc, 0, nm*sizeof(double));
+                  continue;
+                }
+              for (int c = 0; c < nm; c++)
+                {
+                  double v = 0.0;
+                  for (int a = d-2; a < p; a++)
+                    v += prev[(j*ncomp+a)*nmp+par[c]]*z[(j*ncomp+p-1-a)*nz+lst[c]];
+                  cc[c] = v;
+                }
+            }
+    }
+
+  // Contractions
+  res.assign(m*ncol, 0.0);
+  const char transpose[2] = "N";
+  const double one = 1.0;
+  const blas_int mm = m, nc = ncol;
+  for (int d = 1; d <= ord; d++)
+    if (!gm[d-1].empty())
+      {
+        const blas_int nm = nmono(nz, d);
+        dgemm(transpose, transpose, &mm, &nc, &nm, &one, &gm[d-1][0], &mm,
+              &mono[d-1][0], &nm, &one, &res[0], &mm);
+      }
+
+  // Terms in sigma^2 of the pruned version, shifted by two degrees in t
+  if (ncomp > 1)
+    for (int d = 0; d < (int) gsm.size(); d++)
+      {
+        if (gsm[d].empty())
+          continue;
+        if (d == 0)
+          {
+            for (int j = 0; j < nb; j++)
+              for (int i = 0; i < m; i++)
+                res[(j*ncomp+1)*m+i] += gsm[0][i];
+            continue;
+          }
+        const blas_int nm = nmono(nz, d);
+        const blas_int nbb = nb, ldb = nm*ncomp, ldc = m*ncomp;
+        for (int p = d+1; p < ncomp; p++)
+          dgemm(transpose, transpose, &mm, &nbb, &nm, &one, &gsm[d][0], &mm,
+                &mono[d-1][(p-2)*nm], &ldb, &one, &res[p*m], &ldc);
+      }
+}
+
+void
+FoldedPropagation::propagate(const double *yhat, const double *epsilon, const double *constant,
+                             double *y, int s, int num_threads) const
+{
+  const int block = blockSize(1);
+  const int nblocks = (s+block-1)/block;
+#ifdef USE_OMP
+# pragma omp parallel num_threads(num_threads)
+#endif
+  {
+    vector<vector<double> > mono;
+    vector<double> res;
+#ifdef USE_OMP
+# pragma omp for schedule(static)
+#endif
+    for (int b = 0; b < nblocks; b++)
+      {
+        const int first = b*block;
+        const int nb = min(block, s-first);
+        propagateBlock(yhat, epsilon, s, first, nb, 1, mono, res);
+        for (int j = 0; j < nb; j++)
+          {
+            double *yc = &y[(size_t) (first+j)*m];
+            for (int i = 0; i < m; i++)
+              yc[i] = constant[i]+res[j*m+i];
+          }
+      }
+  }
+}
+
+void
+FoldedPropagation::propagatePruned(const double *yhat, const double *epsilon, const double *ys,
+                                   double *y, double *ycomp, int s, int num_threads) const
+{
+  const int ncomp = order();
+  const int block = blockSize(ncomp);
+  const int nblocks = (s+block-1)/block;
+#ifdef USE_OMP
+# pragma omp parallel num_threads(num_threads)
+#endif
+  {
+    vector<vector<double> > mono;
+    vector<double> res;
+#ifdef USE_OMP
+# pragma omp for schedule(static)
+#endif
+    for (int b = 0; b < nblocks; b++)
+      {
+        const int first = b*block;
+        const int nb = min(block, s-first);
+        propagateBlock(yhat, epsilon, s, first, nb, ncomp, mono, res);
+        for (int j = 0; j < nb; j++)
+          {
+            double *yc = &y[(size_t) (first+j)*m];
+            memcpy(yc, ys, m*sizeof(double));
+            for (int p = 0; p < ncomp; p++)
+              {
+                const double *rc = &res[(j*ncomp+p)*m];
+                memcpy(&ycomp[(first+j + (size_t) s*p)*m], rc, m*sizeof(double));
+                for (int i = 0; i < m; i++)
+                  yc[i] += rc[i];
+              }
+          }
+      }
+  }
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FOLDED_PROPAGATION_HH
+#define _FOLDED_PROPAGATION_HH
+
+#include <vector>
+
+/*
+ * Propagation of particles through a decision rule of arbitrary order
+ *
+ *   y = constant + sum_{d=1}^{k} g_d z^(d),   z = [yhat; epsilon]
+ *
+ * where g_d is a m×C(nz+d-1,d) folded tensor (one column per non-decreasing
+ * index sequence i_1<=...<=i_d, in the lexicographic order used by Dynare++,
+ * the Taylor coefficient included, as in dr.g_d), and z^(d) the vector of
+ * the unique monomials z_{i_1}...z_{i_d} weighted by their multiplicity.
+ *
+ * Particles are processed by blocks: for each order, the unique monomials of
+ * all the particles of the block are stacked in a matrix (one column per
+ * particle), each monomial being obtained from its parent of order d-1 by one
+ * product. The contraction with g_d is then a single GEMM. The blocks are
+ * distributed over threads with OpenMP (when compiled with USE_OMP).
+ *
+ * In the pruned version, the states are split into k components of order 1..k
+ * (Kim et al., 2008; Andreasen et al., 2013). Component p is updated with the
+ * terms of order p of the decision rule evaluated at the sum of the
+ * components, the innovations being of order 1 and the perturbation parameter
+ * of order 1. This amounts to taking the coefficient of t^p in the
+ * decision rule evaluated at sum_j t^j z_j, so each monomial is a polynomial
+ * in t truncated at degree k, and each block is still contracted with one
+ * GEMM per order. In this version the g_d are the derivatives with respect to
+ * the states and innovations only, and the terms in sigma^2 z^(d) are given
+ * separately in gs_d (the Taylor coefficient included, i.e. half of
+ * dr.ghs2 for d=0).
+ */
+class FoldedPropagation
+{
+public:
+  /* m is the number of propagated variables, n the number of states, q the
+     number of innovations. g[d-1] points to the m×nmono(d) matrix g_d
+     (column major) for d=1..order, NULL meaning zero. gs[d], for d=0..
+     gs.size()-1, points to the m×nmono(d) matrix of the sigma^2 z^(d)
+     terms, used only by the pruned version. */
+  FoldedPropagation(int m, int n, int q, const std::vector<const double *> &g,
+                    const std::vector<const double *> &gs);
+
+  int
+  order() const
+  {
+    return (int) gm.size();
+  }
+  int
+  nrows() const
+  {
+    return m;
+  }
+  int
+  nstates() const
+  {
+    return n;
+  }
+  int
+  nshocks() const
+  {
+    return q;
+  }
+  // Number of unique monomials of order d in nz=n+q variables
+  static int nmono(int nz, int d);
+
+  /* Non-pruned propagation of s particles: yhat is n×s, epsilon q×s,
+     constant m×1 and y m×s. */
+  void propagate(const double *yhat, const double *epsilon, const double *constant,
+                 double *y, int s, int num_threads) const;
+  /* Pruned propagation of s particles: yhat is n×s×order (the components of
+     the states, in deviation from the steady state), epsilon q×s, ys m×1.
+     The sum of ys and of the updated components is stored in y (m×s), the
+     updated components in ycomp (m×s×order). */
+  void propagatePruned(const double *yhat, const double *epsilon, const double *ys,
+                       double *y, double *ycomp, int s, int num_threads) const;
+private:
+  const int m, n, q, nz;
+  /* Monomials of order d are indexed by d-2 in parent and last: the column of
+     the parent monomial of order d-1 and the index of the last variable. */
+  std::vector<std::vector<int> > parent, last;
+  // The g_d (resp. gs_d) with columns multiplied by the multiplicities, empty if zero
+  std::vector<std::vector<double> > gm, gsm;
+  /* Number of particles in a block, such that the monomials of a block
+     roughly fit in the cache */
+  int blockSize(int ncomp) const;
+  void scaleByMultiplicity(const double *g, int d, const std::vector<double> &mult,
+                           std::vector<double> &res) const;
+  void propagateBlock(const double *yhat, const double *epsilon, int s, int first, int nb,
+                      int ncomp, std::vector<std::vector<double> > &mono, std::vector<double> &res) const;
+};
+
+#endif
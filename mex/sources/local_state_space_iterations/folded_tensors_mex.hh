@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FOLDED_TENSORS_MEX_HH
+#define _FOLDED_TENSORS_MEX_HH
+
+#include <vector>
+#include <dynmex.h>
+
+#include "folded_propagation.hh"
+
+/* Reads a cell array of folded tensors with m rows, the d-th element (0-based) being of order
+   d+offset. Empty elements stand for zero tensors. Returns false if a dimension is wrong. */
+inline bool
+get_folded_tensors(const mxArray *cell, size_t m, int nz, int offset, std::vector<const double *> &res)
+{
+  if (!mxIsCell(cell))
+    return false;
+  size_t k = mxGetNumberOfElements(cell);
+  res.resize(k);
+  for (size_t d = 0; d < k; d++)
+    {
+      const mxArray *g = mxGetCell(cell, d);
+      if (g == NULL || mxIsEmpty(g))
+        {
+          res[d] = NULL;
+          continue;
+        }
+      if (!mxIsDouble(g) || mxIsComplex(g) || mxIsSparse(g)
+          || mxGetM(g) != m || mxGetN(g) != (size_t) FoldedPropagation::nmono(nz, d+offset))
+        return false;
+      res[d] = mxGetPr(g);
+    }
+  return true;
+}
+
+#endif
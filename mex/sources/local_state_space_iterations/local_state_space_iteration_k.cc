@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This mex file computes particles at time t+1 given particles and innovations at time t,
+ * using an approximation of arbitrary order of the nonlinear state space model, with or
+ * without pruning. The decision rule is given by folded tensors (see folded_propagation.hh).
+ */
+
+#include <vector>
+#include <dynmex.h>
+
+#include "folded_tensors_mex.hh"
+
+using namespace std;
+
+void
+mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  /*
+  ** prhs[0] yhat          [double]  n*s array, time t particles (n*s*k array of the k components of the particles in the pruning mode).
+  ** prhs[1] epsilon       [double]  q*s array, time t innovations.
+  ** prhs[2] constant      [double]  m*1 array, deterministic steady state + constant of the decision rule (deterministic steady state in the pruning mode).
+  ** prhs[3] g             [cell]    1*k cell, g{d} is the m*C(n+q+d-1,d) folded tensor of order d of the decision rule.
+  ** prhs[4] gs            [cell]    [OPTIONAL] cell of length lower than k, gs{d+1} is the m*C(n+q+d-1,d) folded tensor of the terms in sigma^2 z^d (pruning mode).
+  ** prhs[5] numthreads    [integer] number of threads.
+  **
+  ** plhs[0] y             [double]  m*s array, time t+1 particles.
+  ** plhs[1] y_            [double]  m*s*k array, time t+1 components of the particles (pruning mode).
+  **
+  */
+
+  // Check the number of input and output.
+  if ((nrhs != 5) && (nrhs != 6))
+    {
+      mexErrMsgTxt("Five or six input arguments are required.");
+    }
+  if ((nrhs == 5 && nlhs > 1) || (nrhs == 6 && nlhs != 2))
+    {
+      mexErrMsgTxt("Numbers of input and output arguments are inconsistent.");
+    }
+  const bool pruning = (nrhs == 6);
+  // Get dimensions.
+  size_t n = mxGetM(prhs[0]);// Number of states.
+  size_t q = mxGetM(prhs[1]);// Number of innovations.
+  size_t s = mxGetN(prhs[1]);// Number of particles.
+  size_t m = mxGetM(prhs[2]);// Number of elements in the union of states and observed variables.
+  int nz = (int) (n+q);
+  // Get the decision rule.
+  vector<const double *> g, gs;
+  if (!get_folded_tensors(prhs[3], m, nz, 1, g) || g.size() == 0)
+    {
+      mexErrMsgTxt("Input dimension mismatch (decision rule)!.");
+    }
+  size_t k = g.size();
+  if (pruning && (!get_folded_tensors(prhs[4], m, nz, 0, gs) || gs.size() >= k))
+    {
+      mexErrMsgTxt("Input dimension mismatch (sigma terms of the decision rule)!.");
+    }
+  // Check the dimensions.
+  size_t ncomp = pruning ? k : 1;
+  if (
+      (mxGetNumberOfElements(prhs[0]) != n*s*ncomp) || // Number of particles and components of yhat
+      (mxGetNumberOfDimensions(prhs[0]) > 3)        ||
+      (mxGetN(prhs[2]) != 1)                           // Number of columns for the constant
+      )
+    {
+      mexErrMsgTxt("Input dimension mismatch!.");
+    }
+  // Get Input arrays.
+  double *yhat = mxGetPr(prhs[0]);
+  double *epsilon = mxGetPr(prhs[1]);
+  double *constant = mxGetPr(prhs[2]);
+  int numthreads = (int) mxGetScalar(prhs[nrhs-1]);
+  if (numthreads < 1)
+    {
+      mexErrMsgTxt("The number of threads must be a positive integer.");
+    }
+
+  FoldedPropagation rule((int) m, (int) n, (int) q, g, gs);
+  plhs[0] = mxCreateDoubleMatrix(m, s, mxREAL);
+  double *y = mxGetPr(plhs[0]);
+  if (!pruning)
+    rule.propagate(yhat, epsilon, constant, y, (int) s, numthreads);
+  else
+    {
+      mwSize dims[3] = { m, s, k };
+      plhs[1] = mxCreateNumericArray(3, dims, mxDOUBLE_CLASS, mxREAL);
+      double *y_ = mxGetPr(plhs[1]);
+      rule.propagatePruned(yhat, epsilon, constant, y, y_, (int) s, numthreads);
+    }
+}
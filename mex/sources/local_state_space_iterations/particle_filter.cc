@@ -0,0 +1,299 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <dynlapack.h>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+#include "particle_filter.hh"
+
+using namespace std;
+
+ParticleFilter::ParticleFilter(const FoldedPropagation &rule_arg, bool pruning_arg,
+                               const double *ys_arg, const double *constant_arg,
+                               const vector<int> &istates_arg, const vector<int> &mf_arg,
+                               const double *particles_arg, int s_arg, ResamplingMethod method_arg,
+                               double threshold_arg, int num_threads_arg)
+  : rule(rule_arg), pruning(pruning_arg), m(rule_arg.nrows()), n(rule_arg.nstates()),
+    p((int) mf_arg.size()), s(s_arg), ncomp(pruning_arg ? rule_arg.order() : 1),
+    ys(ys_arg, ys_arg+rule_arg.nrows()),
+    constant(constant_arg, constant_arg+(pruning_arg ? 0 : rule_arg.nrows())),
+    istates(istates_arg), mf(mf_arg), method(method_arg), threshold(threshold_arg),
+    num_threads(num_threads_arg), logdens_const(0.0),
+    particles(particles_arg, particles_arg+(size_t) n*s*ncomp), weights(s, 1.0/s),
+    y((size_t) m*s), ycomp(pruning_arg ? (size_t) m*s*ncomp : 0), logw(s), cumw(s),
+    resampled_particles((size_t) n*s*ncomp), indices(s)
+{
+}
+
+bool
+ParticleFilter::setMeasurementErrors(const double *H)
+{
+  cholH.assign(H, H+p*p);
+  if (p > 0)
+    {
+      lapack_int pp = p, info;
+      dpotrf("L", &pp, &cholH[0], &pp, &info);
+      if (info != 0)
+        return false;
+    }
+  double logdet = 0.0;
+  for (int i = 0; i < p; i++)
+    logdet += 2.0*log(cholH[i*p+i]);
+  logdens_const = -0.5*(p*1.837877066409345483560659+logdet); // log(2*pi)
+  return true;
+}
+
+/* Cumulative sum of w: the sums of the chunks are computed in parallel and
+   accumulated serially, then each chunk is completed in parallel. */
+void
+ParticleFilter::cumulativeSum(const vector<double> &w, vector<double> &c) const
+{
+  const int nchunks = numChunks();
+  vector<double> offsets(nchunks+1, 0.0);
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int ch = 0; ch < nchunks; ch++)
+    {
+      double sum = 0.0;
+      for (int j = ch*chunk; j < min(s, (ch+1)*chunk); j++)
+        sum += w[j];
+      offsets[ch+1] = sum;
+    }
+  for (int ch = 0; ch < nchunks; ch++)
+    offsets[ch+1] += offsets[ch];
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int ch = 0; ch < nchunks; ch++)
+    {
+      double sum = offsets[ch];
+      for (int j = ch*chunk; j < min(s, (ch+1)*chunk); j++)
+        {
+          sum += w[j];
+          c[j] = sum;
+        }
+    }
+}
+
+/* Draws num particles with probabilities proportional to the increments of
+   the cumulative weights c, at the sorted positions (i+u)/num (u[0] for all
+   i if not stratify, u[i] otherwise) of the total weight. The indices are
+   stored in indices[offset..offset+num-1]. */
+void
+ParticleFilter::resampleSorted(const vector<double> &c, const double *u, bool stratify,
+                               int num, int offset)
+{
+  const double total = c[s-1];
+  const int nchunks = (num+chunk-1)/chunk;
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int ch = 0; ch < nchunks; ch++)
+    {
+      const int first = ch*chunk;
+      const int last = min(num, (ch+1)*chunk);
+      double x = (first+(stratify ? u[first] : u[0]))*total/num;
+      int j = (int) (upper_bound(c.begin(), c.end(), x)-c.begin());
+      for (int i = first; i < last; i++)
+        {
+          x = (i+(stratify ? u[i] : u[0]))*total/num;
+          while (j < s-1 && c[j] <= x)
+            j++;
+          indices[offset+i] = min(j, s-1);
+        }
+    }
+}
+
+void
+ParticleFilter::resample(const double *u)
+{
+  switch (method)
+    {
+    case systematic:
+    case stratified:
+      cumulativeSum(weights, cumw);
+      resampleSorted(cumw, u, method == stratified, s, 0);
+      break;
+    case residual:
+      {
+        /* Each particle is first copied floor(s*w) times, the remaining
+           particles are drawn by systematic resampling with the residual
+           weights (stored in logw) */
+        const int nchunks = numChunks();
+        vector<int> offsets(nchunks+1, 0);
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(num_threads)
+#endif
+        for (int ch = 0; ch < nchunks; ch++)
+          {
+            int count = 0;
+            for (int j = ch*chunk; j < min(s, (ch+1)*chunk); j++)
+              {
+                double sw = s*weights[j];
+                double k = floor(sw);
+                logw[j] = sw-k;
+                count += (int) k;
+              }
+            offsets[ch+1] = count;
+          }
+        for (int ch = 0; ch < nchunks; ch++)
+          offsets[ch+1] += offsets[ch];
+        const int ncopies = min(offsets[nchunks], s);
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(num_threads)
+#endif
+        for (int ch = 0; ch < nchunks; ch++)
+          {
+            int i = offsets[ch];
+            for (int j = ch*chunk; j < min(s, (ch+1)*chunk); j++)
+              for (int k = (int) floor(s*weights[j]); k > 0 && i < ncopies; k--)
+                indices[i++] = j;
+          }
+        if (ncopies < s)
+          {
+            cumulativeSum(logw, cumw);
+            resampleSorted(cumw, u, false, s-ncopies, ncopies);
+          }
+      }
+      break;
+    }
+
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int i = 0; i < s; i++)
+    for (int c = 0; c < ncomp; c++)
+      memcpy(&resampled_particles[((size_t) s*c+i)*n], &particles[((size_t) s*c+indices[i])*n],
+             n*sizeof(double));
+  particles.swap(resampled_particles);
+  fill(weights.begin(), weights.end(), 1.0/s);
+}
+
+double
+ParticleFilter::step(const double *epsilon, const double *yobs, const double *u,
+                     double &ess, bool &resampled)
+{
+  const double minus_inf = -numeric_limits<double>::infinity();
+  resampled = false;
+
+  // Propagation
+  if (pruning)
+    rule.propagatePruned(&particles[0], epsilon, &ys[0], &y[0], &ycomp[0], s, num_threads);
+  else
+    rule.propagate(&particles[0], epsilon, &constant[0], &y[0], s, num_threads);
+
+  // New states and log weights
+  const int nchunks = numChunks();
+  vector<double> chunk_res(nchunks);
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int ch = 0; ch < nchunks; ch++)
+    {
+      vector<double> e(p);
+      double mx = minus_inf;
+      for (int j = ch*chunk; j < min(s, (ch+1)*chunk); j++)
+        {
+          if (pruning)
+            for (int c = 0; c < ncomp; c++)
+              for (int i = 0; i < n; i++)
+                particles[((size_t) s*c+j)*n+i] = ycomp[((size_t) s*c+j)*m+istates[i]];
+          else
+            for (int i = 0; i < n; i++)
+              particles[(size_t) j*n+i] = y[(size_t) j*m+istates[i]]-ys[istates[i]];
+
+          // Forward substitution with the Cholesky factor of H
+          double quad = 0.0;
+          for (int i = 0; i < p; i++)
+            {
+              double v = yobs[i]-y[(size_t) j*m+mf[i]];
+              for (int k = 0; k < i; k++)
+                v -= cholH[k*p+i]*e[k];
+              e[i] = v/cholH[i*p+i];
+              quad += e[i]*e[i];
+            }
+          double lw = log(weights[j])+logdens_const-0.5*quad;
+          if (lw != lw)
+            lw = minus_inf;
+          logw[j] = lw;
+          mx = max(mx, lw);
+        }
+      chunk_res[ch] = mx;
+    }
+  double mx = minus_inf;
+  for (int ch = 0; ch < nchunks; ch++)
+    mx = max(mx, chunk_res[ch]);
+  if (mx == minus_inf)
+    {
+      ess = 0.0;
+      return minus_inf;
+    }
+
+  // Log-sum-exp normalization of the weights
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int ch = 0; ch < nchunks; ch++)
+    {
+      double sum = 0.0;
+      for (int j = ch*chunk; j < min(s, (ch+1)*chunk); j++)
+        {
+          weights[j] = exp(logw[j]-mx);
+          sum += weights[j];
+        }
+      chunk_res[ch] = sum;
+    }
+  double sum = 0.0;
+  for (int ch = 0; ch < nchunks; ch++)
+    sum += chunk_res[ch];
+#ifdef USE_OMP
+# pragma omp parallel for num_threads(num_threads)
+#endif
+  for (int ch = 0; ch < nchunks; ch++)
+    {
+      double sum2 = 0.0;
+      for (int j = ch*chunk; j < min(s, (ch+1)*chunk); j++)
+        {
+          weights[j] /= sum;
+          sum2 += weights[j]*weights[j];
+        }
+      chunk_res[ch] = sum2;
+    }
+  double sum2 = 0.0;
+  for (int ch = 0; ch < nchunks; ch++)
+    sum2 += chunk_res[ch];
+  ess = 1.0/sum2;
+
+  if (ess < threshold*s)
+    {
+      resample(u);
+      resampled = true;
+    }
+
+  return mx+log(sum);
+}
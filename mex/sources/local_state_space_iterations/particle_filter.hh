@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PARTICLE_FILTER_HH
+#define _PARTICLE_FILTER_HH
+
+#include <vector>
+
+#include "folded_propagation.hh"
+
+/*
+ * One step of a bootstrap particle filter over a persistent swarm of
+ * particles: propagation through the decision rule (FoldedPropagation),
+ * evaluation of the Gaussian density of the measurement errors, update and
+ * normalization of the weights (log-sum-exp), and resampling when the
+ * effective sample size falls below a threshold.
+ *
+ * All the reductions (sums, cumulative sums of the weights) are computed over
+ * chunks of fixed size, and the chunk results are combined serially, so the
+ * results do not depend on the number of threads. The resampling is
+ * parallelized over the chunks of the resampled particles: each chunk finds
+ * its first source particle by bisection in the cumulative weights and then
+ * walks forward.
+ */
+class ParticleFilter
+{
+public:
+  enum ResamplingMethod { systematic, stratified, residual };
+
+  /* rule is the decision rule for the m variables whose rows are given by
+     the 0-based indices istates (the n states) and mf (the p observed
+     variables). ys is the deterministic steady state, constant the constant
+     term of the non-pruned rule (unused with pruning). particles is n×s
+     (n×s×order with pruning), in deviation from the steady state. */
+  ParticleFilter(const FoldedPropagation &rule, bool pruning, const double *ys, const double *constant,
+                 const std::vector<int> &istates, const std::vector<int> &mf,
+                 const double *particles, int s, ResamplingMethod method, double threshold,
+                 int num_threads);
+  /* Sets the covariance matrix (p×p) of the measurement errors. Returns false
+     if it is not positive definite. */
+  bool setMeasurementErrors(const double *H);
+  /* Performs one step of the filter given the innovations epsilon (q×s),
+     the observations yobs (p×1) and the uniform draws u of the resampling
+     (one draw for the systematic and residual resampling, s draws for the
+     stratified resampling). Returns the log-likelihood of yobs, stores the
+     effective sample size after the update of the weights in ess, and sets
+     resampled if the particles were resampled. If the likelihood is zero
+     for all the particles, returns -Inf: the weights are left unchanged, but
+     the particles have already been replaced by the propagated states. */
+  double step(const double *epsilon, const double *yobs, const double *u,
+              double &ess, bool &resampled);
+
+  int
+  numParticles() const
+  {
+    return s;
+  }
+  int
+  numComponents() const
+  {
+    return ncomp;
+  }
+  int
+  numStates() const
+  {
+    return n;
+  }
+  int
+  numObserved() const
+  {
+    return p;
+  }
+  bool
+  needsStratifiedDraws() const
+  {
+    return method == stratified;
+  }
+  const std::vector<double> &
+  getParticles() const
+  {
+    return particles;
+  }
+  const std::vector<double> &
+  getWeights() const
+  {
+    return weights;
+  }
+private:
+  const FoldedPropagation &rule;
+  const bool pruning;
+  const int m, n, p, s, ncomp;
+  const std::vector<double> ys, constant;
+  const std::vector<int> istates, mf;
+  const ResamplingMethod method;
+  const double threshold;
+  const int num_threads;
+  // Cholesky factor of the covariance of the measurement errors and constant of the log density
+  std::vector<double> cholH;
+  double logdens_const;
+  // The swarm (n×s×ncomp) and the normalized weights
+  std::vector<double> particles, weights;
+  // Work buffers: the propagated variables, the log weights, the resampling indices
+  std::vector<double> y, ycomp, logw, cumw, resampled_particles;
+  std::vector<int> indices;
+
+  static const int chunk = 4096;
+  int
+  numChunks() const
+  {
+    return (s+chunk-1)/chunk;
+  }
+  void cumulativeSum(const std::vector<double> &w, std::vector<double> &c) const;
+  void resampleSorted(const std::vector<double> &c, const double *u, bool stratify,
+                      int num, int offset);
+  void resample(const double *u);
+};
+
+#endif
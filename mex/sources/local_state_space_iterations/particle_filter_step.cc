@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2015 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This mex file performs the steps of a bootstrap particle filter (propagation, weights,
+ * resampling) over a swarm of particles kept between the calls. See
+ * matlab/particle_filter_step.m for the interface.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+#include <dynmex.h>
+
+#include "folded_tensors_mex.hh"
+#include "particle_filter.hh"
+
+using namespace std;
+
+// Converts a vector of 1-based indices lower than m to 0-based indices
+static bool
+get_indices(const mxArray *arr, size_t m, vector<int> &res)
+{
+  if (!mxIsDouble(arr))
+    return false;
+  size_t k = mxGetNumberOfElements(arr);
+  const double *v = mxGetPr(arr);
+  res.resize(k);
+  for (size_t i = 0; i < k; i++)
+    {
+      if (v[i] < 1 || v[i] > m || v[i] != (int) v[i])
+        return false;
+      res[i] = (int) v[i] - 1;
+    }
+  return true;
+}
+
+class ParticleFilterContext
+{
+public:
+  FoldedPropagation *rule;
+  ParticleFilter *filter;
+  ParticleFilterContext(FoldedPropagation *r) : rule(r), filter(NULL)
+  {
+  }
+  ~ParticleFilterContext()
+  {
+    delete filter;
+    delete rule;
+  }
+};
+
+// The filters opened with particle_filter_step('open', ...), indexed by their handle
+static map<int, ParticleFilterContext *> contexts;
+static int last_handle = 0;
+
+static void
+close_contexts()
+{
+  for (map<int, ParticleFilterContext *>::iterator it = contexts.begin(); it != contexts.end(); ++it)
+    delete it->second;
+  contexts.clear();
+}
+
+static ParticleFilterContext *
+get_context(const mxArray *handle)
+{
+  if (!mxIsNumeric(handle) || mxGetNumberOfElements(handle) != 1)
+    return NULL;
+  map<int, ParticleFilterContext *>::iterator it = contexts.find((int) mxGetScalar(handle));
+  if (it == contexts.end())
+    return NULL;
+  return it->second;
+}
+
+static void
+open_filter(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  /*
+  ** prhs[1] constant      [double]  m*1 array, deterministic steady state + constant of the decision rule (unused with pruning).
+  ** prhs[2] g             [cell]    1*k cell, folded tensors of the decision rule (see local_state_space_iteration_k).
+  ** prhs[3] gs            [cell]    folded tensors of the terms in sigma^2 with pruning, [] (not a cell) without pruning.
+  ** prhs[4] ys            [double]  m*1 array, deterministic steady state.
+  ** prhs[5] istates       [double]  n*1 array, indices of the states in the m rows.
+  ** prhs[6] mf            [double]  p*1 array, indices of the observed variables in the m rows.
+  ** prhs[7] H             [double]  p*p array, covariance matrix of the measurement errors.
+  ** prhs[8] particles     [double]  n*s array, initial particles (n*s*k array of their k components with pruning).
+  ** prhs[9] options       [struct]  [OPTIONAL] fields resampling ('systematic', 'stratified' or 'residual'),
+  **                                 threshold (resampling if ESS<threshold*s) and threads.
+  **
+  ** plhs[0] h             [double]  handle of the filter.
+  */
+  if (nrhs != 9 && nrhs != 10)
+    mexErrMsgTxt("particle_filter_step: 'open' requires eight or nine arguments.");
+  if (nlhs > 1)
+    mexErrMsgTxt("particle_filter_step: 'open' returns one output argument.");
+
+  const size_t m = mxGetM(prhs[4]);
+  const size_t n = mxGetNumberOfElements(prhs[5]);
+  const size_t p = mxGetNumberOfElements(prhs[6]);
+  const bool pruning = mxIsCell(prhs[3]);
+  vector<int> istates, mf;
+  if (!get_indices(prhs[5], m, istates) || !get_indices(prhs[6], m, mf))
+    mexErrMsgTxt("particle_filter_step: wrong indices of the states or observed variables.");
+  if (mxGetM(prhs[0]) != m || mxGetN(prhs[0]) != 1 || mxGetN(prhs[4]) != 1)
+    mexErrMsgTxt("particle_filter_step: input dimension mismatch (steady state)!.");
+  if (!mxIsCell(prhs[2]) || mxGetNumberOfElements(prhs[2]) == 0)
+    mexErrMsgTxt("particle_filter_step: the decision rule must be a non empty cell array.");
+  const mxArray *g1 = mxGetCell(prhs[2], 0);
+  if (g1 == NULL || mxGetN(g1) < n)
+    mexErrMsgTxt("particle_filter_step: input dimension mismatch (decision rule)!.");
+  const size_t q = mxGetN(g1)-n;
+  vector<const double *> g, gs;
+  if (!get_folded_tensors(prhs[2], m, (int) (n+q), 1, g))
+    mexErrMsgTxt("particle_filter_step: input dimension mismatch (decision rule)!.");
+  const size_t k = g.size();
+  if (pruning && (!get_folded_tensors(prhs[3], m, (int) (n+q), 0, gs) || gs.size() >= k))
+    mexErrMsgTxt("particle_filter_step: input dimension mismatch (sigma terms of the decision rule)!.");
+  if (mxGetM(prhs[7]) != p || mxGetN(prhs[7]) != p)
+    mexErrMsgTxt("particle_filter_step: input dimension mismatch (measurement errors)!.");
+  const size_t s = mxGetNumberOfDimensions(prhs[8]) > 1 ? mxGetDimensions(prhs[8])[1] : 1;
+  if (mxGetM(prhs[8]) != n || s == 0 || mxGetNumberOfElements(prhs[8]) != n*s*(pruning ? k : 1))
+    mexErrMsgTxt("particle_filter_step: input dimension mismatch (particles)!.");
+
+  ParticleFilter::ResamplingMethod method = ParticleFilter::systematic;
+  double threshold = 0.5;
+  int num_threads = 1;
+  if (nrhs == 10)
+    {
+      if (!mxIsStruct(prhs[9]))
+        mexErrMsgTxt("particle_filter_step: the options must be a structure.");
+      const mxArray *field = mxGetField(prhs[9], 0, "resampling");
+      if (field != NULL)
+        {
+          char *str = mxArrayToString(field);
+          string name = str == NULL ? "" : str;
+          mxFree(str);
+          if (name == "systematic")
+            method = ParticleFilter::systematic;
+          else if (name == "stratified")
+            method = ParticleFilter::stratified;
+          else if (name == "residual")
+            method = ParticleFilter::residual;
+          else
+            mexErrMsgTxt("particle_filter_step: unknown resampling method.");
+        }
+      field = mxGetField(prhs[9], 0, "threshold");
+      if (field != NULL)
+        threshold = mxGetScalar(field);
+      field = mxGetField(prhs[9], 0, "threads");
+      if (field != NULL)
+        num_threads = (int) mxGetScalar(field);
+      if (num_threads < 1)
+        mexErrMsgTxt("particle_filter_step: the number of threads must be a positive integer.");
+    }
+
+  ParticleFilterContext *context = new ParticleFilterContext(new FoldedPropagation((int) m, (int) n, (int) q, g, gs));
+  context->filter = new ParticleFilter(*context->rule, pruning, mxGetPr(prhs[4]), mxGetPr(prhs[0]),
+                                       istates, mf, mxGetPr(prhs[8]), (int) s, method, threshold,
+                                       num_threads);
+  if (!context->filter->setMeasurementErrors(mxGetPr(prhs[7])))
+    {
+      delete context;
+      mexErrMsgTxt("particle_filter_step: the covariance matrix of the measurement errors is not positive definite.");
+    }
+  contexts[++last_handle] = context;
+  mexAtExit(close_contexts);
+  plhs[0] = mxCreateDoubleScalar(last_handle);
+}
+
+void
+mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  if (nrhs < 1)
+    mexErrMsgTxt("particle_filter_step: at least one input argument is required.");
+
+  if (mxIsChar(prhs[0]))
+    {
+      char *str = mxArrayToString(prhs[0]);
+      string command = str;
+      mxFree(str);
+      if (command == "open")
+        open_filter(nlhs, plhs, nrhs, prhs);
+      else if (command == "close")
+        {
+          ParticleFilterContext *context = nrhs == 2 ? get_context(prhs[1]) : NULL;
+          if (context == NULL)
+            mexErrMsgTxt("particle_filter_step: 'close' requires a valid handle.");
+          contexts.erase((int) mxGetScalar(prhs[1]));
+          delete context;
+        }
+      else if (command == "get")
+        {
+          /*
+          ** plhs[0] particles     [double]  n*s array (n*s*k array with pruning), current particles.
+          ** plhs[1] weights       [double]  1*s array, current normalized weights.
+          */
+          ParticleFilterContext *context = nrhs == 2 ? get_context(prhs[1]) : NULL;
+          if (context == NULL)
+            mexErrMsgTxt("particle_filter_step: 'get' requires a valid handle.");
+          const ParticleFilter &filter = *context->filter;
+          mwSize dims[3] = { (mwSize) filter.numStates(), (mwSize) filter.numParticles(),
+                             (mwSize) filter.numComponents() };
+          plhs[0] = mxCreateNumericArray(filter.numComponents() > 1 ? 3 : 2, dims, mxDOUBLE_CLASS, mxREAL);
+          copy(filter.getParticles().begin(), filter.getParticles().end(), mxGetPr(plhs[0]));
+          if (nlhs > 1)
+            {
+              plhs[1] = mxCreateDoubleMatrix(1, filter.numParticles(), mxREAL);
+              copy(filter.getWeights().begin(), filter.getWeights().end(), mxGetPr(plhs[1]));
+            }
+        }
+      else
+        mexErrMsgTxt("particle_filter_step: unknown command.");
+      return;
+    }
+
+  /*
+  ** prhs[0] h             [double]  handle of the filter.
+  ** prhs[1] epsilon       [double]  q*s array, innovations.
+  ** prhs[2] yobs          [double]  p*1 array, observations.
+  ** prhs[3] u             [double]  uniform draws for the resampling (s draws for the stratified resampling, one otherwise).
+  **
+  ** plhs[0] lik           [double]  log-likelihood of the observations.
+  ** plhs[1] ess           [double]  effective sample size before resampling.
+  ** plhs[2] resampled     [logical] true if the particles were resampled.
+  */
+  ParticleFilterContext *context = get_context(prhs[0]);
+  if (context == NULL)
+    mexErrMsgTxt("particle_filter_step: invalid handle.");
+  if (nrhs != 4 || nlhs > 3)
+    mexErrMsgTxt("particle_filter_step: a step requires four input arguments and returns at most three output arguments.");
+  ParticleFilter &filter = *context->filter;
+  const FoldedPropagation &rule = *context->rule;
+  const size_t s = filter.numParticles();
+  if (mxGetM(prhs[1]) != (size_t) rule.nshocks() || mxGetN(prhs[1]) != s)
+    mexErrMsgTxt("particle_filter_step: input dimension mismatch (innovations)!.");
+  if (mxGetNumberOfElements(prhs[2]) != (size_t) filter.numObserved())
+    mexErrMsgTxt("particle_filter_step: input dimension mismatch (observations)!.");
+  const size_t nu = mxGetNumberOfElements(prhs[3]);
+  if (nu != 1 && nu != s)
+    mexErrMsgTxt("particle_filter_step: input dimension mismatch (uniform draws)!.");
+  if (filter.needsStratifiedDraws() && nu != s)
+    mexErrMsgTxt("particle_filter_step: the stratified resampling requires one uniform draw per particle.");
+
+  double ess;
+  bool resampled;
+  double lik = filter.step(mxGetPr(prhs[1]), mxGetPr(prhs[2]), mxGetPr(prhs[3]), ess, resampled);
+  plhs[0] = mxCreateDoubleScalar(lik);
+  if (nlhs > 1)
+    plhs[1] = mxCreateDoubleScalar(ess);
+  if (nlhs > 2)
+    plhs[2] = mxCreateLogicalScalar(resampled);
+}
@@ -262,7 +262,8 @@ enum NodeTreeReference
     eJacobianParamsDeriv = 5,
     eResidualsParamsSecondDeriv = 6,
     eJacobianParamsSecondDeriv = 7,
-    eHessianParamsDeriv = 8
+    eHessianParamsDeriv = 8,
+    eHigherDeriv = 9
   };
 
 struct Block_contain_type
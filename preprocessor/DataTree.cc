@@ -550,6 +550,50 @@ DataTree::AddSecondDerivExternalFunction(int top_level_symb_id, const vector<exp
   return new SecondDerivExternalFunctionNode(*this, top_level_symb_id, arguments, input_index1, input_index2);
 }
 
+expr_t
+DataTree::AddCopy(expr_t expr, map<expr_t, expr_t> &copied)
+{
+  map<expr_t, expr_t>::const_iterator it = copied.find(expr);
+  if (it != copied.end())
+    return it->second;
+
+  // The arguments are copied one after the other, so that the order of creation of the nodes is well defined
+  expr_t copy;
+  UnaryOpNode *uexpr = dynamic_cast<UnaryOpNode *>(expr);
+  BinaryOpNode *bexpr = dynamic_cast<BinaryOpNode *>(expr);
+  TrinaryOpNode *texpr = dynamic_cast<TrinaryOpNode *>(expr);
+  AbstractExternalFunctionNode *fexpr = dynamic_cast<AbstractExternalFunctionNode *>(expr);
+  if (uexpr != NULL)
+    copy = uexpr->buildSimilarUnaryOpNode(AddCopy(uexpr->get_arg(), copied), *this);
+  else if (bexpr != NULL)
+    {
+      expr_t arg1 = AddCopy(bexpr->get_arg1(), copied);
+      expr_t arg2 = AddCopy(bexpr->get_arg2(), copied);
+      copy = bexpr->buildSimilarBinaryOpNode(arg1, arg2, *this);
+    }
+  else if (texpr != NULL)
+    {
+      expr_t arg1 = AddCopy(texpr->get_arg1(), copied);
+      expr_t arg2 = AddCopy(texpr->get_arg2(), copied);
+      expr_t arg3 = AddCopy(texpr->get_arg3(), copied);
+      copy = texpr->buildSimilarTrinaryOpNode(arg1, arg2, arg3, *this);
+    }
+  else if (fexpr != NULL)
+    {
+      vector<expr_t> arguments;
+      for (vector<expr_t>::const_iterator it2 = fexpr->get_arguments().begin();
+           it2 != fexpr->get_arguments().end(); it2++)
+        arguments.push_back(AddCopy(*it2, copied));
+      copy = fexpr->buildSimilarExternalFunctionNode(arguments, *this);
+    }
+  else
+    // Constants and variables have no argument
+    copy = expr->cloneDynamic(*this);
+
+  copied[expr] = copy;
+  return copy;
+}
+
 bool
 DataTree::isSymbolUsed(int symb_id) const
 {
@@ -34,6 +34,9 @@ using namespace std;
 #include "ExternalFunctionsTable.hh"
 #include "ExprNode.hh"
 
+#include <boost/unordered_map.hpp>
+#include <boost/functional/hash.hpp>
+
 #define CONSTANTS_PRECISION 16
 
 class DataTree
@@ -48,6 +51,7 @@ class DataTree
   friend class ExternalFunctionNode;
   friend class FirstDerivExternalFunctionNode;
   friend class SecondDerivExternalFunctionNode;
+  friend class DerivativesCache;
 protected:
   //! A reference to the symbol table
   SymbolTable &symbol_table;
@@ -62,12 +66,57 @@ protected:
   typedef map<pair<int, int>, VariableNode *> variable_node_map_t;
   variable_node_map_t variable_node_map;
   //! Pair( Pair(arg1, UnaryOpCode), Pair( Expectation Info Set, Pair(param1_symb_id, param2_symb_id)) ))
-  typedef map<pair<pair<expr_t, UnaryOpcode>, pair<int, pair<int, int> > >, UnaryOpNode *> unary_op_node_map_t;
+  typedef pair<pair<expr_t, UnaryOpcode>, pair<int, pair<int, int> > > unary_op_node_key_t;
+  //! Hash function for unary operator nodes
+  /*! Combines the hashes of the argument nodes (see ExprNodeHash) with the other fields of the key */
+  struct UnaryOpNodeHash
+  {
+    size_t
+    operator()(const unary_op_node_key_t &key) const
+    {
+      size_t seed = ExprNodeHash()(key.first.first);
+      boost::hash_combine(seed, (int) key.first.second);
+      boost::hash_combine(seed, key.second.first);
+      boost::hash_combine(seed, key.second.second.first);
+      boost::hash_combine(seed, key.second.second.second);
+      return seed;
+    }
+  };
+  typedef boost::unordered_map<unary_op_node_key_t, UnaryOpNode *, UnaryOpNodeHash> unary_op_node_map_t;
   unary_op_node_map_t unary_op_node_map;
   //! Pair( Pair( Pair(arg1, arg2), order of Power Derivative), opCode)
-  typedef map<pair<pair<pair<expr_t, expr_t>, int>, BinaryOpcode>, BinaryOpNode *> binary_op_node_map_t;
+  typedef pair<pair<pair<expr_t, expr_t>, int>, BinaryOpcode> binary_op_node_key_t;
+  //! Hash function for binary operator nodes
+  struct BinaryOpNodeHash
+  {
+    size_t
+    operator()(const binary_op_node_key_t &key) const
+    {
+      size_t seed = ExprNodeHash()(key.first.first.first);
+      boost::hash_combine(seed, ExprNodeHash()(key.first.first.second));
+      boost::hash_combine(seed, key.first.second);
+      boost::hash_combine(seed, (int) key.second);
+      return seed;
+    }
+  };
+  typedef boost::unordered_map<binary_op_node_key_t, BinaryOpNode *, BinaryOpNodeHash> binary_op_node_map_t;
   binary_op_node_map_t binary_op_node_map;
-  typedef map<pair<pair<pair<expr_t, expr_t>, expr_t>, TrinaryOpcode>, TrinaryOpNode *> trinary_op_node_map_t;
+  //! Pair( Pair( Pair(arg1, arg2), arg3), opCode)
+  typedef pair<pair<pair<expr_t, expr_t>, expr_t>, TrinaryOpcode> trinary_op_node_key_t;
+  //! Hash function for trinary operator nodes
+  struct TrinaryOpNodeHash
+  {
+    size_t
+    operator()(const trinary_op_node_key_t &key) const
+    {
+      size_t seed = ExprNodeHash()(key.first.first.first);
+      boost::hash_combine(seed, ExprNodeHash()(key.first.first.second));
+      boost::hash_combine(seed, ExprNodeHash()(key.first.second));
+      boost::hash_combine(seed, (int) key.second);
+      return seed;
+    }
+  };
+  typedef boost::unordered_map<trinary_op_node_key_t, TrinaryOpNode *, TrinaryOpNodeHash> trinary_op_node_map_t;
   trinary_op_node_map_t trinary_op_node_map;
 
   // (arguments, symb_id) -> ExternalFunctionNode
@@ -218,6 +267,10 @@ public:
   expr_t AddFirstDerivExternalFunction(int top_level_symb_id, const vector<expr_t> &arguments, int input_index);
   //! Adds an external function node for the second derivative of an external function
   expr_t AddSecondDerivExternalFunction(int top_level_symb_id, const vector<expr_t> &arguments, int input_index1, int input_index2);
+  //! Adds a copy of an expression belonging to another data tree
+  /*! The copies of the nodes already copied are stored in the map, so that
+    the subexpressions shared by several expressions are copied only once */
+  expr_t AddCopy(expr_t expr, map<expr_t, expr_t> &copied);
   //! Checks if a given symbol is used somewhere in the data tree
   bool isSymbolUsed(int symb_id) const;
   //! Checks if a given unary op is used somewhere in the data tree
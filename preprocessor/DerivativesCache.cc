@@ -0,0 +1,455 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+
+#include "DerivativesCache.hh"
+
+// For mkdir()
+#ifdef _WIN32
+# include <direct.h>
+#else
+# include <sys/stat.h>
+# include <sys/types.h>
+#endif
+
+#ifndef PACKAGE_VERSION
+# define PACKAGE_VERSION 4.
+#endif
+
+//! First line of the cache files, which must be identical for a file to be read
+#define DERIVATIVES_CACHE_HEADER "Dynare derivatives cache, version " PACKAGE_VERSION
+
+DerivativesCache::DerivativesCache(DataTree &tree_arg) :
+  tree(tree_arg), rejected(false)
+{
+}
+
+bool
+DerivativesCache::writeNodes(expr_t expr, map<expr_t, int> &ids, vector<string> &code,
+                             set<int> &local_vars, set<pair<int, int> > &variables) const
+{
+  if (ids.find(expr) != ids.end())
+    return true;
+
+  ostringstream line;
+  if (NumConstNode *nc = dynamic_cast<NumConstNode *>(expr))
+    line << "N " << tree.num_constants.get(nc->get_id());
+  else if (VariableNode *v = dynamic_cast<VariableNode *>(expr))
+    {
+      int symb_id = v->get_symb_id();
+      SymbolType type = tree.symbol_table.getType(symb_id);
+      if (type == eModelLocalVariable)
+        local_vars.insert(symb_id);
+      else
+        variables.insert(make_pair(symb_id, v->get_lag()));
+      line << "V " << tree.symbol_table.getName(symb_id) << " " << (int) type << " " << v->get_lag();
+    }
+  else if (UnaryOpNode *u = dynamic_cast<UnaryOpNode *>(expr))
+    {
+      // These operators have additional fields, which are not stored
+      if (u->get_op_code() == oExpectation || u->get_op_code() == oSteadyStateParamDeriv
+          || u->get_op_code() == oSteadyStateParam2ndDeriv)
+        return false;
+      if (!writeNodes(u->get_arg(), ids, code, local_vars, variables))
+        return false;
+      line << "U " << (int) u->get_op_code() << " " << ids[u->get_arg()];
+    }
+  else if (BinaryOpNode *b = dynamic_cast<BinaryOpNode *>(expr))
+    {
+      if (!writeNodes(b->get_arg1(), ids, code, local_vars, variables)
+          || !writeNodes(b->get_arg2(), ids, code, local_vars, variables))
+        return false;
+      line << "B " << (int) b->get_op_code() << " " << b->get_power_deriv_order()
+           << " " << ids[b->get_arg1()] << " " << ids[b->get_arg2()];
+    }
+  else if (TrinaryOpNode *t = dynamic_cast<TrinaryOpNode *>(expr))
+    {
+      if (!writeNodes(t->get_arg1(), ids, code, local_vars, variables)
+          || !writeNodes(t->get_arg2(), ids, code, local_vars, variables)
+          || !writeNodes(t->get_arg3(), ids, code, local_vars, variables))
+        return false;
+      line << "T " << (int) t->get_op_code() << " " << ids[t->get_arg1()]
+           << " " << ids[t->get_arg2()] << " " << ids[t->get_arg3()];
+    }
+  else
+    // External functions
+    return false;
+
+  int id = ids.size();
+  ids[expr] = id;
+  code.push_back(line.str());
+  return true;
+}
+
+bool
+DerivativesCache::computeKey(expr_t equation, const set<int> &vars, string &key, vector<int> &eq_vars) const
+{
+  map<expr_t, int> ids;
+  vector<string> code;
+  set<int> local_vars, written_local_vars;
+  set<pair<int, int> > variables;
+  if (!writeNodes(equation, ids, code, local_vars, variables))
+    return false;
+
+  // Definitions of the model local variables, including those used by other definitions
+  while (local_vars.size() > written_local_vars.size())
+    {
+      int symb_id = -1;
+      for (set<int>::const_iterator it = local_vars.begin(); it != local_vars.end(); it++)
+        if (written_local_vars.find(*it) == written_local_vars.end())
+          {
+            symb_id = *it;
+            break;
+          }
+      written_local_vars.insert(symb_id);
+      map<int, expr_t>::const_iterator it = tree.local_variables_table.find(symb_id);
+      if (it == tree.local_variables_table.end()
+          || !writeNodes(it->second, ids, code, local_vars, variables))
+        return false;
+      ostringstream line;
+      line << "L " << tree.symbol_table.getName(symb_id) << " " << ids[it->second];
+      code.push_back(line.str());
+    }
+
+  ostringstream k;
+  for (vector<string>::const_iterator it = code.begin(); it != code.end(); it++)
+    k << *it << ";";
+
+  // Derivation variables
+  k << "|";
+  eq_vars.clear();
+  for (set<int>::const_iterator it = vars.begin(); it != vars.end(); it++)
+    {
+      int symb_id = tree.getSymbIDByDerivID(*it);
+      int lag = tree.getLagByDerivID(*it);
+      if (variables.find(make_pair(symb_id, lag)) != variables.end())
+        {
+          eq_vars.push_back(*it);
+          k << " " << tree.symbol_table.getName(symb_id) << " " << lag;
+        }
+    }
+
+  key = k.str();
+  return true;
+}
+
+bool
+DerivativesCache::contains(const string &key, int order) const
+{
+  map<string, Entry>::const_iterator it = entries.find(key);
+  return it != entries.end() && it->second.order >= order;
+}
+
+int
+DerivativesCache::size() const
+{
+  return entries.size();
+}
+
+bool
+DerivativesCache::readCode(const vector<string> &code, int order, const vector<int> &eq_vars, derivatives_t *derivs) const
+{
+  /* The indices and names are checked, since the file may have been modified
+     or truncated. When only checking (derivs is NULL), no node is created and
+     the nodes are NULL. */
+  vector<expr_t> nodes;
+  for (vector<string>::const_iterator it = code.begin(); it != code.end(); it++)
+    {
+      istringstream line(*it);
+      char kind = 0;
+      line >> kind;
+      expr_t node = NULL;
+      switch (kind)
+        {
+        case 'N':
+          {
+            string value;
+            line >> value;
+            char *end;
+            if (!line || value[0] == '-' || (strtod(value.c_str(), &end), *end != '\0'))
+              return false;
+            if (derivs != NULL)
+              node = tree.AddNonNegativeConstant(value);
+          }
+          break;
+        case 'V':
+          {
+            string name;
+            int type, lag;
+            line >> name >> type >> lag;
+            if (!line || !tree.symbol_table.exists(name)
+                || (int) tree.symbol_table.getType(name) != type)
+              return false;
+            if (derivs != NULL)
+              node = tree.AddVariableInternal(tree.symbol_table.getID(name), lag);
+          }
+          break;
+        case 'U':
+          {
+            int op, arg;
+            line >> op >> arg;
+            if (!line || op < 0 || op > oErf || op == oSteadyStateParamDeriv
+                || op == oSteadyStateParam2ndDeriv || op == oExpectation
+                || arg < 0 || arg >= (int) nodes.size())
+              return false;
+            if (derivs != NULL)
+              node = tree.AddUnaryOp((UnaryOpcode) op, nodes[arg]);
+          }
+          break;
+        case 'B':
+          {
+            int op, power_deriv_order, arg1, arg2;
+            line >> op >> power_deriv_order >> arg1 >> arg2;
+            if (!line || op < 0 || op > oDifferent || power_deriv_order < 0
+                || arg1 < 0 || arg1 >= (int) nodes.size() || arg2 < 0 || arg2 >= (int) nodes.size())
+              return false;
+            if (derivs != NULL)
+              node = tree.AddBinaryOp(nodes[arg1], (BinaryOpcode) op, nodes[arg2], power_deriv_order);
+          }
+          break;
+        case 'T':
+          {
+            int op, arg1, arg2, arg3;
+            line >> op >> arg1 >> arg2 >> arg3;
+            if (!line || op < 0 || op > oNormpdf
+                || arg1 < 0 || arg1 >= (int) nodes.size() || arg2 < 0 || arg2 >= (int) nodes.size()
+                || arg3 < 0 || arg3 >= (int) nodes.size())
+              return false;
+            if (derivs != NULL)
+              node = tree.AddTrinaryOp(nodes[arg1], (TrinaryOpcode) op, nodes[arg2], nodes[arg3]);
+          }
+          break;
+        case 'D':
+          {
+            int index, var;
+            vector<int> deriv_ids;
+            line >> index;
+            if (!line || index < 0 || index >= (int) nodes.size())
+              return false;
+            while (line >> var)
+              {
+                if (var < 0 || var >= (int) eq_vars.size())
+                  return false;
+                deriv_ids.push_back(eq_vars[var]);
+              }
+            if (!line.eof() || (int) deriv_ids.size() != order)
+              return false;
+            if (derivs != NULL)
+              derivs->push_back(make_pair(deriv_ids, nodes[index]));
+          }
+          // A derivative is not a node
+          continue;
+        default:
+          return false;
+        }
+      nodes.push_back(node);
+    }
+  return true;
+}
+
+bool
+DerivativesCache::check(const string &key, int order, const vector<int> &eq_vars) const
+{
+  map<string, Entry>::const_iterator it = entries.find(key);
+  if (it == entries.end() || it->second.order < order)
+    return false;
+  for (int k = 1; k <= order; k++)
+    if (!readCode(it->second.code[k-1], k, eq_vars, NULL))
+      return false;
+  return true;
+}
+
+void
+DerivativesCache::remove(const string &key)
+{
+  entries.erase(key);
+  rejected = true;
+}
+
+bool
+DerivativesCache::isRejected() const
+{
+  return rejected;
+}
+
+void
+DerivativesCache::readDerivatives(const string &key, int order, const vector<int> &eq_vars, derivatives_t &derivs) const
+{
+  // The entry has been checked by check()
+  if (!readCode(entries.find(key)->second.code[order-1], order, eq_vars, &derivs))
+    {
+      cerr << "ERROR: invalid derivatives in the derivatives cache" << endl;
+      exit(EXIT_FAILURE);
+    }
+}
+
+bool
+DerivativesCache::writeDerivatives(const string &key, int order, const vector<int> &eq_vars, const derivatives_t &derivs)
+{
+  map<int, int> var_index;
+  for (int i = 0; i < (int) eq_vars.size(); i++)
+    var_index[eq_vars[i]] = i;
+
+  map<expr_t, int> ids;
+  vector<string> code, deriv_code;
+  set<int> local_vars;
+  set<pair<int, int> > variables;
+  for (derivatives_t::const_iterator it = derivs.begin(); it != derivs.end(); it++)
+    {
+      if (!writeNodes(it->second, ids, code, local_vars, variables))
+        {
+          entries.erase(key);
+          return false;
+        }
+      ostringstream line;
+      line << "D " << ids[it->second];
+      for (vector<int>::const_iterator it2 = it->first.begin(); it2 != it->first.end(); it2++)
+        line << " " << var_index[*it2];
+      deriv_code.push_back(line.str());
+    }
+  code.insert(code.end(), deriv_code.begin(), deriv_code.end());
+
+  Entry &entry = entries[key];
+  entry.code[order-1] = code;
+  entry.order = max(entry.order, order);
+  return true;
+}
+
+void
+DerivativesCache::load(const string &filename)
+{
+  entries.clear();
+  rejected = false;
+
+  ifstream file(filename.c_str(), ios::in | ios::binary);
+  if (!file.is_open())
+    return;
+
+  string line;
+  if (!getline(file, line) || line != DERIVATIVES_CACHE_HEADER)
+    return;
+
+  /* The file is only accepted if it ends with a complete entry: each line
+     must end with a newline (file.eof() is set when reading a last line without
+     one), each entry must have its orders in sequence from 1, and each order
+     its number of lines */
+  bool corrupted = false;
+  Entry *entry = NULL;
+  while (!corrupted && getline(file, line))
+    {
+      if (file.eof())
+        corrupted = true;
+      else if (line.compare(0, 2, "E ") == 0)
+        {
+          if ((entry != NULL && entry->order == 0) || entries.find(line.substr(2)) != entries.end())
+            corrupted = true;
+          else
+            entry = &entries[line.substr(2)];
+        }
+      else if (line.compare(0, 2, "O ") == 0 && entry != NULL)
+        {
+          int order, nlines;
+          istringstream header(line.substr(2));
+          header >> order >> nlines;
+          if (!header || order != entry->order + 1 || order > 3 || nlines < 0)
+            corrupted = true;
+          else
+            {
+              vector<string> &code = entry->code[order-1];
+              while ((int) code.size() < nlines && getline(file, line) && !file.eof())
+                code.push_back(line);
+              corrupted = (int) code.size() < nlines;
+              entry->order = order;
+            }
+        }
+      else
+        corrupted = true;
+    }
+  if (corrupted || file.bad() || (entry != NULL && entry->order == 0))
+    {
+      cerr << "WARNING: the derivatives cache " << filename << " is corrupted, it is ignored" << endl;
+      entries.clear();
+      rejected = true;
+    }
+}
+
+void
+DerivativesCache::save(const string &filename) const
+{
+  size_t pos = filename.find_last_of('/');
+  if (pos != string::npos)
+    {
+      string dirname = filename.substr(0, pos);
+#ifdef _WIN32
+      int r = mkdir(dirname.c_str());
+#else
+      int r = mkdir(dirname.c_str(), 0777);
+#endif
+      if (r < 0 && errno != EEXIST)
+        {
+          perror("ERROR");
+          exit(EXIT_FAILURE);
+        }
+    }
+
+  /* The cache is written to a temporary file, which then replaces it, so that
+     an interrupted run does not leave a truncated cache */
+  string tmp_filename = filename + ".tmp";
+  ofstream file(tmp_filename.c_str(), ios::out | ios::binary);
+  if (!file.is_open())
+    {
+      cerr << "ERROR: Can't open file " << tmp_filename << " for writing" << endl;
+      exit(EXIT_FAILURE);
+    }
+
+  file << DERIVATIVES_CACHE_HEADER << endl;
+  for (map<string, Entry>::const_iterator it = entries.begin(); it != entries.end(); it++)
+    {
+      file << "E " << it->first << endl;
+      for (int order = 1; order <= it->second.order; order++)
+        {
+          const vector<string> &code = it->second.code[order-1];
+          file << "O " << order << " " << code.size() << endl;
+          for (vector<string>::const_iterator it2 = code.begin(); it2 != code.end(); it2++)
+            file << *it2 << endl;
+        }
+    }
+  file.close();
+  if (file.fail())
+    {
+      cerr << "ERROR: Can't write file " << tmp_filename << endl;
+      exit(EXIT_FAILURE);
+    }
+
+#ifdef _WIN32
+  // rename() does not replace an existing file under Windows
+  std::remove(filename.c_str());
+#endif
+  if (rename(tmp_filename.c_str(), filename.c_str()) != 0)
+    {
+      perror("ERROR");
+      exit(EXIT_FAILURE);
+    }
+}
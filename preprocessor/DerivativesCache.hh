@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DERIVATIVESCACHE_HH
+#define _DERIVATIVESCACHE_HH
+
+using namespace std;
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include "DataTree.hh"
+
+//! On-disk cache of the derivatives of the equations of a model
+/*!
+  Each equation is identified by a key, which is a normalized text of the
+  equation: its nodes, the definitions of the model local variables that it
+  uses, and its derivation variables, all of them written with symbol names
+  instead of symbol IDs. The key does not depend on the other equations, nor on
+  the declaration order of the symbols (except through the relative order of
+  the derivation IDs of the variables of the equation).
+
+  For each key, the cache stores the derivatives of the equation up to some
+  order, as lists of nodes which are recreated in the tree when read, without
+  any differentiation.
+*/
+class DerivativesCache
+{
+public:
+  //! Derivatives of a given order of an equation: derivation IDs (in the order of the keys of the derivative maps of ModelTree) and derivative
+  typedef vector<pair<vector<int>, expr_t> > derivatives_t;
+private:
+  //! The derivatives of an equation
+  struct Entry
+  {
+    //! Highest order of the stored derivatives
+    int order;
+    //! For each order, the nodes of the derivatives followed by the derivatives themselves, one per line
+    vector<string> code[3];
+    Entry() : order(0)
+    {
+    };
+  };
+  //! The tree in which the derivatives are read
+  DataTree &tree;
+  //! The entries, indexed by key
+  map<string, Entry> entries;
+  //! Whether the file read by load(), or some of its entries, were found to be corrupted
+  bool rejected;
+  //! Writes the nodes of an expression which are not yet in ids, arguments first
+  /*! Returns false if the expression contains a node which can't be stored (external functions, expectations...).
+    \param local_vars the model local variables used by the expression are added to this set
+    \param variables the other variables (symbol ID and lag) used by the expression are added to this set */
+  bool writeNodes(expr_t expr, map<expr_t, int> &ids, vector<string> &code,
+                  set<int> &local_vars, set<pair<int, int> > &variables) const;
+  //! Reads the derivatives of a given order of an equation from their lines
+  /*! Returns false if a line is invalid.
+    \param derivs the derivatives are added to the tree and to this list, or only checked if it is NULL */
+  bool readCode(const vector<string> &code, int order, const vector<int> &eq_vars, derivatives_t *derivs) const;
+public:
+  DerivativesCache(DataTree &tree_arg);
+  //! Reads a cache file; does nothing if the file does not exist or was written by another version
+  /*! The whole file is ignored, with a warning, if it is corrupted (in particular truncated) */
+  void load(const string &filename);
+  //! Writes a cache file, creating its directory if needed
+  /*! The file is replaced at once, by renaming a temporary file */
+  void save(const string &filename) const;
+  //! Number of equations in the cache
+  int size() const;
+  //! Computes the key of an equation
+  /*! Returns false if the equation can't be stored in the cache.
+    \param vars the derivation IDs of the model
+    \param eq_vars filled with the derivation IDs, among vars, of the variables of the equation, in increasing order */
+  bool computeKey(expr_t equation, const set<int> &vars, string &key, vector<int> &eq_vars) const;
+  //! Whether the cache contains the derivatives up to the given order of an equation
+  bool contains(const string &key, int order) const;
+  //! Whether the derivatives up to the given order of an equation are in the cache, and valid
+  bool check(const string &key, int order, const vector<int> &eq_vars) const;
+  //! Removes an equation which failed check() from the cache
+  void remove(const string &key);
+  //! Whether load() or remove() discarded some content of the file
+  bool isRejected() const;
+  //! Adds to the tree the derivatives of a given order of an equation of the cache, which has passed check()
+  void readDerivatives(const string &key, int order, const vector<int> &eq_vars, derivatives_t &derivs) const;
+  //! Stores the derivatives of a given order of an equation
+  /*! Returns false if a derivative can't be stored, in which case the equation is removed from the cache */
+  bool writeDerivatives(const string &key, int order, const vector<int> &eq_vars, const derivatives_t &derivs);
+};
+
+#endif
@@ -1612,8 +1612,8 @@ DynamicModel::writeDynamicCFile(const string &dynamic_basename, const int order)
   if (external_functions_table.get_total_number_of_unique_model_block_external_functions())
     // External Matlab function, implies Dynamic function will call mex
     mDynamicModelFile << "#include \"mex.h\"" << endl;
-  else
-    mDynamicModelFile << "#include <stdlib.h>" << endl;
+  // Needed in any case by Dynamic_batch
+  mDynamicModelFile << "#include <stdlib.h>" << endl;
 
   mDynamicModelFile << "#define max(a, b) (((a) > (b)) ? (a) : (b))" << endl
                     << "#define min(a, b) (((a) > (b)) ? (b) : (a))" << endl;
@@ -1622,7 +1622,16 @@ DynamicModel::writeDynamicCFile(const string &dynamic_basename, const int order)
   writePowerDerivCHeader(mDynamicModelFile);
 
   // Writing the function body
-  writeDynamicModel(mDynamicModelFile, true, false);
+  writeDynamicModel(mDynamicModelFile, true, false, dynamic_basename);
+  /* When the code is split, the other entry points are not written, since
+     each of them would again contain the whole code of the model */
+  if (split_c_files == 0)
+    {
+      writeDynamicPerOrderCFunctions(mDynamicModelFile);
+      writeDynamicBatchCFunction(mDynamicModelFile);
+    }
+  // There is no other way of computing the derivatives above order 3
+  writeDynamicHigherDerivativesCFunctions(mDynamicModelFile);
 
   writePowerDeriv(mDynamicModelFile, true);
   mDynamicModelFile.close();
@@ -2129,64 +2138,38 @@ DynamicModel::writeSparseDynamicMFile(const string &dynamic_basename, const stri
 }
 
 void
-DynamicModel::writeDynamicModel(ostream &DynamicOutput, bool use_dll, bool julia) const
+DynamicModel::writeDynamicJacobian(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                                   deriv_node_temp_terms_t &tef_terms, vector<CStatement> *statements) const
 {
-  ostringstream model_local_vars_output;  // Used for storing model local vars
-  ostringstream model_output;             // Used for storing model temp vars and equations
-  ostringstream jacobian_output;          // Used for storing jacobian equations
-  ostringstream hessian_output;           // Used for storing Hessian equations
-  ostringstream third_derivatives_output; // Used for storing third order derivatives equations
-
-  ExprNodeOutputType output_type = (use_dll ? oCDynamicModel :
-                                    julia ? oJuliaDynamicModel : oMatlabDynamicModel);
-
-  deriv_node_temp_terms_t tef_terms;
-  temporary_terms_t temp_term_empty;
-  temporary_terms_t temp_term_union = temporary_terms_res;
-  temporary_terms_t temp_term_union_m_1;
-
-  writeModelLocalVariables(model_local_vars_output, output_type, tef_terms);
-
-  writeTemporaryTerms(temporary_terms_res, temp_term_union_m_1, model_output, output_type, tef_terms);
-
-  writeModelEquations(model_output, output_type);
-
-  int nrows = equations.size();
-  int hessianColsNbr = dynJacobianColsNbr * dynJacobianColsNbr;
-
-  // Writing Jacobian
-  temp_term_union_m_1 = temp_term_union;
-  temp_term_union.insert(temporary_terms_g1.begin(), temporary_terms_g1.end());
-  if (!first_derivatives.empty())
-    if (julia)
-      writeTemporaryTerms(temp_term_union, temp_term_empty, jacobian_output, output_type, tef_terms);
-    else
-      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, jacobian_output, output_type, tef_terms);
+  int k = 0; // Keep the position of a nonzero element of the Jacobian (used by the batched C function)
   for (first_derivatives_t::const_iterator it = first_derivatives.begin();
-       it != first_derivatives.end(); it++)
+       it != first_derivatives.end(); it++, k++)
     {
+      ostringstream statement;
       int eq = it->first.first;
       int var = it->first.second;
       expr_t d1 = it->second;
 
-      jacobianHelper(jacobian_output, eq, getDynJacobianCol(var), output_type);
-      jacobian_output << "=";
-      d1->writeOutput(jacobian_output, output_type, temp_term_union, tef_terms);
-      jacobian_output << ";" << endl;
+      if (output_type == oCDynamicBatchModel)
+        statement << "  g1_block[j+" << k << "*DYNARE_BATCH_SIZE]";
+      else
+        jacobianHelper(statement, eq, getDynJacobianCol(var), output_type);
+      statement << "=";
+      d1->writeOutput(statement, output_type, temporary_terms, tef_terms);
+      statement << ";" << endl;
+      writeCStatement(output, statements, 1, statement.str(), temporary_terms, d1);
     }
+}
 
-  // Writing Hessian
-  temp_term_union_m_1 = temp_term_union;
-  temp_term_union.insert(temporary_terms_g2.begin(), temporary_terms_g2.end());
-  if (!second_derivatives.empty())
-    if (julia)
-      writeTemporaryTerms(temp_term_union, temp_term_empty, hessian_output, output_type, tef_terms);
-    else
-      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, hessian_output, output_type, tef_terms);
+void
+DynamicModel::writeDynamicHessian(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                                  deriv_node_temp_terms_t &tef_terms, vector<CStatement> *statements) const
+{
   int k = 0; // Keep the line of a 2nd derivative in v2
   for (second_derivatives_t::const_iterator it = second_derivatives.begin();
        it != second_derivatives.end(); it++)
     {
+      ostringstream statement;
       int eq = it->first.first;
       int var1 = it->first.second.first;
       int var2 = it->first.second.second;
@@ -2202,22 +2185,22 @@ DynamicModel::writeDynamicModel(ostream &DynamicOutput, bool use_dll, bool julia
       if (output_type == oJuliaDynamicModel)
         {
           for_sym << "g2[" << eq + 1 << "," << col_nb + 1 << "]";
-          hessian_output << "  @inbounds " << for_sym.str() << " = ";
-          d2->writeOutput(hessian_output, output_type, temp_term_union, tef_terms);
-          hessian_output << endl;
+          statement << "  @inbounds " << for_sym.str() << " = ";
+          d2->writeOutput(statement, output_type, temporary_terms, tef_terms);
+          statement << endl;
         }
       else
         {
-          sparseHelper(2, hessian_output, k, 0, output_type);
-          hessian_output << "=" << eq + 1 << ";" << endl;
+          sparseHelper(2, statement, k, 0, output_type);
+          statement << "=" << eq + 1 << ";" << endl;
 
-          sparseHelper(2, hessian_output, k, 1, output_type);
-          hessian_output << "=" << col_nb + 1 << ";" << endl;
+          sparseHelper(2, statement, k, 1, output_type);
+          statement << "=" << col_nb + 1 << ";" << endl;
 
-          sparseHelper(2, hessian_output, k, 2, output_type);
-          hessian_output << "=";
-          d2->writeOutput(hessian_output, output_type, temp_term_union, tef_terms);
-          hessian_output << ";" << endl;
+          sparseHelper(2, statement, k, 2, output_type);
+          statement << "=";
+          d2->writeOutput(statement, output_type, temporary_terms, tef_terms);
+          statement << ";" << endl;
 
           k++;
         }
@@ -2225,37 +2208,37 @@ DynamicModel::writeDynamicModel(ostream &DynamicOutput, bool use_dll, bool julia
       // Treating symetric elements
       if (id1 != id2)
         if (output_type == oJuliaDynamicModel)
-          hessian_output << "  @inbounds g2[" << eq + 1 << "," << col_nb_sym + 1 << "] = "
-                         << for_sym.str() << endl;
+          statement << "  @inbounds g2[" << eq + 1 << "," << col_nb_sym + 1 << "] = "
+                    << for_sym.str() << endl;
         else
           {
-            sparseHelper(2, hessian_output, k, 0, output_type);
-            hessian_output << "=" << eq + 1 << ";" << endl;
+            sparseHelper(2, statement, k, 0, output_type);
+            statement << "=" << eq + 1 << ";" << endl;
 
-            sparseHelper(2, hessian_output, k, 1, output_type);
-            hessian_output << "=" << col_nb_sym + 1 << ";" << endl;
+            sparseHelper(2, statement, k, 1, output_type);
+            statement << "=" << col_nb_sym + 1 << ";" << endl;
 
-            sparseHelper(2, hessian_output, k, 2, output_type);
-            hessian_output << "=";
-            sparseHelper(2, hessian_output, k-1, 2, output_type);
-            hessian_output << ";" << endl;
+            sparseHelper(2, statement, k, 2, output_type);
+            statement << "=";
+            sparseHelper(2, statement, k-1, 2, output_type);
+            statement << ";" << endl;
 
             k++;
           }
+      writeCStatement(output, statements, 2, statement.str(), temporary_terms, d2);
     }
+}
 
-  // Writing third derivatives
-  temp_term_union_m_1 = temp_term_union;
-  temp_term_union.insert(temporary_terms_g3.begin(), temporary_terms_g3.end());
-  if (!third_derivatives.empty())
-    if (julia)
-      writeTemporaryTerms(temp_term_union, temp_term_empty, third_derivatives_output, output_type, tef_terms);
-    else
-      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, third_derivatives_output, output_type, tef_terms);
-  k = 0; // Keep the line of a 3rd derivative in v3
+void
+DynamicModel::writeDynamicThirdDerivatives(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                                           deriv_node_temp_terms_t &tef_terms, vector<CStatement> *statements) const
+{
+  int hessianColsNbr = dynJacobianColsNbr * dynJacobianColsNbr;
+  int k = 0; // Keep the line of a 3rd derivative in v3
   for (third_derivatives_t::const_iterator it = third_derivatives.begin();
        it != third_derivatives.end(); it++)
     {
+      ostringstream statement;
       int eq = it->first.first;
       int var1 = it->first.second.first;
       int var2 = it->first.second.second.first;
@@ -2273,22 +2256,22 @@ DynamicModel::writeDynamicModel(ostream &DynamicOutput, bool use_dll, bool julia
       if (output_type == oJuliaDynamicModel)
         {
           for_sym << "g3[" << eq + 1 << "," << ref_col + 1 << "]";
-          third_derivatives_output << "  @inbounds " << for_sym.str() << " = ";
-          d3->writeOutput(third_derivatives_output, output_type, temp_term_union, tef_terms);
-          third_derivatives_output << endl;
+          statement << "  @inbounds " << for_sym.str() << " = ";
+          d3->writeOutput(statement, output_type, temporary_terms, tef_terms);
+          statement << endl;
         }
       else
         {
-          sparseHelper(3, third_derivatives_output, k, 0, output_type);
-          third_derivatives_output << "=" << eq + 1 << ";" << endl;
+          sparseHelper(3, statement, k, 0, output_type);
+          statement << "=" << eq + 1 << ";" << endl;
 
-          sparseHelper(3, third_derivatives_output, k, 1, output_type);
-          third_derivatives_output << "=" << ref_col + 1 << ";" << endl;
+          sparseHelper(3, statement, k, 1, output_type);
+          statement << "=" << ref_col + 1 << ";" << endl;
 
-          sparseHelper(3, third_derivatives_output, k, 2, output_type);
-          third_derivatives_output << "=";
-          d3->writeOutput(third_derivatives_output, output_type, temp_term_union, tef_terms);
-          third_derivatives_output << ";" << endl;
+          sparseHelper(3, statement, k, 2, output_type);
+          statement << "=";
+          d3->writeOutput(statement, output_type, temporary_terms, tef_terms);
+          statement << ";" << endl;
         }
 
       // Compute the column numbers for the 5 other permutations of (id1,id2,id3)
@@ -2304,25 +2287,87 @@ DynamicModel::writeDynamicModel(ostream &DynamicOutput, bool use_dll, bool julia
       for (set<int>::iterator it2 = cols.begin(); it2 != cols.end(); it2++)
         if (*it2 != ref_col)
           if (output_type == oJuliaDynamicModel)
-            third_derivatives_output << "  @inbounds g3[" << eq + 1 << "," << *it2 + 1 << "] = "
-                                     << for_sym.str() << endl;
+            statement << "  @inbounds g3[" << eq + 1 << "," << *it2 + 1 << "] = "
+                      << for_sym.str() << endl;
           else
             {
-              sparseHelper(3, third_derivatives_output, k+k2, 0, output_type);
-              third_derivatives_output << "=" << eq + 1 << ";" << endl;
+              sparseHelper(3, statement, k+k2, 0, output_type);
+              statement << "=" << eq + 1 << ";" << endl;
 
-              sparseHelper(3, third_derivatives_output, k+k2, 1, output_type);
-              third_derivatives_output << "=" << *it2 + 1 << ";" << endl;
+              sparseHelper(3, statement, k+k2, 1, output_type);
+              statement << "=" << *it2 + 1 << ";" << endl;
 
-              sparseHelper(3, third_derivatives_output, k+k2, 2, output_type);
-              third_derivatives_output << "=";
-              sparseHelper(3, third_derivatives_output, k, 2, output_type);
-              third_derivatives_output << ";" << endl;
+              sparseHelper(3, statement, k+k2, 2, output_type);
+              statement << "=";
+              sparseHelper(3, statement, k, 2, output_type);
+              statement << ";" << endl;
 
               k2++;
             }
       k += k2;
+      writeCStatement(output, statements, 3, statement.str(), temporary_terms, d3);
     }
+}
+
+void
+DynamicModel::writeDynamicModel(ostream &DynamicOutput, bool use_dll, bool julia, const string &c_basename) const
+{
+  ostringstream model_local_vars_output;  // Used for storing model local vars
+  ostringstream model_output;             // Used for storing model temp vars and equations
+  ostringstream jacobian_output;          // Used for storing jacobian equations
+  ostringstream hessian_output;           // Used for storing Hessian equations
+  ostringstream third_derivatives_output; // Used for storing third order derivatives equations
+
+  ExprNodeOutputType output_type = (use_dll ? oCDynamicModel :
+                                    julia ? oJuliaDynamicModel : oMatlabDynamicModel);
+
+  deriv_node_temp_terms_t tef_terms;
+  temporary_terms_t temp_term_empty;
+  temporary_terms_t temp_term_union = temporary_terms_res;
+  temporary_terms_t temp_term_union_m_1;
+
+  // With split C files, the statements are kept apart instead of being written to the streams
+  vector<CStatement> statements;
+  vector<CStatement> *c_statements = (output_type == oCDynamicModel && split_c_files > 0 ? &statements : NULL);
+
+  writeModelLocalVariables(model_local_vars_output, output_type, tef_terms);
+
+  writeTemporaryTerms(temporary_terms_res, temp_term_union_m_1, model_output, output_type, tef_terms, c_statements, 0);
+
+  writeModelEquations(model_output, output_type, c_statements);
+
+  int nrows = equations.size();
+  int hessianColsNbr = dynJacobianColsNbr * dynJacobianColsNbr;
+
+  // Writing Jacobian
+  temp_term_union_m_1 = temp_term_union;
+  temp_term_union.insert(temporary_terms_g1.begin(), temporary_terms_g1.end());
+  if (!first_derivatives.empty())
+    if (julia)
+      writeTemporaryTerms(temp_term_union, temp_term_empty, jacobian_output, output_type, tef_terms);
+    else
+      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, jacobian_output, output_type, tef_terms, c_statements, 1);
+  writeDynamicJacobian(jacobian_output, output_type, temp_term_union, tef_terms, c_statements);
+
+  // Writing Hessian
+  temp_term_union_m_1 = temp_term_union;
+  temp_term_union.insert(temporary_terms_g2.begin(), temporary_terms_g2.end());
+  if (!second_derivatives.empty())
+    if (julia)
+      writeTemporaryTerms(temp_term_union, temp_term_empty, hessian_output, output_type, tef_terms);
+    else
+      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, hessian_output, output_type, tef_terms, c_statements, 2);
+  writeDynamicHessian(hessian_output, output_type, temp_term_union, tef_terms, c_statements);
+
+  // Writing third derivatives
+  temp_term_union_m_1 = temp_term_union;
+  temp_term_union.insert(temporary_terms_g3.begin(), temporary_terms_g3.end());
+  if (!third_derivatives.empty())
+    if (julia)
+      writeTemporaryTerms(temp_term_union, temp_term_empty, third_derivatives_output, output_type, tef_terms);
+    else
+      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, third_derivatives_output, output_type, tef_terms, c_statements, 3);
+  writeDynamicThirdDerivatives(third_derivatives_output, output_type, temp_term_union, tef_terms, c_statements);
 
   if (output_type == oMatlabDynamicModel)
     {
@@ -2375,6 +2420,18 @@ DynamicModel::writeDynamicModel(ostream &DynamicOutput, bool use_dll, bool julia
                     << "end" << endl
                     << "end" << endl;
     }
+  else if (output_type == oCDynamicModel && split_c_files > 0)
+    {
+      vector<string> outputs;
+      outputs.push_back("residual");
+      outputs.push_back("g1");
+      outputs.push_back("v2");
+      outputs.push_back("v3");
+      writeSplitCFunction(DynamicOutput, c_basename, "Dynamic",
+                          "double *y, double *x, int nb_row_x, double *params, double *steady_state, int it_, double *residual, double *g1, double *v2, double *v3",
+                          "y, x, nb_row_x, params, steady_state, it_, residual, g1, v2, v3",
+                          model_local_vars_output.str(), statements, outputs);
+    }
   else if (output_type == oCDynamicModel)
     {
       DynamicOutput << "void Dynamic(double *y, double *x, int nb_row_x, double *params, double *steady_state, int it_, double *residual, double *g1, double *v2, double *v3)" << endl
@@ -2507,6 +2564,220 @@ DynamicModel::writeDynamicModel(ostream &DynamicOutput, bool use_dll, bool julia
     }
 }
 
+void
+DynamicModel::writeDynamicPerOrderCFunctions(ostream &output) const
+{
+  const char *suffixes[] = { "resid", "g1", "g2", "g3" };
+  const char *outputs[] = { "residual", "g1", "v2", "v3" };
+  const temporary_terms_t *order_temporary_terms[] = { &temporary_terms_res, &temporary_terms_g1,
+                                                       &temporary_terms_g2, &temporary_terms_g3 };
+  const temporary_terms_t temp_term_empty;
+
+  // Temporary terms that may appear in the expressions of the current order
+  temporary_terms_t temp_term_union;
+  for (int order = 0; order <= 3; order++)
+    {
+      temp_term_union.insert(order_temporary_terms[order]->begin(), order_temporary_terms[order]->end());
+      temporary_terms_t needed;
+      computeNeededTemporaryTerms(order, temp_term_union, needed);
+
+      // Each function computes its own external function calls
+      deriv_node_temp_terms_t tef_terms;
+
+      output << "void Dynamic_" << suffixes[order] << "(double *y, double *x, int nb_row_x, double *params, double *steady_state, int it_, double *"
+             << outputs[order] << ")" << endl
+             << "{" << endl;
+      if (order == 0)
+        output << "  double lhs, rhs;" << endl
+               << endl;
+      writeModelLocalVariables(output, oCDynamicModel, tef_terms);
+      writeTemporaryTerms(needed, temp_term_empty, output, oCDynamicModel, tef_terms);
+      switch (order)
+        {
+        case 0:
+          writeModelEquations(output, oCDynamicModel);
+          break;
+        case 1:
+          writeDynamicJacobian(output, oCDynamicModel, temp_term_union, tef_terms);
+          break;
+        case 2:
+          writeDynamicHessian(output, oCDynamicModel, temp_term_union, tef_terms);
+          break;
+        case 3:
+          writeDynamicThirdDerivatives(output, oCDynamicModel, temp_term_union, tef_terms);
+          break;
+        }
+      output << "}" << endl << endl;
+    }
+}
+
+void
+DynamicModel::writeDynamicHigherDerivativesCFunctions(ostream &output) const
+{
+  const temporary_terms_t temp_term_empty;
+
+  temporary_terms_t temp_term_union = temporary_terms_res;
+  temp_term_union.insert(temporary_terms_g1.begin(), temporary_terms_g1.end());
+  temp_term_union.insert(temporary_terms_g2.begin(), temporary_terms_g2.end());
+  temp_term_union.insert(temporary_terms_g3.begin(), temporary_terms_g3.end());
+  temp_term_union.insert(temporary_terms_higher.begin(), temporary_terms_higher.end());
+
+  for (int order = 4; order - 4 < (int) higher_derivatives.size(); order++)
+    {
+      const higher_derivatives_t &derivs = higher_derivatives[order-4];
+      int nnz = derivs.size();
+
+      temporary_terms_t needed;
+      computeNeededTemporaryTerms(order, temp_term_union, needed);
+
+      deriv_node_temp_terms_t tef_terms;
+
+      output << "/* Derivatives of order " << order << ", w.r. to sorted variables only (the others follow by symmetry)." << endl
+             << "   v" << order << " is a " << nnz << "x" << order + 2 << " matrix (in column-major order), whose rows contain" << endl
+             << "   the 1-based equation number, the " << order << " 1-based columns of the dynamic Jacobian" << endl
+             << "   (by increasing order) w.r. to which the derivative is computed, and its value */" << endl
+             << "#if defined(_WIN32) || defined(__CYGWIN32__)" << endl
+             << "__declspec(dllexport)" << endl
+             << "#endif" << endl
+             << "void Dynamic_g" << order << "(double *y, double *x, int nb_row_x, double *params, double *steady_state, int it_, double *v"
+             << order << ")" << endl
+             << "{" << endl;
+      writeModelLocalVariables(output, oCDynamicModel, tef_terms);
+      writeTemporaryTerms(needed, temp_term_empty, output, oCDynamicModel, tef_terms);
+
+      int k = 0;
+      for (higher_derivatives_t::const_iterator it = derivs.begin(); it != derivs.end(); it++, k++)
+        {
+          vector<int> cols;
+          for (size_t i = 1; i < it->first.size(); i++)
+            cols.push_back(getDynJacobianCol(it->first[i]));
+          sort(cols.begin(), cols.end());
+
+          output << "  v" << order << "[" << k << "] = " << it->first[0] + 1 << ";" << endl;
+          for (int i = 0; i < order; i++)
+            output << "  v" << order << "[" << k + (i+1)*nnz << "] = " << cols[i] + 1 << ";" << endl;
+          output << "  v" << order << "[" << k + (order+1)*nnz << "] = ";
+          it->second->writeOutput(output, oCDynamicModel, temp_term_union, tef_terms);
+          output << ";" << endl;
+        }
+      output << "}" << endl << endl;
+    }
+}
+
+void
+DynamicModel::writeDynamicBatchCFunction(ostream &output) const
+{
+  const temporary_terms_t temp_term_empty;
+
+  // Sparsity pattern of the Jacobian, in the order of the elements computed by Dynamic_batch
+  output << "/* Fills row and col (if not NULL) with the 0-based equation and column numbers" << endl
+         << "   of the nonzero elements of the Jacobian computed by Dynamic_batch; returns their number */" << endl
+         << "int Dynamic_batch_g1_sparsity(int *row, int *col)" << endl
+         << "{" << endl;
+  if (!first_derivatives.empty())
+    {
+      for (int i = 0; i < 2; i++)
+        {
+          output << "  static const int g1_" << (i == 0 ? "row" : "col") << "[] = {";
+          int k = 0;
+          for (first_derivatives_t::const_iterator it = first_derivatives.begin();
+               it != first_derivatives.end(); it++, k++)
+            {
+              output << (k == 0 ? "" : ",") << (k % 20 == 0 ? "\n    " : " ");
+              if (i == 0)
+                output << it->first.first;
+              else
+                output << getDynJacobianCol(it->first.second);
+            }
+          output << endl
+                 << "  };" << endl;
+        }
+      output << "  int k;" << endl
+             << endl
+             << "  for (k = 0; k < " << first_derivatives.size() << "; k++)" << endl
+             << "    {" << endl
+             << "      if (row != NULL)" << endl
+             << "        row[k] = g1_row[k];" << endl
+             << "      if (col != NULL)" << endl
+             << "        col[k] = g1_col[k];" << endl
+             << "    }" << endl;
+    }
+  output << "  return " << first_derivatives.size() << ";" << endl
+         << "}" << endl << endl;
+
+  temporary_terms_t temp_term_union = temporary_terms_res;
+  temp_term_union.insert(temporary_terms_g1.begin(), temporary_terms_g1.end());
+  temporary_terms_t jacobian_temporary_terms;
+  computeNeededTemporaryTerms(1, temp_term_union, jacobian_temporary_terms);
+  jacobian_temporary_terms.insert(temporary_terms_res.begin(), temporary_terms_res.end());
+
+  // Number of points evaluated together (a multiple of the width of SIMD registers)
+  const int batch_block_size = 16;
+
+  /* The points are evaluated by blocks. Within a block, the outputs are
+     stored in buffers whose rows have a fixed length, so that compilers can
+     prove that the stores do not overlap and vectorize the loop over points.
+     Without the guarantee that the arguments do not overlap, they would not
+     vectorize it either. */
+  output << "#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L" << endl
+         << "# define DYNARE_RESTRICT restrict" << endl
+         << "#else" << endl
+         << "# define DYNARE_RESTRICT" << endl
+         << "#endif" << endl
+         << "#define DYNARE_BATCH_SIZE " << batch_block_size << endl
+         << endl
+         << "/* Evaluates the residuals and (if g1 is not NULL) the nonzero elements of the Jacobian" << endl
+         << "   at points it_begin to it_end-1. The arrays y, residual and g1 have nb_row_y rows," << endl
+         << "   row it_ corresponding to point it_: row it_ of y contains the argument y of Dynamic," << endl
+         << "   and the exogenous variables are read from x as in Dynamic. The elements of g1" << endl
+         << "   are stored in the order given by Dynamic_batch_g1_sparsity. */" << endl
+         << "void Dynamic_batch(double * DYNARE_RESTRICT y, int nb_row_y, double * DYNARE_RESTRICT x, int nb_row_x," << endl
+         << "                   double * DYNARE_RESTRICT params, double * DYNARE_RESTRICT steady_state," << endl
+         << "                   int it_begin, int it_end, double * DYNARE_RESTRICT residual, double * DYNARE_RESTRICT g1)" << endl
+         << "{" << endl
+         << "  double *residual_block, *g1_block = NULL;" << endl
+         << "  int block, nb_points, it_, i, j;" << endl
+         << endl
+         << "  residual_block = (double *) malloc(" << max((int) equations.size(), 1) << "*DYNARE_BATCH_SIZE*sizeof(double));" << endl
+         << "  if (g1 != NULL)" << endl
+         << "    g1_block = (double *) malloc(" << max((int) first_derivatives.size(), 1) << "*DYNARE_BATCH_SIZE*sizeof(double));" << endl
+         << endl
+         << "  for (block = it_begin; block < it_end; block += DYNARE_BATCH_SIZE)" << endl
+         << "    {" << endl
+         << "      nb_points = it_end - block < DYNARE_BATCH_SIZE ? it_end - block : DYNARE_BATCH_SIZE;" << endl;
+  for (int with_jacobian = 0; with_jacobian <= 1; with_jacobian++)
+    {
+      // Each loop computes its own external function calls
+      deriv_node_temp_terms_t tef_terms;
+
+      output << (with_jacobian ? "      else" : "      if (g1 == NULL)") << endl
+             << "        for (j = 0; j < nb_points; j++)" << endl
+             << "          {" << endl
+             << "            double lhs, rhs;" << endl
+             << "            it_ = block + j;" << endl;
+      writeModelLocalVariables(output, oCDynamicBatchModel, tef_terms);
+      writeTemporaryTerms(with_jacobian ? jacobian_temporary_terms : temporary_terms_res, temp_term_empty,
+                          output, oCDynamicBatchModel, tef_terms);
+      writeModelEquations(output, oCDynamicBatchModel);
+      if (with_jacobian)
+        writeDynamicJacobian(output, oCDynamicBatchModel, temp_term_union, tef_terms);
+      output << "          }" << endl;
+    }
+  output << endl
+         << "      for (i = 0; i < " << equations.size() << "; i++)" << endl
+         << "        for (j = 0; j < nb_points; j++)" << endl
+         << "          residual[block+j+i*nb_row_y] = residual_block[j+i*DYNARE_BATCH_SIZE];" << endl
+         << "      if (g1 != NULL)" << endl
+         << "        for (i = 0; i < " << first_derivatives.size() << "; i++)" << endl
+         << "          for (j = 0; j < nb_points; j++)" << endl
+         << "            g1[block+j+i*nb_row_y] = g1_block[j+i*DYNARE_BATCH_SIZE];" << endl
+         << "    }" << endl
+         << endl
+         << "  free(residual_block);" << endl
+         << "  free(g1_block);" << endl
+         << "}" << endl << endl;
+}
+
 void
 DynamicModel::writeOutput(ostream &output, const string &basename, bool block_decomposition, bool byte_code, bool use_dll, int order, bool estimation_present, bool compute_xrefs, bool julia) const
 {
@@ -3107,6 +3378,12 @@ DynamicModel::writeOutput(ostream &output, const string &basename, bool block_de
     output << NNZDerivatives[2];
   else
     output << "-1";
+  // Above order 3, only the derivatives w.r. to sorted variables are counted
+  for (int k = 4; k <= order; k++)
+    if (k - 4 < (int) higher_derivatives.size())
+      output << "; " << higher_derivatives[k-4].size();
+    else
+      output << "; -1";
   output << "];" << endl;
 }
 
@@ -3136,11 +3413,12 @@ DynamicModel::runTrendTest(const eval_context_t &eval_context)
 }
 
 void
-DynamicModel::computingPass(bool jacobianExo, bool hessian, bool thirdDerivatives, int paramsDerivsOrder,
+DynamicModel::computingPass(bool jacobianExo, bool hessian, bool thirdDerivatives, int higherDerivsOrder, int paramsDerivsOrder,
                             const eval_context_t &eval_context, bool no_tmp_terms, bool block, bool use_dll,
                             bool bytecode, bool compute_xrefs)
 {
   assert(jacobianExo || !(hessian || thirdDerivatives || paramsDerivsOrder));
+  assert(thirdDerivatives || higherDerivsOrder <= 3);
 
   initializeVariablesAndEquations();
   
@@ -3161,8 +3439,10 @@ DynamicModel::computingPass(bool jacobianExo, bool hessian, bool thirdDerivative
     }
 
   // Launch computations
-  cout << "Computing dynamic model derivatives:" << endl
-       << " - order 1" << endl;
+  cout << "Computing dynamic model derivatives:" << endl;
+  int order = (thirdDerivatives ? 3 : hessian ? 2 : 1);
+  loadDerivativesCache(vars, order);
+  cout << " - order 1" << endl;
   computeJacobian(vars);
 
   if (hessian)
@@ -3186,6 +3466,14 @@ DynamicModel::computingPass(bool jacobianExo, bool hessian, bool thirdDerivative
       computeThirdDerivatives(vars);
     }
 
+  saveDerivativesCache(order);
+
+  for (int k = 4; k <= higherDerivsOrder; k++)
+    {
+      cout << " - order " << k << endl;
+      computeHigherDerivatives(vars, k);
+    }
+
   if (block)
     {
       vector<unsigned int> n_static, n_forward, n_backward, n_mixed;
@@ -4589,8 +4877,21 @@ DynamicModel::isChecksumMatching(const string &basename) const
            << equation_tags[i].second.first
            << equation_tags[i].second.second;
 
+  // The orders of the derivatives written in the C file
+  buffer << "derivatives " << NNZDerivatives[1] << " " << NNZDerivatives[2]
+         << " " << higher_derivatives.size() << endl;
+
   ExprNodeOutputType buffer_type = oCDynamicModel;
 
+  // Write the model local variables, which appear only by their names in the equations
+  for (map<int, expr_t>::const_iterator it = local_variables_table.begin();
+       it != local_variables_table.end(); it++)
+    {
+      buffer << symbol_table.getName(it->first) << " = ";
+      it->second->writeOutput(buffer, buffer_type, temporary_terms);
+      buffer << ";" << endl;
+    }
+
   for (int eq = 0; eq < (int) equations.size(); eq++)
     {
       BinaryOpNode *eq_node = equations[eq];
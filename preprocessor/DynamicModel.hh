@@ -84,8 +84,26 @@ private:
   //! Writes dynamic model file when SparseDLL option is on
   void writeSparseDynamicMFile(const string &dynamic_basename, const string &basename) const;
   //! Writes the dynamic model equations and its derivatives
-  /*! \todo add third derivatives handling in C output */
-  void writeDynamicModel(ostream &DynamicOutput, bool use_dll, bool julia) const;
+  /*! \todo add third derivatives handling in C output
+      \param c_basename base name of the C chunk files, when the C code is split (see split_c_files) */
+  void writeDynamicModel(ostream &DynamicOutput, bool use_dll, bool julia, const string &c_basename = "") const;
+  //! Writes the assignments of the Jacobian
+  void writeDynamicJacobian(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                            deriv_node_temp_terms_t &tef_terms, vector<CStatement> *statements = NULL) const;
+  //! Writes the assignments of the Hessian (in sparse form, except for Julia)
+  void writeDynamicHessian(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                           deriv_node_temp_terms_t &tef_terms, vector<CStatement> *statements = NULL) const;
+  //! Writes the assignments of the third derivatives (in sparse form, except for Julia)
+  void writeDynamicThirdDerivatives(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                                    deriv_node_temp_terms_t &tef_terms, vector<CStatement> *statements = NULL) const;
+  //! Writes the C functions Dynamic_resid, Dynamic_g1, Dynamic_g2 and Dynamic_g3
+  /*! Each of them computes only one output, and only the temporary terms that this output needs */
+  void writeDynamicPerOrderCFunctions(ostream &output) const;
+  //! Writes the C functions Dynamic_g4, Dynamic_g5... computing the derivatives of order 4 and above
+  void writeDynamicHigherDerivativesCFunctions(ostream &output) const;
+  //! Writes the C functions Dynamic_batch and Dynamic_batch_g1_sparsity
+  /*! Dynamic_batch evaluates the residuals and the sparse Jacobian at several points in a single call */
+  void writeDynamicBatchCFunction(ostream &output) const;
   //! Writes the Block reordred structure of the model in M output
   void writeModelEquationsOrdered_M(const string &dynamic_basename) const;
   //! Writes the code of the Block reordred structure of the model in virtual machine bytecode
@@ -208,11 +226,12 @@ public:
     \param jacobianExo whether derivatives w.r. to exo and exo_det should be in the Jacobian (derivatives w.r. to endo are always computed)
     \param hessian whether 2nd derivatives w.r. to exo, exo_det and endo should be computed (implies jacobianExo = true)
     \param thirdDerivatives whether 3rd derivatives w.r. to endo/exo/exo_det should be computed (implies jacobianExo = true)
+    \param higherDerivsOrder if greater than 3, derivatives of orders 4 to higherDerivsOrder w.r. to endo/exo/exo_det are also computed (implies thirdDerivatives = true)
     \param paramsDerivsOrder order of derivatives w.r. to a pair (endo/exo/exo_det, parameter) to be computed (>0 implies jacobianExo = true)
     \param eval_context evaluation context for normalization
     \param no_tmp_terms if true, no temporary terms will be computed in the dynamic files
   */
-  void computingPass(bool jacobianExo, bool hessian, bool thirdDerivatives, int paramsDerivsOrder,
+  void computingPass(bool jacobianExo, bool hessian, bool thirdDerivatives, int higherDerivsOrder, int paramsDerivsOrder,
                      const eval_context_t &eval_context, bool no_tmp_terms, bool block, bool use_dll, bool bytecode, bool compute_xrefs);
   //! Writes model initialization and lead/lag incidence matrix to output
   void writeOutput(ostream &output, const string &basename, bool block, bool byte_code, bool use_dll, int order, bool estimation_present, bool compute_xrefs, bool julia) const;
@@ -41,7 +41,7 @@ void main2(stringstream &in, string &basename, bool debug, bool clear_all, bool
            bool nograph, bool nointeractive, bool parallel, ConfigFile &config_file,
            WarningConsolidation &warnings_arg, bool nostrict, bool check_model_changes,
            bool minimal_workspace, bool compute_xrefs, FileOutputType output_mode,
-           LanguageOutputType lang, int params_derivs_order
+           LanguageOutputType lang, int params_derivs_order, int nthreads, int split_c_files
 #if defined(_WIN32) || defined(__CYGWIN32__)
            , bool cygwin, bool msvc
 #endif
@@ -57,7 +57,7 @@ usage()
   cerr << "Dynare usage: dynare mod_file [debug] [noclearall] [onlyclearglobals] [savemacro[=macro_file]] [onlymacro] [nolinemacro] [notmpterms] [nolog] [warn_uninit]"
        << " [console] [nograph] [nointeractive] [parallel[=cluster_name]] [conffile=parallel_config_path_and_filename] [parallel_slave_open_mode] [parallel_test]"
        << " [-D<variable>[=<value>]] [-I/path] [nostrict] [fast] [minimal_workspace] [compute_xrefs] [output=dynamic|first|second|third] [language=C|C++|julia]"
-       << " [params_derivs_order=0|1|2]"
+       << " [params_derivs_order=0|1|2] [nthreads=N] [split_c_files=N]"
 #if defined(_WIN32) || defined(__CYGWIN32__)
        << " [cygwin] [msvc]"
 #endif
@@ -92,6 +92,8 @@ main(int argc, char **argv)
   bool no_log = false;
   bool no_warn = false;
   int params_derivs_order = 2;
+  int nthreads = 0;
+  int split_c_files = 0;
   bool warn_uninit = false;
   bool console = false;
   bool nograph = false;
@@ -131,6 +133,24 @@ main(int argc, char **argv)
             }
           params_derivs_order = atoi(argv[arg] + 20);
         }
+      else if (strlen(argv[arg]) >= 8 && !strncmp(argv[arg], "nthreads", 8))
+        {
+          if (strlen(argv[arg]) <= 9 || argv[arg][8] != '=' || atoi(argv[arg] + 9) <= 0)
+            {
+              cerr << "Incorrect syntax for nthreads option" << endl;
+              usage();
+            }
+          nthreads = atoi(argv[arg] + 9);
+        }
+      else if (strlen(argv[arg]) >= 13 && !strncmp(argv[arg], "split_c_files", 13))
+        {
+          if (strlen(argv[arg]) <= 14 || argv[arg][13] != '=' || atoi(argv[arg] + 14) <= 0)
+            {
+              cerr << "Incorrect syntax for split_c_files option" << endl;
+              usage();
+            }
+          split_c_files = atoi(argv[arg] + 14);
+        }
       else if (!strcmp(argv[arg], "onlyclearglobals"))
         {
           clear_all = false;
@@ -330,7 +350,7 @@ main(int argc, char **argv)
   main2(macro_output, basename, debug, clear_all, clear_global,
         no_tmp_terms, no_log, no_warn, warn_uninit, console, nograph, nointeractive,
         parallel, config_file, warnings, nostrict, check_model_changes, minimal_workspace,
-        compute_xrefs, output_mode, language, params_derivs_order
+        compute_xrefs, output_mode, language, params_derivs_order, nthreads, split_c_files
 #if defined(_WIN32) || defined(__CYGWIN32__)
         , cygwin, msvc
 #endif
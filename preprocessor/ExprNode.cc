@@ -50,20 +50,63 @@ ExprNode::getDerivative(int deriv_id)
     prepareForDerivation();
 
   // Return zero if derivative is necessarily null (using symbolic a priori)
-  set<int>::const_iterator it = non_null_derivatives.find(deriv_id);
-  if (it == non_null_derivatives.end())
+  if (!isNonNullDerivative(deriv_id))
     return datatree.Zero;
 
   // If derivative is stored in cache, use the cached value, otherwise compute it (and cache it)
-  map<int, expr_t>::const_iterator it2 = derivatives.find(deriv_id);
-  if (it2 != derivatives.end())
-    return it2->second;
-  else
+  expr_t d = getCachedDerivative(deriv_id);
+  if (d == NULL)
     {
-      expr_t d = computeDerivative(deriv_id);
-      derivatives[deriv_id] = d;
-      return d;
+      d = computeDerivative(deriv_id);
+      cacheDerivative(deriv_id, d);
     }
+  return d;
+}
+
+//! Object used to search a derivation ID in the derivative cache
+struct DerivativeCacheLess
+{
+  bool
+  operator()(const pair<int, expr_t> &entry, int deriv_id) const
+  {
+    return entry.first < deriv_id;
+  }
+};
+
+bool
+ExprNode::isNonNullDerivative(int deriv_id) const
+{
+  return binary_search(non_null_derivatives.begin(), non_null_derivatives.end(), deriv_id);
+}
+
+expr_t
+ExprNode::getCachedDerivative(int deriv_id) const
+{
+  vector<pair<int, expr_t> >::const_iterator it
+    = lower_bound(derivatives.begin(), derivatives.end(), deriv_id, DerivativeCacheLess());
+  if (it != derivatives.end() && it->first == deriv_id)
+    return it->second;
+  else
+    return NULL;
+}
+
+void
+ExprNode::cacheDerivative(int deriv_id, expr_t d)
+{
+  vector<pair<int, expr_t> >::iterator it
+    = lower_bound(derivatives.begin(), derivatives.end(), deriv_id, DerivativeCacheLess());
+  if (it != derivatives.end() && it->first == deriv_id)
+    it->second = d;
+  else
+    derivatives.insert(it, make_pair(deriv_id, d));
+}
+
+void
+ExprNode::unionNonNullDerivatives(const vector<int> &a, const vector<int> &b, vector<int> &result)
+{
+  result.clear();
+  result.reserve(a.size() + b.size());
+  set_union(a.begin(), a.end(), b.begin(), b.end(), back_inserter(result));
 }
 
 int
@@ -131,6 +174,12 @@ ExprNode::computeTemporaryTerms(map<expr_t, pair<int, NodeTreeReference> > &refe
   // Nothing to do for a terminal node
 }
 
+void
+ExprNode::collectTemporaryTermsArguments(vector<expr_t> &args) const
+{
+  // Nothing to do for a terminal node or an external function
+}
+
 void
 ExprNode::computeTemporaryTerms(map<expr_t, int> &reference_count,
                                 temporary_terms_t &temporary_terms,
@@ -547,7 +596,7 @@ VariableNode::prepareForDerivation()
     case eTrend:
     case eLogTrend:
       // For a variable or a parameter, the only non-null derivative is with respect to itself
-      non_null_derivatives.insert(datatree.getDerivID(symb_id, lag));
+      non_null_derivatives.push_back(datatree.getDerivID(symb_id, lag));
       break;
     case eModelLocalVariable:
       datatree.local_variables_table[symb_id]->prepareForDerivation();
@@ -695,6 +744,10 @@ VariableNode::writeOutput(ostream &output, ExprNodeOutputType output_type,
           i = tsid + (lag+1)*datatree.symbol_table.endo_nbr() + ARRAY_SUBSCRIPT_OFFSET(output_type);
           output <<  "y" << LEFT_ARRAY_SUBSCRIPT(output_type) << i << RIGHT_ARRAY_SUBSCRIPT(output_type);
           break;
+        case oCDynamicBatchModel:
+          i = datatree.getDynJacobianCol(datatree.getDerivID(symb_id, lag));
+          output << "y[it_+" << i << "*nb_row_y]";
+          break;
         case oCStaticModel:
         case oJuliaStaticModel:
         case oMatlabStaticModel:
@@ -754,6 +807,7 @@ VariableNode::writeOutput(ostream &output, ExprNodeOutputType output_type,
           break;
         case oCDynamicModel:
         case oCDynamic2Model:
+        case oCDynamicBatchModel:
           if (lag == 0)
             output <<  "x[it_+" << i << "*nb_row_x]";
           else if (lag > 0)
@@ -806,6 +860,7 @@ VariableNode::writeOutput(ostream &output, ExprNodeOutputType output_type,
           break;
         case oCDynamicModel:
         case oCDynamic2Model:
+        case oCDynamicBatchModel:
           if (lag == 0)
             output <<  "x[it_+" << i << "*nb_row_x]";
           else if (lag > 0)
@@ -1021,17 +1076,17 @@ VariableNode::getChainRuleDerivative(int deriv_id, const map<int, expr_t> &recur
           map<int, expr_t>::const_iterator it = recursive_variables.find(datatree.getDerivID(symb_id, lag));
           if (it != recursive_variables.end())
             {
-              map<int, expr_t>::const_iterator it2 = derivatives.find(deriv_id);
-              if (it2 != derivatives.end())
-                return it2->second;
+              expr_t d = getCachedDerivative(deriv_id);
+              if (d != NULL)
+                return d;
               else
                 {
                   map<int, expr_t> recursive_vars2(recursive_variables);
                   recursive_vars2.erase(it->first);
                   //expr_t c = datatree.AddNonNegativeConstant("1");
-                  expr_t d = datatree.AddUMinus(it->second->getChainRuleDerivative(deriv_id, recursive_vars2));
+                  d = datatree.AddUMinus(it->second->getChainRuleDerivative(deriv_id, recursive_vars2));
                   //d = datatree.AddTimes(c, d);
-                  derivatives[deriv_id] = d;
+                  cacheDerivative(deriv_id, d);
                   return d;
                 }
             }
@@ -1527,10 +1582,16 @@ UnaryOpNode::prepareForDerivation()
   arg->prepareForDerivation();
 
   // Non-null derivatives are those of the argument (except for STEADY_STATE)
-  non_null_derivatives = arg->non_null_derivatives;
   if (op_code == oSteadyState || op_code == oSteadyStateParamDeriv
       || op_code == oSteadyStateParam2ndDeriv)
-    datatree.addAllParamDerivId(non_null_derivatives);
+    {
+      set<int> param_deriv_id_set;
+      datatree.addAllParamDerivId(param_deriv_id_set);
+      vector<int> param_deriv_ids(param_deriv_id_set.begin(), param_deriv_id_set.end());
+      unionNonNullDerivatives(arg->non_null_derivatives, param_deriv_ids, non_null_derivatives);
+    }
+  else
+    non_null_derivatives = arg->non_null_derivatives;
 }
 
 expr_t
@@ -1807,6 +1868,12 @@ UnaryOpNode::computeTemporaryTerms(map<expr_t, pair<int, NodeTreeReference> > &r
     }
 }
 
+void
+UnaryOpNode::collectTemporaryTermsArguments(vector<expr_t> &args) const
+{
+  args.push_back(arg);
+}
+
 void
 UnaryOpNode::computeTemporaryTerms(map<expr_t, int> &reference_count,
                                    temporary_terms_t &temporary_terms,
@@ -1930,7 +1997,7 @@ UnaryOpNode::writeOutput(ostream &output, ExprNodeOutputType output_type,
       output << "abs";
       break;
     case oSign:
-      if (output_type == oCDynamicModel || output_type == oCStaticModel)
+      if (output_type == oCDynamicModel || output_type == oCDynamicBatchModel || output_type == oCStaticModel)
         output << "copysign";
       else
         output << "sign";
@@ -1946,6 +2013,7 @@ UnaryOpNode::writeOutput(ostream &output, ExprNodeOutputType output_type,
           new_output_type = oLatexDynamicSteadyStateOperator;
           break;
         case oCDynamicModel:
+        case oCDynamicBatchModel:
           new_output_type = oCDynamicSteadyStateOperator;
           break;
         case oJuliaDynamicModel:
@@ -2020,7 +2088,8 @@ UnaryOpNode::writeOutput(ostream &output, ExprNodeOutputType output_type,
           && arg->precedence(output_type, temporary_terms) < precedence(output_type, temporary_terms)))
     {
       output << LEFT_PAR(output_type);
-      if (op_code == oSign && (output_type == oCDynamicModel || output_type == oCStaticModel))
+      if (op_code == oSign && (output_type == oCDynamicModel || output_type == oCDynamicBatchModel
+                               || output_type == oCStaticModel))
         output << "1.0,";
       close_parenthesis = true;
     }
@@ -2621,11 +2690,7 @@ BinaryOpNode::prepareForDerivation()
 
   // Non-null derivatives are the union of those of the arguments
   // Compute set union of arg1->non_null_derivatives and arg2->non_null_derivatives
-  set_union(arg1->non_null_derivatives.begin(),
-            arg1->non_null_derivatives.end(),
-            arg2->non_null_derivatives.begin(),
-            arg2->non_null_derivatives.end(),
-            inserter(non_null_derivatives, non_null_derivatives.begin()));
+  unionNonNullDerivatives(arg1->non_null_derivatives, arg2->non_null_derivatives, non_null_derivatives);
 }
 
 expr_t
@@ -2923,6 +2988,13 @@ BinaryOpNode::computeTemporaryTerms(map<expr_t, pair<int, NodeTreeReference> > &
     }
 }
 
+void
+BinaryOpNode::collectTemporaryTermsArguments(vector<expr_t> &args) const
+{
+  args.push_back(arg1);
+  args.push_back(arg2);
+}
+
 void
 BinaryOpNode::computeTemporaryTerms(map<expr_t, int> &reference_count,
                                     temporary_terms_t &temporary_terms,
@@ -3918,17 +3990,9 @@ TrinaryOpNode::prepareForDerivation()
 
   // Non-null derivatives are the union of those of the arguments
   // Compute set union of arg{1,2,3}->non_null_derivatives
-  set<int> non_null_derivatives_tmp;
-  set_union(arg1->non_null_derivatives.begin(),
-            arg1->non_null_derivatives.end(),
-            arg2->non_null_derivatives.begin(),
-            arg2->non_null_derivatives.end(),
-            inserter(non_null_derivatives_tmp, non_null_derivatives_tmp.begin()));
-  set_union(non_null_derivatives_tmp.begin(),
-            non_null_derivatives_tmp.end(),
-            arg3->non_null_derivatives.begin(),
-            arg3->non_null_derivatives.end(),
-            inserter(non_null_derivatives, non_null_derivatives.begin()));
+  vector<int> non_null_derivatives_tmp;
+  unionNonNullDerivatives(arg1->non_null_derivatives, arg2->non_null_derivatives, non_null_derivatives_tmp);
+  unionNonNullDerivatives(non_null_derivatives_tmp, arg3->non_null_derivatives, non_null_derivatives);
 }
 
 expr_t
@@ -4105,6 +4169,14 @@ TrinaryOpNode::computeTemporaryTerms(map<expr_t, pair<int, NodeTreeReference> >
     }
 }
 
+void
+TrinaryOpNode::collectTemporaryTermsArguments(vector<expr_t> &args) const
+{
+  args.push_back(arg1);
+  args.push_back(arg2);
+  args.push_back(arg3);
+}
+
 void
 TrinaryOpNode::computeTemporaryTerms(map<expr_t, int> &reference_count,
                                      temporary_terms_t &temporary_terms,
@@ -4579,11 +4651,11 @@ AbstractExternalFunctionNode::prepareForDerivation()
 
   non_null_derivatives = arguments.at(0)->non_null_derivatives;
   for (int i = 1; i < (int) arguments.size(); i++)
-    set_union(non_null_derivatives.begin(),
-              non_null_derivatives.end(),
-              arguments.at(i)->non_null_derivatives.begin(),
-              arguments.at(i)->non_null_derivatives.end(),
-              inserter(non_null_derivatives, non_null_derivatives.begin()));
+    {
+      vector<int> non_null_derivatives_tmp;
+      non_null_derivatives_tmp.swap(non_null_derivatives);
+      unionNonNullDerivatives(non_null_derivatives_tmp, arguments.at(i)->non_null_derivatives, non_null_derivatives);
+    }
 
   preparedForDerivation = true;
 }
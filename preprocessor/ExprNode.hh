@@ -38,6 +38,7 @@ class BinaryOpNode;
 typedef class ExprNode *expr_t;
 
 struct ExprNodeLess;
+struct ExprNodeHash;
 
 //! Type for set of temporary terms
 /*! They are ordered by index number thanks to ExprNodeLess */
@@ -64,6 +65,7 @@ enum ExprNodeOutputType
     oMatlabDynamicModelSparse,                    //!< Matlab code, dynamic block decomposed model
     oCDynamicModel,                               //!< C code, dynamic model
     oCDynamic2Model,                              //!< C code, dynamic model, alternative numbering of endogenous variables
+    oCDynamicBatchModel,                          //!< C code, dynamic model, evaluated at several points (in Dynamic_batch)
     oCStaticModel,                                //!< C code, static model
     oJuliaStaticModel,                            //!< Julia code, static model
     oJuliaDynamicModel,                           //!< Julia code, dynamic model
@@ -96,6 +98,7 @@ enum ExprNodeOutputType
 
 #define IS_C(output_type) ((output_type) == oCDynamicModel \
 			   || (output_type) == oCDynamic2Model \
+			   || (output_type) == oCDynamicBatchModel \
 			   || (output_type) == oCStaticModel \
 			   || (output_type) == oCDynamicSteadyStateOperator \
 			   || (output_type) == oCSteadyStateFile)
@@ -121,6 +124,15 @@ enum ExprNodeOutputType
 #define MIN_COST_C (40*4)
 #define MIN_COST(is_matlab) ((is_matlab) ? MIN_COST_MATLAB : MIN_COST_C)
 
+// Cost of a temporary term (assignment, storage and reads), which must be
+// exceeded by the cost of the evaluations that it saves
+#define TEMPORARY_TERM_COST_MATLAB (MIN_COST_MATLAB/2)
+#define TEMPORARY_TERM_COST_C (2*4)
+#define TEMPORARY_TERM_COST(is_matlab) ((is_matlab) ? TEMPORARY_TERM_COST_MATLAB : TEMPORARY_TERM_COST_C)
+
+// Cost of an addition, used to express the costs in floating point operations
+#define ADDITION_COST(is_matlab) ((is_matlab) ? 90 : 4)
+
 //! Base class for expression nodes
 class ExprNode
 {
@@ -129,6 +141,7 @@ class ExprNode
   friend class StaticModel;
   friend class ModelTree;
   friend struct ExprNodeLess;
+  friend struct ExprNodeHash;
   friend class NumConstNode;
   friend class VariableNode;
   friend class UnaryOpNode;
@@ -150,11 +163,22 @@ protected:
   //! Is the data member non_null_derivatives initialized ?
   bool preparedForDerivation;
 
-  //! Set of derivation IDs with respect to which the derivative is potentially non-null
-  set<int> non_null_derivatives;
+  //! Derivation IDs with respect to which the derivative is potentially non-null
+  /*! Stored as a sorted vector without duplicates: it is computed once by a set union of the vectors of the arguments, and afterwards only searched by bisection */
+  vector<int> non_null_derivatives;
 
   //! Used for caching of first order derivatives (when non-null)
-  map<int, expr_t> derivatives;
+  /*! Pairs (derivation ID, derivative), sorted by derivation ID */
+  vector<pair<int, expr_t> > derivatives;
+
+  //! Returns true if the derivative with respect to deriv_id is potentially non-null
+  bool isNonNullDerivative(int deriv_id) const;
+  //! Returns the cached derivative with respect to deriv_id, or NULL if it has not been computed yet
+  expr_t getCachedDerivative(int deriv_id) const;
+  //! Stores a derivative in the cache
+  void cacheDerivative(int deriv_id, expr_t d);
+  //! Computes the union of two sorted vectors of derivation IDs
+  static void unionNonNullDerivatives(const vector<int> &a, const vector<int> &b, vector<int> &result);
 
   //! Cost of computing current node
   /*! Nodes included in temporary_terms are considered having a null cost */
@@ -200,6 +224,12 @@ public:
                                      map<NodeTreeReference, temporary_terms_t> &temp_terms_map,
                                      bool is_matlab, NodeTreeReference tr) const;
 
+  //! Adds to args the arguments of the node which can be temporary terms
+  /*! Used by the cost-aware computation of temporary terms of ModelTree. The
+    arguments of external functions are not added, since these nodes are always
+    temporary terms and their arguments are written inline. */
+  virtual void collectTemporaryTermsArguments(vector<expr_t> &args) const;
+
   //! Writes output of node, using a Txxx notation for nodes in temporary_terms, and specifiying the set of already written external functions
   /*!
     \param[in] output the output stream
@@ -461,6 +491,19 @@ struct ExprNodeLess
   }
 };
 
+//! Object used to hash a node (using its index)
+/*! Since a DataTree never creates two nodes for the same expression, the
+  index identifies the whole expression below the node, and it is a valid
+  structural hash (which, unlike the address, does not vary between runs) */
+struct ExprNodeHash
+{
+  size_t
+  operator()(expr_t arg) const
+  {
+    return (size_t) arg->idx;
+  }
+};
+
 //! Numerical constant node
 /*! The constant is necessarily non-negative (this is enforced at the NumericalConstants class level) */
 class NumConstNode : public ExprNode
@@ -601,6 +644,7 @@ public:
   virtual void computeTemporaryTerms(map<expr_t, pair<int, NodeTreeReference> > &reference_count,
                                      map<NodeTreeReference, temporary_terms_t> &temp_terms_map,
                                      bool is_matlab, NodeTreeReference tr) const;
+  virtual void collectTemporaryTermsArguments(vector<expr_t> &args) const;
   virtual void writeOutput(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms, deriv_node_temp_terms_t &tef_terms) const;
   virtual bool containsExternalFunction() const;
   virtual void writeExternalFunctionOutput(ostream &output, ExprNodeOutputType output_type,
@@ -688,6 +732,7 @@ public:
   virtual void computeTemporaryTerms(map<expr_t, pair<int, NodeTreeReference> > &reference_count,
                                      map<NodeTreeReference, temporary_terms_t> &temp_terms_map,
                                      bool is_matlab, NodeTreeReference tr) const;
+  virtual void collectTemporaryTermsArguments(vector<expr_t> &args) const;
   virtual void writeOutput(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms, deriv_node_temp_terms_t &tef_terms) const;
   virtual bool containsExternalFunction() const;
   virtual void writeExternalFunctionOutput(ostream &output, ExprNodeOutputType output_type,
@@ -793,6 +838,7 @@ public:
   virtual void computeTemporaryTerms(map<expr_t, pair<int, NodeTreeReference> > &reference_count,
                                      map<NodeTreeReference, temporary_terms_t> &temp_terms_map,
                                      bool is_matlab, NodeTreeReference tr) const;
+  virtual void collectTemporaryTermsArguments(vector<expr_t> &args) const;
   virtual void writeOutput(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms, deriv_node_temp_terms_t &tef_terms) const;
   virtual bool containsExternalFunction() const;
   virtual void writeExternalFunctionOutput(ostream &output, ExprNodeOutputType output_type,
@@ -824,6 +870,30 @@ public:
   virtual int maxLead() const;
   virtual expr_t decreaseLeadsLags(int n) const;
   virtual expr_t substituteEndoLeadGreaterThanTwo(subst_table_t &subst_table, vector<BinaryOpNode *> &neweqs, bool deterministic_model) const;
+  //! Returns first operand
+  expr_t
+  get_arg1() const
+  {
+    return (arg1);
+  };
+  //! Returns second operand
+  expr_t
+  get_arg2() const
+  {
+    return (arg2);
+  };
+  //! Returns third operand
+  expr_t
+  get_arg3() const
+  {
+    return (arg3);
+  };
+  //! Returns op code
+  TrinaryOpcode
+  get_op_code() const
+  {
+    return (op_code);
+  };
   //! Creates another TrinaryOpNode with the same opcode, but with a possibly different datatree and arguments
   expr_t buildSimilarTrinaryOpNode(expr_t alt_arg1, expr_t alt_arg2, expr_t alt_arg3, DataTree &alt_datatree) const;
   virtual expr_t substituteEndoLagGreaterThanTwo(subst_table_t &subst_table, vector<BinaryOpNode *> &neweqs) const;
@@ -911,6 +981,18 @@ public:
   virtual expr_t substituteExoLag(subst_table_t &subst_table, vector<BinaryOpNode *> &neweqs) const;
   virtual expr_t substituteExpectation(subst_table_t &subst_table, vector<BinaryOpNode *> &neweqs, bool partial_information_model) const;
   virtual expr_t buildSimilarExternalFunctionNode(vector<expr_t> &alt_args, DataTree &alt_datatree) const = 0;
+  //! Returns the arguments of the external function
+  const vector<expr_t> &
+  get_arguments() const
+  {
+    return arguments;
+  };
+  //! Returns the symbol ID of the external function (not of its derivatives)
+  int
+  get_symb_id() const
+  {
+    return symb_id;
+  };
   virtual expr_t decreaseLeadsLagsPredeterminedVariables() const;
   virtual expr_t differentiateForwardVars(const vector<string> &subset, subst_table_t &subst_table, vector<BinaryOpNode *> &neweqs) const;
   virtual bool isNumConstNodeEqualTo(double value) const;
@@ -118,8 +118,9 @@ namespace MFS
   }
 
   AdjacencyList_t
-  AM_2_AdjacencyList(bool *AM, unsigned int n)
+  AM_2_AdjacencyList(const SparseIncidence &AM)
   {
+    unsigned int n = AM.getNRows();
     AdjacencyList_t G(n);
     property_map<AdjacencyList_t, vertex_index_t>::type v_index = get(vertex_index, G);
     property_map<AdjacencyList_t, vertex_index1_t>::type v_index1 = get(vertex_index1, G);
@@ -129,9 +130,8 @@ namespace MFS
         put(v_index1, vertex(i, G), i);
       }
     for (unsigned int i = 0; i < n; i++)
-      for (unsigned int j = 0; j < n; j++)
-        if (AM[i*n+j])
-          add_edge(vertex(j, G), vertex(i, G), G);
+      for (int k = AM.rowBegin(i); k < AM.rowEnd(i); k++)
+        add_edge(vertex(AM.colIndex(k), G), vertex(i, G), G);
     return G;
   }
 
@@ -24,6 +24,8 @@
 #include <vector>
 #include <boost/graph/adjacency_list.hpp>
 
+#include "SparseIncidence.hh"
+
 using namespace std;
 using namespace boost;
 
@@ -55,8 +57,9 @@ namespace MFS
   bool Suppression_of_Vertex_X_if_it_loops_store_in_set_of_feedback_vertex_Step(set<int> &feed_back_vertices, AdjacencyList_t &G1);
   //! Print the Graph
   void Print(AdjacencyList_t &G);
-  //! Create an adjacency graph from a Adjacency Matrix (an incidence Matrix without the diagonal terms)
-  AdjacencyList_t AM_2_AdjacencyList(bool *AMp, unsigned int n);
+  //! Create an adjacency graph from a sparse Adjacency Matrix (an incidence Matrix without the diagonal terms)
+  /*! A nonzero element (i, j) gives an edge from vertex j to vertex i */
+  AdjacencyList_t AM_2_AdjacencyList(const SparseIncidence &AM);
   //! Extracts a subgraph
   /*!
     \param[in] G1 The original graph
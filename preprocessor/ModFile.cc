@@ -469,11 +469,34 @@ ModFile::transformPass(bool nostrict)
 }
 
 void
-ModFile::computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xrefs, int params_derivs_order)
+ModFile::computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xrefs, int params_derivs_order, int nthreads, int split_c_files,
+                       const string &derivatives_cache_dir)
 {
   // Mod file may have no equation (for example in a standalone BVAR estimation)
   if (dynamic_model.equation_number() > 0)
     {
+      static_model.nthreads = nthreads;
+      dynamic_model.nthreads = nthreads;
+
+      if (!derivatives_cache_dir.empty())
+        {
+          static_model.derivatives_cache_file = derivatives_cache_dir + "/static_derivatives.cache";
+          dynamic_model.derivatives_cache_file = derivatives_cache_dir + "/dynamic_derivatives.cache";
+        }
+
+      if (split_c_files > 0)
+        {
+          if (!use_dll)
+            warnings << "WARNING: The 'split_c_files' option is ignored without the 'use_dll' option" << endl;
+          else if (external_functions_table.get_total_number_of_unique_model_block_external_functions())
+            warnings << "WARNING: The 'split_c_files' option is ignored, since the model uses external functions" << endl;
+          else
+            {
+              static_model.split_c_files = split_c_files;
+              dynamic_model.split_c_files = split_c_files;
+            }
+        }
+
       if (nonstationary_variables)
         trend_dynamic_model.runTrendTest(global_eval_context);
 
@@ -503,7 +526,7 @@ ModFile::computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xr
 	  || mod_file_struct.calib_smoother_present)
 	{
 	  if (mod_file_struct.perfect_foresight_solver_present)
-	    dynamic_model.computingPass(true, false, false, none, global_eval_context, no_tmp_terms, block, use_dll, byte_code, compute_xrefs);
+	    dynamic_model.computingPass(true, false, false, 0, none, global_eval_context, no_tmp_terms, block, use_dll, byte_code, compute_xrefs);
 	      else
 		{
 		  if (mod_file_struct.stoch_simul_present
@@ -511,28 +534,34 @@ ModFile::computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xr
 		      || mod_file_struct.ramsey_model_present || mod_file_struct.identification_present
 		      || mod_file_struct.calib_smoother_present)
 		    dynamic_model.set_cutoff_to_zero();
-		  if (mod_file_struct.order_option < 1 || mod_file_struct.order_option > 3)
+		  if (mod_file_struct.order_option < 1)
 		    {
 		      cerr << "ERROR: Incorrect order option..." << endl;
 		      exit(EXIT_FAILURE);
 		    }
+		  // Derivatives above order 3 are only written in the C version of the dynamic file
+		  if (mod_file_struct.order_option > 3 && (!use_dll || block))
+		    {
+		      cerr << "ERROR: order > 3 requires the 'use_dll' option, and is incompatible with the 'block' option" << endl;
+		      exit(EXIT_FAILURE);
+		    }
 		  bool hessian = mod_file_struct.order_option >= 2 
 		    || mod_file_struct.identification_present 
 		    || mod_file_struct.estimation_analytic_derivation
                     || linear
 		    || output == second 
 		    || output == third;
-		  bool thirdDerivatives = mod_file_struct.order_option == 3 
+		  bool thirdDerivatives = mod_file_struct.order_option >= 3 
 		    || mod_file_struct.estimation_analytic_derivation
 		    || output == third;
                   int paramsDerivsOrder = 0;
                   if (mod_file_struct.identification_present || mod_file_struct.estimation_analytic_derivation)
                     paramsDerivsOrder = params_derivs_order;
-		  dynamic_model.computingPass(true, hessian, thirdDerivatives, paramsDerivsOrder, global_eval_context, no_tmp_terms, block, use_dll, byte_code, compute_xrefs);
+		  dynamic_model.computingPass(true, hessian, thirdDerivatives, mod_file_struct.order_option, paramsDerivsOrder, global_eval_context, no_tmp_terms, block, use_dll, byte_code, compute_xrefs);
 		}
 	    }
 	  else // No computing task requested, compute derivatives up to 2nd order by default
-	    dynamic_model.computingPass(true, true, false, none, global_eval_context, no_tmp_terms, block, use_dll, byte_code, compute_xrefs);
+	    dynamic_model.computingPass(true, true, false, 0, none, global_eval_context, no_tmp_terms, block, use_dll, byte_code, compute_xrefs);
 
       if (linear && !dynamic_model.checkHessianZero())
         {
@@ -751,15 +780,15 @@ ModFile::writeOutputFiles(const string &basename, bool clear_all, bool clear_glo
 #if defined(_WIN32) || defined(__CYGWIN32__)
       if (msvc)
         // MATLAB/Windows + Microsoft Visual C++
-	mOutputFile << "dyn_mex('msvc', '" << basename << "', " << !check_model_changes << ")" <<  endl;
+	mOutputFile << "dyn_mex('msvc', '" << basename << "', " << !check_model_changes << ", " << dynamic_model.split_c_files << ")" <<  endl;
       else if (cygwin)
         // MATLAB/Windows + Cygwin g++
-	mOutputFile << "dyn_mex('cygwin', '" << basename << "', " << !check_model_changes << ")" << endl;
+	mOutputFile << "dyn_mex('cygwin', '" << basename << "', " << !check_model_changes << ", " << dynamic_model.split_c_files << ")" << endl;
       else
         mOutputFile << "    error('When using the USE_DLL option, you must give either ''cygwin'' or ''msvc'' option to the ''dynare'' command')" << endl;
 #else
       // other configurations
-      mOutputFile << "dyn_mex('', '" << basename << "', " << !check_model_changes << ")" << endl;
+      mOutputFile << "dyn_mex('', '" << basename << "', " << !check_model_changes << ", " << dynamic_model.split_c_files << ")" << endl;
 #endif
     }
 
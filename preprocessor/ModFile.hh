@@ -133,7 +133,11 @@ public:
   /*! \param no_tmp_terms if true, no temporary terms will be computed in the static and dynamic files */
   /*! \param compute_xrefs if true, equation cross references will be computed */
   /*! \param params_derivs_order compute this order of derivs wrt parameters */
-  void computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xrefs, int params_derivs_order);
+  /*! \param nthreads number of threads computing the derivatives of the static and dynamic models (0 for no threads) */
+  /*! \param split_c_files number of files across which the C code of the static and dynamic models is split, with use_dll (0 for no split) */
+  /*! \param derivatives_cache_dir directory of the cache of the derivatives of the static and dynamic models (empty for no cache) */
+  void computingPass(bool no_tmp_terms, FileOutputType output, bool compute_xrefs, int params_derivs_order, int nthreads, int split_c_files,
+                     const string &derivatives_cache_dir);
   //! Writes Matlab/Octave output files
   /*!
     \param basename The base name used for writing output files. Should be the name of the mod file without its extension
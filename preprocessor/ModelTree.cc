@@ -22,11 +22,17 @@
 #include <cmath>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <algorithm>
+#include <cctype>
+#include <pthread.h>
 
 #include "ModelTree.hh"
 #include "MinimumFeedbackSet.hh"
+#include "StagingDataTree.hh"
 #include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/max_cardinality_matching.hpp>
 #include <boost/graph/strong_components.hpp>
 #include <boost/graph/topological_sort.hpp>
 
@@ -40,66 +46,24 @@ ModelTree::computeNormalization(const jacob_map_t &contemporaneous_jacobian, boo
 
   assert(n == symbol_table.endo_nbr());
 
-  typedef adjacency_list<vecS, vecS, undirectedS> BipartiteGraph;
-
   /*
-    Vertices 0 to n-1 are for endogenous (using type specific ID)
-    Vertices n to 2*n-1 are for equations (using equation no.)
+    Rows of the bipartite graph are endogenous (using type specific ID),
+    columns are equations
   */
-  BipartiteGraph g(2 * n);
-
-  // Fill in the graph
-  set<pair<int, int> > endo;
-
+  vector<pair<int, int> > entries;
+  entries.reserve(contemporaneous_jacobian.size());
   for (jacob_map_t::const_iterator it = contemporaneous_jacobian.begin(); it != contemporaneous_jacobian.end(); it++)
-    add_edge(it->first.first + n, it->first.second, g);
+    entries.push_back(make_pair(it->first.second, it->first.first));
+  SparseIncidence g(n, n, entries);
 
   // Compute maximum cardinality matching
-  vector<int> mate_map(2*n);
-
-#if 1
-  bool check = checked_edmonds_maximum_cardinality_matching(g, &mate_map[0]);
-#else // Alternative way to compute normalization, by giving an initial matching using natural normalizations
-  fill(mate_map.begin(), mate_map.end(), graph_traits<BipartiteGraph>::null_vertex());
-
-  multimap<int, int> natural_endo2eqs;
-  computeNormalizedEquations(natural_endo2eqs);
-
-  for (int i = 0; i < symbol_table.endo_nbr(); i++)
-    {
-      if (natural_endo2eqs.count(i) == 0)
-        continue;
-
-      int j = natural_endo2eqs.find(i)->second;
-
-      put(&mate_map[0], i, n+j);
-      put(&mate_map[0], n+j, i);
-    }
-
-  edmonds_augmenting_path_finder<BipartiteGraph, size_t *, property_map<BipartiteGraph, vertex_index_t>::type> augmentor(g, &mate_map[0], get(vertex_index, g));
-  bool not_maximum_yet = true;
-  while (not_maximum_yet)
-    {
-      not_maximum_yet = augmentor.augment_matching();
-    }
-  augmentor.get_current_matching(&mate_map[0]);
-
-  bool check = maximum_cardinality_matching_verifier<BipartiteGraph, size_t *, property_map<BipartiteGraph, vertex_index_t>::type>::verify_matching(g, &mate_map[0], get(vertex_index, g));
-#endif
-
-  assert(check);
+  int cardinality = g.maximumMatching(endo2eq);
 
 #ifdef DEBUG
   for (int i = 0; i < n; i++)
     cout << "Endogenous " << symbol_table.getName(symbol_table.getID(eEndogenous, i))
-         << " matched with equation " << (mate_map[i]-n+1) << endl;
-#endif
-
-  // Create the resulting map, by copying the n first elements of mate_map, and substracting n to them
-  endo2eq.resize(equation_number());
-  transform(mate_map.begin(), mate_map.begin() + n, endo2eq.begin(), bind2nd(minus<int>(), n));
+         << " matched with equation " << (endo2eq[i]+1) << endl;
 
-#ifdef DEBUG
   multimap<int, int> natural_endo2eqs;
   computeNormalizedEquations(natural_endo2eqs);
 
@@ -124,16 +88,18 @@ ModelTree::computeNormalization(const jacob_map_t &contemporaneous_jacobian, boo
 #endif
 
   // Check if all variables are normalized
-  vector<int>::const_iterator it = find(mate_map.begin(), mate_map.begin() + n, graph_traits<BipartiteGraph>::null_vertex());
-  if (it != mate_map.begin() + n)
+  if (cardinality < n)
     {
       if (verbose)
-        cerr << "ERROR: Could not normalize the model. Variable "
-             << symbol_table.getName(symbol_table.getID(eEndogenous, it - mate_map.begin()))
-             << " is not in the maximum cardinality matching." << endl;
-      check = false;
+        {
+          vector<int>::const_iterator it = find(endo2eq.begin(), endo2eq.end(), -1);
+          cerr << "ERROR: Could not normalize the model. Variable "
+               << symbol_table.getName(symbol_table.getID(eEndogenous, it - endo2eq.begin()))
+               << " is not in the maximum cardinality matching." << endl;
+        }
+      return false;
     }
-  return check;
+  return true;
 }
 
 void
@@ -414,36 +380,66 @@ ModelTree::evaluateAndReduceJacobian(const eval_context_t &eval_context, jacob_m
     }
 }
 
+SparseIncidence
+ModelTree::computeStaticIncidence(const jacob_map_t &static_jacobian) const
+{
+  int n = equation_number();
+  vector<pair<int, int> > entries;
+  if (cutoff == 0)
+    {
+      set<pair<int, int> > endo;
+      for (int i = 0; i < n; i++)
+        {
+          endo.clear();
+          equations[i]->collectEndogenous(endo);
+          for (set<pair<int, int> >::const_iterator it = endo.begin(); it != endo.end(); it++)
+            entries.push_back(make_pair(i, it->first));
+        }
+    }
+  else
+    {
+      entries.reserve(static_jacobian.size());
+      for (jacob_map_t::const_iterator it = static_jacobian.begin(); it != static_jacobian.end(); it++)
+        entries.push_back(it->first);
+    }
+  return SparseIncidence(n, symbol_table.endo_nbr(), entries);
+}
+
 void
 ModelTree::computePrologueAndEpilogue(const jacob_map_t &static_jacobian_arg, vector<int> &equation_reordered, vector<int> &variable_reordered)
 {
-  vector<int> eq2endo(equation_number(), 0);
-  equation_reordered.resize(equation_number());
-  variable_reordered.resize(equation_number());
-  bool *IM;
   int n = equation_number();
-  IM = (bool *) calloc(n*n, sizeof(bool));
+  equation_reordered.resize(n);
+  variable_reordered.resize(n);
   int i = 0;
   for (vector<int>::const_iterator it = endo2eq.begin(); it != endo2eq.end(); it++, i++)
     {
-      eq2endo[*it] = i;
       equation_reordered[i] = i;
       variable_reordered[*it] = i;
-    }
-  if (cutoff == 0)
-    {
-      set<pair<int, int> > endo;
-      for (int i = 0; i < n; i++)
-        {
-          endo.clear();
-          equations[i]->collectEndogenous(endo);
-          for (set<pair<int, int> >::const_iterator it = endo.begin(); it != endo.end(); it++)
-            IM[i * n + endo2eq[it->first]] = true;
-        }
-    }
-  else
-    for (jacob_map_t::const_iterator it = static_jacobian_arg.begin(); it != static_jacobian_arg.end(); it++)
-      IM[it->first.first * n + endo2eq[it->first.second]] = true;
+    }
+
+  /*
+    The incidence matrix IM has equations in rows and, in columns, the
+    variables identified by their normalized equation (endo2eq). Instead of
+    permuting the rows and the columns of a dense matrix, we keep IM and its
+    transpose fixed and maintain the permutations: row_pos[i] is the current
+    position of row i and row_at[p] the row at position p (idem for columns).
+    The positions evolve exactly as the rows and columns of the dense matrix
+    would.
+  */
+  SparseIncidence incidence = computeStaticIncidence(static_jacobian_arg);
+  vector<pair<int, int> > entries;
+  entries.reserve(incidence.getNnz());
+  for (int eq = 0; eq < n; eq++)
+    for (int k = incidence.rowBegin(eq); k < incidence.rowEnd(eq); k++)
+      entries.push_back(make_pair(eq, endo2eq[incidence.colIndex(k)]));
+  SparseIncidence IM(n, n, entries);
+  SparseIncidence IMt = IM.transpose();
+
+  vector<int> row_pos(n), row_at(n), col_pos(n), col_at(n);
+  for (int p = 0; p < n; p++)
+    row_pos[p] = row_at[p] = col_pos[p] = col_at[p] = p;
+
   bool something_has_been_done = true;
   prologue = 0;
   int k = 0;
@@ -455,32 +451,23 @@ ModelTree::computePrologueAndEpilogue(const jacob_map_t &static_jacobian_arg, ve
       for (int i = prologue; i < n; i++)
         {
           int nze = 0;
-          for (int j = tmp_prologue; j < n; j++)
-            if (IM[i * n + j])
+          int row = row_at[i];
+          for (int l = IM.rowBegin(row); l < IM.rowEnd(row) && nze < 2; l++)
+            if (col_pos[IM.colIndex(l)] >= tmp_prologue)
               {
                 nze++;
-                k = j;
+                k = col_pos[IM.colIndex(l)];
               }
           if (nze == 1)
             {
-              for (int j = 0; j < n; j++)
-                {
-                  bool tmp_bool = IM[tmp_prologue * n + j];
-                  IM[tmp_prologue * n + j] = IM[i * n + j];
-                  IM[i * n + j] = tmp_bool;
-                }
-              int tmp = equation_reordered[tmp_prologue];
-              equation_reordered[tmp_prologue] = equation_reordered[i];
-              equation_reordered[i] = tmp;
-              for (int j = 0; j < n; j++)
-                {
-                  bool tmp_bool = IM[j * n + tmp_prologue];
-                  IM[j * n + tmp_prologue] = IM[j * n + k];
-                  IM[j * n + k] = tmp_bool;
-                }
-              tmp = variable_reordered[tmp_prologue];
-              variable_reordered[tmp_prologue] = variable_reordered[k];
-              variable_reordered[k] = tmp;
+              swap(row_at[tmp_prologue], row_at[i]);
+              row_pos[row_at[tmp_prologue]] = tmp_prologue;
+              row_pos[row_at[i]] = i;
+              swap(equation_reordered[tmp_prologue], equation_reordered[i]);
+              swap(col_at[tmp_prologue], col_at[k]);
+              col_pos[col_at[tmp_prologue]] = tmp_prologue;
+              col_pos[col_at[k]] = k;
+              swap(variable_reordered[tmp_prologue], variable_reordered[k]);
               tmp_prologue++;
               something_has_been_done = true;
             }
@@ -498,39 +485,33 @@ ModelTree::computePrologueAndEpilogue(const jacob_map_t &static_jacobian_arg, ve
       for (int i = prologue; i < n - (int) epilogue; i++)
         {
           int nze = 0;
-          for (int j = prologue; j < n - tmp_epilogue; j++)
-            if (IM[j * n + i])
-              {
-                nze++;
-                k = j;
-              }
-          if (nze == 1)
+          int col = col_at[i];
+          for (int l = IMt.rowBegin(col); l < IMt.rowEnd(col) && nze < 2; l++)
             {
-              for (int j = 0; j < n; j++)
-                {
-                  bool tmp_bool = IM[(n - 1 - tmp_epilogue) * n + j];
-                  IM[(n - 1 - tmp_epilogue) * n + j] = IM[k * n + j];
-                  IM[k * n + j] = tmp_bool;
-                }
-              int tmp = equation_reordered[n - 1 - tmp_epilogue];
-              equation_reordered[n - 1 - tmp_epilogue] = equation_reordered[k];
-              equation_reordered[k] = tmp;
-              for (int j = 0; j < n; j++)
+              int p = row_pos[IMt.colIndex(l)];
+              if (p >= (int) prologue && p < n - tmp_epilogue)
                 {
-                  bool tmp_bool = IM[j * n + n - 1 - tmp_epilogue];
-                  IM[j * n + n - 1 - tmp_epilogue] = IM[j * n + i];
-                  IM[j * n + i] = tmp_bool;
+                  nze++;
+                  k = p;
                 }
-              tmp = variable_reordered[n - 1 - tmp_epilogue];
-              variable_reordered[n - 1 - tmp_epilogue] = variable_reordered[i];
-              variable_reordered[i] = tmp;
+            }
+          if (nze == 1)
+            {
+              int last = n - 1 - tmp_epilogue;
+              swap(row_at[last], row_at[k]);
+              row_pos[row_at[last]] = last;
+              row_pos[row_at[k]] = k;
+              swap(equation_reordered[last], equation_reordered[k]);
+              swap(col_at[last], col_at[i]);
+              col_pos[col_at[last]] = last;
+              col_pos[col_at[i]] = i;
+              swap(variable_reordered[last], variable_reordered[i]);
               tmp_epilogue++;
               something_has_been_done = true;
             }
         }
       epilogue = tmp_epilogue;
     }
-  free(IM);
 }
 
 equation_type_and_normalized_equation_t
@@ -643,29 +624,22 @@ ModelTree::computeBlockDecompositionAndFeedbackVariablesForEachBlock(const jacob
     {
       reverse_equation_reordered[equation_reordered[i]] = i;
       reverse_variable_reordered[variable_reordered[i]] = i;
-    }
-  jacob_map_t tmp_normalized_contemporaneous_jacobian;
-  if (cutoff == 0)
-    {
-      set<pair<int, int> > endo;
-      for (int i = 0; i < nb_var; i++)
-        {
-          endo.clear();
-          equations[i]->collectEndogenous(endo);
-          for (set<pair<int, int> >::const_iterator it = endo.begin(); it != endo.end(); it++)
-            tmp_normalized_contemporaneous_jacobian[make_pair(i, it->first)] = 1;
-
-        }
-    }
-  else
-    tmp_normalized_contemporaneous_jacobian = static_jacobian;
-  for (jacob_map_t::const_iterator it = tmp_normalized_contemporaneous_jacobian.begin(); it != tmp_normalized_contemporaneous_jacobian.end(); it++)
-    if (reverse_equation_reordered[it->first.first] >= (int) prologue && reverse_equation_reordered[it->first.first] < (int) (nb_var - epilogue)
-        && reverse_variable_reordered[it->first.second] >= (int) prologue && reverse_variable_reordered[it->first.second] < (int) (nb_var - epilogue)
-        && it->first.first != endo2eq[it->first.second])
-      add_edge(vertex(reverse_equation_reordered[endo2eq[it->first.second]]-prologue, G2),
-               vertex(reverse_equation_reordered[it->first.first]-prologue, G2),
-               G2);
+    }
+  SparseIncidence incidence = computeStaticIncidence(static_jacobian);
+  for (int eq = 0; eq < nb_var; eq++)
+    {
+      if (reverse_equation_reordered[eq] < (int) prologue || reverse_equation_reordered[eq] >= (int) (nb_var - epilogue))
+        continue;
+      for (int k = incidence.rowBegin(eq); k < incidence.rowEnd(eq); k++)
+        {
+          int var = incidence.colIndex(k);
+          if (reverse_variable_reordered[var] >= (int) prologue && reverse_variable_reordered[var] < (int) (nb_var - epilogue)
+              && eq != endo2eq[var])
+            add_edge(vertex(reverse_equation_reordered[endo2eq[var]]-prologue, G2),
+                     vertex(reverse_equation_reordered[eq]-prologue, G2),
+                     G2);
+        }
+    }
 
   vector<int> endo2block(num_vertices(G2)), discover_time(num_vertices(G2));
   iterator_property_map<int *, property_map<AdjacencyList_t, vertex_index_t>::type, int, int &> endo2block_map(&endo2block[0], get(vertex_index, G2));
@@ -752,6 +726,7 @@ ModelTree::computeBlockDecompositionAndFeedbackVariablesForEachBlock(const jacob
       else if (variable_lag_lead[tmp_variable_reordered[i]].first == 0 && variable_lag_lead[tmp_variable_reordered[i]].second == 0)
         n_static[i]++;
     }
+
   //For each block, the minimum set of feedback variable is computed
   // and the non-feedback variables are reordered to get
   // a sub-recursive block without feedback variables
@@ -1103,8 +1078,11 @@ ModelTree::ModelTree(SymbolTable &symbol_table_arg,
                      NumericalConstants &num_constants_arg,
                      ExternalFunctionsTable &external_functions_table_arg) :
   DataTree(symbol_table_arg, num_constants_arg, external_functions_table_arg),
+  derivatives_cache(*this),
   cutoff(1e-15),
-  mfs(0)
+  mfs(0),
+  nthreads(0),
+  split_c_files(0)
 
 {
   for (int i = 0; i < 3; i++)
@@ -1132,11 +1110,36 @@ ModelTree::writeDerivative(ostream &output, int eq, int symb_id, int lag,
 void
 ModelTree::computeJacobian(const set<int> &vars)
 {
+  addCachedDerivatives(1);
+
+  if (nthreads > 0)
+    {
+      vector<vector<pair<expr_t, int> > > exprs(equations.size());
+      for (int eq = 0; eq < (int) equations.size(); eq++)
+        if (!isCachedEquation(eq))
+          exprs[eq].push_back(make_pair(equations[eq], numeric_limits<int>::max()));
+
+      vector<vector<vector<pair<int, expr_t> > > > derivs;
+      computeDerivativesInParallel(exprs, vars, derivs);
+
+      for (int eq = 0; eq < (int) equations.size(); eq++)
+        if (!isCachedEquation(eq))
+          for (vector<pair<int, expr_t> >::const_iterator it = derivs[eq][0].begin();
+               it != derivs[eq][0].end(); it++)
+            {
+              first_derivatives[make_pair(eq, it->first)] = it->second;
+              ++NNZDerivatives[0];
+            }
+      return;
+    }
+
   for (set<int>::const_iterator it = vars.begin();
        it != vars.end(); it++)
     {
       for (int eq = 0; eq < (int) equations.size(); eq++)
         {
+          if (isCachedEquation(eq))
+            continue;
           expr_t d1 = equations[eq]->getDerivative(*it);
           if (d1 == Zero)
             continue;
@@ -1149,10 +1152,44 @@ ModelTree::computeJacobian(const set<int> &vars)
 void
 ModelTree::computeHessian(const set<int> &vars)
 {
+  addCachedDerivatives(2);
+
+  if (nthreads > 0)
+    {
+      // Second derivatives with var2 <= var1 are computed
+      vector<vector<pair<expr_t, int> > > exprs(equations.size());
+      for (first_derivatives_t::const_iterator it = first_derivatives.begin();
+           it != first_derivatives.end(); it++)
+        if (!isCachedEquation(it->first.first))
+          exprs[it->first.first].push_back(make_pair(it->second, it->first.second));
+
+      vector<vector<vector<pair<int, expr_t> > > > derivs;
+      computeDerivativesInParallel(exprs, vars, derivs);
+
+      for (int eq = 0; eq < (int) equations.size(); eq++)
+        for (int i = 0; i < (int) exprs[eq].size(); i++)
+          {
+            int var1 = exprs[eq][i].second;
+            for (vector<pair<int, expr_t> >::const_iterator it = derivs[eq][i].begin();
+                 it != derivs[eq][i].end(); it++)
+              {
+                int var2 = it->first;
+                second_derivatives[make_pair(eq, make_pair(var1, var2))] = it->second;
+                if (var2 == var1)
+                  ++NNZDerivatives[1];
+                else
+                  NNZDerivatives[1] += 2;
+              }
+          }
+      return;
+    }
+
   for (first_derivatives_t::const_iterator it = first_derivatives.begin();
        it != first_derivatives.end(); it++)
     {
       int eq = it->first.first;
+      if (isCachedEquation(eq))
+        continue;
       int var1 = it->first.second;
       expr_t d1 = it->second;
 
@@ -1179,10 +1216,53 @@ ModelTree::computeHessian(const set<int> &vars)
 void
 ModelTree::computeThirdDerivatives(const set<int> &vars)
 {
+  addCachedDerivatives(3);
+
+  if (nthreads > 0)
+    {
+      // Third derivatives with var3 <= var2 <= var1 are computed
+      vector<vector<pair<expr_t, int> > > exprs(equations.size());
+      vector<vector<pair<int, int> > > deriv_vars(equations.size());
+      for (second_derivatives_t::const_iterator it = second_derivatives.begin();
+           it != second_derivatives.end(); it++)
+        {
+          int eq = it->first.first;
+          if (isCachedEquation(eq))
+            continue;
+          exprs[eq].push_back(make_pair(it->second, it->first.second.second));
+          deriv_vars[eq].push_back(it->first.second);
+        }
+
+      vector<vector<vector<pair<int, expr_t> > > > derivs;
+      computeDerivativesInParallel(exprs, vars, derivs);
+
+      for (int eq = 0; eq < (int) equations.size(); eq++)
+        for (int i = 0; i < (int) exprs[eq].size(); i++)
+          {
+            int var1 = deriv_vars[eq][i].first;
+            int var2 = deriv_vars[eq][i].second;
+            for (vector<pair<int, expr_t> >::const_iterator it = derivs[eq][i].begin();
+                 it != derivs[eq][i].end(); it++)
+              {
+                int var3 = it->first;
+                third_derivatives[make_pair(eq, make_pair(var1, make_pair(var2, var3)))] = it->second;
+                if (var3 == var2 && var2 == var1)
+                  ++NNZDerivatives[2];
+                else if (var3 == var2 || var2 == var1)
+                  NNZDerivatives[2] += 3;
+                else
+                  NNZDerivatives[2] += 6;
+              }
+          }
+      return;
+    }
+
   for (second_derivatives_t::const_iterator it = second_derivatives.begin();
        it != second_derivatives.end(); it++)
     {
       int eq = it->first.first;
+      if (isCachedEquation(eq))
+        continue;
 
       int var1 = it->first.second.first;
       int var2 = it->first.second.second;
@@ -1212,58 +1292,527 @@ ModelTree::computeThirdDerivatives(const set<int> &vars)
     }
 }
 
+void
+ModelTree::computeHigherDerivatives(const set<int> &vars, int order)
+{
+  assert(order >= 4);
+  if ((int) higher_derivatives.size() < order - 3)
+    higher_derivatives.resize(order - 3);
+  higher_derivatives_t &derivs = higher_derivatives[order - 4];
+
+  // Derivatives of the previous order, with their key
+  vector<pair<vector<int>, expr_t> > prev;
+  if (order == 4)
+    for (third_derivatives_t::const_iterator it = third_derivatives.begin();
+         it != third_derivatives.end(); it++)
+      {
+        vector<int> key(4);
+        key[0] = it->first.first;
+        key[1] = it->first.second.first;
+        key[2] = it->first.second.second.first;
+        key[3] = it->first.second.second.second;
+        prev.push_back(make_pair(key, it->second));
+      }
+  else
+    prev.assign(higher_derivatives[order - 5].begin(), higher_derivatives[order - 5].end());
+
+  // Only derivatives such that the last variable is <= the previous one are computed
+  if (nthreads > 0)
+    {
+      vector<vector<pair<expr_t, int> > > exprs(equations.size());
+      vector<vector<int> > prev_index(equations.size());
+      for (int i = 0; i < (int) prev.size(); i++)
+        {
+          int eq = prev[i].first[0];
+          exprs[eq].push_back(make_pair(prev[i].second, prev[i].first.back()));
+          prev_index[eq].push_back(i);
+        }
+
+      vector<vector<vector<pair<int, expr_t> > > > d;
+      computeDerivativesInParallel(exprs, vars, d);
+
+      for (int eq = 0; eq < (int) equations.size(); eq++)
+        for (int i = 0; i < (int) exprs[eq].size(); i++)
+          for (vector<pair<int, expr_t> >::const_iterator it = d[eq][i].begin();
+               it != d[eq][i].end(); it++)
+            {
+              vector<int> key = prev[prev_index[eq][i]].first;
+              key.push_back(it->first);
+              derivs[key] = it->second;
+            }
+      return;
+    }
+
+  for (vector<pair<vector<int>, expr_t> >::const_iterator it = prev.begin();
+       it != prev.end(); it++)
+    for (set<int>::const_iterator it2 = vars.begin();
+         it2 != vars.end(); it2++)
+      {
+        int var = *it2;
+        if (var > it->first.back())
+          continue;
+
+        expr_t d = it->second->getDerivative(var);
+        if (d == Zero)
+          continue;
+        vector<int> key = it->first;
+        key.push_back(var);
+        derivs[key] = d;
+      }
+}
+
+bool
+ModelTree::isCachedEquation(int eq) const
+{
+  return eq < (int) cached_equations.size() && cached_equations[eq];
+}
+
+void
+ModelTree::loadDerivativesCache(const set<int> &vars, int order)
+{
+  cached_equations.clear();
+  derivatives_cache_keys.clear();
+  derivatives_cache_vars.clear();
+  if (derivatives_cache_file.empty())
+    return;
+
+  derivatives_cache.load(derivatives_cache_file);
+
+  int ncached = 0;
+  derivatives_cache_keys.resize(equations.size());
+  derivatives_cache_vars.resize(equations.size());
+  cached_equations.resize(equations.size(), false);
+  for (int eq = 0; eq < (int) equations.size(); eq++)
+    if (derivatives_cache.computeKey(equations[eq], vars, derivatives_cache_keys[eq], derivatives_cache_vars[eq]))
+      {
+        cached_equations[eq] = derivatives_cache.contains(derivatives_cache_keys[eq], order);
+        // An invalid entry is discarded, and the equation differentiated
+        if (cached_equations[eq]
+            && !derivatives_cache.check(derivatives_cache_keys[eq], order, derivatives_cache_vars[eq]))
+          {
+            cerr << "WARNING: the derivatives of equation " << eq+1 << " in the derivatives cache "
+                 << derivatives_cache_file << " are invalid, they are recomputed" << endl;
+            derivatives_cache.remove(derivatives_cache_keys[eq]);
+            cached_equations[eq] = false;
+          }
+        if (cached_equations[eq])
+          ncached++;
+      }
+    else
+      derivatives_cache_keys[eq].clear();
+
+  cout << " - derivatives of " << ncached << " equation(s) out of " << equations.size()
+       << " read from the cache" << endl;
+}
+
+void
+ModelTree::addCachedDerivatives(int order)
+{
+  for (int eq = 0; eq < (int) cached_equations.size(); eq++)
+    {
+      if (!cached_equations[eq])
+        continue;
+
+      DerivativesCache::derivatives_t derivs;
+      derivatives_cache.readDerivatives(derivatives_cache_keys[eq], order, derivatives_cache_vars[eq], derivs);
+      for (DerivativesCache::derivatives_t::const_iterator it = derivs.begin();
+           it != derivs.end(); it++)
+        {
+          const vector<int> &v = it->first;
+          switch (order)
+            {
+            case 1:
+              first_derivatives[make_pair(eq, v[0])] = it->second;
+              ++NNZDerivatives[0];
+              break;
+            case 2:
+              second_derivatives[make_pair(eq, make_pair(v[0], v[1]))] = it->second;
+              NNZDerivatives[1] += (v[1] == v[0] ? 1 : 2);
+              break;
+            case 3:
+              third_derivatives[make_pair(eq, make_pair(v[0], make_pair(v[1], v[2])))] = it->second;
+              if (v[2] == v[1] && v[1] == v[0])
+                ++NNZDerivatives[2];
+              else if (v[2] == v[1] || v[1] == v[0])
+                NNZDerivatives[2] += 3;
+              else
+                NNZDerivatives[2] += 6;
+              break;
+            }
+        }
+    }
+}
+
+void
+ModelTree::saveDerivativesCache(int order)
+{
+  if (derivatives_cache_file.empty() || derivatives_cache_keys.size() != equations.size())
+    return;
+
+  /* Nothing to do if all the equations, and only them, are in the cache, and
+     nothing was discarded when reading it */
+  set<string> keys;
+  bool all_cached = true;
+  for (int eq = 0; eq < (int) equations.size(); eq++)
+    if (!derivatives_cache_keys[eq].empty())
+      {
+        keys.insert(derivatives_cache_keys[eq]);
+        all_cached = all_cached && cached_equations[eq];
+      }
+  if (all_cached && (int) keys.size() == derivatives_cache.size()
+      && !derivatives_cache.isRejected())
+    return;
+
+  vector<DerivativesCache::derivatives_t> derivs[3];
+  for (int i = 0; i < 3; i++)
+    derivs[i].resize(equations.size());
+  for (first_derivatives_t::const_iterator it = first_derivatives.begin();
+       it != first_derivatives.end(); it++)
+    derivs[0][it->first.first].push_back(make_pair(vector<int>(1, it->first.second), it->second));
+  for (second_derivatives_t::const_iterator it = second_derivatives.begin();
+       it != second_derivatives.end(); it++)
+    {
+      vector<int> v;
+      v.push_back(it->first.second.first);
+      v.push_back(it->first.second.second);
+      derivs[1][it->first.first].push_back(make_pair(v, it->second));
+    }
+  for (third_derivatives_t::const_iterator it = third_derivatives.begin();
+       it != third_derivatives.end(); it++)
+    {
+      vector<int> v;
+      v.push_back(it->first.second.first);
+      v.push_back(it->first.second.second.first);
+      v.push_back(it->first.second.second.second);
+      derivs[2][it->first.first].push_back(make_pair(v, it->second));
+    }
+
+  // Only the current equations are kept in the cache
+  DerivativesCache new_cache(*this);
+  for (int eq = 0; eq < (int) equations.size(); eq++)
+    if (!derivatives_cache_keys[eq].empty())
+      for (int k = 1; k <= order; k++)
+        if (!new_cache.writeDerivatives(derivatives_cache_keys[eq], k, derivatives_cache_vars[eq], derivs[k-1][eq]))
+          break;
+  new_cache.save(derivatives_cache_file);
+}
+
+//! State shared by the threads of ModelTree::computeDerivativesInParallel()
+struct ParallelDerivation
+{
+  //! Derivation IDs
+  const set<int> *vars;
+  //! For each group, the staging tree
+  vector<StagingDataTree *> trees;
+  //! For each group, the copies of the expressions in the staging tree, with their largest derivation ID
+  vector<vector<pair<expr_t, int> > > exprs;
+  //! For each group and expression, the non-null derivatives in the staging tree
+  vector<vector<vector<pair<int, expr_t> > > > derivs;
+  //! Whether each group has been processed
+  vector<bool> done;
+  //! Next group to be processed
+  int next_group;
+  //! Whether an exception has been raised in a thread
+  bool failed;
+  //! Protects next_group, done and failed
+  pthread_mutex_t mutex;
+  //! Signaled when a group has been processed
+  pthread_cond_t group_done;
+};
+
+//! Differentiates groups of expressions in their staging trees, until there are no more groups
+static void *
+differentiateGroups(void *arg)
+{
+  ParallelDerivation &pd = *static_cast<ParallelDerivation *>(arg);
+  while (true)
+    {
+      pthread_mutex_lock(&pd.mutex);
+      int group = pd.next_group++;
+      bool stop = pd.failed || group >= (int) pd.trees.size();
+      pthread_mutex_unlock(&pd.mutex);
+      if (stop)
+        break;
+
+      bool failed = false;
+      try
+        {
+          expr_t zero = pd.trees[group]->Zero;
+          for (int i = 0; i < (int) pd.exprs[group].size(); i++)
+            {
+              expr_t expr = pd.exprs[group][i].first;
+              int max_deriv_id = pd.exprs[group][i].second;
+              for (set<int>::const_iterator it = pd.vars->begin();
+                   it != pd.vars->end() && *it <= max_deriv_id; it++)
+                {
+                  expr_t d = expr->getDerivative(*it);
+                  if (d != zero)
+                    pd.derivs[group][i].push_back(make_pair(*it, d));
+                }
+            }
+        }
+      catch (...)
+        {
+          failed = true;
+        }
+
+      pthread_mutex_lock(&pd.mutex);
+      pd.done[group] = true;
+      pd.failed = pd.failed || failed;
+      pthread_cond_broadcast(&pd.group_done);
+      pthread_mutex_unlock(&pd.mutex);
+    }
+  return NULL;
+}
+
+void
+ModelTree::computeDerivativesInParallel(const vector<vector<pair<expr_t, int> > > &exprs, const set<int> &vars,
+                                        vector<vector<vector<pair<int, expr_t> > > > &derivs)
+{
+  int ngroups = exprs.size();
+  derivs.clear();
+  derivs.resize(ngroups);
+
+  // Copy the expressions into the staging trees, before any thread is started
+  vector<NumericalConstants> staging_num_constants(ngroups);
+  ParallelDerivation pd;
+  pd.vars = &vars;
+  pd.trees.resize(ngroups);
+  pd.exprs.resize(ngroups);
+  pd.derivs.resize(ngroups);
+  pd.done.resize(ngroups, false);
+  pd.next_group = 0;
+  pd.failed = false;
+  for (int group = 0; group < ngroups; group++)
+    {
+      pd.trees[group] = new StagingDataTree(*this, symbol_table, staging_num_constants[group],
+                                            external_functions_table, local_variables_table);
+      for (vector<pair<expr_t, int> >::const_iterator it = exprs[group].begin();
+           it != exprs[group].end(); it++)
+        pd.exprs[group].push_back(make_pair(pd.trees[group]->importExpression(it->first), it->second));
+      pd.derivs[group].resize(exprs[group].size());
+    }
+
+  pthread_mutex_init(&pd.mutex, NULL);
+  pthread_cond_init(&pd.group_done, NULL);
+  int nthr = min(nthreads, ngroups);
+  vector<pthread_t> threads(nthr);
+  for (int i = 0; i < nthr; i++)
+    if (pthread_create(&threads[i], NULL, differentiateGroups, &pd))
+      {
+        cerr << "ERROR: can't create a thread for computing the derivatives" << endl;
+        exit(EXIT_FAILURE);
+      }
+
+  /* Copy the derivatives back into the model, in the order of the groups,
+     while the threads process the next groups */
+  for (int group = 0; group < ngroups; group++)
+    {
+      pthread_mutex_lock(&pd.mutex);
+      while (!pd.done[group] && !pd.failed)
+        pthread_cond_wait(&pd.group_done, &pd.mutex);
+      bool failed = pd.failed;
+      pthread_mutex_unlock(&pd.mutex);
+      if (failed)
+        break;
+
+      map<expr_t, expr_t> copied;
+      derivs[group].resize(exprs[group].size());
+      for (int i = 0; i < (int) exprs[group].size(); i++)
+        for (vector<pair<int, expr_t> >::const_iterator it = pd.derivs[group][i].begin();
+             it != pd.derivs[group][i].end(); it++)
+          {
+            expr_t d = AddCopy(it->second, copied);
+            if (d != Zero)
+              derivs[group][i].push_back(make_pair(it->first, d));
+          }
+      delete pd.trees[group];
+      pd.trees[group] = NULL;
+    }
+
+  for (int i = 0; i < nthr; i++)
+    pthread_join(threads[i], NULL);
+  pthread_cond_destroy(&pd.group_done);
+  pthread_mutex_destroy(&pd.mutex);
+
+  if (pd.failed)
+    {
+      cerr << "ERROR: the derivatives of the model could not be computed" << endl;
+      exit(EXIT_FAILURE);
+    }
+}
+
+int
+ModelTree::addTemporaryTermsCandidate(expr_t expr, NodeTreeReference tr, map<expr_t, int> &index,
+                                      vector<expr_t> &nodes, vector<vector<int> > &args,
+                                      vector<NodeTreeReference> &trees) const
+{
+  map<expr_t, int>::const_iterator it = index.find(expr);
+  if (it != index.end())
+    return it->second;
+
+  vector<expr_t> expr_args;
+  expr->collectTemporaryTermsArguments(expr_args);
+  vector<int> arg_indices;
+  for (vector<expr_t>::const_iterator it2 = expr_args.begin(); it2 != expr_args.end(); it2++)
+    arg_indices.push_back(addTemporaryTermsCandidate(*it2, tr, index, nodes, args, trees));
+
+  int i = nodes.size();
+  index[expr] = i;
+  nodes.push_back(expr);
+  args.push_back(arg_indices);
+  trees.push_back(tr);
+  return i;
+}
+
+void
+ModelTree::countTemporaryTermsReferences(const vector<vector<int> > &args, const vector<int> &roots,
+                                         const vector<bool> &is_temporary, vector<double> &references)
+{
+  references.assign(args.size(), 0);
+  for (vector<int>::const_iterator it = roots.begin(); it != roots.end(); it++)
+    references[*it]++;
+
+  // The parents of a node come after it
+  for (int i = (int) args.size() - 1; i >= 0; i--)
+    {
+      // A temporary term is evaluated once, other nodes every time they are referenced
+      double evaluations = is_temporary[i] ? 1 : references[i];
+      for (vector<int>::const_iterator it = args[i].begin(); it != args[i].end(); it++)
+        references[*it] += evaluations;
+    }
+}
+
 void
 ModelTree::computeTemporaryTerms(bool is_matlab)
 {
-  map<expr_t, pair<int, NodeTreeReference> > reference_count;
   temporary_terms.clear();
   temporary_terms_res.clear();
   temporary_terms_g1.clear();
   temporary_terms_g2.clear();
   temporary_terms_g3.clear();
-  map<NodeTreeReference, temporary_terms_t> temp_terms_map;
-  temp_terms_map[eResiduals]=temporary_terms_res;
-  temp_terms_map[eFirstDeriv]=temporary_terms_g1;
-  temp_terms_map[eSecondDeriv]=temporary_terms_g2;
-  temp_terms_map[eThirdDeriv]=temporary_terms_g3;
+  temporary_terms_higher.clear();
+
+  // The nodes of the model, arguments first, with the tree where they first appear
+  map<expr_t, int> index;
+  vector<expr_t> nodes;
+  vector<vector<int> > args;
+  vector<NodeTreeReference> trees;
+  vector<int> roots;
 
   for (vector<BinaryOpNode *>::iterator it = equations.begin();
        it != equations.end(); it++)
-    (*it)->computeTemporaryTerms(reference_count,
-                                 temp_terms_map,
-                                 is_matlab, eResiduals);
+    roots.push_back(addTemporaryTermsCandidate(*it, eResiduals, index, nodes, args, trees));
 
   for (first_derivatives_t::iterator it = first_derivatives.begin();
        it != first_derivatives.end(); it++)
-    it->second->computeTemporaryTerms(reference_count,
-                                      temp_terms_map,
-                                      is_matlab, eFirstDeriv);
+    roots.push_back(addTemporaryTermsCandidate(it->second, eFirstDeriv, index, nodes, args, trees));
 
   for (second_derivatives_t::iterator it = second_derivatives.begin();
        it != second_derivatives.end(); it++)
-    it->second->computeTemporaryTerms(reference_count,
-                                      temp_terms_map,
-                                      is_matlab, eSecondDeriv);
+    roots.push_back(addTemporaryTermsCandidate(it->second, eSecondDeriv, index, nodes, args, trees));
 
   for (third_derivatives_t::iterator it = third_derivatives.begin();
        it != third_derivatives.end(); it++)
-    it->second->computeTemporaryTerms(reference_count,
-                                      temp_terms_map,
-                                      is_matlab, eThirdDeriv);
+    roots.push_back(addTemporaryTermsCandidate(it->second, eThirdDeriv, index, nodes, args, trees));
 
-  for (map<NodeTreeReference, temporary_terms_t>::const_iterator it = temp_terms_map.begin();
-       it != temp_terms_map.end(); it++)
-    temporary_terms.insert(it->second.begin(), it->second.end());
+  for (vector<higher_derivatives_t>::const_iterator it = higher_derivatives.begin();
+       it != higher_derivatives.end(); it++)
+    for (higher_derivatives_t::const_iterator it2 = it->begin(); it2 != it->end(); it2++)
+      roots.push_back(addTemporaryTermsCandidate(it2->second, eHigherDeriv, index, nodes, args, trees));
+
+  int n = nodes.size();
+  vector<int> op_cost(n);
+  vector<bool> forced(n), excluded(n);
+  for (int i = 0; i < n; i++)
+    {
+      op_cost[i] = nodes[i]->cost(0, is_matlab);
+      // External functions are always temporary terms, equal nodes never
+      forced[i] = (dynamic_cast<AbstractExternalFunctionNode *>(nodes[i]) != NULL);
+      BinaryOpNode *bopn = dynamic_cast<BinaryOpNode *>(nodes[i]);
+      excluded[i] = (bopn != NULL && bopn->get_op_code() == oEqual);
+    }
+
+  // Cost of the generated code without temporary terms
+  vector<bool> is_temporary(forced);
+  vector<double> references;
+  countTemporaryTermsReferences(args, roots, is_temporary, references);
+  double cost_without = 0;
+  for (int i = 0; i < n; i++)
+    cost_without += op_cost[i] * (is_temporary[i] ? 1 : references[i]);
+
+  // Initially, each node is assumed to be evaluated once per parent
+  countTemporaryTermsReferences(args, roots, vector<bool>(n, true), references);
+  vector<double> inline_cost(n);
+  for (int iter = 0; iter < 10; iter++)
+    {
+      vector<bool> new_is_temporary(n);
+      for (int i = 0; i < n; i++)
+        {
+          inline_cost[i] = op_cost[i];
+          for (vector<int>::const_iterator it = args[i].begin(); it != args[i].end(); it++)
+            if (!new_is_temporary[*it])
+              inline_cost[i] += inline_cost[*it];
+          new_is_temporary[i] = forced[i]
+            || (!excluded[i] && (references[i] - 1) * inline_cost[i] > TEMPORARY_TERM_COST(is_matlab));
+        }
+      bool changed = (new_is_temporary != is_temporary);
+      is_temporary = new_is_temporary;
+      countTemporaryTermsReferences(args, roots, is_temporary, references);
+      if (!changed)
+        break;
+    }
+
+  double cost_with = 0;
+  map<NodeTreeReference, temporary_terms_t> temp_terms_map;
+  for (int i = 0; i < n; i++)
+    if (is_temporary[i])
+      {
+        cost_with += op_cost[i];
+        temp_terms_map[trees[i]].insert(nodes[i]);
+        temporary_terms.insert(nodes[i]);
+      }
+    else
+      cost_with += op_cost[i] * references[i];
 
   temporary_terms_res = temp_terms_map[eResiduals];
   temporary_terms_g1  = temp_terms_map[eFirstDeriv];
   temporary_terms_g2  = temp_terms_map[eSecondDeriv];
   temporary_terms_g3  = temp_terms_map[eThirdDeriv];
+  temporary_terms_higher = temp_terms_map[eHigherDeriv];
+
+  ostringstream report;
+  report << fixed << setprecision(0)
+         << " - " << temporary_terms.size() << " temporary terms, estimated cost of the "
+         << (is_matlab ? "MATLAB" : "C") << " code: " << cost_with / ADDITION_COST(is_matlab)
+         << " flops (" << cost_without / ADDITION_COST(is_matlab) << " without temporary terms)";
+  cout << report.str() << endl;
+}
+
+void
+ModelTree::writeCStatement(ostream &output, vector<CStatement> *statements, int section, const string &code,
+                           const temporary_terms_t &tt, expr_t expr1, expr_t expr2, int temporary_term) const
+{
+  if (statements == NULL)
+    {
+      output << code;
+      return;
+    }
+
+  CStatement statement;
+  statement.section = section;
+  statement.code = code;
+  statement.temporary_term = temporary_term;
+  expr1->collectTemporary_terms(tt, statement.used, 0);
+  if (expr2 != NULL)
+    expr2->collectTemporary_terms(tt, statement.used, 0);
+  statements->push_back(statement);
 }
 
 void
 ModelTree::writeTemporaryTerms(const temporary_terms_t &tt, const temporary_terms_t &ttm1, ostream &output,
-                               ExprNodeOutputType output_type, deriv_node_temp_terms_t &tef_terms) const
+                               ExprNodeOutputType output_type, deriv_node_temp_terms_t &tef_terms,
+                               vector<CStatement> *statements, int section) const
 {
   // Local var used to keep track of temp nodes already written
   temporary_terms_t tt2 = ttm1;
@@ -1271,27 +1820,229 @@ ModelTree::writeTemporaryTerms(const temporary_terms_t &tt, const temporary_term
        it != tt.end(); it++)
     if (ttm1.find(*it) == ttm1.end())
       {
+        ostringstream statement;
         if (dynamic_cast<AbstractExternalFunctionNode *>(*it) != NULL)
-          (*it)->writeExternalFunctionOutput(output, output_type, tt2, tef_terms);
+          (*it)->writeExternalFunctionOutput(statement, output_type, tt2, tef_terms);
 
-        if (IS_C(output_type))
-          output << "double ";
+        if (IS_C(output_type) && statements == NULL)
+          statement << "double ";
         else if (IS_JULIA(output_type))
-          output << "  @inbounds const ";
+          statement << "  @inbounds const ";
 
-        (*it)->writeOutput(output, output_type, tt, tef_terms);
-        output << " = ";
-        (*it)->writeOutput(output, output_type, tt2, tef_terms);
+        (*it)->writeOutput(statement, output_type, tt, tef_terms);
+        statement << " = ";
+        (*it)->writeOutput(statement, output_type, tt2, tef_terms);
 
         if (IS_C(output_type) || IS_MATLAB(output_type))
-          output << ";";
-        output << endl;
+          statement << ";";
+        statement << endl;
+
+        // The definition uses the temporary terms already written
+        writeCStatement(output, statements, section, statement.str(), tt2, *it, NULL, (*it)->idx);
 
         // Insert current node into tt2
         tt2.insert(*it);
       }
 }
 
+void
+ModelTree::computeNeededTemporaryTerms(int order, const temporary_terms_t &tt, temporary_terms_t &needed) const
+{
+  temporary_terms_inuse_t inuse;
+  switch (order)
+    {
+    case 0:
+      for (size_t i = 0; i < equations.size(); i++)
+        equations[i]->collectTemporary_terms(tt, inuse, 0);
+      break;
+    case 1:
+      for (first_derivatives_t::const_iterator it = first_derivatives.begin();
+           it != first_derivatives.end(); it++)
+        it->second->collectTemporary_terms(tt, inuse, 0);
+      break;
+    case 2:
+      for (second_derivatives_t::const_iterator it = second_derivatives.begin();
+           it != second_derivatives.end(); it++)
+        it->second->collectTemporary_terms(tt, inuse, 0);
+      break;
+    case 3:
+      for (third_derivatives_t::const_iterator it = third_derivatives.begin();
+           it != third_derivatives.end(); it++)
+        it->second->collectTemporary_terms(tt, inuse, 0);
+      break;
+    default:
+      if (order < 4 || order - 4 >= (int) higher_derivatives.size())
+        {
+          cerr << "ModelTree::computeNeededTemporaryTerms: invalid order " << order << endl;
+          exit(EXIT_FAILURE);
+        }
+      for (higher_derivatives_t::const_iterator it = higher_derivatives[order-4].begin();
+           it != higher_derivatives[order-4].end(); it++)
+        it->second->collectTemporary_terms(tt, inuse, 0);
+    }
+
+  /* The output of the derivative of an external function may refer to the
+     call of the function itself, or of its first derivative, for the same
+     arguments (see FirstDerivExternalFunctionNode::writeOutput()). These
+     calls are temporary terms created before the derivative, which must be
+     needed along with it. */
+  map<pair<int, vector<expr_t> >, vector<int> > external_function_calls;
+  for (temporary_terms_t::const_iterator it = tt.begin(); it != tt.end(); it++)
+    if (AbstractExternalFunctionNode *ef = dynamic_cast<AbstractExternalFunctionNode *>(*it))
+      external_function_calls[make_pair(ef->get_symb_id(), ef->get_arguments())].push_back((*it)->idx);
+
+  /* The arguments of a node are created before it, so the definition of a
+     temporary term only involves temporary terms of smaller index: visiting
+     them by decreasing index gives all the needed ones in a single pass */
+  for (temporary_terms_t::const_reverse_iterator it = tt.rbegin(); it != tt.rend(); it++)
+    {
+      if (inuse.find((*it)->idx) == inuse.end())
+        continue;
+      needed.insert(*it);
+      if (UnaryOpNode *uo = dynamic_cast<UnaryOpNode *>(*it))
+        uo->get_arg()->collectTemporary_terms(tt, inuse, 0);
+      else if (BinaryOpNode *bo = dynamic_cast<BinaryOpNode *>(*it))
+        {
+          bo->get_arg1()->collectTemporary_terms(tt, inuse, 0);
+          bo->get_arg2()->collectTemporary_terms(tt, inuse, 0);
+        }
+      else if (TrinaryOpNode *to = dynamic_cast<TrinaryOpNode *>(*it))
+        {
+          to->get_arg1()->collectTemporary_terms(tt, inuse, 0);
+          to->get_arg2()->collectTemporary_terms(tt, inuse, 0);
+          to->get_arg3()->collectTemporary_terms(tt, inuse, 0);
+        }
+      else if (AbstractExternalFunctionNode *ef = dynamic_cast<AbstractExternalFunctionNode *>(*it))
+        {
+          for (vector<expr_t>::const_iterator it2 = ef->get_arguments().begin();
+               it2 != ef->get_arguments().end(); it2++)
+            (*it2)->collectTemporary_terms(tt, inuse, 0);
+          const vector<int> &calls = external_function_calls[make_pair(ef->get_symb_id(), ef->get_arguments())];
+          inuse.insert(calls.begin(), calls.end());
+        }
+    }
+}
+
+void
+ModelTree::writeSplitCFunction(ostream &output, const string &basename, const string &func_name,
+                               const string &args, const string &call_args, const string &local_vars,
+                               const vector<CStatement> &statements, const vector<string> &outputs) const
+{
+  // Position of the temporary terms in the array shared by the chunks
+  map<int, int> temp_pos;
+  size_t total_size = 0;
+  for (vector<CStatement>::const_iterator it = statements.begin(); it != statements.end(); it++)
+    {
+      if (it->temporary_term >= 0)
+        {
+          int pos = temp_pos.size();
+          temp_pos[it->temporary_term] = pos;
+        }
+      total_size += it->code.size();
+    }
+
+  // Assign the statements, in order, to chunks of similar size
+  const int nchunks = split_c_files;
+  vector<int> chunk_begin(nchunks + 1, statements.size());
+  size_t size_before = 0;
+  for (int i = 0, c = -1; i < (int) statements.size(); i++)
+    {
+      int chunk = min((int) (size_before * nchunks / total_size), nchunks - 1);
+      while (c < chunk)
+        chunk_begin[++c] = i;
+      size_before += statements[i].code.size();
+    }
+
+  for (int c = 0; c < nchunks; c++)
+    {
+      ostringstream chunk_name, filename;
+      chunk_name << func_name << "_chunk" << c + 1;
+      filename << basename << "_chunk" << c + 1 << ".c";
+
+      // Temporary terms defined or referenced in the chunk
+      set<int> used;
+      bool has_residuals = false;
+      for (int i = chunk_begin[c]; i < chunk_begin[c+1]; i++)
+        {
+          has_residuals = has_residuals || statements[i].section == 0;
+          if (statements[i].temporary_term >= 0)
+            used.insert(statements[i].temporary_term);
+          used.insert(statements[i].used.begin(), statements[i].used.end());
+        }
+
+      ofstream chunk_file;
+      chunk_file.open(filename.str().c_str(), ios::out | ios::binary);
+      if (!chunk_file.is_open())
+        {
+          cerr << "Error: Can't open file " << filename.str() << " for writing" << endl;
+          exit(EXIT_FAILURE);
+        }
+      chunk_file << "/*" << endl
+                 << " * " << filename.str() << " : Part " << c + 1 << " of " << nchunks
+                 << " of the " << func_name << " function (see " << basename << ".c)" << endl
+                 << " *" << endl
+                 << " * Warning : this file is generated automatically by Dynare" << endl
+                 << " *           from model file (.mod)" << endl
+                 << " */" << endl
+                 << "#include <math.h>" << endl
+                 << "#include <stdlib.h>" << endl
+                 << "#define max(a, b) (((a) > (b)) ? (a) : (b))" << endl
+                 << "#define min(a, b) (((a) > (b)) ? (b) : (a))" << endl;
+      writePowerDerivCHeader(chunk_file);
+      for (set<int>::const_iterator it = used.begin(); it != used.end(); it++)
+        {
+          // A model local variable may use temporary terms which are not written
+          map<int, int>::const_iterator pos = temp_pos.find(*it);
+          if (pos != temp_pos.end())
+            chunk_file << "#define T" << *it << " T[" << pos->second << "]" << endl;
+        }
+      chunk_file << endl
+                 << "void " << chunk_name.str() << "(double *T, " << args << ")" << endl
+                 << "{" << endl;
+      if (has_residuals)
+        chunk_file << "  double lhs, rhs;" << endl
+                   << endl;
+      if (chunk_begin[c] < chunk_begin[c+1])
+        chunk_file << local_vars;
+      for (int i = chunk_begin[c]; i < chunk_begin[c+1]; i++)
+        {
+          // The driver only calls the chunk if the output of its first section is requested
+          if (i > chunk_begin[c] && statements[i].section != statements[i-1].section)
+            chunk_file << "  if (" << outputs[statements[i].section] << " == NULL)" << endl
+                       << "    return;" << endl;
+          chunk_file << statements[i].code;
+        }
+      chunk_file << "}" << endl;
+      chunk_file.close();
+    }
+
+  for (int c = 0; c < nchunks; c++)
+    output << "void " << func_name << "_chunk" << c + 1 << "(double *T, " << args << ");" << endl;
+  output << endl
+         << "void " << func_name << "(" << args << ")" << endl
+         << "{" << endl
+         << "  double *T = (double *) malloc(" << max((int) temp_pos.size(), 1) << "*sizeof(double));" << endl
+         << endl;
+  for (int c = 0; c < nchunks; c++)
+    {
+      if (chunk_begin[c] == chunk_begin[c+1])
+        continue;
+      int first_section = statements[chunk_begin[c]].section;
+      if (first_section > 0)
+        {
+          output << "  if (";
+          for (int s = 1; s <= first_section; s++)
+            output << (s > 1 ? " && " : "") << outputs[s] << " != NULL";
+          output << ")" << endl
+                 << "  ";
+        }
+      output << "  " << func_name << "_chunk" << c + 1 << "(T, " << call_args << ");" << endl;
+    }
+  output << endl
+         << "  free(T);" << endl
+         << "}" << endl << endl;
+}
+
 void
 ModelTree::compileTemporaryTerms(ostream &code_file, unsigned int &instruction_number, const temporary_terms_t &tt, map_idx_t map_idx, bool dynamic, bool steady_dynamic) const
 {
@@ -1360,7 +2111,7 @@ ModelTree::writeModelLocalVariables(ostream &output, ExprNodeOutputType output_t
 }
 
 void
-ModelTree::writeModelEquations(ostream &output, ExprNodeOutputType output_type) const
+ModelTree::writeModelEquations(ostream &output, ExprNodeOutputType output_type, vector<CStatement> *statements) const
 {
   temporary_terms_t temp_terms;
   if (IS_JULIA(output_type))
@@ -1384,37 +2135,42 @@ ModelTree::writeModelEquations(ostream &output, ExprNodeOutputType output_type)
         {
         }
 
+      ostringstream residual;
+      if (output_type == oCDynamicBatchModel)
+        residual << "residual_block[j+" << eq << "*DYNARE_BATCH_SIZE]";
+      else
+        residual << "residual" << LEFT_ARRAY_SUBSCRIPT(output_type)
+                 << eq + ARRAY_SUBSCRIPT_OFFSET(output_type)
+                 << RIGHT_ARRAY_SUBSCRIPT(output_type);
+
+      ostringstream statement;
       if (vrhs != 0) // The right hand side of the equation is not empty ==> residual=lhs-rhs;
         {
           if (IS_JULIA(output_type))
-            output << "  @inbounds ";
-          output << "lhs =";
-          lhs->writeOutput(output, output_type, temp_terms);
-          output << ";" << endl;
+            statement << "  @inbounds ";
+          statement << "lhs =";
+          lhs->writeOutput(statement, output_type, temp_terms);
+          statement << ";" << endl;
 
           if (IS_JULIA(output_type))
-            output << "  @inbounds ";
-          output << "rhs =";
-          rhs->writeOutput(output, output_type, temp_terms);
-          output << ";" << endl;
+            statement << "  @inbounds ";
+          statement << "rhs =";
+          rhs->writeOutput(statement, output_type, temp_terms);
+          statement << ";" << endl;
 
           if (IS_JULIA(output_type))
-            output << "  @inbounds ";
-          output << "residual" << LEFT_ARRAY_SUBSCRIPT(output_type)
-                 << eq + ARRAY_SUBSCRIPT_OFFSET(output_type)
-                 << RIGHT_ARRAY_SUBSCRIPT(output_type)
-                 << "= lhs-rhs;" << endl;
+            statement << "  @inbounds ";
+          statement << residual.str() << "= lhs-rhs;" << endl;
+          writeCStatement(output, statements, 0, statement.str(), temp_terms, lhs, rhs);
         }
       else // The right hand side of the equation is empty ==> residual=lhs;
         {
           if (IS_JULIA(output_type))
-            output << "  @inbounds ";
-          output << "residual" << LEFT_ARRAY_SUBSCRIPT(output_type)
-                 << eq + ARRAY_SUBSCRIPT_OFFSET(output_type)
-                 << RIGHT_ARRAY_SUBSCRIPT(output_type)
-                 << " = ";
-          lhs->writeOutput(output, output_type, temp_terms);
-          output << ";" << endl;
+            statement << "  @inbounds ";
+          statement << residual.str() << " = ";
+          lhs->writeOutput(statement, output_type, temp_terms);
+          statement << ";" << endl;
+          writeCStatement(output, statements, 0, statement.str(), temp_terms, lhs);
         }
     }
 }
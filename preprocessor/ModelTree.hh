@@ -30,6 +30,8 @@ using namespace std;
 
 #include "DataTree.hh"
 #include "ExtendedPreprocessorTypes.hh"
+#include "SparseIncidence.hh"
+#include "DerivativesCache.hh"
 
 //! Vector describing equations: BlockSimulationType, if BlockSimulationType == EVALUATE_s then a expr_t on the new normalized equation
 typedef vector<pair<EquationType, expr_t > > equation_type_and_normalized_equation_t;
@@ -93,6 +95,16 @@ protected:
   */
   third_derivatives_t third_derivatives;
 
+  typedef map<vector<int>, expr_t> higher_derivatives_t;
+  //! Derivatives of order 4 and above
+  /*! higher_derivatives[k-4] contains the derivatives of order k. The key is
+    the equation number, followed by the k variables w.r. to which is computed
+    the derivative, with var1 >= var2 >= ... >= vark.
+    Only non-null derivatives are stored in the map.
+    Variable indices are those of the getDerivID() method.
+  */
+  vector<higher_derivatives_t> higher_derivatives;
+
   //! Derivatives of the residuals w.r. to parameters
   /*! First index is equation number, second is parameter.
     Only non-null derivatives are stored in the map.
@@ -142,6 +154,8 @@ protected:
   temporary_terms_t temporary_terms_g1;
   temporary_terms_t temporary_terms_g2;
   temporary_terms_t temporary_terms_g3;
+  //! Temporary terms for the derivatives of order 4 and above
+  temporary_terms_t temporary_terms_higher;
 
   //! Temporary terms for the file containing parameters derivatives
   temporary_terms_t params_derivs_temporary_terms;
@@ -176,16 +190,109 @@ protected:
   //! Computes 3rd derivatives
   /*! \param vars the derivation IDs w.r. to which derive the 2nd derivatives */
   void computeThirdDerivatives(const set<int> &vars);
+  //! Computes derivatives of order 4 and above
+  /*! The derivatives of order (order-1) must have been computed
+    \param vars the derivation IDs w.r. to which derive the derivatives of order (order-1) */
+  void computeHigherDerivatives(const set<int> &vars, int order);
+  //! Differentiates expressions of the model in parallel
+  /*!
+    The expressions are split in groups (one group per equation). Each group
+    is copied into a StagingDataTree and differentiated there by one of the
+    threads, then the non-null derivatives are copied back into the model, one
+    group after the other. The resulting nodes therefore do not depend on the
+    number of threads.
+    \param[in] exprs For each group, the expressions to differentiate, each with the largest derivation ID w.r. to which it must be derived
+    \param[in] vars The derivation IDs w.r. to which derive the expressions
+    \param[out] derivs For each group and each expression, the non-null derivatives as pairs (derivation ID, derivative), by increasing derivation ID
+  */
+  void computeDerivativesInParallel(const vector<vector<pair<expr_t, int> > > &exprs, const set<int> &vars,
+                                    vector<vector<vector<pair<int, expr_t> > > > &derivs);
+  //! The derivatives cache
+  DerivativesCache derivatives_cache;
+  //! For each equation, its key in the derivatives cache (empty if the equation can't be stored in the cache)
+  vector<string> derivatives_cache_keys;
+  //! For each equation, the derivation IDs of its variables (see DerivativesCache::computeKey())
+  vector<vector<int> > derivatives_cache_vars;
+  //! For each equation, whether its derivatives are read from the derivatives cache instead of being computed
+  vector<bool> cached_equations;
+  //! Reads the derivatives cache, and finds the equations whose derivatives up to the given order are in it
+  /*! Does nothing if derivatives_cache_file is empty */
+  void loadDerivativesCache(const set<int> &vars, int order);
+  //! Adds the derivatives of the given order of the cached equations to the derivatives of the model
+  void addCachedDerivatives(int order);
+  //! Stores the derivatives up to the given order of the equations in the derivatives cache file
+  /*! The file is not rewritten if all equations were read from it */
+  void saveDerivativesCache(int order);
+  //! Whether the derivatives of an equation are read from the derivatives cache
+  bool isCachedEquation(int eq) const;
   //! Computes derivatives of the Jacobian and Hessian w.r. to parameters
   void computeParamsDerivatives(int paramsDerivsOrder);
   //! Write derivative of an equation w.r. to a variable
   void writeDerivative(ostream &output, int eq, int symb_id, int lag, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms) const;
   //! Computes temporary terms (for all equations and derivatives)
+  /*! Common subexpressions are selected globally, across the residuals and all
+    derivative orders, using the cost of each operator (see ExprNode::cost()):
+    a node becomes a temporary term if the evaluations that it saves cost more
+    than TEMPORARY_TERM_COST. Since the number of evaluations of a node depends
+    on which of its ancestors are temporary terms, and its cost depends on which
+    of its descendants are temporary terms, the selection is iterated until it
+    no longer changes. The estimated cost of the generated code, with and
+    without temporary terms, is printed. */
   void computeTemporaryTerms(bool is_matlab);
+  //! Adds a node and its arguments (if not already there) to the nodes considered by computeTemporaryTerms()
+  /*! The arguments of a node are added before it. Returns the index of the node in nodes.
+    \param tr the tree in which the node is referenced; it is recorded for the nodes which are added */
+  int addTemporaryTermsCandidate(expr_t expr, NodeTreeReference tr, map<expr_t, int> &index,
+                                 vector<expr_t> &nodes, vector<vector<int> > &args,
+                                 vector<NodeTreeReference> &trees) const;
+  //! Computes the number of references to the nodes in the generated code, given the nodes which are temporary terms
+  /*! \param roots the indices of the residuals and derivatives, with repetitions */
+  static void countTemporaryTermsReferences(const vector<vector<int> > &args, const vector<int> &roots,
+                                            const vector<bool> &is_temporary, vector<double> &references);
   //! Computes temporary terms for the file containing parameters derivatives
   void computeParamsDerivativesTemporaryTerms();
+  //! A statement of the C code of the model, kept apart when the code is split (see writeSplitCFunction())
+  struct CStatement
+  {
+    //! The part of the model function: 0 for the residuals, 1 for the first derivatives, 2 for the second...
+    int section;
+    //! The code of the statement; a temporary term is assigned without being declared
+    string code;
+    //! The index of the temporary term defined by the statement, -1 if there is none
+    int temporary_term;
+    //! The indices of the temporary terms used by the statement
+    temporary_terms_inuse_t used;
+  };
+  //! Writes a statement to output, or appends it to statements if it is not NULL
+  /*! The temporary terms of tt used by expr1 and expr2 (if not NULL) are recorded in the statement */
+  void writeCStatement(ostream &output, vector<CStatement> *statements, int section, const string &code,
+                       const temporary_terms_t &tt, expr_t expr1, expr_t expr2 = NULL, int temporary_term = -1) const;
 //! Writes temporary terms
-  void writeTemporaryTerms(const temporary_terms_t &tt, const temporary_terms_t &ttm1, ostream &output, ExprNodeOutputType output_type, deriv_node_temp_terms_t &tef_terms) const;
+  /*! \param statements if not NULL, the temporary terms are appended to it as statements of the given section instead of being written to output */
+  void writeTemporaryTerms(const temporary_terms_t &tt, const temporary_terms_t &ttm1, ostream &output, ExprNodeOutputType output_type, deriv_node_temp_terms_t &tef_terms,
+                           vector<CStatement> *statements = NULL, int section = 0) const;
+  //! Computes the temporary terms needed for evaluating the residuals (order 0) or the derivatives of a given order
+  /*! Among the temporary terms of tt, selects those which appear in the
+      residuals or derivatives, and recursively those which appear in the
+      definition of a selected temporary term */
+  void computeNeededTemporaryTerms(int order, const temporary_terms_t &tt, temporary_terms_t &needed) const;
+  //! Writes a C model function whose code is split across several files
+  /*! The statements of the sections (temporary terms, then equations or
+      derivatives) are distributed, in order, among split_c_files chunk
+      functions of similar code size, each one written to its own file
+      basename_chunk<i>.c so that they can be compiled independently. The
+      temporary terms are stored in an array shared by the chunks: since a
+      temporary term only depends on temporary terms of smaller index, calling
+      the chunks in order respects the dependencies. The driver, written to
+      output, allocates the array and calls the chunks.
+      \param args the arguments of the model function (and of the chunks, which have the array of temporary terms as additional first argument)
+      \param call_args the names of these arguments
+      \param local_vars the declarations of the model local variables, repeated in every chunk
+      \param statements the statements of the function, by increasing section
+      \param outputs the output array of each section; the sections after the first one are skipped when their output is NULL */
+  void writeSplitCFunction(ostream &output, const string &basename, const string &func_name,
+                           const string &args, const string &call_args, const string &local_vars,
+                           const vector<CStatement> &statements, const vector<string> &outputs) const;
   //! Compiles temporary terms
   void compileTemporaryTerms(ostream &code_file, unsigned int &instruction_number, const temporary_terms_t &tt, map_idx_t map_idx, bool dynamic, bool steady_dynamic) const;
   //! Adds informations for simulation in a binary file
@@ -195,7 +302,8 @@ protected:
   /*! No temporary term is used in the output, so that local parameters declarations can be safely put before temporary terms declaration in the output files */
   void writeModelLocalVariables(ostream &output, ExprNodeOutputType output_type, deriv_node_temp_terms_t &tef_terms) const;
   //! Writes model equations
-  void writeModelEquations(ostream &output, ExprNodeOutputType output_type) const;
+  /*! \param statements if not NULL, the equations are appended to it as statements of section 0 instead of being written to output */
+  void writeModelEquations(ostream &output, ExprNodeOutputType output_type, vector<CStatement> *statements = NULL) const;
   //! Compiles model equations
   void compileModelEquations(ostream &code_file, unsigned int &instruction_number, const temporary_terms_t &tt, const map_idx_t &map_idx, bool dynamic, bool steady_dynamic) const;
 
@@ -222,6 +330,7 @@ protected:
 
   //! Compute the matching between endogenous and variable using the jacobian contemporaneous_jacobian
   /*!
+    The matching is computed by the Hopcroft-Karp algorithm on the sparse incidence matrix.
     \param contemporaneous_jacobian Jacobian used as an incidence matrix: all elements declared in the map (even if they are zero), are used as vertices of the incidence matrix
     \return True if a complete normalization has been achieved
   */
@@ -247,6 +356,9 @@ protected:
   void writeRevXrefs(ostream &output, const map<int, set<int> > &xrefmap, const string &type) const;
   //! Evaluate the jacobian and suppress all the elements below the cutoff
   void evaluateAndReduceJacobian(const eval_context_t &eval_context, jacob_map_t &contemporaneous_jacobian, jacob_map_t &static_jacobian, dynamic_jacob_map_t &dynamic_jacobian, double cutoff, bool verbose);
+  //! Compute the static incidence matrix (equations in rows, endogenous type specific IDs in columns)
+  /*! If cutoff is zero, the symbolic incidence is used, otherwise the pattern of static_jacobian */
+  SparseIncidence computeStaticIncidence(const jacob_map_t &static_jacobian) const;
   //! Search the equations and variables belonging to the prologue and the epilogue of the model
   void computePrologueAndEpilogue(const jacob_map_t &static_jacobian, vector<int> &equation_reordered, vector<int> &variable_reordered);
   //! Determine the type of each equation of model and try to normalized the unnormalized equation using computeNormalizedEquations
@@ -322,6 +434,18 @@ public:
     3 : the variables belonging to a non normalizable non linear equation are considered as feedback variables
     default value = 0 */
   int mfs;
+  //! Number of threads used for computing the derivatives of the model
+  /*! If zero (the default), the derivatives are computed in the model tree itself, without threads.
+    The output does not depend on the number of threads when it is positive, but the nodes are not created in
+    the same order as without threads, so that the operands of sums and products and the numbering of
+    temporary terms may then differ. */
+  int nthreads;
+  //! Number of files across which the C code of the model is split
+  /*! If zero (the default), the code of the model is written to a single file */
+  int split_c_files;
+  //! File of the derivatives cache
+  /*! If empty (the default), no cache is used, and the derivatives of all equations are computed */
+  string derivatives_cache_file;
   //! Declare a node as an equation of the model; also give its line number
   void addEquation(expr_t eq, int lineno);
   //! Declare a node as an equation of the model, also giving its tags
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cassert>
+#include <algorithm>
+#include <limits>
+
+#include "SparseIncidence.hh"
+
+SparseIncidence::SparseIncidence(int nrows_arg, int ncols_arg) :
+  nrows(nrows_arg), ncols(ncols_arg), row_start(nrows_arg+1, 0)
+{
+}
+
+SparseIncidence::SparseIncidence(int nrows_arg, int ncols_arg, const vector<pair<int, int> > &entries) :
+  nrows(nrows_arg), ncols(ncols_arg), row_start(nrows_arg+1, 0)
+{
+  // Count the elements of each row, and place them by a counting sort on rows
+  for (vector<pair<int, int> >::const_iterator it = entries.begin(); it != entries.end(); it++)
+    {
+      assert(it->first >= 0 && it->first < nrows && it->second >= 0 && it->second < ncols);
+      row_start[it->first+1]++;
+    }
+  for (int i = 0; i < nrows; i++)
+    row_start[i+1] += row_start[i];
+
+  vector<int> tmp_col_index(entries.size());
+  vector<int> fill(row_start.begin(), row_start.end()-1);
+  for (vector<pair<int, int> >::const_iterator it = entries.begin(); it != entries.end(); it++)
+    tmp_col_index[fill[it->first]++] = it->second;
+
+  // Sort each row and remove the duplicates
+  col_index.reserve(entries.size());
+  int begin = 0;
+  for (int i = 0; i < nrows; i++)
+    {
+      vector<int>::iterator first = tmp_col_index.begin() + begin, last = tmp_col_index.begin() + row_start[i+1];
+      sort(first, last);
+      begin = row_start[i+1];
+      row_start[i+1] = row_start[i] + (unique(first, last) - first);
+      col_index.insert(col_index.end(), first, first + (row_start[i+1] - row_start[i]));
+    }
+}
+
+bool
+SparseIncidence::isNonzero(int i, int j) const
+{
+  return binary_search(col_index.begin() + row_start[i], col_index.begin() + row_start[i+1], j);
+}
+
+SparseIncidence
+SparseIncidence::transpose() const
+{
+  SparseIncidence T(ncols, nrows);
+  for (vector<int>::const_iterator it = col_index.begin(); it != col_index.end(); it++)
+    T.row_start[*it+1]++;
+  for (int j = 0; j < ncols; j++)
+    T.row_start[j+1] += T.row_start[j];
+
+  // Rows are visited in increasing order, so the columns of T come out sorted
+  T.col_index.resize(col_index.size());
+  vector<int> fill(T.row_start.begin(), T.row_start.end()-1);
+  for (int i = 0; i < nrows; i++)
+    for (int k = row_start[i]; k < row_start[i+1]; k++)
+      T.col_index[fill[col_index[k]]++] = i;
+  return T;
+}
+
+int
+SparseIncidence::maximumMatching(vector<int> &row2col) const
+{
+  const int infinity = numeric_limits<int>::max();
+  row2col.assign(nrows, -1);
+  vector<int> col2row(ncols, -1);
+  int cardinality = 0;
+
+  // Greedy initial matching
+  for (int i = 0; i < nrows; i++)
+    for (int k = row_start[i]; k < row_start[i+1]; k++)
+      if (col2row[col_index[k]] == -1)
+        {
+          row2col[i] = col_index[k];
+          col2row[col_index[k]] = i;
+          cardinality++;
+          break;
+        }
+
+  vector<int> dist(nrows), queue(nrows), next_edge(nrows), stack;
+  stack.reserve(nrows);
+  while (true)
+    {
+      // Breadth first search from the free rows, building the layers of alternating paths
+      int qbegin = 0, qend = 0;
+      for (int i = 0; i < nrows; i++)
+        if (row2col[i] == -1)
+          {
+            dist[i] = 0;
+            queue[qend++] = i;
+          }
+        else
+          dist[i] = infinity;
+      bool found = false;
+      while (qbegin < qend)
+        {
+          int i = queue[qbegin++];
+          for (int k = row_start[i]; k < row_start[i+1]; k++)
+            {
+              int i2 = col2row[col_index[k]];
+              if (i2 == -1)
+                found = true;
+              else if (dist[i2] == infinity)
+                {
+                  dist[i2] = dist[i] + 1;
+                  queue[qend++] = i2;
+                }
+            }
+        }
+      if (!found)
+        break;
+
+      // Depth first search of vertex disjoint augmenting paths along the layers
+      // (iterative, since the paths may be very long)
+      for (int i = 0; i < nrows; i++)
+        next_edge[i] = row_start[i];
+      for (int i = 0; i < nrows; i++)
+        {
+          if (row2col[i] != -1)
+            continue;
+          stack.clear();
+          stack.push_back(i);
+          while (!stack.empty())
+            {
+              int r = stack.back();
+              if (next_edge[r] == row_start[r+1])
+                {
+                  // Dead end
+                  dist[r] = infinity;
+                  stack.pop_back();
+                  continue;
+                }
+              int r2 = col2row[col_index[next_edge[r]]];
+              if (r2 == -1)
+                {
+                  // Augment along the path stored in the stack
+                  for (vector<int>::const_iterator it = stack.begin(); it != stack.end(); it++)
+                    {
+                      row2col[*it] = col_index[next_edge[*it]];
+                      col2row[col_index[next_edge[*it]]] = *it;
+                    }
+                  cardinality++;
+                  break;
+                }
+              else if (dist[r2] != infinity && dist[r2] == dist[r] + 1)
+                stack.push_back(r2);
+              else
+                next_edge[r]++;
+            }
+        }
+    }
+  return cardinality;
+}
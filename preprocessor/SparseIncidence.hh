@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SPARSEINCIDENCE_HH
+#define _SPARSEINCIDENCE_HH
+
+using namespace std;
+
+#include <vector>
+#include <utility>
+
+//! Sparsity pattern of a matrix, stored in compressed sparse row (CSR) format
+/*!
+  The column indices of row i are col_index[row_start[i]] to
+  col_index[row_start[i+1]-1], in increasing order and without duplicates.
+  The storage is proportional to the number of nonzero elements, so it can be
+  used for the incidence matrices of very large models.
+*/
+class SparseIncidence
+{
+private:
+  int nrows, ncols;
+  vector<int> row_start, col_index;
+public:
+  //! Creates an empty matrix
+  SparseIncidence(int nrows_arg = 0, int ncols_arg = 0);
+  //! Creates the matrix from a list of (row, column) pairs; duplicate pairs are allowed
+  SparseIncidence(int nrows_arg, int ncols_arg, const vector<pair<int, int> > &entries);
+  inline int getNRows() const { return nrows; };
+  inline int getNCols() const { return ncols; };
+  inline int getNnz() const { return (int) col_index.size(); };
+  //! Position of the first element of row i in the column index array
+  inline int rowBegin(int i) const { return row_start[i]; };
+  //! Position after the last element of row i in the column index array
+  inline int rowEnd(int i) const { return row_start[i+1]; };
+  //! Column index of the element at position k
+  inline int colIndex(int k) const { return col_index[k]; };
+  //! Tests whether element (i, j) is nonzero (by bisection in row i)
+  bool isNonzero(int i, int j) const;
+  //! Returns the transposed pattern (i.e. this pattern in compressed sparse column format)
+  SparseIncidence transpose() const;
+  //! Computes a maximum cardinality matching between rows and columns
+  /*!
+    Uses the Hopcroft-Karp algorithm, which runs in O(nnz*sqrt(nrows+ncols)).
+    \param[out] row2col For each row, the matched column, or -1 if the row is unmatched
+    \return The cardinality of the matching
+  */
+  int maximumMatching(vector<int> &row2col) const;
+};
+
+#endif
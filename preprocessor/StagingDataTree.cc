@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StagingDataTree.hh"
+
+StagingDataTree::StagingDataTree(DataTree &model_arg, SymbolTable &symbol_table_arg,
+                                 NumericalConstants &num_constants_arg,
+                                 ExternalFunctionsTable &external_functions_table_arg,
+                                 const map<int, expr_t> &model_local_variables_arg) :
+  DataTree(symbol_table_arg, num_constants_arg, external_functions_table_arg),
+  model(model_arg),
+  model_local_variables(model_local_variables_arg)
+{
+}
+
+expr_t
+StagingDataTree::importExpression(expr_t expr)
+{
+  return AddCopy(expr, imported);
+}
+
+VariableNode *
+StagingDataTree::AddVariable(int symb_id, int lag)
+{
+  if (symbol_table.getType(symb_id) == eModelLocalVariable
+      && local_variables_table.find(symb_id) == local_variables_table.end())
+    {
+      map<int, expr_t>::const_iterator it = model_local_variables.find(symb_id);
+      if (it != model_local_variables.end())
+        AddLocalVariable(symb_id, importExpression(it->second));
+    }
+  return AddVariableInternal(symb_id, lag);
+}
+
+int
+StagingDataTree::getDerivID(int symb_id, int lag) const throw (UnknownDerivIDException)
+{
+  return model.getDerivID(symb_id, lag);
+}
+
+SymbolType
+StagingDataTree::getTypeByDerivID(int deriv_id) const throw (UnknownDerivIDException)
+{
+  return model.getTypeByDerivID(deriv_id);
+}
+
+int
+StagingDataTree::getLagByDerivID(int deriv_id) const throw (UnknownDerivIDException)
+{
+  return model.getLagByDerivID(deriv_id);
+}
+
+int
+StagingDataTree::getSymbIDByDerivID(int deriv_id) const throw (UnknownDerivIDException)
+{
+  return model.getSymbIDByDerivID(deriv_id);
+}
+
+int
+StagingDataTree::getDynJacobianCol(int deriv_id) const throw (UnknownDerivIDException)
+{
+  return model.getDynJacobianCol(deriv_id);
+}
+
+void
+StagingDataTree::addAllParamDerivId(set<int> &deriv_id_set)
+{
+  model.addAllParamDerivId(deriv_id_set);
+}
+
+bool
+StagingDataTree::isDynamic() const
+{
+  return model.isDynamic();
+}
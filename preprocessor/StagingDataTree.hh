@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2016 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _STAGINGDATATREE_HH
+#define _STAGINGDATATREE_HH
+
+using namespace std;
+
+#include <map>
+
+#include "DataTree.hh"
+
+//! A private data tree in which some expressions of a model are differentiated
+/*!
+  The expressions are copied from the model into the staging tree, and then
+  differentiated there, without modifying the model. Since the staging tree
+  has its own nodes, derivative caches and numerical constants, several
+  staging trees can be used simultaneously by different threads.
+
+  The derivation IDs are those of the model. The model local variables are
+  copied when they are first encountered.
+*/
+class StagingDataTree : public DataTree
+{
+private:
+  //! The model whose expressions are differentiated
+  DataTree &model;
+  //! The model local variables of the model
+  const map<int, expr_t> &model_local_variables;
+  //! Maps the nodes of the model to their copies in the staging tree
+  map<expr_t, expr_t> imported;
+public:
+  StagingDataTree(DataTree &model_arg, SymbolTable &symbol_table_arg,
+                  NumericalConstants &num_constants_arg,
+                  ExternalFunctionsTable &external_functions_table_arg,
+                  const map<int, expr_t> &model_local_variables_arg);
+  //! Returns the copy of an expression of the model
+  expr_t importExpression(expr_t expr);
+  //! Adds a variable, copying the value of a model local variable if needed
+  virtual VariableNode *AddVariable(int symb_id, int lag = 0);
+  virtual int getDerivID(int symb_id, int lag) const throw (UnknownDerivIDException);
+  virtual SymbolType getTypeByDerivID(int deriv_id) const throw (UnknownDerivIDException);
+  virtual int getLagByDerivID(int deriv_id) const throw (UnknownDerivIDException);
+  virtual int getSymbIDByDerivID(int deriv_id) const throw (UnknownDerivIDException);
+  virtual int getDynJacobianCol(int deriv_id) const throw (UnknownDerivIDException);
+  virtual void addAllParamDerivId(set<int> &deriv_id_set);
+  virtual bool isDynamic() const;
+};
+
+#endif
@@ -1077,8 +1077,10 @@ StaticModel::computingPass(const eval_context_t &eval_context, bool no_tmp_terms
     }        
  
   // Launch computations
-  cout << "Computing static model derivatives:" << endl
-       << " - order 1" << endl;
+  cout << "Computing static model derivatives:" << endl;
+  int order = (thirdDerivatives ? 3 : hessian ? 2 : 1);
+  loadDerivativesCache(vars, order);
+  cout << " - order 1" << endl;
   first_derivatives.clear();
 
   computeJacobian(vars);
@@ -1095,6 +1097,8 @@ StaticModel::computingPass(const eval_context_t &eval_context, bool no_tmp_terms
       computeThirdDerivatives(vars);
     }
 
+  saveDerivativesCache(order);
+
   if (paramsDerivsOrder > 0)
     {
       cout << " - derivatives of Jacobian/Hessian w.r. to parameters" << endl;
@@ -1200,66 +1204,35 @@ StaticModel::writeStaticMFile(const string &func_name) const
 }
 
 void
-StaticModel::writeStaticModel(ostream &StaticOutput, bool use_dll, bool julia) const
+StaticModel::writeStaticJacobian(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                                 deriv_node_temp_terms_t &tef_terms, vector<CStatement> *statements) const
 {
-  ostringstream model_local_vars_output;   // Used for storing model local vars
-  ostringstream model_output;              // Used for storing model
-  ostringstream jacobian_output;           // Used for storing jacobian equations
-  ostringstream hessian_output;            // Used for storing Hessian equations
-  ostringstream third_derivatives_output;  // Used for storing third order derivatives equations
-  ostringstream for_sym;
-  ExprNodeOutputType output_type = (use_dll ? oCStaticModel :
-                                    julia ? oJuliaStaticModel : oMatlabStaticModel);
-
-  deriv_node_temp_terms_t tef_terms;
-  temporary_terms_t temp_term_empty;
-  temporary_terms_t temp_term_union = temporary_terms_res;
-  temporary_terms_t temp_term_union_m_1;
-
-  writeModelLocalVariables(model_local_vars_output, output_type, tef_terms);
-
-  writeTemporaryTerms(temporary_terms_res, temp_term_union_m_1, model_output, output_type, tef_terms);
-
-  writeModelEquations(model_output, output_type);
-
-  int nrows = equations.size();
-  int JacobianColsNbr = symbol_table.endo_nbr();
-  int hessianColsNbr = JacobianColsNbr*JacobianColsNbr;
-
-  // Write Jacobian w.r. to endogenous only
-  temp_term_union_m_1 = temp_term_union;
-  temp_term_union.insert(temporary_terms_g1.begin(), temporary_terms_g1.end());
-  if (!first_derivatives.empty())
-    if (julia)
-      writeTemporaryTerms(temp_term_union, temp_term_empty, jacobian_output, output_type, tef_terms);
-    else
-      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, jacobian_output, output_type, tef_terms);
   for (first_derivatives_t::const_iterator it = first_derivatives.begin();
        it != first_derivatives.end(); it++)
     {
+      ostringstream statement;
       int eq = it->first.first;
       int symb_id = getSymbIDByDerivID(it->first.second);
       expr_t d1 = it->second;
 
-      jacobianHelper(jacobian_output, eq, symbol_table.getTypeSpecificID(symb_id), output_type);
-      jacobian_output << "=";
-      d1->writeOutput(jacobian_output, output_type, temp_term_union, tef_terms);
-      jacobian_output << ";" << endl;
+      jacobianHelper(statement, eq, symbol_table.getTypeSpecificID(symb_id), output_type);
+      statement << "=";
+      d1->writeOutput(statement, output_type, temporary_terms, tef_terms);
+      statement << ";" << endl;
+      writeCStatement(output, statements, 1, statement.str(), temporary_terms, d1);
     }
+}
 
-  int g2ncols = symbol_table.endo_nbr() * symbol_table.endo_nbr();
-  // Write Hessian w.r. to endogenous only (only if 2nd order derivatives have been computed)
-  temp_term_union_m_1 = temp_term_union;
-  temp_term_union.insert(temporary_terms_g2.begin(), temporary_terms_g2.end());
-  if (!second_derivatives.empty())
-    if (julia)
-      writeTemporaryTerms(temp_term_union, temp_term_empty, hessian_output, output_type, tef_terms);
-    else
-      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, hessian_output, output_type, tef_terms);
+void
+StaticModel::writeStaticHessian(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                                deriv_node_temp_terms_t &tef_terms, vector<CStatement> *statements) const
+{
+  ostringstream for_sym;
   int k = 0; // Keep the line of a 2nd derivative in v2
   for (second_derivatives_t::const_iterator it = second_derivatives.begin();
        it != second_derivatives.end(); it++)
     {
+      ostringstream statement;
       int eq = it->first.first;
       int symb_id1 = getSymbIDByDerivID(it->first.second.first);
       int symb_id2 = getSymbIDByDerivID(it->first.second.second);
@@ -1274,22 +1247,22 @@ StaticModel::writeStaticModel(ostream &StaticOutput, bool use_dll, bool julia) c
       if (output_type == oJuliaDynamicModel)
         {
           for_sym << "g2[" << eq + 1 << "," << col_nb + 1 << "]";
-          hessian_output << "  @inbounds " << for_sym.str() << " = ";
-          d2->writeOutput(hessian_output, output_type, temp_term_union, tef_terms);
-          hessian_output << endl;
+          statement << "  @inbounds " << for_sym.str() << " = ";
+          d2->writeOutput(statement, output_type, temporary_terms, tef_terms);
+          statement << endl;
         }
       else
         {
-          sparseHelper(2, hessian_output, k, 0, output_type);
-          hessian_output << "=" << eq + 1 << ";" << endl;
+          sparseHelper(2, statement, k, 0, output_type);
+          statement << "=" << eq + 1 << ";" << endl;
 
-          sparseHelper(2, hessian_output, k, 1, output_type);
-          hessian_output << "=" << col_nb + 1 << ";" << endl;
+          sparseHelper(2, statement, k, 1, output_type);
+          statement << "=" << col_nb + 1 << ";" << endl;
 
-          sparseHelper(2, hessian_output, k, 2, output_type);
-          hessian_output << "=";
-          d2->writeOutput(hessian_output, output_type, temp_term_union, tef_terms);
-          hessian_output << ";" << endl;
+          sparseHelper(2, statement, k, 2, output_type);
+          statement << "=";
+          d2->writeOutput(statement, output_type, temporary_terms, tef_terms);
+          statement << ";" << endl;
 
           k++;
         }
@@ -1297,34 +1270,35 @@ StaticModel::writeStaticModel(ostream &StaticOutput, bool use_dll, bool julia) c
       // Treating symetric elements
       if (symb_id1 != symb_id2)
         if (output_type == oJuliaDynamicModel)
-          hessian_output << "  @inbounds g2[" << eq + 1 << "," << col_nb_sym + 1 << "] = "
-                         << for_sym.str() << endl;
+          statement << "  @inbounds g2[" << eq + 1 << "," << col_nb_sym + 1 << "] = "
+                    << for_sym.str() << endl;
         else
           {
-            sparseHelper(2, hessian_output, k, 0, output_type);
-            hessian_output << "=" << eq + 1 << ";" << endl;
+            sparseHelper(2, statement, k, 0, output_type);
+            statement << "=" << eq + 1 << ";" << endl;
 
-            sparseHelper(2, hessian_output, k, 1, output_type);
-            hessian_output << "=" << col_nb_sym + 1 << ";" << endl;
+            sparseHelper(2, statement, k, 1, output_type);
+            statement << "=" << col_nb_sym + 1 << ";" << endl;
 
-            sparseHelper(2, hessian_output, k, 2, output_type);
-            hessian_output << "=";
-            sparseHelper(2, hessian_output, k-1, 2, output_type);
-            hessian_output << ";" << endl;
+            sparseHelper(2, statement, k, 2, output_type);
+            statement << "=";
+            sparseHelper(2, statement, k-1, 2, output_type);
+            statement << ";" << endl;
 
             k++;
           }
+      writeCStatement(output, statements, 2, statement.str(), temporary_terms, d2);
     }
+}
 
-  // Writing third derivatives
-  temp_term_union_m_1 = temp_term_union;
-  temp_term_union.insert(temporary_terms_g3.begin(), temporary_terms_g3.end());
-  if (!third_derivatives.empty())
-    if (julia)
-      writeTemporaryTerms(temp_term_union, temp_term_empty, third_derivatives_output, output_type, tef_terms);
-    else
-      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, third_derivatives_output, output_type, tef_terms);
-  k = 0; // Keep the line of a 3rd derivative in v3
+void
+StaticModel::writeStaticThirdDerivatives(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                                         deriv_node_temp_terms_t &tef_terms) const
+{
+  ostringstream for_sym;
+  int JacobianColsNbr = symbol_table.endo_nbr();
+  int hessianColsNbr = JacobianColsNbr*JacobianColsNbr;
+  int k = 0; // Keep the line of a 3rd derivative in v3
   for (third_derivatives_t::const_iterator it = third_derivatives.begin();
        it != third_derivatives.end(); it++)
     {
@@ -1345,22 +1319,22 @@ StaticModel::writeStaticModel(ostream &StaticOutput, bool use_dll, bool julia) c
       if (output_type == oJuliaDynamicModel)
         {
           for_sym << "g3[" << eq + 1 << "," << ref_col + 1 << "]";
-          third_derivatives_output << "  @inbounds " << for_sym.str() << " = ";
-          d3->writeOutput(third_derivatives_output, output_type, temp_term_union, tef_terms);
-          third_derivatives_output << endl;
+          output << "  @inbounds " << for_sym.str() << " = ";
+          d3->writeOutput(output, output_type, temporary_terms, tef_terms);
+          output << endl;
         }
       else
         {
-          sparseHelper(3, third_derivatives_output, k, 0, output_type);
-          third_derivatives_output << "=" << eq + 1 << ";" << endl;
+          sparseHelper(3, output, k, 0, output_type);
+          output << "=" << eq + 1 << ";" << endl;
 
-          sparseHelper(3, third_derivatives_output, k, 1, output_type);
-          third_derivatives_output << "=" << ref_col + 1 << ";" << endl;
+          sparseHelper(3, output, k, 1, output_type);
+          output << "=" << ref_col + 1 << ";" << endl;
 
-          sparseHelper(3, third_derivatives_output, k, 2, output_type);
-          third_derivatives_output << "=";
-          d3->writeOutput(third_derivatives_output, output_type, temp_term_union, tef_terms);
-          third_derivatives_output << ";" << endl;
+          sparseHelper(3, output, k, 2, output_type);
+          output << "=";
+          d3->writeOutput(output, output_type, temporary_terms, tef_terms);
+          output << ";" << endl;
         }
 
       // Compute the column numbers for the 5 other permutations of (id1,id2,id3)
@@ -1376,25 +1350,87 @@ StaticModel::writeStaticModel(ostream &StaticOutput, bool use_dll, bool julia) c
       for (set<int>::iterator it2 = cols.begin(); it2 != cols.end(); it2++)
         if (*it2 != ref_col)
           if (output_type == oJuliaDynamicModel)
-            third_derivatives_output << "  @inbounds g3[" << eq + 1 << "," << *it2 + 1 << "] = "
-                                     << for_sym.str() << endl;
+            output << "  @inbounds g3[" << eq + 1 << "," << *it2 + 1 << "] = "
+                   << for_sym.str() << endl;
           else
             {
-              sparseHelper(3, third_derivatives_output, k+k2, 0, output_type);
-              third_derivatives_output << "=" << eq + 1 << ";" << endl;
+              sparseHelper(3, output, k+k2, 0, output_type);
+              output << "=" << eq + 1 << ";" << endl;
 
-              sparseHelper(3, third_derivatives_output, k+k2, 1, output_type);
-              third_derivatives_output << "=" << *it2 + 1 << ";" << endl;
+              sparseHelper(3, output, k+k2, 1, output_type);
+              output << "=" << *it2 + 1 << ";" << endl;
 
-              sparseHelper(3, third_derivatives_output, k+k2, 2, output_type);
-              third_derivatives_output << "=";
-              sparseHelper(3, third_derivatives_output, k, 2, output_type);
-              third_derivatives_output << ";" << endl;
+              sparseHelper(3, output, k+k2, 2, output_type);
+              output << "=";
+              sparseHelper(3, output, k, 2, output_type);
+              output << ";" << endl;
 
               k2++;
             }
       k += k2;
     }
+}
+
+void
+StaticModel::writeStaticModel(ostream &StaticOutput, bool use_dll, bool julia, const string &c_basename) const
+{
+  ostringstream model_local_vars_output;   // Used for storing model local vars
+  ostringstream model_output;              // Used for storing model
+  ostringstream jacobian_output;           // Used for storing jacobian equations
+  ostringstream hessian_output;            // Used for storing Hessian equations
+  ostringstream third_derivatives_output;  // Used for storing third order derivatives equations
+  ExprNodeOutputType output_type = (use_dll ? oCStaticModel :
+                                    julia ? oJuliaStaticModel : oMatlabStaticModel);
+
+  deriv_node_temp_terms_t tef_terms;
+  temporary_terms_t temp_term_empty;
+  temporary_terms_t temp_term_union = temporary_terms_res;
+  temporary_terms_t temp_term_union_m_1;
+
+  // With split C files, the statements are kept apart instead of being written to the streams
+  vector<CStatement> statements;
+  vector<CStatement> *c_statements = (output_type == oCStaticModel && split_c_files > 0 ? &statements : NULL);
+
+  writeModelLocalVariables(model_local_vars_output, output_type, tef_terms);
+
+  writeTemporaryTerms(temporary_terms_res, temp_term_union_m_1, model_output, output_type, tef_terms, c_statements, 0);
+
+  writeModelEquations(model_output, output_type, c_statements);
+
+  int nrows = equations.size();
+  int JacobianColsNbr = symbol_table.endo_nbr();
+  int hessianColsNbr = JacobianColsNbr*JacobianColsNbr;
+
+  // Write Jacobian w.r. to endogenous only
+  temp_term_union_m_1 = temp_term_union;
+  temp_term_union.insert(temporary_terms_g1.begin(), temporary_terms_g1.end());
+  if (!first_derivatives.empty())
+    if (julia)
+      writeTemporaryTerms(temp_term_union, temp_term_empty, jacobian_output, output_type, tef_terms);
+    else
+      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, jacobian_output, output_type, tef_terms, c_statements, 1);
+  writeStaticJacobian(jacobian_output, output_type, temp_term_union, tef_terms, c_statements);
+
+  int g2ncols = symbol_table.endo_nbr() * symbol_table.endo_nbr();
+  // Write Hessian w.r. to endogenous only (only if 2nd order derivatives have been computed)
+  temp_term_union_m_1 = temp_term_union;
+  temp_term_union.insert(temporary_terms_g2.begin(), temporary_terms_g2.end());
+  if (!second_derivatives.empty())
+    if (julia)
+      writeTemporaryTerms(temp_term_union, temp_term_empty, hessian_output, output_type, tef_terms);
+    else
+      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, hessian_output, output_type, tef_terms, c_statements, 2);
+  writeStaticHessian(hessian_output, output_type, temp_term_union, tef_terms, c_statements);
+
+  // Writing third derivatives
+  temp_term_union_m_1 = temp_term_union;
+  temp_term_union.insert(temporary_terms_g3.begin(), temporary_terms_g3.end());
+  if (!third_derivatives.empty())
+    if (julia)
+      writeTemporaryTerms(temp_term_union, temp_term_empty, third_derivatives_output, output_type, tef_terms);
+    else
+      writeTemporaryTerms(temp_term_union, temp_term_union_m_1, third_derivatives_output, output_type, tef_terms);
+  writeStaticThirdDerivatives(third_derivatives_output, output_type, temp_term_union, tef_terms);
 
   if (output_type == oMatlabStaticModel)
     {
@@ -1446,6 +1482,17 @@ StaticModel::writeStaticModel(ostream &StaticOutput, bool use_dll, bool julia) c
                    << "end" << endl
                    << "end" << endl;
     }
+  else if (output_type == oCStaticModel && split_c_files > 0)
+    {
+      vector<string> outputs;
+      outputs.push_back("residual");
+      outputs.push_back("g1");
+      outputs.push_back("v2");
+      writeSplitCFunction(StaticOutput, c_basename, "Static",
+                          "double *y, double *x, int nb_row_x, double *params, double *residual, double *g1, double *v2",
+                          "y, x, nb_row_x, params, residual, g1, v2",
+                          model_local_vars_output.str(), statements, outputs);
+    }
   else if (output_type == oCStaticModel)
     {
       StaticOutput << "void Static(double *y, double *x, int nb_row_x, double *params, double *residual, double *g1, double *v2)" << endl
@@ -1576,6 +1623,53 @@ StaticModel::writeStaticModel(ostream &StaticOutput, bool use_dll, bool julia) c
     }
 }
 
+void
+StaticModel::writeStaticPerOrderCFunctions(ostream &output) const
+{
+  const char *suffixes[] = { "resid", "g1", "g2", "g3" };
+  const char *outputs[] = { "residual", "g1", "v2", "v3" };
+  const temporary_terms_t *order_temporary_terms[] = { &temporary_terms_res, &temporary_terms_g1,
+                                                       &temporary_terms_g2, &temporary_terms_g3 };
+  const temporary_terms_t temp_term_empty;
+
+  // Temporary terms that may appear in the expressions of the current order
+  temporary_terms_t temp_term_union;
+  for (int order = 0; order <= 3; order++)
+    {
+      temp_term_union.insert(order_temporary_terms[order]->begin(), order_temporary_terms[order]->end());
+      temporary_terms_t needed;
+      computeNeededTemporaryTerms(order, temp_term_union, needed);
+
+      // Each function computes its own external function calls
+      deriv_node_temp_terms_t tef_terms;
+
+      output << "void Static_" << suffixes[order] << "(double *y, double *x, int nb_row_x, double *params, double *"
+             << outputs[order] << ")" << endl
+             << "{" << endl;
+      if (order == 0)
+        output << "  double lhs, rhs;" << endl
+               << endl;
+      writeModelLocalVariables(output, oCStaticModel, tef_terms);
+      writeTemporaryTerms(needed, temp_term_empty, output, oCStaticModel, tef_terms);
+      switch (order)
+        {
+        case 0:
+          writeModelEquations(output, oCStaticModel);
+          break;
+        case 1:
+          writeStaticJacobian(output, oCStaticModel, temp_term_union, tef_terms);
+          break;
+        case 2:
+          writeStaticHessian(output, oCStaticModel, temp_term_union, tef_terms);
+          break;
+        case 3:
+          writeStaticThirdDerivatives(output, oCStaticModel, temp_term_union, tef_terms);
+          break;
+        }
+      output << "}" << endl << endl;
+    }
+}
+
 void
 StaticModel::writeStaticCFile(const string &func_name) const
 {
@@ -1613,8 +1707,13 @@ StaticModel::writeStaticCFile(const string &func_name) const
   writePowerDerivCHeader(output);
 
   // Writing the function body
-  writeStaticModel(output, true, false);
-  output << "}" << endl << endl;
+  writeStaticModel(output, true, false, func_name + "_static");
+  // When the code is split, the driver is complete and Static_resid etc. are not written
+  if (split_c_files == 0)
+    {
+      output << "}" << endl << endl;
+      writeStaticPerOrderCFunctions(output);
+    }
 
   writePowerDeriv(output, true);
   output.close();
@@ -54,7 +54,20 @@ private:
   void writeStaticJuliaFile(const string &basename) const;
 
   //! Writes the static model equations and its derivatives
-  void writeStaticModel(ostream &StaticOutput, bool use_dll, bool julia) const;
+  /*! \param c_basename base name of the C chunk files, when the C code is split (see split_c_files) */
+  void writeStaticModel(ostream &StaticOutput, bool use_dll, bool julia, const string &c_basename = "") const;
+  //! Writes the assignments of the Jacobian
+  void writeStaticJacobian(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                           deriv_node_temp_terms_t &tef_terms, vector<CStatement> *statements = NULL) const;
+  //! Writes the assignments of the Hessian (in sparse form, except for Julia)
+  void writeStaticHessian(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                          deriv_node_temp_terms_t &tef_terms, vector<CStatement> *statements = NULL) const;
+  //! Writes the assignments of the third derivatives (in sparse form, except for Julia)
+  void writeStaticThirdDerivatives(ostream &output, ExprNodeOutputType output_type, const temporary_terms_t &temporary_terms,
+                                   deriv_node_temp_terms_t &tef_terms) const;
+  //! Writes the C functions Static_resid, Static_g1, Static_g2 and Static_g3
+  /*! Each of them computes only one output, and only the temporary terms that this output needs */
+  void writeStaticPerOrderCFunctions(ostream &output) const;
 
   //! Writes the static function calling the block to solve (Matlab version)
   void writeStaticBlockMFSFile(const string &basename) const;
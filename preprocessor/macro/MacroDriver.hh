@@ -29,6 +29,7 @@
 #include <stack>
 #include <map>
 #include <set>
+#include <vector>
 
 #include "MacroValue.hh"
 #include "MacroBison.hh"
@@ -49,6 +50,20 @@ using namespace std;
 class MacroFlex : public MacroFlexLexer
 {
 private:
+  //! A segment of a loop body, made of consecutive lines
+  struct LoopBodySegment
+  {
+    //! True iff the segment contains no macro code, in which case it is copied to the output without being scanned
+    bool is_literal;
+    //! Text of the segment (for a literal segment, with the end of lines as they are output)
+    string text;
+    //! Number of lines of the segment
+    int lines;
+  };
+
+  //! A loop body, split into segments
+  typedef vector<LoopBodySegment> loop_body_t;
+
   //! Used to backup all the information related to a given scanning context
   class ScanContext
   {
@@ -57,14 +72,15 @@ private:
     struct yy_buffer_state *buffer;
     const Macro::parser::location_type yylloc;
     const bool is_for_context;
-    const string for_body;
+    const loop_body_t *for_body;
+    const size_t for_body_segment;
     const Macro::parser::location_type for_body_loc;
     ScanContext(istream *input_arg, struct yy_buffer_state *buffer_arg,
                 Macro::parser::location_type &yylloc_arg, bool is_for_context_arg,
-                const string &for_body_arg,
+                const loop_body_t *for_body_arg, size_t for_body_segment_arg,
                 Macro::parser::location_type &for_body_loc_arg) :
       input(input_arg), buffer(buffer_arg), yylloc(yylloc_arg), is_for_context(is_for_context_arg),
-      for_body(for_body_arg), for_body_loc(for_body_loc_arg)
+      for_body(for_body_arg), for_body_segment(for_body_segment_arg), for_body_loc(for_body_loc_arg)
     {
     }
   };
@@ -82,11 +98,17 @@ private:
   vector<string> path;
   //! True iff current context is the body of a loop
   bool is_for_context;
-  //! If current context is the body of a loop, contains the string of the loop body
-  string for_body;
+  //! If current context is the body of a loop, contains the segments of the loop body
+  const loop_body_t *for_body;
+  //! If current context is the body of a loop, index of the next segment of the loop body to be scanned or output
+  size_t for_body_segment;
   //! If current context is the body of a loop, contains the location of the beginning of the body
   Macro::parser::location_type for_body_loc;
 
+  //! The loop bodies already split into segments, indexed by their text
+  /*! Nested loops are scanned at each iteration of the outer loop, but their bodies are only split once */
+  map<string, loop_body_t> loop_bodies;
+
   //! Temporary variable used in FOR_BODY mode
   string for_body_tmp;
   //! Temporary variable used in FOR_BODY mode
@@ -137,8 +159,16 @@ private:
   //! Saves current scanning context and create a new context based on the "else" body
   void create_else_context(Macro::parser::location_type *yylloc);
 
-  //! Initialise a new flex buffer with the loop body
-  void new_loop_body_buffer(Macro::parser::location_type *yylloc);
+  //! Returns the segments of a loop body, splitting it if it has not been seen before
+  const loop_body_t *compile_loop_body(const string &body);
+
+  //! Begins a new iteration of the current loop body
+  void begin_loop_iteration(Macro::parser::location_type *yylloc);
+
+  //! Outputs the literal segments of the current loop body, until a segment containing macro code is found
+  /*! Iterates over the loop when the end of the body is reached. Returns true if a new flex buffer
+    has been initialised with a segment containing macro code, false if the loop has terminated */
+  bool next_loop_body_segment(Macro::parser::location_type *yylloc, MacroDriver &driver);
 
 public:
   MacroFlex(istream *in, ostream *out, bool no_line_macro_arg, vector<string> path_arg);
@@ -21,6 +21,8 @@
 using namespace std;
 
 #include <fstream>
+#include <algorithm>
+#include <cctype>
 #include <boost/algorithm/string/trim.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <boost/tokenizer.hpp>
@@ -263,6 +265,7 @@ CONT \\\\
                               for_body_tmp.append(yytext);
                               yylloc->step();
                             }
+<FOR_BODY>[^@\r\n]+          { for_body_tmp.append(yytext); yylloc->step(); }
 <FOR_BODY>.                 { for_body_tmp.append(yytext); yylloc->step(); }
 <FOR_BODY><<EOF>>           { driver.error(for_stmt_loc_tmp, "@#for loop not matched by an @#endfor or file does not end with a new line (unexpected end of file)"); }
 <FOR_BODY>^{SPC}*@#{SPC}*endfor{SPC}*(\/\/.*)?{EOL} {
@@ -284,10 +287,12 @@ CONT \\\\
                                       save_context(yylloc);
 
                                       is_for_context = true;
-                                      for_body = for_body_tmp;
+                                      for_body = compile_loop_body(for_body_tmp);
                                       for_body_loc = for_body_loc_tmp;
 
-                                      new_loop_body_buffer(yylloc);
+                                      begin_loop_iteration(yylloc);
+                                      if (!next_loop_body_segment(yylloc, driver))
+                                        restore_context(yylloc);
                                     }
 
                                   BEGIN(INITIAL);
@@ -380,9 +385,7 @@ CONT \\\\
 
                               /* If we are not in a loop body, or if the loop has terminated,
                                  pop a context */
-                              if (is_for_context && driver.iter_loop())
-                                new_loop_body_buffer(yylloc);
-                              else
+                              if (!is_for_context || !next_loop_body_segment(yylloc, driver))
                                 restore_context(yylloc);
                             }
 
@@ -396,6 +399,7 @@ CONT \\\\
                             }
 
  /* Copy everything else to output */
+<INITIAL>[^@\r\n]+           { yylloc->step(); ECHO; }
 <INITIAL>.                  { yylloc->step(); ECHO; }
 
 <*>.                        { driver.error(*yylloc, "Macro lexer error: '" + string(yytext) + "'"); }
@@ -403,6 +407,7 @@ CONT \\\\
 
 MacroFlex::MacroFlex(istream* in, ostream* out, bool no_line_macro_arg, vector<string> path_arg)
   : MacroFlexLexer(in, out), input(in), no_line_macro(no_line_macro_arg), path(path_arg),
+    is_for_context(false), for_body(NULL), for_body_segment(0),
     reading_for_statement(false), reading_if_statement(false)
 {
 }
@@ -424,7 +429,7 @@ void
 MacroFlex::save_context(Macro::parser::location_type *yylloc)
 {
   context_stack.push(ScanContext(input, YY_CURRENT_BUFFER, *yylloc, is_for_context,
-                                 for_body, for_body_loc));
+                                 for_body, for_body_segment, for_body_loc));
 }
 
 void
@@ -435,6 +440,7 @@ MacroFlex::restore_context(Macro::parser::location_type *yylloc)
   *yylloc = context_stack.top().yylloc;
   is_for_context = context_stack.top().is_for_context;
   for_body = context_stack.top().for_body;
+  for_body_segment = context_stack.top().for_body_segment;
   for_body_loc = context_stack.top().for_body_loc;
   // Remove top of stack
   context_stack.pop();
@@ -493,7 +499,7 @@ MacroFlex::create_include_context(string *filename, Macro::parser::location_type
   yylloc->begin.column = yylloc->end.column = 0;
   // We are not in a loop body
   is_for_context = false;
-  for_body.clear();
+  for_body = NULL;
   // Output @#line information
   output_line(yylloc);
   // Switch to new buffer
@@ -508,7 +514,7 @@ MacroFlex::create_then_context(Macro::parser::location_type *yylloc)
   *yylloc = then_body_loc_tmp;
   yylloc->begin.filename = yylloc->end.filename = new string(*then_body_loc_tmp.begin.filename);
   is_for_context = false;
-  for_body.clear();
+  for_body = NULL;
   output_line(yylloc);
   yy_switch_to_buffer(yy_create_buffer(input, YY_BUF_SIZE));
 }
@@ -521,19 +527,175 @@ MacroFlex::create_else_context(Macro::parser::location_type *yylloc)
   *yylloc = else_body_loc_tmp;
   yylloc->begin.filename = yylloc->end.filename = new string(*else_body_loc_tmp.begin.filename);
   is_for_context = false;
-  for_body.clear();
+  for_body = NULL;
   output_line(yylloc);
   yy_switch_to_buffer(yy_create_buffer(input, YY_BUF_SIZE));
 }
 
+const MacroFlex::loop_body_t *
+MacroFlex::compile_loop_body(const string &body)
+{
+  map<string, loop_body_t>::const_iterator it = loop_bodies.find(body);
+  if (it != loop_bodies.end())
+    return &it->second;
+
+  loop_body_t &segments = loop_bodies[body];
+
+  /* A line can be output without being scanned if it contains no '@', and if
+     the lexer would read it in INITIAL mode, i.e. neither inside a nested
+     @#for/@#if block, nor inside a macro statement or expression started on a
+     previous line. The modes are followed as the rules above would do: a
+     statement ends at the end of its line, unless continued, an expression at
+     its closing brace, and both may contain strings spanning lines. Inside a
+     nested block, only the statements opening and closing a block of the same
+     kind are counted, as in the FOR_BODY and THEN_BODY/ELSE_BODY modes. */
+  enum { in_text, in_statement, in_expression } mode = in_text;
+  bool in_string = false;
+  string nested_kind;
+  int nested_nb = 0;
+  size_t pos = 0;
+  while (pos < body.length())
+    {
+      size_t end = body.find('\n', pos);
+      end = (end == string::npos ? body.length() : end + 1);
+      string line = body.substr(pos, end - pos);
+      pos = end;
+
+      bool is_literal = nested_nb == 0 && mode == in_text && line.find('@') == string::npos;
+      if (!is_literal)
+        {
+          size_t i = 0;
+          if (mode == in_text)
+            {
+              // Keyword of the statement, if the line begins with "@#"
+              i = line.find_first_not_of(" \t");
+              bool is_statement = i != string::npos && line.compare(i, 2, "@#") == 0;
+              string keyword;
+              bool opening = false, closing = false;
+              if (is_statement)
+                {
+                  size_t j = line.find_first_not_of(" \t", i + 2);
+                  i = (j == string::npos ? line.length() : j);
+                  while (i < line.length() && isalpha(line[i]))
+                    keyword += tolower(line[i++]);
+                  opening = i < line.length()
+                    && (line[i] == ' ' || line[i] == '\t' || line.compare(i, 2, "\\\\") == 0);
+                  j = line.find_first_not_of(" \t", i);
+                  closing = j == string::npos || line[j] == '\n' || line.compare(j, 2, "\r\n") == 0
+                    || line.compare(j, 2, "//") == 0;
+                }
+
+              if (nested_nb > 0)
+                {
+                  // Line of a nested block, read as is until the end of the block
+                  if (is_statement && keyword == nested_kind && opening)
+                    nested_nb++;
+                  else if (is_statement && keyword == "end" + nested_kind && closing)
+                    nested_nb--;
+                  i = line.length();
+                }
+              else if (is_statement)
+                {
+                  if (keyword == "for" && opening)
+                    nested_kind = "for";
+                  else if ((keyword == "if" || keyword == "ifdef" || keyword == "ifndef") && opening)
+                    nested_kind = "if";
+                  else
+                    nested_kind.clear();
+                  nested_nb = (nested_kind.empty() ? 0 : 1);
+                  mode = in_statement;
+                }
+            }
+
+          // Follow the statements and expressions up to the end of the line
+          bool continued = false;
+          for (; i < line.length(); i++)
+            if (in_string)
+              in_string = line[i] != '"';
+            else if (mode == in_text)
+              {
+                if (line.compare(i, 2, "@{") == 0)
+                  {
+                    mode = in_expression;
+                    i++;
+                  }
+              }
+            else if (line[i] == '"')
+              in_string = true;
+            else if (mode == in_expression && line[i] == '}')
+              mode = in_text;
+            else if (mode == in_statement && line.compare(i, 2, "\\\\") == 0
+                     && line.find_first_not_of(" \t\r\n", i + 2) == string::npos)
+              {
+                continued = true;
+                break;
+              }
+          if (mode == in_statement && !in_string && !continued)
+            mode = in_text;
+        }
+
+      if (is_literal)
+        {
+          // Same output as the INITIAL mode, which outputs end of lines with endl
+          if (line.length() >= 2 && line.compare(line.length() - 2, 2, "\r\n") == 0)
+            line.erase(line.length() - 2, 1);
+        }
+
+      if (segments.empty() || segments.back().is_literal != is_literal)
+        {
+          LoopBodySegment segment;
+          segment.is_literal = is_literal;
+          segment.lines = 0;
+          segments.push_back(segment);
+        }
+      segments.back().text.append(line);
+      if (line[line.length() - 1] == '\n')
+        segments.back().lines++;
+    }
+
+  return &segments;
+}
+
 void
-MacroFlex::new_loop_body_buffer(Macro::parser::location_type *yylloc)
+MacroFlex::begin_loop_iteration(Macro::parser::location_type *yylloc)
 {
-  input = new stringstream(for_body);
   *yylloc = for_body_loc;
-  yylloc->begin.filename = yylloc->end.filename = new string(*for_body_loc.begin.filename);
+  for_body_segment = 0;
   output_line(yylloc);
-  yy_switch_to_buffer(yy_create_buffer(input, YY_BUF_SIZE));
+}
+
+bool
+MacroFlex::next_loop_body_segment(Macro::parser::location_type *yylloc, MacroDriver &driver)
+{
+  while (true)
+    {
+      if (for_body_segment == for_body->size())
+        {
+          if (!driver.iter_loop())
+            return false;
+          begin_loop_iteration(yylloc);
+          continue;
+        }
+
+      const LoopBodySegment &segment = (*for_body)[for_body_segment++];
+      if (segment.is_literal)
+        {
+#if (YY_FLEX_MAJOR_VERSION > 2) || (YY_FLEX_MAJOR_VERSION == 2 && YY_FLEX_MINOR_VERSION >= 6)
+          yyout << segment.text;
+#else
+          *yyout << segment.text;
+#endif
+          yylloc->lines(segment.lines);
+          yylloc->step();
+        }
+      else
+        {
+          input = new stringstream(segment.text);
+          yylloc->begin.filename = yylloc->end.filename = new string(*for_body_loc.begin.filename);
+          yy_switch_to_buffer(yy_create_buffer(input, YY_BUF_SIZE));
+          return true;
+        }
+    }
 }
 
 /* This implementation of MacroFlexLexer::yylex() is required to fill the
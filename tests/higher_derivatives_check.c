@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2026 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks the functions Dynamic_g4, Dynamic_g5, ... of a shared library built
+ * from the dynamic C file written by the preprocessor with order > 3. On
+ * random inputs, the derivatives of order k must be equal to the central
+ * finite differences of those of order k-1, which are given by the v3 output
+ * of Dynamic for k = 4. Every derivative of order k must be found, with its
+ * columns sorted, and no other.
+ *
+ * Usage: higher_derivatives_check DYNAMIC NY NX NNZ3 NNZ4 [NNZ5...]
+ * where NY is the number of endogenous variables in the argument y of
+ * Dynamic, NX the number of exogenous variables, and NNZk the number of
+ * derivatives of order k (as given by M_.NNZDerivatives).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <dlfcn.h>
+
+/* Upper bound on the size of the inputs and outputs of the test models */
+#define MAX_SIZE 1000000
+/* Highest order of the derivatives which can be checked */
+#define MAX_ORDER 10
+
+#define STEP 1e-4
+#define TOLERANCE 1e-5
+
+typedef void (*dynamic_fn)(double *y, double *x, int nb_row_x, double *params, double *steady_state,
+                           int it_, double *residual, double *g1, double *v2, double *v3);
+typedef void (*dynamic_gk_fn)(double *y, double *x, int nb_row_x, double *params, double *steady_state,
+                              int it_, double *vk);
+
+/* A derivative, w.r. to sorted columns of the dynamic Jacobian (0-based) */
+typedef struct
+{
+  int eq;
+  int cols[MAX_ORDER];
+  double value;
+  int matched;
+} derivative;
+
+static dynamic_fn dynamic;
+static dynamic_gk_fn dynamic_gk[MAX_ORDER+1];
+static int ny, nx, order;
+static double *y, *x, *params, *steady_state, *residual, *g1, *v2, *v;
+
+static int
+compare_ints(const void *a, const void *b)
+{
+  return *(const int *) a - *(const int *) b;
+}
+
+/* Orders derivatives by equation, then by columns */
+static int
+compare_derivatives(const void *a, const void *b)
+{
+  const derivative *d1 = a, *d2 = b;
+  int i;
+  if (d1->eq != d2->eq)
+    return d1->eq - d2->eq;
+  for (i = 0; i < order; i++)
+    if (d1->cols[i] != d2->cols[i])
+      return d1->cols[i] - d2->cols[i];
+  return 0;
+}
+
+/* Evaluates the nnz derivatives of order k at the current inputs, with their columns sorted */
+static void
+evaluate(int k, int nnz, derivative *d)
+{
+  int i, j, ncols = ny + nx;
+  memset(v, 0, MAX_SIZE*sizeof(double));
+  if (k == 3)
+    dynamic(y, x, 1, params, steady_state, 0, residual, g1, v2, v);
+  else
+    dynamic_gk[k](y, x, 1, params, steady_state, 0, v);
+  for (i = 0; i < nnz; i++)
+    {
+      d[i].eq = (int) v[i] - 1;
+      if (k == 3)
+        {
+          /* v3 contains every permutation, with the columns packed in a 1-based index */
+          int col = (int) v[i + nnz] - 1;
+          d[i].cols[0] = col / (ncols*ncols);
+          d[i].cols[1] = (col / ncols) % ncols;
+          d[i].cols[2] = col % ncols;
+        }
+      else
+        for (j = 0; j < k; j++)
+          d[i].cols[j] = (int) v[i + (j+1)*nnz] - 1;
+      qsort(d[i].cols, k, sizeof(int), compare_ints);
+      d[i].value = v[i + (k == 3 ? 2 : k+1)*nnz];
+      d[i].matched = 0;
+    }
+}
+
+static double *
+input(int col)
+{
+  return col < ny ? &y[col] : &x[col - ny];
+}
+
+/* Returns the number of errors in the derivatives of order k */
+static int
+check_order(int k, int nnz_lower, int nnz)
+{
+  derivative *lower = malloc(nnz_lower*sizeof(derivative));
+  derivative *plus = malloc(nnz_lower*sizeof(derivative));
+  derivative *minus = malloc(nnz_lower*sizeof(derivative));
+  derivative *d = malloc(nnz*sizeof(derivative));
+  derivative key, *found;
+  int i, j, nerr = 0;
+
+  order = k;
+  evaluate(k, nnz, d);
+  qsort(d, nnz, sizeof(derivative), compare_derivatives);
+  for (i = 1; i < nnz; i++)
+    if (compare_derivatives(&d[i-1], &d[i]) == 0)
+      {
+        printf("Order %d: the derivative of equation %d w.r. to columns %d... is written twice\n",
+               k, d[i].eq + 1, d[i].cols[0] + 1);
+        nerr++;
+      }
+
+  evaluate(k-1, nnz_lower, lower);
+  for (j = 0; j < ny + nx; j++)
+    {
+      double *in = input(j), save = *in;
+      *in = save + STEP;
+      evaluate(k-1, nnz_lower, plus);
+      *in = save - STEP;
+      evaluate(k-1, nnz_lower, minus);
+      *in = save;
+
+      for (i = 0; i < nnz_lower; i++)
+        {
+          double fd = (plus[i].value - minus[i].value) / (2*STEP), expected = 0;
+          key.eq = lower[i].eq;
+          memcpy(key.cols, lower[i].cols, (k-1)*sizeof(int));
+          key.cols[k-1] = j;
+          qsort(key.cols, k, sizeof(int), compare_ints);
+          found = bsearch(&key, d, nnz, sizeof(derivative), compare_derivatives);
+          if (found != NULL)
+            {
+              expected = found->value;
+              found->matched = 1;
+            }
+          if (fabs(fd - expected) > TOLERANCE*(1 + fabs(expected) + fabs(lower[i].value)))
+            {
+              if (nerr < 10)
+                printf("Order %d: equation %d, column %d: the derivative is %.17g, the finite difference %.17g\n",
+                       k, key.eq + 1, j + 1, expected, fd);
+              nerr++;
+            }
+        }
+    }
+
+  for (i = 0; i < nnz; i++)
+    if (!d[i].matched)
+      {
+        if (nerr < 10)
+          printf("Order %d: the derivative of equation %d w.r. to columns %d... has no lower order derivative\n",
+                 k, d[i].eq + 1, d[i].cols[0] + 1);
+        nerr++;
+      }
+
+  free(lower);
+  free(plus);
+  free(minus);
+  free(d);
+  return nerr;
+}
+
+int
+main(int argc, char **argv)
+{
+  void *handle;
+  int i, k, max_order = argc - 2, nerr = 0;
+  int nnz[MAX_ORDER+1];
+  char name[20];
+
+  if (argc < 6 || max_order > MAX_ORDER)
+    {
+      fprintf(stderr, "Usage: %s DYNAMIC NY NX NNZ3 NNZ4 [NNZ5...]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  ny = atoi(argv[2]);
+  nx = atoi(argv[3]);
+  for (k = 3; k <= max_order; k++)
+    nnz[k] = atoi(argv[k+1]);
+
+  handle = dlopen(argv[1], RTLD_NOW | RTLD_LOCAL);
+  if (handle == NULL)
+    {
+      fprintf(stderr, "Can't load %s: %s\n", argv[1], dlerror());
+      return EXIT_FAILURE;
+    }
+  dynamic = (dynamic_fn) dlsym(handle, "Dynamic");
+  if (dynamic == NULL)
+    {
+      fprintf(stderr, "Can't find Dynamic in %s\n", argv[1]);
+      return EXIT_FAILURE;
+    }
+  for (k = 4; k <= max_order; k++)
+    {
+      sprintf(name, "Dynamic_g%d", k);
+      dynamic_gk[k] = (dynamic_gk_fn) dlsym(handle, name);
+      if (dynamic_gk[k] == NULL)
+        {
+          fprintf(stderr, "Can't find %s in %s\n", name, argv[1]);
+          return EXIT_FAILURE;
+        }
+    }
+
+  srand(1);
+  y = malloc(MAX_SIZE*sizeof(double));
+  x = malloc(MAX_SIZE*sizeof(double));
+  params = malloc(MAX_SIZE*sizeof(double));
+  steady_state = malloc(MAX_SIZE*sizeof(double));
+  for (i = 0; i < MAX_SIZE; i++)
+    {
+      y[i] = 0.5 + (double) rand() / RAND_MAX;
+      x[i] = 0.5 + (double) rand() / RAND_MAX;
+      params[i] = 0.5 + (double) rand() / RAND_MAX;
+      steady_state[i] = 0.5 + (double) rand() / RAND_MAX;
+    }
+  residual = malloc(MAX_SIZE*sizeof(double));
+  g1 = malloc(MAX_SIZE*sizeof(double));
+  v2 = malloc(MAX_SIZE*sizeof(double));
+  v = malloc(MAX_SIZE*sizeof(double));
+
+  for (k = 4; k <= max_order; k++)
+    nerr += check_order(k, nnz[k-1], nnz[k]);
+
+  return nerr == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
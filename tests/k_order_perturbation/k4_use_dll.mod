@@ -0,0 +1,72 @@
+// checks the derivatives of order 4 computed with use_dll, on a model in which
+// the decision rules of y and q are known: they are static functions of the
+// AR(1) processes x and z, so that their approximation at order 4 is exact.
+// The derivatives of Dynamic_g4 are also checked by run_higher_derivatives_test.sh
+
+var y q x z w;
+varexo e_x e_z;
+
+parameters a b c d rhox rhoz bet;
+
+a = 0.5;
+b = -0.3;
+c = 0.7;
+d = 0.2;
+rhox = 0.9;
+rhoz = 0.8;
+bet = 0.95;
+
+model(use_dll);
+y = exp(a*x + b*z(-1));
+q = exp(c*z + d*x(-1));
+x = rhox*x(-1) + e_x;
+z = rhoz*z(-1) + e_z;
+w = bet*w(+1)^0.9*exp(x*z(-1));
+end;
+
+initval;
+y = 1;
+q = 1;
+w = bet^10;
+end;
+
+shocks;
+var e_x; stderr 0.01;
+var e_z; stderr 0.01;
+end;
+
+steady;
+
+stoch_simul(order=4,irf=0);
+
+// Coefficients of y and q in their exponential, w.r. to the state variables
+// and the shocks, in the order of the columns of the decision rules
+nstate = M_.nspred + M_.exo_nbr;
+coef = zeros(2, nstate);
+for i=1:M_.nspred;
+    switch deblank(M_.endo_names(oo_.dr.order_var(M_.nstatic+i),:))
+      case 'x'
+        coef(:,i) = [a*rhox; d];
+      case 'z'
+        coef(:,i) = [b; c*rhoz];
+    end;
+end;
+coef(:,M_.nspred+1:end) = [a 0; 0 c];
+
+// Folded tensor of the 4th derivatives divided by 4!, with the steady state of y and q equal to 1
+g_4 = zeros(2, 0);
+for i=1:nstate;
+    for j=i:nstate;
+        for k=j:nstate;
+            for l=k:nstate;
+                g_4(:,end+1) = coef(:,i).*coef(:,j).*coef(:,k).*coef(:,l)/24;
+            end;
+        end;
+    end;
+end;
+
+iy = find(oo_.dr.order_var == strmatch('y',M_.endo_names,'exact'));
+iq = find(oo_.dr.order_var == strmatch('q',M_.endo_names,'exact'));
+if max(max(abs(oo_.dr.g_4([iy; iq],:) - g_4))) > 1e-10;
+   error('error in g_4');
+end;
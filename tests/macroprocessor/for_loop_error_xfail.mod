@@ -0,0 +1,15 @@
+// Checks the line of an error in the body of a @#for loop, which is only
+// raised at the second iteration.
+
+@#define countries = [ "H", "F" ]
+
+var
+@#for co in countries
+  y_@{co}
+// A comment,
+// then a conditional
+@#if co == "F"
+  z_@{unknown}
+@#endif
+@#endfor
+;
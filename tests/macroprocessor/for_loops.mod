@@ -0,0 +1,68 @@
+// Checks the expansion of @#for loops: nested loops and conditionals,
+// expressions spanning lines and continued directives in a loop body.
+// The expected output is in for_loops.expected.
+
+@#define countries = [ "H", "F" ]
+@#define sectors = [ "A", \\
+                    "B" ]
+
+var
+@#for co in countries
+  y_@{co}
+@#for s in sectors
+  x_@{co}_@{s}
+@#endfor
+@#endfor
+;
+
+varexo
+@#for co in countries
+  e_@{co}
+@#endfor
+;
+
+parameters rho
+@#for co in countries
+  alpha_@{co}
+@#endfor
+;
+
+rho = 0.9;
+@#for co in countries
+// Trade share of country @{co}
+alpha_@{co} = 0.1/@{
+  length(countries)
+  };
+@#endfor
+
+model;
+@#for co in countries
+@#define others = countries \\
+                 - [ co ]
+y_@{co} = rho*y_@{co}(-1) + alpha_@{co}*(0
+@#for o in others
+  + y_@{o}(-1)
+@#endfor
+  ) + e_@{co};
+@#for s in sectors
+@#if s == "A"
+x_@{co}_@{s} = 0.5*y_@{co};
+@#else
+// Sector @{s} is
+// persistent
+x_@{co}_@{s} = 0.5*x_@{co}_@{s}(-1) + 0.1*y_@{co};
+@#endif
+@#endfor
+@#endfor
+end;
+
+steady;
+check;
+
+shocks;
+@#for co in countries
+var e_@{co}; stderr 0.01;
+@#endfor
+end;
+
+stoch_simul(order=1, irf=0);
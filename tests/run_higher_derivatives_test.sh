@@ -0,0 +1,54 @@
+#!/bin/bash
+
+# Checks the derivatives of order 4 and above written by the preprocessor in
+# the dynamic C file of each model, which must have order > 3 and use_dll.
+# The file is compiled into a shared library, and higher_derivatives_check
+# compares its Dynamic_g4, Dynamic_g5, ... functions with the finite
+# differences of the derivatives of the order below.
+#
+# Usage: run_higher_derivatives_test.sh DYNARE_M CC MODFILE...
+
+dynare_m=$1
+cc=$2
+shift 2
+case $dynare_m in
+  /*) ;;
+  *) dynare_m=`pwd`/$dynare_m ;;
+esac
+
+tmpdir=`mktemp -d higher_derivatives.XXXXXX`
+declare -i failed=0
+
+for modfile in "$@" ; do
+  base=`basename $modfile .mod`
+  cp $modfile $tmpdir/
+  if ! (cd $tmpdir && $dynare_m $base.mod nolog > preprocessor.log 2>&1 \
+        && $cc -shared -fPIC -o dynamic.so ${base}_dynamic.c -lm) ; then
+    echo "$modfile: the model could not be built"
+    cat $tmpdir/preprocessor.log
+    ((failed++))
+    rm -rf $tmpdir/*
+    continue
+  fi
+
+  # Number of endogenous variables in the argument y of Dynamic (the largest
+  # element of the lead/lag incidence matrix), of exogenous variables, and of
+  # derivatives of order 3 and above
+  ny=`sed -n '/^M_.lead_lag_incidence = \[/,/\]/p' $tmpdir/$base.m | tr -c '0-9\n' ' ' | tr ' ' '\n' | sort -n | tail -n 1`
+  nx=`sed -n 's/^M_.exo_nbr = \([0-9]*\);/\1/p' $tmpdir/$base.m`
+  nx_det=`sed -n 's/^M_.exo_det_nbr = \([0-9]*\);/\1/p' $tmpdir/$base.m`
+  nnz=`sed -n 's/^M_.NNZDerivatives = \[\(.*\)\];/\1/p' $tmpdir/$base.m | tr -d ';' | cut -d ' ' -f 3-`
+  if ! ./higher_derivatives_check $tmpdir/dynamic.so $ny $((nx + nx_det)) $nnz ; then
+    echo "$modfile: the derivatives of order 4 and above are wrong"
+    ((failed++))
+  fi
+  rm -rf $tmpdir/*
+done
+
+rm -rf $tmpdir
+
+if [ $failed -ne 0 ] ; then
+  echo "higher derivatives tests: $failed failure(s)"
+  exit 1
+fi
+echo "higher derivatives tests: all passed"
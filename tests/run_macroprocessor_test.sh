@@ -0,0 +1,57 @@
+#!/bin/bash
+
+# Checks the output of the macro processor. Each model of MODFILE... is
+# expanded, and the output is compared with the .expected file next to it.
+# The models of XFAIL_MODFILE... must be rejected, and the error message is
+# compared with the first line of the .expected file next to them.
+#
+# Usage: run_macroprocessor_test.sh DYNARE_M MODFILE... -- XFAIL_MODFILE...
+
+dynare_m=$1
+shift
+case $dynare_m in
+  /*) ;;
+  *) dynare_m=`pwd`/$dynare_m ;;
+esac
+
+tmpdir=`mktemp -d macroprocessor.XXXXXX`
+declare -i failed=0
+xfail=0
+
+for modfile in "$@" ; do
+  if [ "$modfile" = "--" ] ; then
+    xfail=1
+    continue
+  fi
+  base=`basename $modfile .mod`
+  expected=`dirname $modfile`/$base.expected
+  cp $modfile $tmpdir/
+  if (cd $tmpdir && $dynare_m $base.mod savemacro=$base.out onlymacro > $base.log 2>&1) ; then
+    if [ $xfail -eq 1 ] ; then
+      echo "$modfile: the macro processor did not fail"
+      ((failed++))
+    elif ! diff $expected $tmpdir/$base.out ; then
+      echo "$modfile: the output of the macro processor differs from $expected"
+      ((failed++))
+    fi
+  else
+    if [ $xfail -eq 0 ] ; then
+      echo "$modfile: the macro processor failed"
+      cat $tmpdir/$base.log
+      ((failed++))
+    elif ! grep -q -x -F "`head -n 1 $expected`" $tmpdir/$base.log ; then
+      echo "$modfile: the error of the macro processor differs from $expected"
+      cat $tmpdir/$base.log
+      ((failed++))
+    fi
+  fi
+  rm -f $tmpdir/*
+done
+
+rm -rf $tmpdir
+
+if [ $failed -ne 0 ] ; then
+  echo "macroprocessor tests: $failed failure(s)"
+  exit 1
+fi
+echo "macroprocessor tests: all passed"
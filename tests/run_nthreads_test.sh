@@ -0,0 +1,55 @@
+#!/bin/bash
+
+# Checks that the files written by the preprocessor do not depend on the
+# number of threads given by the nthreads option. Without the option, the
+# derivatives are computed serially directly in the model tree; the files
+# are then only required to have the same names.
+#
+# Usage: run_nthreads_test.sh DYNARE_M MODFILE...
+
+dynare_m=$1
+shift
+case $dynare_m in
+  /*) ;;
+  *) dynare_m=`pwd`/$dynare_m ;;
+esac
+
+tmpdir=`mktemp -d nthreads.XXXXXX`
+declare -i failed=0
+
+for modfile in "$@" ; do
+  base=`basename $modfile`
+  for n in 0 1 4 ; do
+    mkdir -p $tmpdir/$n
+    cp $modfile $tmpdir/$n/
+    if [ $n -eq 0 ] ; then
+      opt=""
+    else
+      opt="nthreads=$n"
+    fi
+    if ! (cd $tmpdir/$n && $dynare_m $base nolog $opt > preprocessor.log 2>&1) ; then
+      echo "$modfile: the preprocessor failed with threads=$n"
+      cat $tmpdir/$n/preprocessor.log
+      ((failed++))
+    fi
+    rm -f $tmpdir/$n/preprocessor.log
+  done
+
+  if ! diff -r $tmpdir/1 $tmpdir/4 ; then
+    echo "$modfile: the files differ with nthreads=1 and nthreads=4"
+    ((failed++))
+  fi
+  if [ "`cd $tmpdir/0 && find . | sort`" != "`cd $tmpdir/1 && find . | sort`" ] ; then
+    echo "$modfile: different files are written with and without nthreads"
+    ((failed++))
+  fi
+  rm -rf $tmpdir/0 $tmpdir/1 $tmpdir/4
+done
+
+rm -rf $tmpdir
+
+if [ $failed -ne 0 ] ; then
+  echo "nthreads tests: $failed failure(s)"
+  exit 1
+fi
+echo "nthreads tests: all passed"
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+# Checks the split_c_files option. The C files of each model are written
+# by the preprocessor without the option, and with the model split across
+# 3 and 40 files. The files are compiled into shared libraries, and
+# split_c_files_check compares the outputs of their Dynamic and Static
+# functions.
+#
+# Usage: run_split_c_files_test.sh DYNARE_M CC MODFILE...
+
+dynare_m=$1
+cc=$2
+shift 2
+case $dynare_m in
+  /*) ;;
+  *) dynare_m=`pwd`/$dynare_m ;;
+esac
+
+# Without the option, there is no chunk file
+shopt -s nullglob
+
+tmpdir=`mktemp -d split_c_files.XXXXXX`
+declare -i failed=0
+
+for modfile in "$@" ; do
+  base=`basename $modfile .mod`
+  for n in 0 3 40 ; do
+    mkdir -p $tmpdir/$n
+    cp $modfile $tmpdir/$n/
+    if [ $n -eq 0 ] ; then
+      opt=""
+    else
+      opt="split_c_files=$n"
+    fi
+    if ! (cd $tmpdir/$n && $dynare_m $base.mod nolog $opt > preprocessor.log 2>&1 \
+          && $cc -shared -fPIC -o dynamic.so ${base}_dynamic.c ${base}_dynamic_chunk*.c -lm \
+          && $cc -shared -fPIC -o static.so ${base}_static.c ${base}_static_chunk*.c -lm) ; then
+      echo "$modfile: the model could not be built with split_c_files=$n"
+      cat $tmpdir/$n/preprocessor.log
+      ((failed++))
+      continue
+    fi
+    if [ $n -ne 0 ] && ! ./split_c_files_check $tmpdir/0/dynamic.so $tmpdir/$n/dynamic.so \
+                                               $tmpdir/0/static.so $tmpdir/$n/static.so ; then
+      echo "$modfile: the outputs differ with split_c_files=$n"
+      ((failed++))
+    fi
+  done
+  rm -rf $tmpdir/0 $tmpdir/3 $tmpdir/40
+done
+
+rm -rf $tmpdir
+
+if [ $failed -ne 0 ] ; then
+  echo "split_c_files tests: $failed failure(s)"
+  exit 1
+fi
+echo "split_c_files tests: all passed"
@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2026 Dynare Team
+ *
+ * This file is part of Dynare.
+ *
+ * Dynare is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Dynare is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Dynare.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Compares the Dynamic and Static functions of two shared libraries built
+ * from the C files written by the preprocessor for the same model, one
+ * without and one with the split_c_files option. The functions are called
+ * on the same random inputs, once with all the outputs and once with the
+ * first derivatives only, and must give bitwise identical outputs.
+ *
+ * Usage: split_c_files_check DYNAMIC_REF DYNAMIC_SPLIT STATIC_REF STATIC_SPLIT
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+
+/* Upper bound on the size of the inputs and outputs of the test models */
+#define MAX_SIZE 1000000
+
+typedef void (*dynamic_fn)(double *y, double *x, int nb_row_x, double *params, double *steady_state,
+                           int it_, double *residual, double *g1, double *v2, double *v3);
+typedef void (*static_fn)(double *y, double *x, int nb_row_x, double *params,
+                          double *residual, double *g1, double *v2);
+
+static double *inputs[4];
+static double *outputs[2][4];
+
+static void *
+load(const char *library, const char *function)
+{
+  void *handle = dlopen(library, RTLD_NOW | RTLD_LOCAL);
+  void *f;
+  if (handle == NULL)
+    {
+      fprintf(stderr, "Can't load %s: %s\n", library, dlerror());
+      exit(EXIT_FAILURE);
+    }
+  f = dlsym(handle, function);
+  if (f == NULL)
+    {
+      fprintf(stderr, "Can't find %s in %s\n", function, library);
+      exit(EXIT_FAILURE);
+    }
+  return f;
+}
+
+static void
+reset_outputs(void)
+{
+  int i, j;
+  for (i = 0; i < 2; i++)
+    for (j = 0; j < 4; j++)
+      memset(outputs[i][j], 0, MAX_SIZE*sizeof(double));
+}
+
+/* Returns the number of outputs which differ between the two libraries */
+static int
+compare_outputs(const char *call)
+{
+  const char *names[] = { "residual", "g1", "v2", "v3" };
+  int j, k, ndiff = 0;
+  for (j = 0; j < 4; j++)
+    for (k = 0; k < MAX_SIZE; k++)
+      if (memcmp(&outputs[0][j][k], &outputs[1][j][k], sizeof(double)) != 0)
+        {
+          if (ndiff < 10)
+            printf("%s: %s[%d] is %.17g without split and %.17g with split\n",
+                   call, names[j], k, outputs[0][j][k], outputs[1][j][k]);
+          ndiff++;
+        }
+  return ndiff;
+}
+
+int
+main(int argc, char **argv)
+{
+  dynamic_fn dynamic[2];
+  static_fn static_model[2];
+  int i, j, ndiff = 0;
+
+  if (argc != 5)
+    {
+      fprintf(stderr, "Usage: %s DYNAMIC_REF DYNAMIC_SPLIT STATIC_REF STATIC_SPLIT\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      dynamic[i] = (dynamic_fn) load(argv[1+i], "Dynamic");
+      static_model[i] = (static_fn) load(argv[3+i], "Static");
+    }
+
+  srand(1);
+  for (j = 0; j < 4; j++)
+    {
+      inputs[j] = malloc(MAX_SIZE*sizeof(double));
+      for (i = 0; i < MAX_SIZE; i++)
+        inputs[j][i] = 0.5 + (double) rand() / RAND_MAX;
+    }
+  for (i = 0; i < 2; i++)
+    for (j = 0; j < 4; j++)
+      outputs[i][j] = malloc(MAX_SIZE*sizeof(double));
+
+  reset_outputs();
+  for (i = 0; i < 2; i++)
+    dynamic[i](inputs[0], inputs[1], 1, inputs[2], inputs[3], 0,
+               outputs[i][0], outputs[i][1], outputs[i][2], outputs[i][3]);
+  ndiff += compare_outputs("Dynamic");
+
+  reset_outputs();
+  for (i = 0; i < 2; i++)
+    dynamic[i](inputs[0], inputs[1], 1, inputs[2], inputs[3], 0,
+               outputs[i][0], outputs[i][1], NULL, NULL);
+  ndiff += compare_outputs("Dynamic without v2 and v3");
+
+  reset_outputs();
+  for (i = 0; i < 2; i++)
+    static_model[i](inputs[0], inputs[1], 1, inputs[2],
+                    outputs[i][0], outputs[i][1], outputs[i][2]);
+  ndiff += compare_outputs("Static");
+
+  reset_outputs();
+  for (i = 0; i < 2; i++)
+    static_model[i](inputs[0], inputs[1], 1, inputs[2],
+                    outputs[i][0], outputs[i][1], NULL);
+  ndiff += compare_outputs("Static without v2");
+
+  return ndiff == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}